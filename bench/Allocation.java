@@ -0,0 +1,31 @@
+// One operation is the allocation of an object, with the call to its
+// constructor, and of an int array of 4 elements. Run with -Xgc to
+// include the garbage collection cost.
+public class Allocation {
+
+	static final int OPERATIONS = 50000;
+
+	static int sink;
+
+	int value;
+
+	Allocation(int value) {
+		this.value = value;
+	}
+
+	public static void main(String[] args) {
+		int total = 0;
+
+		for (int i = 0; i < OPERATIONS; i++) {
+			Allocation object = new Allocation(i);
+			int[] values = new int[4];
+
+			values[i & 3] = object.value;
+			total = total + values[i & 3];
+		}
+
+		sink = total;
+		System.out.println(sink);
+	}
+
+}
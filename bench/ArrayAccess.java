@@ -0,0 +1,25 @@
+// One operation is a load and a store of an int array element, with
+// their bounds checks.
+public class ArrayAccess {
+
+	static final int OPERATIONS = 200000;
+
+	static final int LENGTH = 1000;
+
+	static int sink;
+
+	public static void main(String[] args) {
+		int[] values = new int[LENGTH];
+
+		for (int pass = 0; pass < OPERATIONS / LENGTH; pass++) {
+			for (int i = 1; i < LENGTH; i++)
+				values[i] = values[i - 1] + i;
+
+			values[0] = values[LENGTH - 1];
+		}
+
+		sink = values[LENGTH / 2];
+		System.out.println(sink);
+	}
+
+}
@@ -0,0 +1,25 @@
+// One operation is an iteration of the loop: an add, a subtract, a
+// multiply, a divide and a comparison on doubles.
+public class DoubleArithmetic {
+
+	static final int OPERATIONS = 200000;
+
+	static double sink;
+
+	public static void main(String[] args) {
+		double a = 1.5, b = 0.25, c = 0;
+
+		for (int i = 0; i < OPERATIONS; i++) {
+			a = a * b + 0.5;
+			b = a * 0.5 - b;
+			c = c + a / (b + 3.0);
+
+			if (c > 1000000.0)
+				c = c - 1000000.0;
+		}
+
+		sink = a + b + c;
+		System.out.println(sink);
+	}
+
+}
@@ -0,0 +1,24 @@
+// One operation is an iteration of the loop: a read and a write of
+// an instance field, and a read and a write of a static field.
+public class FieldAccess {
+
+	static final int OPERATIONS = 200000;
+
+	static int total;
+
+	int count;
+
+	public static void main(String[] args) {
+		FieldAccess object = new FieldAccess();
+
+		total = 0;
+
+		for (int i = 0; i < OPERATIONS; i++) {
+			object.count = object.count + i;
+			total = total + object.count;
+		}
+
+		System.out.println(total);
+	}
+
+}
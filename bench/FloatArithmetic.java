@@ -0,0 +1,25 @@
+// One operation is an iteration of the loop: an add, a subtract, a
+// multiply, a divide and a comparison on floats.
+public class FloatArithmetic {
+
+	static final int OPERATIONS = 200000;
+
+	static float sink;
+
+	public static void main(String[] args) {
+		float a = 1.5f, b = 0.25f, c = 0;
+
+		for (int i = 0; i < OPERATIONS; i++) {
+			a = a * b + 0.5f;
+			b = a * 0.5f - b;
+			c = c + a / (b + 3.0f);
+
+			if (c > 1000000.0f)
+				c = c - 1000000.0f;
+		}
+
+		sink = a + b + c;
+		System.out.println(sink);
+	}
+
+}
@@ -0,0 +1,24 @@
+// One operation is an iteration of the loop: an add, a subtract, a
+// multiply, a divide, a remainder, a shift and an xor on longs.
+public class LongArithmetic {
+
+	static final int OPERATIONS = 200000;
+
+	static long sink;
+
+	public static void main(String[] args) {
+		long a = 1, b = 7, c = 0;
+
+		for (int i = 0; i < OPERATIONS; i++) {
+			a = a + i;
+			b = b - a;
+			c = (a * 31) / (b | 1);
+			c = c % 1000 + ((long) i << 2);
+			a = a ^ c;
+		}
+
+		sink = a + b + c;
+		System.out.println(sink);
+	}
+
+}
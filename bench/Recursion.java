@@ -0,0 +1,21 @@
+// One operation is a call of the recursive Fibonacci function,
+// fib(20) making 21891 of them.
+public class Recursion {
+
+	static final int OPERATIONS = 21891;
+
+	static int sink;
+
+	static int fib(int n) {
+		if (n < 2)
+			return n;
+
+		return fib(n - 1) + fib(n - 2);
+	}
+
+	public static void main(String[] args) {
+		sink = fib(20);
+		System.out.println(sink);
+	}
+
+}
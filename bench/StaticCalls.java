@@ -0,0 +1,23 @@
+// One operation is a call to a static method with two arguments,
+// and its return.
+public class StaticCalls {
+
+	static final int OPERATIONS = 200000;
+
+	static int sink;
+
+	static int add(int a, int b) {
+		return a + b;
+	}
+
+	public static void main(String[] args) {
+		int total = 0;
+
+		for (int i = 0; i < OPERATIONS; i++)
+			total = add(total, i);
+
+		sink = total;
+		System.out.println(sink);
+	}
+
+}
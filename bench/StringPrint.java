@@ -0,0 +1,12 @@
+// One operation is a println of a constant string. Redirect the
+// output, as the terminal would otherwise be measured.
+public class StringPrint {
+
+	static final int OPERATIONS = 2000;
+
+	public static void main(String[] args) {
+		for (int i = 0; i < OPERATIONS; i++)
+			System.out.println("The quick brown fox jumps over the lazy dog");
+	}
+
+}
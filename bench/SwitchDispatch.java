@@ -0,0 +1,36 @@
+// One operation is a dense switch, compiled to a tableswitch, and a
+// sparse switch, compiled to a lookupswitch.
+public class SwitchDispatch {
+
+	static final int OPERATIONS = 200000;
+
+	static int sink;
+
+	public static void main(String[] args) {
+		int total = 0;
+
+		for (int i = 0; i < OPERATIONS; i++) {
+			switch (i & 7) {
+				case 0: total += 1; break;
+				case 1: total += 3; break;
+				case 2: total -= 2; break;
+				case 3: total ^= 5; break;
+				case 4: total += 7; break;
+				case 5: total -= 1; break;
+				case 6: total <<= 1; break;
+				default: total >>= 1; break;
+			}
+
+			switch ((i & 3) * 1000) {
+				case 0: total += 11; break;
+				case 1000: total -= 13; break;
+				case 2000: total ^= 17; break;
+				default: total += 19; break;
+			}
+		}
+
+		sink = total;
+		System.out.println(sink);
+	}
+
+}
@@ -0,0 +1,48 @@
+// One operation is a call to an instance method with an argument,
+// overridden by the class of the receiver, and its return. Receivers
+// alternate between two classes.
+public class VirtualCalls {
+
+	static final int OPERATIONS = 200000;
+
+	static int sink;
+
+	public static void main(String[] args) {
+		Shape square = new Square();
+		Shape circle = new Circle();
+		int total = 0;
+
+		for (int i = 0; i < OPERATIONS; i += 2) {
+			total = total + square.area(i);
+			total = total + circle.area(i);
+		}
+
+		sink = total;
+		System.out.println(sink);
+	}
+
+}
+
+class Shape {
+
+	int area(int size) {
+		return 0;
+	}
+
+}
+
+class Square extends Shape {
+
+	int area(int size) {
+		return size * size;
+	}
+
+}
+
+class Circle extends Shape {
+
+	int area(int size) {
+		return 3 * size * size;
+	}
+
+}
@@ -0,0 +1,266 @@
+#include "allocprofile.h"
+#include "memoryinspect.h"
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#define ALLOC_PROFILE_MASK (ALLOC_PROFILE_BUCKETS - 1)
+
+/// @brief Creates an empty allocation profile.
+///
+/// @param uint32_t intervalBytes - bytes allocated between samples,
+/// 1 to sample every allocation.
+///
+/// @return The profile, to be freed with freeAllocationProfile(), or
+/// NULL if there is not enough memory.
+AllocationProfile* newAllocationProfile(uint32_t intervalBytes)
+{
+    AllocationProfile* profile = (AllocationProfile*)malloc(sizeof(AllocationProfile));
+
+    if (profile)
+    {
+        memset(profile, 0, sizeof(AllocationProfile));
+        profile->interval = intervalBytes ? intervalBytes : 1;
+        profile->bytesUntilSample = profile->interval;
+    }
+
+    return profile;
+}
+
+void freeAllocationProfile(AllocationProfile* profile)
+{
+    AllocationSite* site;
+    AllocationType* type;
+    uint32_t bucket;
+
+    for (bucket = 0; bucket < ALLOC_PROFILE_BUCKETS; bucket++)
+    {
+        while ((site = profile->sites[bucket]))
+        {
+            profile->sites[bucket] = site->next;
+            free(site);
+        }
+
+        while ((type = profile->types[bucket]))
+        {
+            profile->types[bucket] = type->next;
+            free(type->name);
+            free(type);
+        }
+    }
+
+    free(profile);
+}
+
+static AllocationSite* getAllocationSite(AllocationProfile* profile, FrameStack* frames)
+{
+    JavaClass* jc = frames ? frames->frame->jc : NULL;
+    method_info* method = frames ? frames->frame->method : NULL;
+    uint32_t pc = frames ? frames->frame->pc : 0;
+    uint32_t bucket = (uint32_t)(((uintptr_t)method >> 4) * 31 + pc) & ALLOC_PROFILE_MASK;
+    AllocationSite* site;
+
+    for (site = profile->sites[bucket]; site; site = site->next)
+    {
+        if (site->method == method && site->pc == pc)
+            return site;
+    }
+
+    site = (AllocationSite*)malloc(sizeof(AllocationSite));
+
+    if (site)
+    {
+        site->jc = jc;
+        site->method = method;
+        site->pc = pc;
+        site->bytes = 0;
+        site->objects = 0;
+        site->next = profile->sites[bucket];
+        profile->sites[bucket] = site;
+        profile->siteCount++;
+    }
+
+    return site;
+}
+
+static AllocationType* getAllocationType(AllocationProfile* profile, const uint8_t* typeName, int32_t typeNameLength, uint8_t isArray)
+{
+    char name[256];
+    uint32_t hash = 2166136261u;
+    uint32_t length, index;
+    AllocationType* type;
+
+    snprintf(name, sizeof(name), "%.*s%s", (int)typeNameLength, (const char*)typeName, isArray ? "[]" : "");
+    length = (uint32_t)strlen(name);
+
+    for (index = 0; index < length; index++)
+        hash = (hash ^ (uint8_t)name[index]) * 16777619u;
+
+    for (type = profile->types[hash & ALLOC_PROFILE_MASK]; type; type = type->next)
+    {
+        if (!strcmp(type->name, name))
+            return type;
+    }
+
+    type = (AllocationType*)malloc(sizeof(AllocationType));
+
+    if (!type)
+        return NULL;
+
+    type->name = (char*)malloc(length + 1);
+
+    if (!type->name)
+    {
+        free(type);
+        return NULL;
+    }
+
+    memcpy(type->name, name, length + 1);
+    type->bytes = 0;
+    type->objects = 0;
+    type->next = profile->types[hash & ALLOC_PROFILE_MASK];
+    profile->types[hash & ALLOC_PROFILE_MASK] = type;
+    profile->typeCount++;
+    return type;
+}
+
+/// @brief Records an allocation that countAllocation() picked, charging
+/// the bytes allocated since the previous sample to its site and type.
+///
+/// @param FrameStack* frames - frames of the JVM, whose top frame is
+/// the one allocating.
+/// @param uint32_t bytes - size of the allocation.
+/// @param const uint8_t* typeName - class name, or element type name
+/// for arrays.
+/// @param uint8_t isArray - whether "[]" is appended to the type name.
+void sampleAllocation(AllocationProfile* profile, FrameStack* frames, uint32_t bytes,
+                      const uint8_t* typeName, int32_t typeNameLength, uint8_t isArray)
+{
+    AllocationSite* site = getAllocationSite(profile, frames);
+    AllocationType* type = getAllocationType(profile, typeName, typeNameLength, isArray);
+
+    // An allocation larger than the interval can cross several sample
+    // points, and stands for all of them.
+    int64_t crossed = 1 + (-profile->bytesUntilSample) / profile->interval;
+    double sampledBytes = (double)crossed * profile->interval;
+    double sampledObjects = bytes ? sampledBytes / bytes : 1.0;
+
+    profile->bytesUntilSample += crossed * profile->interval;
+    profile->sampleCount++;
+
+    if (site)
+    {
+        site->bytes += sampledBytes;
+        site->objects += sampledObjects;
+    }
+
+    if (type)
+    {
+        type->bytes += sampledBytes;
+        type->objects += sampledObjects;
+    }
+}
+
+static int compareSiteBytes(const void* a, const void* b)
+{
+    double bytes1 = (*(AllocationSite* const*)a)->bytes;
+    double bytes2 = (*(AllocationSite* const*)b)->bytes;
+
+    return bytes1 < bytes2 ? 1 : (bytes1 > bytes2 ? -1 : 0);
+}
+
+static int compareTypeBytes(const void* a, const void* b)
+{
+    double bytes1 = (*(AllocationType* const*)a)->bytes;
+    double bytes2 = (*(AllocationType* const*)b)->bytes;
+
+    return bytes1 < bytes2 ? 1 : (bytes1 > bytes2 ? -1 : 0);
+}
+
+static void formatSiteName(char* buffer, size_t size, AllocationSite* site)
+{
+    cp_info* className;
+    cp_info* methodName;
+    uint16_t line;
+
+    if (!site->method)
+    {
+        snprintf(buffer, size, "[jvm]");
+        return;
+    }
+
+    className = site->jc->constantPool + site->jc->thisClass - 1;
+    className = site->jc->constantPool + className->Class.name_index - 1;
+    methodName = site->jc->constantPool + site->method->name_index - 1;
+
+    // The pc is already past the opcode being executed
+    line = getMethodLineNumber(site->jc, site->method, site->pc ? site->pc - 1 : 0);
+
+    if (line)
+        snprintf(buffer, size, "%.*s.%.*s:%u (pc %u)", (int)className->Utf8.length, className->Utf8.bytes,
+                 (int)methodName->Utf8.length, methodName->Utf8.bytes, line, site->pc ? site->pc - 1 : 0);
+    else
+        snprintf(buffer, size, "%.*s.%.*s (pc %u)", (int)className->Utf8.length, className->Utf8.bytes,
+                 (int)methodName->Utf8.length, methodName->Utf8.bytes, site->pc ? site->pc - 1 : 0);
+}
+
+/// @brief Prints the allocation sites and types with the most bytes to
+/// stderr, with their estimated bytes and objects.
+///
+/// @param uint32_t rowCount - number of sites and of types to print.
+void printAllocationReport(AllocationProfile* profile, uint32_t rowCount)
+{
+    AllocationSite** sites = (AllocationSite**)malloc((profile->siteCount + 1) * sizeof(AllocationSite*));
+    AllocationType** types = (AllocationType**)malloc((profile->typeCount + 1) * sizeof(AllocationType*));
+    AllocationSite* site;
+    AllocationType* type;
+    double sampledBytes = 0;
+    uint32_t siteCount = 0, typeCount = 0;
+    uint32_t bucket, index;
+    char name[512];
+
+    fprintf(stderr, "\nAllocations: %" PRIu64 " objects, %" PRIu64 " bytes, %" PRIu64 " samples, every %u bytes\n",
+            profile->totalObjects, profile->totalBytes, profile->sampleCount, profile->interval);
+
+    if (!sites || !types)
+    {
+        free(sites);
+        free(types);
+        return;
+    }
+
+    for (bucket = 0; bucket < ALLOC_PROFILE_BUCKETS; bucket++)
+    {
+        for (site = profile->sites[bucket]; site; site = site->next)
+        {
+            sites[siteCount++] = site;
+            sampledBytes += site->bytes;
+        }
+
+        for (type = profile->types[bucket]; type; type = type->next)
+            types[typeCount++] = type;
+    }
+
+    qsort(sites, siteCount, sizeof(AllocationSite*), compareSiteBytes);
+    qsort(types, typeCount, sizeof(AllocationType*), compareTypeBytes);
+
+    fprintf(stderr, "\n  %-60s %14s %7s %12s\n", "Site", "Bytes", "%", "Objects");
+
+    for (index = 0; index < siteCount && index < rowCount; index++)
+    {
+        formatSiteName(name, sizeof(name), sites[index]);
+        fprintf(stderr, "  %-60s %14.0f %6.2f%% %12.0f\n", name, sites[index]->bytes,
+                sampledBytes ? 100.0 * sites[index]->bytes / sampledBytes : 0.0, sites[index]->objects);
+    }
+
+    fprintf(stderr, "\n  %-60s %14s %7s %12s\n", "Type", "Bytes", "%", "Objects");
+
+    for (index = 0; index < typeCount && index < rowCount; index++)
+    {
+        fprintf(stderr, "  %-60s %14.0f %6.2f%% %12.0f\n", types[index]->name, types[index]->bytes,
+                sampledBytes ? 100.0 * types[index]->bytes / sampledBytes : 0.0, types[index]->objects);
+    }
+
+    free(sites);
+    free(types);
+}
@@ -0,0 +1,101 @@
+#ifndef ALLOCPROFILE_H
+#define ALLOCPROFILE_H
+
+typedef struct AllocationProfile AllocationProfile;
+
+#include <stdint.h>
+#include "framestack.h"
+
+// Buckets of the site and type hash tables, a power of two
+#define ALLOC_PROFILE_BUCKETS 1024
+
+/// @brief Allocations estimated from the samples taken at a pc.
+typedef struct AllocationSite
+{
+    // Method allocating, or NULL outside Java methods
+    JavaClass* jc;
+    method_info* method;
+    uint32_t pc;
+
+    double bytes;
+    double objects;
+
+    struct AllocationSite* next;
+} AllocationSite;
+
+/// @brief Allocations estimated from the samples of a class or array
+/// type, such as "java/lang/String" or "int[]".
+typedef struct AllocationType
+{
+    char* name;
+
+    double bytes;
+    double objects;
+
+    struct AllocationType* next;
+} AllocationType;
+
+struct AllocationProfile
+{
+    // Bytes between samples
+    uint32_t interval;
+
+    // Counts down the bytes allocated, a sample being taken when it
+    // reaches zero
+    int64_t bytesUntilSample;
+
+    // Exact totals, counted for every allocation
+    uint64_t totalBytes;
+    uint64_t totalObjects;
+    uint64_t sampleCount;
+
+    AllocationSite* sites[ALLOC_PROFILE_BUCKETS];
+    AllocationType* types[ALLOC_PROFILE_BUCKETS];
+    uint32_t siteCount;
+    uint32_t typeCount;
+};
+
+/// @brief Counts an allocation of \c bytes.
+///
+/// @return 1 if the allocation must be sampled with sampleAllocation(),
+/// 0 otherwise.
+static inline uint8_t countAllocation(AllocationProfile* profile, uint32_t bytes)
+{
+    profile->totalBytes += bytes;
+    profile->totalObjects++;
+    profile->bytesUntilSample -= bytes;
+    return profile->bytesUntilSample <= 0;
+}
+
+AllocationProfile* newAllocationProfile(uint32_t intervalBytes);
+void freeAllocationProfile(AllocationProfile* profile);
+void sampleAllocation(AllocationProfile* profile, FrameStack* frames, uint32_t bytes,
+                      const uint8_t* typeName, int32_t typeNameLength, uint8_t isArray);
+void printAllocationReport(AllocationProfile* profile, uint32_t rowCount);
+
+#endif // ALLOCPROFILE_H
+
+/// @defgroup allocprofile Allocation profile module
+///
+/// @brief Tells which code allocates, and what.
+///
+/// "-Xallocprofile" counts the objects, arrays and strings created and
+/// their bytes, and takes a sample every 4096 bytes allocated, or as
+/// set by "-Xallocsampleinterval:<bytes>". A sample records the method
+/// and pc on top of the frame stack, and the class or array type.
+///
+/// Each sample stands for the bytes allocated since the previous one,
+/// so the bytes and objects of each site and type are estimates, which
+/// get closer to the real numbers as the interval shrinks. An interval
+/// of 1 samples every allocation. When the program ends, the sites and
+/// types with the most bytes are printed to stderr.
+///
+/// Bytes are the memory the JVM allocates for the object and its data,
+/// not counting the allocator overhead. Without the option, each
+/// allocation only tests a null pointer.
+///
+/// Methods running on the register IR don't update the pc of their
+/// frame, so their sites are where they were entered or where they
+/// last left the IR.
+///
+/// @see countAllocation(), sampleAllocation()
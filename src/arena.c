@@ -0,0 +1,77 @@
+#include "arena.h"
+#include "memoryinspect.h"
+
+// Pieces are aligned for any of the types stored in an arena
+#define ARENA_ALIGNMENT 8
+
+struct ArenaBlock
+{
+    ArenaBlock* next;
+};
+
+/// @brief Sets up an empty arena. No memory is allocated until
+/// the first piece is requested.
+/// @param Arena* arena - pointer to the arena.
+/// @param size_t blockSize - minimum size of each block.
+/// @see allocFromArena(), freeArena()
+void initArena(Arena* arena, size_t blockSize)
+{
+    arena->blocks = NULL;
+    arena->next = NULL;
+    arena->available = 0;
+    arena->blockSize = blockSize < 256 ? 256 : blockSize;
+}
+
+/// @brief Gets a piece of memory from an arena.
+///
+/// @param Arena* arena - pointer to an initialized arena.
+/// @param size_t bytes - size of the piece, which can be zero.
+///
+/// @return Pointer to the piece, which is released by freeArena(),
+/// or NULL if a new block couldn't be allocated.
+void* allocFromArena(Arena* arena, size_t bytes)
+{
+    bytes = (bytes + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+
+    if (bytes > arena->available || !arena->blocks)
+    {
+        // The header is padded so that pieces stay aligned
+        size_t header = (sizeof(ArenaBlock) + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+        size_t size = bytes > arena->blockSize ? bytes : arena->blockSize;
+        ArenaBlock* block = (ArenaBlock*)malloc(header + size);
+
+        if (!block)
+            return NULL;
+
+        block->next = arena->blocks;
+        arena->blocks = block;
+        arena->next = (uint8_t*)block + header;
+        arena->available = size;
+    }
+
+    void* piece = arena->next;
+
+    arena->next += bytes;
+    arena->available -= bytes;
+    return piece;
+}
+
+/// @brief Releases all blocks of an arena, and every piece taken
+/// from them. The arena is left empty and can be used again.
+/// @param Arena* arena - pointer to an initialized arena.
+void freeArena(Arena* arena)
+{
+    ArenaBlock* block = arena->blocks;
+    ArenaBlock* next;
+
+    while (block)
+    {
+        next = block->next;
+        free(block);
+        block = next;
+    }
+
+    arena->blocks = NULL;
+    arena->next = NULL;
+    arena->available = 0;
+}
@@ -0,0 +1,36 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef struct ArenaBlock ArenaBlock;
+
+/// @brief Memory that is handed out in pieces and released all
+/// at once.
+///
+/// Pieces are carved from the current block. When it runs out, a
+/// new block of at least \c blockSize bytes is allocated.
+typedef struct Arena
+{
+    ArenaBlock* blocks;
+    uint8_t* next;
+    size_t available;
+    size_t blockSize;
+} Arena;
+
+void initArena(Arena* arena, size_t blockSize);
+void* allocFromArena(Arena* arena, size_t bytes);
+void freeArena(Arena* arena);
+
+#endif // ARENA_H
+
+/// @defgroup arena Arena module
+///
+/// @brief Allocates memory whose pieces share the same lifetime.
+///
+/// Each class has an arena, and the parser takes its constant pool,
+/// field, method and attribute tables from it. Closing the class
+/// frees the few blocks of the arena instead of every table.
+///
+/// @see allocFromArena(), closeClassFile()
@@ -7,8 +7,7 @@
 
 #define DECLARE_ATTR_FUNCS(attr) \
     uint8_t readAttribute##attr(JavaClass* jc, attribute_info* entry); \
-    void printAttribute##attr(JavaClass* jc, attribute_info* entry, int identationLevel); \
-    void freeAttribute##attr(attribute_info* entry);
+    void printAttribute##attr(JavaClass* jc, attribute_info* entry, int identationLevel);
 
 DECLARE_ATTR_FUNCS(SourceFile)
 DECLARE_ATTR_FUNCS(InnerClasses)
@@ -17,6 +16,7 @@ DECLARE_ATTR_FUNCS(ConstantValue)
 DECLARE_ATTR_FUNCS(Code)
 DECLARE_ATTR_FUNCS(Deprecated)
 DECLARE_ATTR_FUNCS(Exceptions)
+DECLARE_ATTR_FUNCS(StackMapTable)
 
 char readAttribute(JavaClass* jc, attribute_info* entry)
 {
@@ -47,29 +47,36 @@ char readAttribute(JavaClass* jc, attribute_info* entry)
             result = readAttribute##name(jc, entry); \
         }
 
+    // Method bodies and the attributes only needed by the verifier
+    // or for debugging are skipped, and decoded by decodeAttribute()
+    #define IF_LAZY_ATTR_CHECK(name) \
+        if (cmp_UTF8_Ascii(cp->Utf8.bytes, cp->Utf8.length, (uint8_t*)#name, sizeof(#name) - 1)) { \
+            entry->attributeType = ATTR_##name; \
+            result = readBytes(jc, entry->length) != NULL; \
+            if (!result) \
+                jc->status = UNEXPECTED_EOF_READING_ATTRIBUTE_INFO; \
+        }
+
     uint32_t totalBytesRead = jc->totalBytesRead;
     char result;
 
+    entry->offset = totalBytesRead;
+
     IF_ATTR_CHECK(ConstantValue)
     else IF_ATTR_CHECK(SourceFile)
     else IF_ATTR_CHECK(InnerClasses)
-    else IF_ATTR_CHECK(Code)
-    else IF_ATTR_CHECK(LineNumberTable)
+    else IF_LAZY_ATTR_CHECK(Code)
+    else IF_LAZY_ATTR_CHECK(LineNumberTable)
     else IF_ATTR_CHECK(Deprecated)
-    else IF_ATTR_CHECK(Exceptions)
+    else IF_LAZY_ATTR_CHECK(Exceptions)
+    else IF_LAZY_ATTR_CHECK(StackMapTable)
     else
     {
-        uint32_t u32;
-
-        for (u32 = 0; u32 < entry->length; u32++)
+        // Unknown attributes are skipped without being read
+        if (!readBytes(jc, entry->length))
         {
-            if (fgetc(jc->file) == EOF)
-            {
-                jc->status = UNEXPECTED_EOF_READING_ATTRIBUTE_INFO;
-                return 0;
-            }
-
-            jc->totalBytesRead++;
+            jc->status = UNEXPECTED_EOF_READING_ATTRIBUTE_INFO;
+            return 0;
         }
 
         result = 1;
@@ -82,7 +89,62 @@ char readAttribute(JavaClass* jc, attribute_info* entry)
         return 0;
     }
 
-    #undef ATTR_CHECK
+    #undef IF_ATTR_CHECK
+    #undef IF_LAZY_ATTR_CHECK
+    return result;
+}
+
+/// @brief Decodes an attribute that was skipped when the class
+/// file was read.
+///
+/// Nothing is done if the attribute is already decoded or is not
+/// one of the attributes decoded on first use. Attributes found
+/// inside a Code attribute are themselves left to be decoded later.
+///
+/// @param JavaClass* jc - class the attribute belongs to, whose
+/// file must still be open.
+/// @param attribute_info* entry - the attribute to be decoded.
+///
+/// @return 0 if the attribute is invalid, in which case the class
+/// status tells why, 1 otherwise.
+/// @see readAttribute()
+uint8_t decodeAttribute(JavaClass* jc, attribute_info* entry)
+{
+    #define ATTR_CASE(attr) case ATTR_##attr: result = readAttribute##attr(jc, entry); break;
+
+    if (entry->info)
+        return 1;
+
+    uint32_t totalBytesRead = jc->totalBytesRead;
+    uint8_t result;
+
+    jc->totalBytesRead = entry->offset;
+
+    switch (entry->attributeType)
+    {
+        ATTR_CASE(Code)
+        ATTR_CASE(LineNumberTable)
+        ATTR_CASE(Exceptions)
+        ATTR_CASE(StackMapTable)
+        default:
+            jc->totalBytesRead = totalBytesRead;
+            return 1;
+    }
+
+    if (result && jc->totalBytesRead - entry->offset != entry->length)
+    {
+        jc->status = ATTRIBUTE_LENGTH_MISMATCH;
+        result = 0;
+    }
+
+    jc->totalBytesRead = totalBytesRead;
+
+    // What was decoded stays in the arena of the class until it is
+    // closed, but the attribute is left undecoded
+    if (!result)
+        entry->info = NULL;
+
+    #undef ATTR_CASE
     return result;
 }
 
@@ -104,14 +166,9 @@ void printAttributeDeprecated(JavaClass* jc, attribute_info* entry, int identati
     printf("This element is marked as deprecated and should no longer be used.");
 }
 
-void freeAttributeDeprecated(attribute_info* entry)
-{
-
-}
-
 uint8_t readAttributeConstantValue(JavaClass* jc, attribute_info* entry)
 {
-    att_ConstantValue_info* info = (att_ConstantValue_info*)malloc(sizeof(att_ConstantValue_info));
+    att_ConstantValue_info* info = (att_ConstantValue_info*)allocFromArena(&jc->arena, sizeof(att_ConstantValue_info));
     entry->info = (void*)info;
 
     if (!info)
@@ -188,17 +245,9 @@ void printAttributeConstantValue(JavaClass* jc, attribute_info* entry, int ident
     printf(">");
 }
 
-void freeAttributeConstantValue(attribute_info* entry)
-{
-    if (entry->info)
-        free(entry->info);
-
-    entry->info = NULL;
-}
-
 uint8_t readAttributeSourceFile(JavaClass* jc, attribute_info* entry)
 {
-    att_SourceFile_info* info = (att_SourceFile_info*)malloc(sizeof(att_SourceFile_info));
+    att_SourceFile_info* info = (att_SourceFile_info*)allocFromArena(&jc->arena, sizeof(att_SourceFile_info));
     entry->info = (void*)info;
 
     if (!info)
@@ -236,17 +285,9 @@ void printAttributeSourceFile(JavaClass* jc, attribute_info* entry, int identati
     printf("sourcefile_index: #%u <%s>", info->sourcefile_index, buffer);
 }
 
-void freeAttributeSourceFile(attribute_info* entry)
-{
-    if (entry->info)
-        free(entry->info);
-
-    entry->info = NULL;
-}
-
 uint8_t readAttributeInnerClasses(JavaClass* jc, attribute_info* entry)
 {
-    att_InnerClasses_info* info = (att_InnerClasses_info*)malloc(sizeof(att_InnerClasses_info));
+    att_InnerClasses_info* info = (att_InnerClasses_info*)allocFromArena(&jc->arena, sizeof(att_InnerClasses_info));
     entry->info = (void*)info;
 
     if (!info)
@@ -263,7 +304,7 @@ uint8_t readAttributeInnerClasses(JavaClass* jc, attribute_info* entry)
         return 0;
     }
 
-    info->inner_classes = (InnerClassInfo*)malloc(info->number_of_classes * sizeof(InnerClassInfo));
+    info->inner_classes = (InnerClassInfo*)allocFromArena(&jc->arena, info->number_of_classes * sizeof(InnerClassInfo));
 
     if (!info->inner_classes)
     {
@@ -363,24 +404,9 @@ void printAttributeInnerClasses(JavaClass* jc, attribute_info* entry, int identa
     }
 }
 
-void freeAttributeInnerClasses(attribute_info* entry)
-{
-    att_InnerClasses_info* info = (att_InnerClasses_info*)entry->info;
-
-    if (info)
-    {
-        if (info->inner_classes)
-            free(info->inner_classes);
-
-        free(info);
-    }
-
-    entry->info = NULL;
-}
-
 uint8_t readAttributeLineNumberTable(JavaClass* jc, attribute_info* entry)
 {
-    att_LineNumberTable_info* info = (att_LineNumberTable_info*)malloc(sizeof(att_LineNumberTable_info));
+    att_LineNumberTable_info* info = (att_LineNumberTable_info*)allocFromArena(&jc->arena, sizeof(att_LineNumberTable_info));
     entry->info = (void*)info;
 
     if (!info)
@@ -397,7 +423,7 @@ uint8_t readAttributeLineNumberTable(JavaClass* jc, attribute_info* entry)
         return 0;
     }
 
-    info->line_number_table = (LineNumberTableEntry*)malloc(info->line_number_table_length * sizeof(LineNumberTableEntry));
+    info->line_number_table = (LineNumberTableEntry*)allocFromArena(&jc->arena, info->line_number_table_length * sizeof(LineNumberTableEntry));
 
     if (!info->line_number_table)
     {
@@ -441,23 +467,9 @@ void printAttributeLineNumberTable(JavaClass* jc, attribute_info* entry, int ide
     }
 }
 
-void freeAttributeLineNumberTable(attribute_info* entry)
-{
-    att_LineNumberTable_info* info = (att_LineNumberTable_info*)entry->info;
-
-    if (info)
-    {
-        if (info->line_number_table)
-            free(info->line_number_table);
-
-        free(info);
-        entry->info = NULL;
-    }
-}
-
 uint8_t readAttributeCode(JavaClass* jc, attribute_info* entry)
 {
-    att_Code_info* info = (att_Code_info*)malloc(sizeof(att_Code_info));
+    att_Code_info* info = (att_Code_info*)allocFromArena(&jc->arena, sizeof(att_Code_info));
     entry->info = (void*)info;
     uint32_t u32;
 
@@ -469,6 +481,14 @@ uint8_t readAttributeCode(JavaClass* jc, attribute_info* entry)
 
     info->code = NULL;
     info->exception_table = NULL;
+    info->attributes_count = 0;
+    info->attributes = NULL;
+    info->ir = NULL;
+    info->types = NULL;
+    info->verified = 0;
+    info->linked = 0;
+    info->traced = 0;
+    info->trampoline = NULL;
 
     if (!readu2(jc, &info->max_stack) ||
         !readu2(jc, &info->max_locals) ||
@@ -484,22 +504,15 @@ uint8_t readAttributeCode(JavaClass* jc, attribute_info* entry)
         return 0;
     }
 
-    info->code = (uint8_t*)malloc(info->code_length);
+    // The bytecode points into the mapping of the class file
+    info->code = readBytes(jc, info->code_length);
 
     if (!info->code)
-    {
-        jc->status = MEMORY_ALLOCATION_FAILED;
-        return 0;
-    }
-
-    if (fread(info->code, sizeof(uint8_t), info->code_length, jc->file) != info->code_length)
     {
         jc->status = UNEXPECTED_EOF_READING_ATTRIBUTE_INFO;
         return 0;
     }
 
-    jc->totalBytesRead += info->code_length;
-
     // TODO: check if all instructions are valid and have correct parameters.
 
     if (!readu2(jc, &info->exception_table_length))
@@ -508,7 +521,7 @@ uint8_t readAttributeCode(JavaClass* jc, attribute_info* entry)
         return 0;
     }
 
-    info->exception_table = (ExceptionTableEntry*)malloc(info->exception_table_length * sizeof(ExceptionTableEntry));
+    info->exception_table = (ExceptionTableEntry*)allocFromArena(&jc->arena, info->exception_table_length * sizeof(ExceptionTableEntry));
 
     if (!info->exception_table)
     {
@@ -540,7 +553,7 @@ uint8_t readAttributeCode(JavaClass* jc, attribute_info* entry)
         return 0;
     }
 
-    info->attributes = (attribute_info*)malloc(info->attributes_count * sizeof(attribute_info));
+    info->attributes = (attribute_info*)allocFromArena(&jc->arena, info->attributes_count * sizeof(attribute_info));
 
     if (!info->attributes)
     {
@@ -1101,36 +1114,9 @@ void printAttributeCode(JavaClass* jc, attribute_info* entry, int identationLeve
     }
 }
 
-void freeAttributeCode(attribute_info* entry)
-{
-    att_Code_info* info = (att_Code_info*)entry->info;
-
-    if (info)
-    {
-        if (info->code)
-            free(info->code);
-
-        if (info->exception_table)
-            free(info->exception_table);
-
-        if (info->attributes)
-        {
-            uint16_t u16;
-
-            for (u16 = 0; u16 < info->attributes_count; u16++)
-                freeAttributeInfo(info->attributes + u16);
-
-            free(info->attributes);
-        }
-
-        free(info);
-        entry->info = NULL;
-    }
-}
-
 uint8_t readAttributeExceptions(JavaClass* jc, attribute_info* entry)
 {
-    att_Exceptions_info* info = (att_Exceptions_info*)malloc(sizeof(att_Exceptions_info));
+    att_Exceptions_info* info = (att_Exceptions_info*)allocFromArena(&jc->arena, sizeof(att_Exceptions_info));
     entry->info = (void*)info;
 
     if (!info)
@@ -1147,7 +1133,7 @@ uint8_t readAttributeExceptions(JavaClass* jc, attribute_info* entry)
         return 0;
     }
 
-    info->exception_index_table = (uint16_t*)malloc(info->number_of_exceptions * sizeof(uint16_t));
+    info->exception_index_table = (uint16_t*)allocFromArena(&jc->arena, info->number_of_exceptions * sizeof(uint16_t));
 
     if (!info->exception_index_table)
     {
@@ -1202,44 +1188,297 @@ void printAttributeExceptions(JavaClass* jc, attribute_info* entry, int identati
     }
 }
 
-void freeAttributeExceptions(attribute_info* entry)
+static uint8_t readVerificationTypeInfo(JavaClass* jc, VerificationTypeInfo* vti)
 {
-    att_Exceptions_info* info = (att_Exceptions_info*)entry->info;
+    vti->index_or_offset = 0;
+
+    if (!readu1(jc, &vti->tag))
+        return 0;
+
+    if (vti->tag == ITEM_Object || vti->tag == ITEM_Uninitialized)
+        return readu2(jc, &vti->index_or_offset);
+
+    return 1;
+}
+
+static uint8_t readVerificationTypeInfos(JavaClass* jc, VerificationTypeInfo** outPtr, uint16_t count)
+{
+    uint16_t u16;
 
-    if (info)
+    if (count == 0)
+        return 1;
+
+    *outPtr = (VerificationTypeInfo*)allocFromArena(&jc->arena, count * sizeof(VerificationTypeInfo));
+
+    if (!*outPtr)
     {
-        if (info->exception_index_table)
-            free(info->exception_index_table);
+        jc->status = MEMORY_ALLOCATION_FAILED;
+        return 0;
+    }
 
-        free(info);
-        entry->info = NULL;
+    for (u16 = 0; u16 < count; u16++)
+    {
+        if (!readVerificationTypeInfo(jc, *outPtr + u16))
+        {
+            jc->status = UNEXPECTED_EOF_READING_ATTRIBUTE_INFO;
+            return 0;
+        }
+
+        if ((*outPtr)[u16].tag > ITEM_Uninitialized)
+        {
+            jc->status = ATTRIBUTE_INVALID_STACKMAPTABLE;
+            return 0;
+        }
+
+        if ((*outPtr)[u16].tag == ITEM_Object &&
+            ((*outPtr)[u16].index_or_offset == 0 ||
+             (*outPtr)[u16].index_or_offset >= jc->constantPoolCount ||
+             jc->constantPool[(*outPtr)[u16].index_or_offset - 1].tag != CONSTANT_Class))
+        {
+            jc->status = ATTRIBUTE_INVALID_STACKMAPTABLE;
+            return 0;
+        }
     }
+
+    return 1;
 }
 
-void freeAttributeInfo(attribute_info* entry)
+uint8_t readAttributeStackMapTable(JavaClass* jc, attribute_info* entry)
 {
-    #define ATTR_CASE(attr) case ATTR_##attr: freeAttribute##attr(entry); return;
+    att_StackMapTable_info* info = (att_StackMapTable_info*)allocFromArena(&jc->arena, sizeof(att_StackMapTable_info));
+    entry->info = (void*)info;
 
-    switch (entry->attributeType)
+    if (!info)
     {
-        ATTR_CASE(Code)
-        ATTR_CASE(LineNumberTable)
-        ATTR_CASE(SourceFile)
-        ATTR_CASE(InnerClasses)
-        ATTR_CASE(ConstantValue)
-        ATTR_CASE(Deprecated)
-        ATTR_CASE(Exceptions)
-        default:
-            break;
+        jc->status = MEMORY_ALLOCATION_FAILED;
+        return 0;
     }
 
-    #undef ATTR_CASE
+    info->entries = NULL;
+
+    if (!readu2(jc, &info->number_of_entries))
+    {
+        jc->status = UNEXPECTED_EOF_READING_ATTRIBUTE_INFO;
+        return 0;
+    }
+
+    if (info->number_of_entries == 0)
+        return 1;
+
+    info->entries = (StackMapFrame*)allocFromArena(&jc->arena, info->number_of_entries * sizeof(StackMapFrame));
+
+    if (!info->entries)
+    {
+        jc->status = MEMORY_ALLOCATION_FAILED;
+        return 0;
+    }
+
+    uint16_t u16;
+    StackMapFrame* frame;
+
+    // Frames must be cleared first, so they can be released
+    // if reading the table fails halfway
+    for (u16 = 0; u16 < info->number_of_entries; u16++)
+    {
+        frame = info->entries + u16;
+        frame->number_of_locals = 0;
+        frame->locals = NULL;
+        frame->number_of_stack_items = 0;
+        frame->stack = NULL;
+    }
+
+    for (u16 = 0; u16 < info->number_of_entries; u16++)
+    {
+        frame = info->entries + u16;
+
+        if (!readu1(jc, &frame->frame_type))
+        {
+            jc->status = UNEXPECTED_EOF_READING_ATTRIBUTE_INFO;
+            return 0;
+        }
+
+        if (frame->frame_type <= 63)
+        {
+            // same_frame
+            frame->offset_delta = frame->frame_type;
+            continue;
+        }
+
+        if (frame->frame_type <= 127)
+        {
+            // same_locals_1_stack_item_frame
+            frame->offset_delta = frame->frame_type - 64;
+            frame->number_of_stack_items = 1;
+
+            if (!readVerificationTypeInfos(jc, &frame->stack, 1))
+                return 0;
+
+            continue;
+        }
+
+        if (frame->frame_type < 247)
+        {
+            // Reserved for future use
+            jc->status = ATTRIBUTE_INVALID_STACKMAPTABLE;
+            return 0;
+        }
+
+        if (!readu2(jc, &frame->offset_delta))
+        {
+            jc->status = UNEXPECTED_EOF_READING_ATTRIBUTE_INFO;
+            return 0;
+        }
+
+        if (frame->frame_type == 247)
+        {
+            // same_locals_1_stack_item_frame_extended
+            frame->number_of_stack_items = 1;
+
+            if (!readVerificationTypeInfos(jc, &frame->stack, 1))
+                return 0;
+        }
+        else if (frame->frame_type >= 252 && frame->frame_type <= 254)
+        {
+            // append_frame
+            frame->number_of_locals = frame->frame_type - 251;
+
+            if (!readVerificationTypeInfos(jc, &frame->locals, frame->number_of_locals))
+                return 0;
+        }
+        else if (frame->frame_type == 255)
+        {
+            // full_frame
+            if (!readu2(jc, &frame->number_of_locals))
+            {
+                jc->status = UNEXPECTED_EOF_READING_ATTRIBUTE_INFO;
+                return 0;
+            }
+
+            if (!readVerificationTypeInfos(jc, &frame->locals, frame->number_of_locals))
+                return 0;
+
+            if (!readu2(jc, &frame->number_of_stack_items))
+            {
+                jc->status = UNEXPECTED_EOF_READING_ATTRIBUTE_INFO;
+                return 0;
+            }
+
+            if (!readVerificationTypeInfos(jc, &frame->stack, frame->number_of_stack_items))
+                return 0;
+        }
+
+        // chop_frame and same_frame_extended only have the offset delta
+    }
+
+    return 1;
+}
+
+static void printVerificationTypeInfos(JavaClass* jc, VerificationTypeInfo* vti, uint16_t count)
+{
+    static const char* names[] = {
+        "top", "int", "float", "double", "long", "null", "uninitializedThis"
+    };
+
+    char buffer[48];
+    cp_info* cpi;
+    uint16_t u16;
+
+    printf("[");
+
+    for (u16 = 0; u16 < count; u16++, vti++)
+    {
+        if (u16 > 0)
+            printf(", ");
+
+        if (vti->tag == ITEM_Object)
+        {
+            cpi = jc->constantPool + vti->index_or_offset - 1;
+            cpi = jc->constantPool + cpi->Class.name_index - 1;
+            UTF8_to_Ascii((uint8_t*)buffer, sizeof(buffer), cpi->Utf8.bytes, cpi->Utf8.length);
+            printf("#%u <%s>", vti->index_or_offset, buffer);
+        }
+        else if (vti->tag == ITEM_Uninitialized)
+        {
+            printf("uninitialized(%u)", vti->index_or_offset);
+        }
+        else
+        {
+            printf("%s", names[vti->tag]);
+        }
+    }
+
+    printf("]");
+}
+
+void printAttributeStackMapTable(JavaClass* jc, attribute_info* entry, int identationLevel)
+{
+    att_StackMapTable_info* info = (att_StackMapTable_info*)entry->info;
+    StackMapFrame* frame = info->entries;
+    const char* frameName;
+    uint16_t index;
+
+    printf("\n");
+    ident(identationLevel);
+    printf("number_of_entries: %u", info->number_of_entries);
+
+    for (index = 0; index < info->number_of_entries; index++, frame++)
+    {
+        if (frame->frame_type <= 63)
+            frameName = "same_frame";
+        else if (frame->frame_type <= 127)
+            frameName = "same_locals_1_stack_item_frame";
+        else if (frame->frame_type == 247)
+            frameName = "same_locals_1_stack_item_frame_extended";
+        else if (frame->frame_type <= 250)
+            frameName = "chop_frame";
+        else if (frame->frame_type == 251)
+            frameName = "same_frame_extended";
+        else if (frame->frame_type <= 254)
+            frameName = "append_frame";
+        else
+            frameName = "full_frame";
+
+        printf("\n\n");
+        ident(identationLevel + 1);
+        printf("Frame #%u: %s (frame_type = %u, offset_delta = %u)", index + 1, frameName,
+               frame->frame_type, frame->offset_delta);
+
+        if (frame->frame_type >= 248 && frame->frame_type <= 250)
+        {
+            printf("\n");
+            ident(identationLevel + 2);
+            printf("chopped locals: %u", 251 - frame->frame_type);
+        }
+
+        if (frame->number_of_locals > 0 || frame->frame_type == 255)
+        {
+            printf("\n");
+            ident(identationLevel + 2);
+            printf("locals: ");
+            printVerificationTypeInfos(jc, frame->locals, frame->number_of_locals);
+        }
+
+        if (frame->number_of_stack_items > 0 || frame->frame_type == 255)
+        {
+            printf("\n");
+            ident(identationLevel + 2);
+            printf("stack: ");
+            printVerificationTypeInfos(jc, frame->stack, frame->number_of_stack_items);
+        }
+    }
 }
 
 void printAttribute(JavaClass* jc, attribute_info* entry, int identationLevel)
 {
     #define ATTR_CASE(attr) case ATTR_##attr: printAttribute##attr(jc, entry, identationLevel); break;
 
+    if (!decodeAttribute(jc, entry))
+    {
+        ident(identationLevel);
+        printf("Attribute couldn't be decoded: %s\n", decodeJavaClassStatus(jc->status));
+        return;
+    }
+
     switch (entry->attributeType)
     {
         ATTR_CASE(Code)
@@ -1249,6 +1488,7 @@ void printAttribute(JavaClass* jc, attribute_info* entry, int identationLevel)
         ATTR_CASE(LineNumberTable)
         ATTR_CASE(Deprecated)
         ATTR_CASE(Exceptions)
+        ATTR_CASE(StackMapTable)
         default:
             ident(identationLevel);
             printf("Attribute not implemented and ignored.");
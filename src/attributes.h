@@ -2,6 +2,9 @@
 #define ATTRIBUTES_H
 
 typedef struct attribute_info attribute_info;
+typedef struct att_Code_info att_Code_info;
+typedef struct IRMethod IRMethod;
+typedef struct MethodTypes MethodTypes;
 
 #include <stdint.h>
 #include "javaclass.h"
@@ -11,6 +14,12 @@ struct attribute_info {
     uint32_t length;
     void* info;
     uint8_t attributeType;
+
+    // Not part of the class file: offset of the attribute data in
+    // the class file. Code, LineNumberTable, StackMapTable and
+    // Exceptions attributes are only decoded from there the first
+    // time they are needed, until then their info is NULL.
+    uint32_t offset;
 };
 
 enum AttributeType {
@@ -21,7 +30,8 @@ enum AttributeType {
     ATTR_Code,
     ATTR_LineNumberTable,
     ATTR_Exceptions,
-    ATTR_Deprecated
+    ATTR_Deprecated,
+    ATTR_StackMapTable
 };
 
 typedef struct {
@@ -61,7 +71,7 @@ typedef struct {
     uint16_t catch_type;
 } ExceptionTableEntry;
 
-typedef struct {
+struct att_Code_info {
     uint16_t max_stack;
     uint16_t max_locals;
     uint32_t code_length;
@@ -70,7 +80,70 @@ typedef struct {
     ExceptionTableEntry* exception_table;
     uint16_t attributes_count;
     attribute_info* attributes;
-} att_Code_info;
+
+    // Not part of the class file: register IR translated
+    // from the code when the class is linked, or NULL.
+    IRMethod* ir;
+
+    // Not part of the class file: types of the locals and
+    // operands at each instruction, computed when the class
+    // is linked, or NULL.
+    MethodTypes* types;
+
+    // Not part of the class file: whether the method passed
+    // verification.
+    uint8_t verified;
+
+    // Not part of the class file: whether the type map, register
+    // IR and superinstructions were set up, which happens the
+    // first time the method runs.
+    uint8_t linked;
+
+    // Not part of the class file: 0 until the trace filters are
+    // matched against the method, then 1 if it is traced, 2 if not.
+    uint8_t traced;
+
+    // Not part of the class file: machine code calling the
+    // interpreter for this method, created with "-Xperfmap", or NULL.
+    void* trampoline;
+};
+
+enum VerificationTypeTag {
+    ITEM_Top = 0,
+    ITEM_Integer,
+    ITEM_Float,
+    ITEM_Double,
+    ITEM_Long,
+    ITEM_Null,
+    ITEM_UninitializedThis,
+    ITEM_Object,
+    ITEM_Uninitialized
+};
+
+typedef struct {
+    uint8_t tag;
+
+    // Constant pool index of the class for ITEM_Object, or
+    // offset of the "new" instruction for ITEM_Uninitialized.
+    uint16_t index_or_offset;
+} VerificationTypeInfo;
+
+// Every kind of frame is stored as its offset delta plus the
+// locals and stack items it carries. Chop frames don't carry
+// locals, the number of chopped locals is 251 - frame_type.
+typedef struct {
+    uint8_t frame_type;
+    uint16_t offset_delta;
+    uint16_t number_of_locals;
+    VerificationTypeInfo* locals;
+    uint16_t number_of_stack_items;
+    VerificationTypeInfo* stack;
+} StackMapFrame;
+
+typedef struct {
+    uint16_t number_of_entries;
+    StackMapFrame* entries;
+} att_StackMapTable_info;
 
 typedef struct {
     uint16_t number_of_exceptions;
@@ -78,7 +151,7 @@ typedef struct {
 } att_Exceptions_info;
 
 char readAttribute(JavaClass* jc, attribute_info* entry);
-void freeAttributeInfo(attribute_info* entry);
+uint8_t decodeAttribute(JavaClass* jc, attribute_info* entry);
 void printAttribute(JavaClass* jc, attribute_info* entry, int identationLevel);
 void printAllAttributes(JavaClass* jc);
 attribute_info* getAttributeByType(attribute_info* attributes, uint16_t attributes_length, enum AttributeType type);
@@ -0,0 +1,160 @@
+#include "benchmark.h"
+#include "threads.h"
+#include "memoryinspect.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+// Two-sided 95% quantiles of the Student's t distribution, for 1 to
+// 30 degrees of freedom. More degrees use the normal distribution.
+static const double studentT95[] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+};
+
+/// @brief Mean of samples and half the width of its 95% confidence
+/// interval.
+typedef struct Estimate
+{
+    double mean;
+    double deviation;
+    double margin;
+} Estimate;
+
+static void estimate(const double* samples, uint32_t count, Estimate* result)
+{
+    double sum = 0, squares = 0;
+    uint32_t index;
+
+    for (index = 0; index < count; index++)
+        sum += samples[index];
+
+    result->mean = count ? sum / count : 0;
+
+    for (index = 0; index < count; index++)
+        squares += (samples[index] - result->mean) * (samples[index] - result->mean);
+
+    result->deviation = count > 1 ? sqrt(squares / (count - 1)) : 0;
+
+    if (count < 2)
+        result->margin = 0;
+    else if (count - 1 <= sizeof(studentT95) / sizeof(studentT95[0]))
+        result->margin = studentT95[count - 2] * result->deviation / sqrt(count);
+    else
+        result->margin = 1.960 * result->deviation / sqrt(count);
+}
+
+/// @brief Reads the "static final int OPERATIONS" field of the
+/// benchmark, once its class is initialized.
+/// @return The value of the field, 1 if there is no such field.
+static uint32_t getOperationCount(LoadedClasses* mainClass)
+{
+    const uint8_t name[] = "OPERATIONS";
+    field_info* field = getFieldMatching(mainClass->jc, name, sizeof(name) - 1, (const uint8_t*)"I", 1, ACC_STATIC);
+
+    if (!field || !mainClass->staticFieldsData || mainClass->staticFieldsData[field->offset] <= 0)
+        return 1;
+
+    return (uint32_t)mainClass->staticFieldsData[field->offset];
+}
+
+static void writeResult(JavaVirtualMachine* jvm, FILE* file, const char* name, uint32_t warmupIterations,
+                        uint32_t iterations, uint32_t operations, const double* times, Estimate* time,
+                        Estimate* throughput)
+{
+    uint32_t index;
+
+    fprintf(file, "{\"benchmark\":\"%s\",\"warmup\":%u,\"iterations\":%u,\"operations\":%u,", name, warmupIterations,
+            iterations, operations);
+    fprintf(file, "\"ir\":%s,\"superinstructions\":%s,\"gc\":%s,\"times_ms\":[", jvm->useRegisterIR ? "true" : "false",
+            jvm->useSuperinstructions ? "true" : "false", jvm->collector ? "true" : "false");
+
+    for (index = 0; index < iterations; index++)
+        fprintf(file, "%s%.4f", index ? "," : "", times[index]);
+
+    fprintf(file, "],\"mean_ms\":%.4f,\"stddev_ms\":%.4f,\"mean_ms_ci95\":[%.4f,%.4f],", time->mean, time->deviation,
+            time->mean - time->margin, time->mean + time->margin);
+    fprintf(file, "\"ops_per_s\":%.1f,\"ops_per_s_ci95\":[%.1f,%.1f]}\n", throughput->mean,
+            throughput->mean - throughput->margin, throughput->mean + throughput->margin);
+}
+
+/// @brief Runs the main method of a class again and again, timing the
+/// runs after the warmup.
+///
+/// @param LoadedClasses* mainClass - class resolved by resolveClass().
+/// @param const char* name - name of the benchmark in the results.
+/// @param uint32_t iterations - runs measured, at least 1.
+/// @param const char* path - file the results are appended to.
+///
+/// @return 1 if every run succeeded and the results were written, 0
+/// otherwise. A failing run sets the JVM status, as executeJVM() does.
+uint8_t runBenchmark(JavaVirtualMachine* jvm, LoadedClasses* mainClass, const char* name,
+                     uint32_t warmupIterations, uint32_t iterations, const char* path)
+{
+    double* times;
+    double* rates;
+    double start, mainStartTime = 0;
+    uint32_t operations, index;
+    Estimate time, throughput;
+    FILE* file;
+
+    if (!iterations)
+        iterations = 1;
+
+    times = (double*)malloc(iterations * sizeof(double));
+    rates = (double*)malloc(iterations * sizeof(double));
+
+    if (!times || !rates)
+    {
+        free(times);
+        free(rates);
+        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        return 0;
+    }
+
+    for (index = 0; index < warmupIterations + iterations && jvm->status == JVM_STATUS_OK; index++)
+    {
+        start = getMonotonicTime();
+        executeJVM(jvm, mainClass);
+
+        if (index >= warmupIterations)
+            times[index - warmupIterations] = getMonotonicTime() - start;
+
+        // The startup report shows the first run
+        if (!index)
+            mainStartTime = jvm->mainStartTime;
+    }
+
+    jvm->mainStartTime = mainStartTime;
+
+    if (jvm->status != JVM_STATUS_OK)
+    {
+        free(times);
+        free(rates);
+        return 0;
+    }
+
+    operations = getOperationCount(mainClass);
+
+    for (index = 0; index < iterations; index++)
+        rates[index] = times[index] > 0 ? operations / (times[index] / 1000) : 0;
+
+    estimate(times, iterations, &time);
+    estimate(rates, iterations, &throughput);
+
+    fprintf(stderr, "%s: %.3f ms +- %.3f ms per run, %.0f +- %.0f operations/s (95%% confidence, %u runs after %u warmup)\n",
+            name, time.mean, time.margin, throughput.mean, throughput.margin, iterations, warmupIterations);
+
+    file = fopen(path, "a");
+
+    if (file)
+    {
+        writeResult(jvm, file, name, warmupIterations, iterations, operations, times, &time, &throughput);
+        fclose(file);
+    }
+
+    free(times);
+    free(rates);
+    return file != NULL;
+}
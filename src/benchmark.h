@@ -0,0 +1,38 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <stdint.h>
+#include "jvm.h"
+
+// Iterations run before and while measuring, unless set by
+// "-Xbenchwarmup:<n>" and "-Xbenchiterations:<n>"
+#define BENCHMARK_DEFAULT_WARMUP 3
+#define BENCHMARK_DEFAULT_ITERATIONS 10
+
+uint8_t runBenchmark(JavaVirtualMachine* jvm, LoadedClasses* mainClass, const char* name,
+                     uint32_t warmupIterations, uint32_t iterations, const char* path);
+
+#endif // BENCHMARK_H
+
+/// @defgroup benchmark Benchmark module
+///
+/// @brief Times the main method of a class.
+///
+/// "-Xbench:<file>" runs main BENCHMARK_DEFAULT_WARMUP times without
+/// measuring, then BENCHMARK_DEFAULT_ITERATIONS times, timing each
+/// run. Classes are initialized once, by the first run, so static
+/// fields keep their values from one run to the next.
+///
+/// A benchmark declares how many operations a run of main does with a
+/// "static final int OPERATIONS" field, 1 if it has none. The mean
+/// time per run and the operations per second are printed to stderr
+/// with their 95% confidence intervals, from the Student's t
+/// distribution of the runs, and appended to <file> as a JSON line,
+/// with the time of every run and whether the register IR,
+/// superinstructions and the garbage collector were used.
+///
+/// "make bench" runs the benchmarks of "bench/" and writes
+/// "bench/results.json", and "tools/benchcompare.c" compares the
+/// results of two builds, benchmark by benchmark.
+///
+/// @see runBenchmark()
@@ -0,0 +1,141 @@
+#include "classlist.h"
+#include "memoryinspect.h"
+#include <stdio.h>
+#include <string.h>
+
+/// @brief Creates an empty class list.
+///
+/// @param const char* path - file the list is replayed from and saved
+/// to. The string must outlive the list.
+///
+/// @return The list, to be freed with freeClassList(), or NULL if
+/// there is not enough memory.
+ClassList* newClassList(const char* path)
+{
+    ClassList* list = (ClassList*)malloc(sizeof(ClassList));
+
+    if (list)
+    {
+        list->path = path;
+        list->first = list->last = NULL;
+        list->count = 0;
+        list->replayedCount = 0;
+    }
+
+    return list;
+}
+
+void freeClassList(ClassList* list)
+{
+    ClassListEntry* entry = list->first;
+    ClassListEntry* next;
+
+    while (entry)
+    {
+        next = entry->next;
+        free(entry->name);
+        free(entry);
+        entry = next;
+    }
+
+    free(list);
+}
+
+/// @brief Adds a class to the end of the list.
+///
+/// @param ClassList* list - the list.
+/// @param const uint8_t* className_utf8_bytes - name the class was
+/// resolved with.
+/// @param int32_t utf8_len - length of the name.
+/// @param double loadTime - milliseconds since the JVM was initialized.
+///
+/// @return 1 on success, 0 if there is not enough memory.
+uint8_t recordLoadedClass(ClassList* list, const uint8_t* className_utf8_bytes, int32_t utf8_len, double loadTime)
+{
+    ClassListEntry* entry = (ClassListEntry*)malloc(sizeof(ClassListEntry));
+
+    if (!entry)
+        return 0;
+
+    entry->name = (uint8_t*)malloc(utf8_len > 0 ? utf8_len : 1);
+
+    if (!entry->name)
+    {
+        free(entry);
+        return 0;
+    }
+
+    memcpy(entry->name, className_utf8_bytes, utf8_len);
+    entry->nameLength = utf8_len;
+    entry->loadTime = loadTime;
+    entry->next = NULL;
+
+    if (list->last)
+        list->last->next = entry;
+    else
+        list->first = entry;
+
+    list->last = entry;
+    list->count++;
+
+    return 1;
+}
+
+/// @brief Queues the classes of the list saved by a previous run to
+/// be parsed by the class loader workers, in the order they were loaded.
+///
+/// @param ClassList* list - the list, whose file is read.
+/// @param ClassPrefetcher* prefetcher - the workers to queue the
+/// classes to.
+///
+/// @return The number of classes queued. A missing file isn't an
+/// error, the list just hasn't been saved yet.
+uint32_t replayClassList(ClassList* list, ClassPrefetcher* prefetcher)
+{
+    FILE* file = fopen(list->path, "r");
+    char line[1024];
+    char* name;
+    size_t nameLength;
+
+    if (!file)
+        return 0;
+
+    while (fgets(line, sizeof(line), file))
+    {
+        if (line[0] == '#' || !(name = strchr(line, '\t')))
+            continue;
+
+        name++;
+        nameLength = strcspn(name, "\r\n");
+
+        if (nameLength > 0)
+        {
+            prefetchClass(prefetcher, (const uint8_t*)name, (int32_t)nameLength);
+            list->replayedCount++;
+        }
+    }
+
+    fclose(file);
+    return list->replayedCount;
+}
+
+/// @brief Writes the classes loaded by this run to the file of the
+/// list, replacing the list of the previous run.
+///
+/// @return 1 if the file could be written, 0 otherwise.
+uint8_t saveClassList(ClassList* list)
+{
+    ClassListEntry* entry;
+    FILE* file = fopen(list->path, "w");
+
+    if (!file)
+        return 0;
+
+    fprintf(file, "# Classes loaded by a run, in load order\n");
+    fprintf(file, "# milliseconds\tclass\n");
+
+    for (entry = list->first; entry; entry = entry->next)
+        fprintf(file, "%.3f\t%.*s\n", entry->loadTime, (int)entry->nameLength, entry->name);
+
+    return fclose(file) == 0;
+}
@@ -0,0 +1,58 @@
+#ifndef CLASSLIST_H
+#define CLASSLIST_H
+
+typedef struct ClassList ClassList;
+
+#include <stdint.h>
+#include "classprefetch.h"
+
+/// @brief A class loaded during the run, and when.
+typedef struct ClassListEntry
+{
+    uint8_t* name;
+    int32_t nameLength;
+
+    // Milliseconds since the JVM was initialized
+    double loadTime;
+
+    struct ClassListEntry* next;
+} ClassListEntry;
+
+/// @brief The classes loaded by a run, in the order they were loaded.
+struct ClassList
+{
+    const char* path;
+
+    ClassListEntry* first;
+    ClassListEntry* last;
+    uint32_t count;
+
+    // Number of classes queued from the list saved by a previous run
+    uint32_t replayedCount;
+};
+
+ClassList* newClassList(const char* path);
+void freeClassList(ClassList* list);
+uint8_t recordLoadedClass(ClassList* list, const uint8_t* className_utf8_bytes, int32_t utf8_len, double loadTime);
+uint32_t replayClassList(ClassList* list, ClassPrefetcher* prefetcher);
+uint8_t saveClassList(ClassList* list);
+
+#endif // CLASSLIST_H
+
+/// @defgroup classlist Class list module
+///
+/// @brief Records the classes a program loads, so the next run can
+/// parse them before they are needed.
+///
+/// With "-Xclasslist:<file>", the classes loaded by the run are written
+/// to the file when the program ends, one per line as
+/// "milliseconds<TAB>name", in load order. If the file already exists
+/// when the JVM starts, its classes are queued to the class loader
+/// workers in that order, so they are usually parsed by the time
+/// resolveClass() asks for them.
+///
+/// A stale list only costs some parsing: classes in it that are never
+/// used are parsed and thrown away, and classes missing from it are
+/// opened when needed, as usual.
+///
+/// @see recordLoadedClass(), replayClassList(), @ref classprefetch
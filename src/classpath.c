@@ -0,0 +1,529 @@
+#include "classpath.h"
+#include "memoryinspect.h"
+#include <string.h>
+#include <stdio.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
+struct NameSetEntry
+{
+    char* name;
+    uint32_t length;
+    uint32_t hash;
+    uint32_t next;
+};
+
+#define NAMESET_NO_ENTRY 0xFFFFFFFF
+
+static uint32_t hashName(const char* name, uint32_t length)
+{
+    uint32_t hash = 2166136261u;
+
+    while (length--)
+    {
+        hash ^= (uint8_t)*name++;
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+static void initNameSet(NameSet* set)
+{
+    set->entries = NULL;
+    set->count = 0;
+    set->capacity = 0;
+    set->buckets = NULL;
+    set->bucketCount = 0;
+}
+
+static void freeNameSet(NameSet* set)
+{
+    uint32_t index;
+
+    for (index = 0; index < set->count; index++)
+        free(set->entries[index].name);
+
+    if (set->entries)
+        free(set->entries);
+
+    if (set->buckets)
+        free(set->buckets);
+
+    initNameSet(set);
+}
+
+static uint8_t containsName(NameSet* set, const char* name, uint32_t length)
+{
+    uint32_t hash, index;
+    struct NameSetEntry* entry;
+
+    if (set->count == 0)
+        return 0;
+
+    hash = hashName(name, length);
+    index = set->buckets[hash & (set->bucketCount - 1)];
+
+    while (index != NAMESET_NO_ENTRY)
+    {
+        entry = set->entries + index;
+
+        if (entry->hash == hash && entry->length == length && !memcmp(entry->name, name, length))
+            return 1;
+
+        index = entry->next;
+    }
+
+    return 0;
+}
+
+/// @brief Doubles the capacity of a set, rebuilding its hash chains.
+static uint8_t growNameSet(NameSet* set)
+{
+    uint32_t capacity = set->capacity ? set->capacity * 2 : 64;
+    struct NameSetEntry* entries = (struct NameSetEntry*)malloc(sizeof(struct NameSetEntry) * capacity);
+    uint32_t* buckets = (uint32_t*)malloc(sizeof(uint32_t) * capacity * 2);
+    uint32_t index, bucket;
+
+    if (!entries || !buckets)
+    {
+        if (entries)
+            free(entries);
+
+        if (buckets)
+            free(buckets);
+
+        return 0;
+    }
+
+    if (set->entries)
+    {
+        memcpy(entries, set->entries, sizeof(struct NameSetEntry) * set->count);
+        free(set->entries);
+        free(set->buckets);
+    }
+
+    set->entries = entries;
+    set->capacity = capacity;
+    set->buckets = buckets;
+    set->bucketCount = capacity * 2;
+
+    for (index = 0; index < set->bucketCount; index++)
+        buckets[index] = NAMESET_NO_ENTRY;
+
+    for (index = 0; index < set->count; index++)
+    {
+        bucket = entries[index].hash & (set->bucketCount - 1);
+        entries[index].next = buckets[bucket];
+        buckets[bucket] = index;
+    }
+
+    return 1;
+}
+
+static void addName(NameSet* set, const char* name, uint32_t length)
+{
+    struct NameSetEntry* entry;
+    uint32_t bucket;
+
+    if (set->count == set->capacity && !growNameSet(set))
+        return;
+
+    entry = set->entries + set->count;
+    entry->name = (char*)malloc(length ? length : 1);
+
+    if (!entry->name)
+        return;
+
+    memcpy(entry->name, name, length);
+    entry->length = length;
+    entry->hash = hashName(name, length);
+
+    bucket = entry->hash & (set->bucketCount - 1);
+    entry->next = set->buckets[bucket];
+    set->buckets[bucket] = set->count++;
+}
+
+/// @brief Adds the .class files of a directory of a class path entry
+/// to its set of files, as "<directory><file name>".
+/// @param ClassPathEntry* entry - the class path entry.
+/// @param const char* directory - the directory, relative to the
+/// entry, empty or ending with a slash.
+/// @param uint32_t length - length of the directory.
+static void listDirectory(ClassPathEntry* entry, const char* directory, uint32_t length)
+{
+    char path[1024];
+    char name[1024];
+    size_t nameLength;
+
+    addName(&entry->listedDirectories, directory, length);
+
+#ifdef _WIN32
+    WIN32_FIND_DATAA data;
+    HANDLE find;
+
+    snprintf(path, sizeof(path), "%s%.*s*.class", entry->path, (int)length, directory);
+    find = FindFirstFileA(path, &data);
+
+    if (find == INVALID_HANDLE_VALUE)
+        return;
+
+    do {
+        if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            continue;
+
+        nameLength = (size_t)snprintf(name, sizeof(name), "%.*s%s", (int)length, directory, data.cFileName);
+
+        if (nameLength < sizeof(name))
+            addName(&entry->files, name, (uint32_t)nameLength);
+
+    } while (FindNextFileA(find, &data));
+
+    FindClose(find);
+#else
+    DIR* dir;
+    struct dirent* file;
+    size_t fileNameLength;
+
+    snprintf(path, sizeof(path), "%s%.*s", entry->path, (int)length, directory);
+    dir = opendir(path[0] ? path : ".");
+
+    if (!dir)
+        return;
+
+    while ((file = readdir(dir)))
+    {
+        fileNameLength = strlen(file->d_name);
+
+        if (fileNameLength <= 6 || strcmp(file->d_name + fileNameLength - 6, ".class"))
+            continue;
+
+        nameLength = (size_t)snprintf(name, sizeof(name), "%.*s%s", (int)length, directory, file->d_name);
+
+        if (nameLength < sizeof(name))
+            addName(&entry->files, name, (uint32_t)nameLength);
+    }
+
+    closedir(dir);
+#endif
+}
+
+/// @brief Checks if a class file is in a directory class path entry,
+/// listing its package directory the first time it is needed.
+/// @param const char* fileName - the class name followed by ".class".
+static uint8_t directoryHasFile(ClassPathEntry* entry, const char* fileName, uint32_t length)
+{
+    uint32_t directoryLength = length;
+
+    while (directoryLength > 0 && fileName[directoryLength - 1] != '/' && fileName[directoryLength - 1] != '\\')
+        directoryLength--;
+
+    if (!containsName(&entry->listedDirectories, fileName, directoryLength))
+        listDirectory(entry, fileName, directoryLength);
+
+    return containsName(&entry->files, fileName, length);
+}
+
+void initClassPath(ClassPath* classPath)
+{
+    classPath->entries = NULL;
+    classPath->count = 0;
+    initNameSet(&classPath->missingClasses);
+    initMutex(&classPath->lock);
+}
+
+static uint8_t isJarPath(const char* path, size_t length)
+{
+    const char* extension = path + length - 4;
+
+    if (length < 4)
+        return 0;
+
+    return !strcmp(extension, ".jar") || !strcmp(extension, ".zip") ||
+           !strcmp(extension, ".JAR") || !strcmp(extension, ".ZIP");
+}
+
+/// @brief Adds a directory or jar file after the entries already
+/// in the class path.
+///
+/// @param ClassPath* classPath - the class path.
+/// @param const char* path - the directory or jar file. An empty
+/// path is the working directory.
+/// @param size_t length - length of the path.
+///
+/// @return 1 in case of success, 0 if a jar couldn't be opened.
+uint8_t addClassPathEntry(ClassPath* classPath, const char* path, size_t length)
+{
+    ClassPathEntry* entries;
+    ClassPathEntry* entry;
+
+    entries = (ClassPathEntry*)malloc(sizeof(ClassPathEntry) * (classPath->count + 1));
+
+    if (!entries)
+        return 0;
+
+    if (classPath->entries)
+    {
+        memcpy(entries, classPath->entries, sizeof(ClassPathEntry) * classPath->count);
+        free(classPath->entries);
+    }
+
+    classPath->entries = entries;
+    entry = entries + classPath->count;
+
+    // Room for a slash at the end of directories
+    entry->path = (char*)malloc(length + 2);
+    entry->jar = NULL;
+    initNameSet(&entry->listedDirectories);
+    initNameSet(&entry->files);
+
+    if (!entry->path)
+        return 0;
+
+    memcpy(entry->path, path, length);
+    entry->path[length] = '\0';
+
+    if (isJarPath(entry->path, length))
+    {
+        entry->jar = (JarFile*)malloc(sizeof(JarFile));
+
+        if (!entry->jar || !openJarFile(entry->jar, entry->path))
+        {
+            if (entry->jar)
+            {
+                closeJarFile(entry->jar);
+                free(entry->jar);
+            }
+
+            free(entry->path);
+            return 0;
+        }
+    }
+    else if (length > 0 && path[length - 1] != '/' && path[length - 1] != '\\')
+    {
+        entry->path[length] = '/';
+        entry->path[length + 1] = '\0';
+    }
+
+    // A new entry may have classes that were missing so far
+    freeNameSet(&classPath->missingClasses);
+
+    classPath->count++;
+    return 1;
+}
+
+/// @brief Adds the entries of a class path list, such as
+/// "classes:lib/a.jar", after the entries already in the class path.
+///
+/// @param ClassPath* classPath - the class path.
+/// @param const char* list - entries separated by CLASSPATH_SEPARATOR.
+///
+/// @return 1 if all entries were added, 0 if a jar couldn't be opened,
+/// in which case it is left out.
+uint8_t addClassPathEntries(ClassPath* classPath, const char* list)
+{
+    static const char separator[] = {CLASSPATH_SEPARATOR, '\0'};
+
+    uint8_t success = 1;
+    size_t length;
+
+    while (*list)
+    {
+        length = strcspn(list, separator);
+
+        if (length > 0 && !addClassPathEntry(classPath, list, length))
+        {
+            printf("Couldn't open class path entry '%.*s'\n", (int)length, list);
+            success = 0;
+        }
+
+        list += length;
+
+        if (*list)
+            list++;
+    }
+
+    return success;
+}
+
+void freeClassPath(ClassPath* classPath)
+{
+    uint16_t index;
+    ClassPathEntry* entry;
+
+    for (index = 0; index < classPath->count; index++)
+    {
+        entry = classPath->entries + index;
+
+        if (entry->jar)
+        {
+            closeJarFile(entry->jar);
+            free(entry->jar);
+        }
+
+        freeNameSet(&entry->listedDirectories);
+        freeNameSet(&entry->files);
+        free(entry->path);
+    }
+
+    if (classPath->entries)
+        free(classPath->entries);
+
+    freeNameSet(&classPath->missingClasses);
+    destroyMutex(&classPath->lock);
+
+    classPath->entries = NULL;
+    classPath->count = 0;
+}
+
+/// @brief Finds the first class path entry, from \c firstEntry on,
+/// that has a class file.
+/// @param const char* fileName - the class name followed by ".class".
+/// @param [out] JarEntry** outJarEntry - the entry in the jar, if the
+/// class path entry is a jar.
+/// @return Index of the class path entry, or -1 if none has the class.
+/// @note Must be called with the class path locked.
+static int32_t findClassEntry(ClassPath* classPath, uint16_t firstEntry, const char* fileName, uint32_t length, JarEntry** outJarEntry)
+{
+    uint16_t index;
+    ClassPathEntry* entry;
+
+    for (index = firstEntry; index < classPath->count; index++)
+    {
+        entry = classPath->entries + index;
+
+        if (entry->jar)
+        {
+            *outJarEntry = findJarEntry(entry->jar, (const uint8_t*)fileName, length);
+
+            if (*outJarEntry)
+                return index;
+        }
+        else if (directoryHasFile(entry, fileName, length))
+        {
+            *outJarEntry = NULL;
+            return index;
+        }
+    }
+
+    return -1;
+}
+
+/// @brief Opens a class from the first class path entry having it.
+///
+/// Classes in jars are parsed directly from the jar: stored entries
+/// from its mapping, compressed ones from the buffer they are
+/// inflated into, which the class then owns.
+///
+/// @param ClassPath* classPath - the class path.
+/// @param JavaClass* jc - receives the class. If no entry has the
+/// class, it is left empty with CLASS_STATUS_FILE_COULDNT_BE_OPENED.
+/// @param const uint8_t* className_utf8_bytes - the class name, such
+/// as "java/lang/Object".
+/// @param int32_t utf8_len - length of the class name.
+///
+/// @return 1 if the class was found, 0 otherwise.
+uint8_t openClassFromClassPath(ClassPath* classPath, JavaClass* jc, const uint8_t* className_utf8_bytes, int32_t utf8_len)
+{
+    char fileName[1024];
+    char path[2048];
+    int32_t index = -1;
+    ClassPathEntry* entry;
+    JarEntry* jarEntry;
+    uint8_t* data;
+    uint8_t allocated;
+    int length;
+
+    initJavaClass(jc);
+    jc->status = CLASS_STATUS_FILE_COULDNT_BE_OPENED;
+
+    length = snprintf(fileName, sizeof(fileName), "%.*s.class", utf8_len, className_utf8_bytes);
+
+    if (length < 0 || (size_t)length >= sizeof(fileName))
+        return 0;
+
+    // Only the lookup is locked, classes are read and parsed in parallel
+    lockMutex(&classPath->lock);
+
+    if (containsName(&classPath->missingClasses, (const char*)className_utf8_bytes, (uint32_t)utf8_len))
+    {
+        unlockMutex(&classPath->lock);
+        return 0;
+    }
+
+    while ((index = findClassEntry(classPath, (uint16_t)(index + 1), fileName, (uint32_t)length, &jarEntry)) >= 0)
+    {
+        unlockMutex(&classPath->lock);
+        entry = classPath->entries + index;
+
+        if (jarEntry)
+        {
+            data = readJarEntry(entry->jar, jarEntry, &allocated);
+
+            if (!data)
+                return 0;
+
+            openClassData(jc, fileName, data, jarEntry->uncompressedSize, allocated ? CLASS_FILE_ALLOCATED : CLASS_FILE_BORROWED, 0);
+            return 1;
+        }
+
+        snprintf(path, sizeof(path), "%s%s", entry->path, fileName);
+        openClassFile(jc, path);
+
+        // The file may have been removed since it was listed
+        if (jc->status != CLASS_STATUS_FILE_COULDNT_BE_OPENED)
+            return 1;
+
+        lockMutex(&classPath->lock);
+    }
+
+    addName(&classPath->missingClasses, (const char*)className_utf8_bytes, (uint32_t)utf8_len);
+    unlockMutex(&classPath->lock);
+    return 0;
+}
+
+/// @brief Gets the file a class would be loaded from: its class file,
+/// or the jar file containing it.
+///
+/// @param ClassPath* classPath - the class path.
+/// @param const uint8_t* className_utf8_bytes - the class name.
+/// @param int32_t utf8_len - length of the class name.
+/// @param [out] char* outPath - receives the path of the file.
+/// @param size_t size - size of the outPath buffer.
+///
+/// @return 1 if the class was found, 0 otherwise.
+uint8_t getClassSource(ClassPath* classPath, const uint8_t* className_utf8_bytes, int32_t utf8_len, char* outPath, size_t size)
+{
+    char fileName[1024];
+    JarEntry* jarEntry;
+    int32_t index;
+    int length;
+
+    length = snprintf(fileName, sizeof(fileName), "%.*s.class", utf8_len, className_utf8_bytes);
+
+    if (length < 0 || (size_t)length >= sizeof(fileName))
+        return 0;
+
+    lockMutex(&classPath->lock);
+
+    if (containsName(&classPath->missingClasses, (const char*)className_utf8_bytes, (uint32_t)utf8_len))
+        index = -1;
+    else
+        index = findClassEntry(classPath, 0, fileName, (uint32_t)length, &jarEntry);
+
+    unlockMutex(&classPath->lock);
+
+    if (index < 0)
+        return 0;
+
+    if (jarEntry)
+        length = snprintf(outPath, size, "%s", classPath->entries[index].path);
+    else
+        length = snprintf(outPath, size, "%s%s", classPath->entries[index].path, fileName);
+
+    return length >= 0 && (size_t)length < size;
+}
@@ -0,0 +1,83 @@
+#ifndef CLASSPATH_H
+#define CLASSPATH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "javaclass.h"
+#include "jarfile.h"
+#include "threads.h"
+
+#ifdef _WIN32
+#define CLASSPATH_SEPARATOR ';'
+#else
+#define CLASSPATH_SEPARATOR ':'
+#endif
+
+/// @brief A set of names, used to cache directory listings and
+/// lookup misses.
+typedef struct NameSet
+{
+    struct NameSetEntry* entries;
+    uint32_t count;
+    uint32_t capacity;
+
+    // Power of two number of hash chains
+    uint32_t* buckets;
+    uint32_t bucketCount;
+} NameSet;
+
+typedef struct ClassPathEntry
+{
+    // Directory, empty or ending with a slash, or path of a jar file
+    char* path;
+
+    // The opened jar, or NULL for directories
+    JarFile* jar;
+
+    // Directories, relative to the entry, whose listing has been
+    // read, and the .class files found in them
+    NameSet listedDirectories;
+    NameSet files;
+} ClassPathEntry;
+
+typedef struct ClassPath
+{
+    ClassPathEntry* entries;
+    uint16_t count;
+
+    // Classes that no entry has
+    NameSet missingClasses;
+
+    // Guards the cached listings and misses, as classes are looked
+    // up by class loader workers too. Entries must all be added
+    // before any lookup.
+    Mutex lock;
+} ClassPath;
+
+void initClassPath(ClassPath* classPath);
+uint8_t addClassPathEntry(ClassPath* classPath, const char* path, size_t length);
+uint8_t addClassPathEntries(ClassPath* classPath, const char* list);
+void freeClassPath(ClassPath* classPath);
+uint8_t openClassFromClassPath(ClassPath* classPath, JavaClass* jc, const uint8_t* className_utf8_bytes, int32_t utf8_len);
+uint8_t getClassSource(ClassPath* classPath, const uint8_t* className_utf8_bytes, int32_t utf8_len, char* outPath, size_t size);
+
+#endif // CLASSPATH_H
+
+/// @defgroup classpath Class path module
+///
+/// @brief Finds class files in the working directory, the directory
+/// of the main class and the directories and jar files given with
+/// "-cp", in that order.
+///
+/// Entries of "-cp" are separated by CLASSPATH_SEPARATOR. Entries
+/// ending with ".jar" or ".zip" are opened once and indexed, see
+/// @ref jarfile; others are directories.
+///
+/// Lookups don't touch the file system unless a class is there: the
+/// first time a package directory of an entry is needed, its .class
+/// files are listed once into a set. Class names that no entry has
+/// are remembered, so looking them up again costs a single hash
+/// lookup. Class files added to a directory after it was listed
+/// aren't seen.
+///
+/// @see openClassFromClassPath()
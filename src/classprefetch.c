@@ -0,0 +1,366 @@
+#include "classprefetch.h"
+#include "threads.h"
+#include "memoryinspect.h"
+#include <string.h>
+
+// Power of two number of hash chains of the class table
+#define PREFETCH_BUCKET_COUNT 256
+
+enum PrefetchState {
+    PREFETCH_QUEUED,
+    PREFETCH_PARSING,
+    PREFETCH_PARSED,
+
+    // Taken by the main thread, or opened by it instead
+    PREFETCH_TAKEN
+};
+
+typedef struct PrefetchedClass
+{
+    uint8_t* name;
+    int32_t nameLength;
+    uint8_t state;
+
+    // The parsed class, set when the state is PREFETCH_PARSED
+    JavaClass* jc;
+
+    struct PrefetchedClass* nextInBucket;
+    struct PrefetchedClass* nextQueued;
+} PrefetchedClass;
+
+struct ClassPrefetcher
+{
+    JavaVirtualMachine* jvm;
+
+    // Guards everything below
+    Mutex lock;
+    Condition classQueued;
+    Condition classParsed;
+
+    Thread* threads;
+    uint32_t threadCount;
+
+    // Every class ever queued or taken, so none is parsed twice
+    PrefetchedClass* buckets[PREFETCH_BUCKET_COUNT];
+
+    PrefetchedClass* queueHead;
+    PrefetchedClass* queueTail;
+
+    uint8_t stopping;
+    uint32_t parsedCount;
+    uint32_t usedCount;
+};
+
+static uint32_t hashClassName(const uint8_t* name, int32_t length)
+{
+    uint32_t hash = 2166136261u;
+
+    while (length-- > 0)
+    {
+        hash ^= *name++;
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+/// @note Must be called with the prefetcher locked.
+static PrefetchedClass* findPrefetchedClass(ClassPrefetcher* prefetcher, const uint8_t* name, int32_t length)
+{
+    PrefetchedClass* entry = prefetcher->buckets[hashClassName(name, length) & (PREFETCH_BUCKET_COUNT - 1)];
+
+    while (entry && (entry->nameLength != length || memcmp(entry->name, name, length)))
+        entry = entry->nextInBucket;
+
+    return entry;
+}
+
+/// @note Must be called with the prefetcher locked.
+static PrefetchedClass* addPrefetchedClass(ClassPrefetcher* prefetcher, const uint8_t* name, int32_t length, uint8_t state)
+{
+    PrefetchedClass* entry = (PrefetchedClass*)malloc(sizeof(PrefetchedClass));
+    PrefetchedClass** bucket = prefetcher->buckets + (hashClassName(name, length) & (PREFETCH_BUCKET_COUNT - 1));
+
+    if (!entry)
+        return NULL;
+
+    entry->name = (uint8_t*)malloc(length > 0 ? length : 1);
+
+    if (!entry->name)
+    {
+        free(entry);
+        return NULL;
+    }
+
+    memcpy(entry->name, name, length);
+    entry->nameLength = length;
+    entry->state = state;
+    entry->jc = NULL;
+    entry->nextQueued = NULL;
+    entry->nextInBucket = *bucket;
+    *bucket = entry;
+
+    return entry;
+}
+
+static void runWorker(void* argument)
+{
+    ClassPrefetcher* prefetcher = (ClassPrefetcher*)argument;
+    PrefetchedClass* entry;
+    JavaClass* jc;
+
+    lockMutex(&prefetcher->lock);
+
+    for (;;)
+    {
+        while (!prefetcher->stopping && !prefetcher->queueHead)
+            waitCondition(&prefetcher->classQueued, &prefetcher->lock);
+
+        if (prefetcher->stopping)
+            break;
+
+        entry = prefetcher->queueHead;
+        prefetcher->queueHead = entry->nextQueued;
+
+        if (!prefetcher->queueHead)
+            prefetcher->queueTail = NULL;
+
+        // The main thread may have needed it first
+        if (entry->state != PREFETCH_QUEUED)
+            continue;
+
+        entry->state = PREFETCH_PARSING;
+        unlockMutex(&prefetcher->lock);
+
+        jc = (JavaClass*)malloc(sizeof(JavaClass));
+
+        if (jc)
+            loadClassFile(prefetcher->jvm, jc, entry->name, entry->nameLength);
+
+        lockMutex(&prefetcher->lock);
+
+        if (jc)
+        {
+            entry->jc = jc;
+            entry->state = PREFETCH_PARSED;
+            prefetcher->parsedCount += jc->status == CLASS_STATUS_OK;
+        }
+        else
+        {
+            entry->state = PREFETCH_TAKEN;
+        }
+
+        broadcastCondition(&prefetcher->classParsed);
+    }
+
+    unlockMutex(&prefetcher->lock);
+}
+
+/// @brief Starts the worker threads that parse classes ahead of
+/// the JVM.
+///
+/// The class path and the shared archive of the JVM must be set up
+/// before, as the workers read classes from them.
+///
+/// @param JavaVirtualMachine* jvm - the JVM the classes are for.
+/// @param uint32_t threadCount - number of worker threads.
+///
+/// @return The prefetcher, to be freed with freeClassPrefetcher(), or
+/// NULL if no worker could be started.
+ClassPrefetcher* newClassPrefetcher(JavaVirtualMachine* jvm, uint32_t threadCount)
+{
+    ClassPrefetcher* prefetcher;
+    uint32_t index;
+
+    if (threadCount == 0)
+        return NULL;
+
+    prefetcher = (ClassPrefetcher*)malloc(sizeof(ClassPrefetcher));
+
+    if (!prefetcher)
+        return NULL;
+
+    prefetcher->threads = (Thread*)malloc(threadCount * sizeof(Thread));
+
+    if (!prefetcher->threads)
+    {
+        free(prefetcher);
+        return NULL;
+    }
+
+    prefetcher->jvm = jvm;
+    prefetcher->threadCount = 0;
+    prefetcher->queueHead = prefetcher->queueTail = NULL;
+    prefetcher->stopping = 0;
+    prefetcher->parsedCount = 0;
+    prefetcher->usedCount = 0;
+
+    for (index = 0; index < PREFETCH_BUCKET_COUNT; index++)
+        prefetcher->buckets[index] = NULL;
+
+    initMutex(&prefetcher->lock);
+    initCondition(&prefetcher->classQueued);
+    initCondition(&prefetcher->classParsed);
+
+    for (index = 0; index < threadCount; index++)
+    {
+        if (!startThread(prefetcher->threads + index, runWorker, prefetcher))
+            break;
+
+        prefetcher->threadCount++;
+    }
+
+    if (prefetcher->threadCount == 0)
+    {
+        freeClassPrefetcher(prefetcher);
+        return NULL;
+    }
+
+    return prefetcher;
+}
+
+/// @brief Stops the workers, after they finish the classes they
+/// are parsing. Classes queued but not started are left alone.
+///
+/// Nothing else is released, so the process can exit right after.
+///
+/// @see freeClassPrefetcher()
+void stopClassPrefetcher(ClassPrefetcher* prefetcher)
+{
+    uint32_t index;
+
+    lockMutex(&prefetcher->lock);
+    prefetcher->stopping = 1;
+    broadcastCondition(&prefetcher->classQueued);
+    unlockMutex(&prefetcher->lock);
+
+    for (index = 0; index < prefetcher->threadCount; index++)
+        joinThread(prefetcher->threads[index]);
+
+    prefetcher->threadCount = 0;
+}
+
+/// @brief Stops the workers and closes the classes they parsed
+/// that were never taken.
+void freeClassPrefetcher(ClassPrefetcher* prefetcher)
+{
+    PrefetchedClass* entry;
+    PrefetchedClass* next;
+    uint32_t index;
+
+    stopClassPrefetcher(prefetcher);
+
+    for (index = 0; index < PREFETCH_BUCKET_COUNT; index++)
+    {
+        for (entry = prefetcher->buckets[index]; entry; entry = next)
+        {
+            next = entry->nextInBucket;
+
+            if (entry->jc)
+            {
+                closeClassFile(entry->jc);
+                free(entry->jc);
+            }
+
+            free(entry->name);
+            free(entry);
+        }
+    }
+
+    destroyCondition(&prefetcher->classQueued);
+    destroyCondition(&prefetcher->classParsed);
+    destroyMutex(&prefetcher->lock);
+    free(prefetcher->threads);
+    free(prefetcher);
+}
+
+/// @brief Queues a class to be parsed by a worker.
+///
+/// Nothing is done if the class has already been queued or taken.
+///
+/// @param ClassPrefetcher* prefetcher - the prefetcher.
+/// @param const uint8_t* className_utf8_bytes - the class name, such
+/// as "java/lang/Object".
+/// @param int32_t utf8_len - length of the class name.
+void prefetchClass(ClassPrefetcher* prefetcher, const uint8_t* className_utf8_bytes, int32_t utf8_len)
+{
+    PrefetchedClass* entry;
+
+    lockMutex(&prefetcher->lock);
+
+    if (!findPrefetchedClass(prefetcher, className_utf8_bytes, utf8_len))
+    {
+        entry = addPrefetchedClass(prefetcher, className_utf8_bytes, utf8_len, PREFETCH_QUEUED);
+
+        if (entry)
+        {
+            if (prefetcher->queueTail)
+                prefetcher->queueTail->nextQueued = entry;
+            else
+                prefetcher->queueHead = entry;
+
+            prefetcher->queueTail = entry;
+            signalCondition(&prefetcher->classQueued);
+        }
+    }
+
+    unlockMutex(&prefetcher->lock);
+}
+
+/// @brief Gets a class parsed by a worker.
+///
+/// If a worker is parsing the class, this waits until it is done.
+/// Either way, the class is never handed out by the prefetcher
+/// again, and queuing it has no effect anymore.
+///
+/// @param ClassPrefetcher* prefetcher - the prefetcher.
+/// @param const uint8_t* className_utf8_bytes - the class name.
+/// @param int32_t utf8_len - length of the class name.
+/// @param JavaClass* jc - receives the class, as it would have been
+/// opened by loadClassFile(), including its status.
+///
+/// @return 1 if the class was given, 0 if it wasn't parsed by a
+/// worker and the caller must open it.
+uint8_t takePrefetchedClass(ClassPrefetcher* prefetcher, const uint8_t* className_utf8_bytes, int32_t utf8_len, JavaClass* jc)
+{
+    PrefetchedClass* entry;
+    uint8_t taken = 0;
+
+    lockMutex(&prefetcher->lock);
+
+    entry = findPrefetchedClass(prefetcher, className_utf8_bytes, utf8_len);
+
+    if (!entry)
+    {
+        addPrefetchedClass(prefetcher, className_utf8_bytes, utf8_len, PREFETCH_TAKEN);
+    }
+    else
+    {
+        while (entry->state == PREFETCH_PARSING)
+            waitCondition(&prefetcher->classParsed, &prefetcher->lock);
+
+        if (entry->state == PREFETCH_PARSED)
+        {
+            *jc = *entry->jc;
+            free(entry->jc);
+            entry->jc = NULL;
+            prefetcher->usedCount++;
+            taken = 1;
+        }
+
+        entry->state = PREFETCH_TAKEN;
+    }
+
+    unlockMutex(&prefetcher->lock);
+    return taken;
+}
+
+/// @brief Gets how many classes the workers parsed, and how many of
+/// them were taken by the JVM.
+void getPrefetchStatistics(ClassPrefetcher* prefetcher, uint32_t* outParsed, uint32_t* outUsed)
+{
+    lockMutex(&prefetcher->lock);
+    *outParsed = prefetcher->parsedCount;
+    *outUsed = prefetcher->usedCount;
+    unlockMutex(&prefetcher->lock);
+}
@@ -0,0 +1,40 @@
+#ifndef CLASSPREFETCH_H
+#define CLASSPREFETCH_H
+
+#include <stdint.h>
+
+typedef struct ClassPrefetcher ClassPrefetcher;
+
+#include "jvm.h"
+
+ClassPrefetcher* newClassPrefetcher(JavaVirtualMachine* jvm, uint32_t threadCount);
+void stopClassPrefetcher(ClassPrefetcher* prefetcher);
+void freeClassPrefetcher(ClassPrefetcher* prefetcher);
+void prefetchClass(ClassPrefetcher* prefetcher, const uint8_t* className_utf8_bytes, int32_t utf8_len);
+uint8_t takePrefetchedClass(ClassPrefetcher* prefetcher, const uint8_t* className_utf8_bytes, int32_t utf8_len, JavaClass* jc);
+void getPrefetchStatistics(ClassPrefetcher* prefetcher, uint32_t* outParsed, uint32_t* outUsed);
+
+#endif // CLASSPREFETCH_H
+
+/// @defgroup classprefetch Class prefetch module
+///
+/// @brief Reads and parses classes on worker threads before the
+/// JVM asks for them.
+///
+/// When a class is loaded, its superclass, its interfaces and the
+/// classes named in its constant pool are queued. Workers take them
+/// from the queue and open them from the shared archive or the class
+/// path, which includes mapping or inflating the file, parsing it
+/// and checking its constant pool.
+///
+/// Only that speculative parsing runs on the workers. resolveClass()
+/// still resolves, verifies and links classes on the main thread, in
+/// the same order as without workers, taking the parsed class when
+/// it gets to it. A class that is still queued is parsed by the main
+/// thread, one being parsed is waited for. Classes that were never
+/// needed are closed when the JVM ends.
+///
+/// The number of workers is set with "-Xloaderthreads:<n>", and 0
+/// disables them.
+///
+/// @see prefetchClass(), takePrefetchedClass()
@@ -166,37 +166,20 @@ char readConstantPool_Utf8(JavaClass* jc, cp_info* entry)
 
     if (entry->Utf8.length > 0)
     {
-        entry->Utf8.bytes = (uint8_t*)malloc(entry->Utf8.length);
+        // The string points into the mapping of the class file
+        entry->Utf8.bytes = readBytes(jc, entry->Utf8.length);
 
         if (!entry->Utf8.bytes)
         {
-            jc->status = MEMORY_ALLOCATION_FAILED;
+            jc->status = UNEXPECTED_EOF_READING_UTF8;
             return 0;
         }
 
-        uint16_t i;
-        uint8_t* bytes = entry->Utf8.bytes;
-
-        for (i = 0; i < entry->Utf8.length; i++)
+        // UTF-8 byte values can't be null and must not be in the range [0xF0, 0xFF].
+        if (!jc->trusted && !hasValidUTF8Bytes(entry->Utf8.bytes, entry->Utf8.length))
         {
-            int byte = fgetc(jc->file);
-
-            if (byte == EOF)
-            {
-                jc->status = UNEXPECTED_EOF_READING_UTF8;
-                return 0;
-            }
-
-            jc->totalBytesRead++;
-
-            // UTF-8 byte values can't be null and must not be in the range [0xF0, 0xFF].
-            if (byte == 0 || (byte >= 0xF0))
-            {
-                jc->status = INVALID_UTF8_BYTES;
-                return 0;
-            }
-
-            *bytes++ = (uint8_t)byte;
+            jc->status = INVALID_UTF8_BYTES;
+            return 0;
         }
     }
     else
@@ -221,18 +204,13 @@ char readConstantPool_Utf8(JavaClass* jc, cp_info* entry)
 char readConstantPoolEntry(JavaClass* jc, cp_info* entry)
 {
     // Gets the entry tag
-    int byte = fgetc(jc->file);
-
-    if (byte == EOF)
+    if (!readu1(jc, &entry->tag))
     {
         jc->status = UNEXPECTED_EOF_READING_CONSTANT_POOL;
         entry->tag = 0xFF;
         return 0;
     }
 
-    entry->tag = (uint8_t)byte;
-
-    jc->totalBytesRead++;
     jc->lastTagRead = entry->tag;
 
     switch(entry->tag)
@@ -263,14 +241,12 @@ char readConstantPoolEntry(JavaClass* jc, cp_info* entry)
         // Compatibility with Java 8
         case CONSTANT_MethodHandle:
 
-            if (!readu2(jc, NULL) || fgetc(jc->file) == EOF)
+            if (!readu2(jc, NULL) || !readu1(jc, NULL))
             {
                 jc->status = UNEXPECTED_EOF_READING_CONSTANT_POOL;
                 return 0;
             }
 
-            jc->totalBytesRead++;
-
             break;
 
         default:
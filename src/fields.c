@@ -55,7 +55,7 @@ char readField(JavaClass* jc, field_info* entry)
 
     if (entry->attributes_count > 0)
     {
-        entry->attributes = (attribute_info*)malloc(sizeof(attribute_info) * entry->attributes_count);
+        entry->attributes = (attribute_info*)allocFromArena(&jc->arena, sizeof(attribute_info) * entry->attributes_count);
 
         if (!entry->attributes)
         {
@@ -85,29 +85,6 @@ char readField(JavaClass* jc, field_info* entry)
     return 1;
 }
 
-/// @brief Releases attributes used by the field_info struct
-///
-/// @param field_info* entry - pointer to the field_info that 
-/// contains the attributes
-///
-/// @note This function does not free the @b *entry pointer, 
-/// just attributes
-void freeFieldAttributes(field_info* entry)
-{
-    uint32_t i;
-
-    if (entry->attributes != NULL)
-    {
-        for (i = 0; i < entry->attributes_count; i++)
-            freeAttributeInfo(entry->attributes + i);
-
-        free(entry->attributes);
-
-        entry->attributes_count = 0;
-        entry->attributes = NULL;
-    }
-}
-
 /// @brief Function to print all fields of the class file. 
 ///
 /// @param JavaClass *jc - pointer to JavaClass structure that must already
@@ -22,7 +22,6 @@ struct field_info {
 };
 
 char readField(JavaClass* jc, field_info* entry);
-void freeFieldAttributes(field_info* entry);
 void printAllFields(JavaClass* jc);
 
 field_info* getFieldMatching(JavaClass* jc, const uint8_t* name, int32_t name_len, const uint8_t* descriptor,
@@ -1,5 +1,6 @@
 #include "framestack.h"
 #include "memoryinspect.h"
+#include "threads.h"
 
 Frame* newFrame(JavaClass* jc, method_info* method)
 {
@@ -7,34 +8,53 @@ Frame* newFrame(JavaClass* jc, method_info* method)
 
     if (frame)
     {
-        attribute_info* codeAttribute = getAttributeByType(method->attributes, method->attributes_count, ATTR_Code);
-        att_Code_info* code;
+        att_Code_info* code = getMethodCode(jc, method);
 
-        if (codeAttribute)
+        // Native methods have no Code attribute, but they can
+        // still push a return value of up to two slots.
+        uint16_t max_locals = 0;
+        uint16_t max_stack = 2;
+
+        if (code)
         {
-            code = (att_Code_info*)codeAttribute->info;
+            max_locals = code->max_locals;
+            max_stack = code->max_stack;
             frame->code = code->code;
             frame->code_length = code->code_length;
-
-            if (code->max_locals > 0)
-                frame->localVariables = (int32_t*)malloc(code->max_locals * sizeof(int32_t));
-            else
-                frame->localVariables = NULL;
-
-#ifdef DEBUG
-            frame->max_locals = code->max_locals;
-#endif // DEBUG
-
+            frame->ir = code->ir;
+            frame->types = code->types;
+            frame->verified = code->verified;
         }
         else
         {
             frame->code = NULL;
             frame->code_length = 0;
+            frame->ir = NULL;
+            frame->types = NULL;
+            frame->verified = 0;
+        }
+
+        frame->max_locals = max_locals;
+        frame->traced = 0;
+
+        // Local variables and operand stack values share the same
+        // memory block: the stack slots come right after the locals.
+        if (max_locals + max_stack > 0)
+            frame->localVariables = (Slot*)malloc((max_locals + max_stack) * sizeof(Slot));
+        else
             frame->localVariables = NULL;
+
+        if (max_locals + max_stack > 0 && !frame->localVariables)
+        {
+            free(frame);
+            return NULL;
         }
 
-        frame->operands = NULL;
+        initOperandStack(&frame->operands, frame->localVariables + max_locals, max_stack);
+
+        frame->executionCounters = NULL;
         frame->jc = jc;
+        frame->method = method;
         frame->pc = 0;
         frame->fp_strict = (method->access_flags & ACC_STRICT) != 0;
     }
@@ -47,9 +67,6 @@ void freeFrame(Frame* frame)
     if (frame->localVariables)
         free(frame->localVariables);
 
-    if (frame->operands)
-        freeOperandStack(&frame->operands);
-
     free(frame);
 }
 
@@ -61,6 +78,10 @@ uint8_t pushFrame(FrameStack** fs, Frame* frame)
     {
         node->frame = frame;
         node->next = *fs;
+
+        // The sampler may read the stack from a signal handler at any
+        // point, so the node is complete before it is reachable
+        SIGNAL_FENCE();
         *fs = node;
     }
 
@@ -77,6 +98,7 @@ uint8_t popFrame(FrameStack** fs, Frame* outPtr)
             *outPtr = *node->frame;
 
         *fs = node->next;
+        SIGNAL_FENCE();
         free(node);
     }
 
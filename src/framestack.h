@@ -11,6 +11,9 @@ struct Frame
 {
     JavaClass* jc;
 
+    // The method running in this frame
+    method_info* method;
+
     // Use strict floating points?
     uint8_t fp_strict;
 
@@ -21,12 +24,28 @@ struct Frame
     uint32_t pc, code_length;
     uint8_t* code;
 
-    OperandStack* operands;
-    int32_t* localVariables;
+    OperandStack operands;
+    Slot* localVariables;
+
+    // Register IR of the method, if it has been translated.
+    IRMethod* ir;
+
+    // Types of the locals and operands at each instruction, if
+    // they could be computed when the method was linked.
+    MethodTypes* types;
+
+    // Whether the method passed verification, in which case
+    // the interpreter doesn't check operand stack bounds.
+    uint8_t verified;
+
+    // How many times each instruction of the method has been
+    // executed, only used while recording an n-gram profile.
+    uint32_t* executionCounters;
 
-#ifdef DEBUG
     uint16_t max_locals;
-#endif
+
+    // Whether the method matches the trace filters, see isMethodTraced()
+    uint8_t traced;
 };
 
 struct FrameStack
@@ -0,0 +1,563 @@
+#include "garbagecollector.h"
+#include "heapdump.h"
+#include "threads.h"
+#include "memoryinspect.h"
+#include <string.h>
+#include <inttypes.h>
+
+// Upper bounds of the pause histogram buckets, in milliseconds. The
+// last bucket holds the longer pauses.
+static const double pauseBuckets[] = { 0.01, 0.1, 1, 10, 100, 1000 };
+
+#define PAUSE_BUCKET_COUNT (sizeof(pauseBuckets) / sizeof(pauseBuckets[0]) + 1)
+
+static const char* const causeNames[] = {
+    "none",
+    "young generation full",
+    "old generation full"
+};
+
+/// @brief The objects of a collection, in the order of the object
+/// table, with an index to find them by address.
+typedef struct MarkState
+{
+    ReferenceTable** nodes;
+    uint32_t nodeCount;
+
+    uint8_t* marks;
+
+    // Node index + 1 of each bucket, 0 for empty buckets
+    uint32_t* indexes;
+    uint32_t indexMask;
+
+    // Marked nodes whose fields are still to be scanned
+    uint32_t* stack;
+    uint32_t stackTop;
+} MarkState;
+
+/// @brief Creates a collector with empty generations.
+///
+/// @param uint64_t youngSize - bytes allocated between minor
+/// collections.
+///
+/// @return The collector, to be freed with freeGarbageCollector(), or
+/// NULL if there is not enough memory.
+GarbageCollector* newGarbageCollector(uint64_t youngSize)
+{
+    GarbageCollector* collector = (GarbageCollector*)malloc(sizeof(GarbageCollector));
+
+    if (collector)
+    {
+        memset(collector, 0, sizeof(GarbageCollector));
+        collector->youngSize = youngSize ? youngSize : GC_DEFAULT_YOUNG_SIZE;
+        collector->oldLimit = collector->youngSize * 4;
+    }
+
+    return collector;
+}
+
+void freeGarbageCollector(GarbageCollector* collector)
+{
+    if (collector->textLog && collector->textLog != stderr)
+        fclose(collector->textLog);
+
+    if (collector->jsonLog)
+        fclose(collector->jsonLog);
+
+    free(collector->pauses);
+    free(collector);
+}
+
+/// @brief Opens the logs collections are written to.
+///
+/// @param const char* textPath - file of the text log, "" for stderr,
+/// or NULL for no text log.
+/// @param const char* jsonPath - file of the JSON lines log, or NULL.
+///
+/// @return 1 on success, 0 if a file couldn't be created.
+uint8_t openGarbageCollectionLogs(GarbageCollector* collector, const char* textPath, const char* jsonPath)
+{
+    if (textPath)
+    {
+        collector->textLog = *textPath ? fopen(textPath, "w") : stderr;
+
+        if (!collector->textLog)
+            return 0;
+    }
+
+    if (jsonPath)
+    {
+        collector->jsonLog = fopen(jsonPath, "w");
+
+        if (!collector->jsonLog)
+            return 0;
+    }
+
+    return 1;
+}
+
+/// @brief Adds a new object to the young generation, asking for a
+/// collection at the next safepoint once the young generation is full.
+void countCollectedAllocation(GarbageCollector* collector, uint32_t bytes)
+{
+    collector->young.objects++;
+    collector->young.bytes += bytes;
+    collector->allocatedObjects++;
+    collector->allocatedBytes += bytes;
+    collector->allocatedSinceCollection += bytes;
+
+    if (collector->allocatedSinceCollection >= collector->youngSize && !collector->pendingCause)
+        collector->pendingCause = GC_CAUSE_YOUNG_FULL;
+}
+
+static uint32_t hashReference(uint32_t reference)
+{
+    return (reference >> 3) * 2654435761u;
+}
+
+static void freeMarkState(MarkState* state)
+{
+    free(state->nodes);
+    free(state->marks);
+    free(state->indexes);
+    free(state->stack);
+}
+
+static uint8_t initMarkState(MarkState* state, JavaVirtualMachine* jvm)
+{
+    ReferenceTable* node;
+    uint32_t index, buckets = 16;
+
+    memset(state, 0, sizeof(MarkState));
+
+    for (node = jvm->objects; node; node = node->next)
+        state->nodeCount++;
+
+    while (buckets < state->nodeCount * 2)
+        buckets *= 2;
+
+    state->nodes = (ReferenceTable**)malloc((state->nodeCount + 1) * sizeof(ReferenceTable*));
+    state->marks = (uint8_t*)malloc(state->nodeCount + 1);
+    state->stack = (uint32_t*)malloc((state->nodeCount + 1) * sizeof(uint32_t));
+    state->indexes = (uint32_t*)malloc(buckets * sizeof(uint32_t));
+    state->indexMask = buckets - 1;
+
+    if (!state->nodes || !state->marks || !state->stack || !state->indexes)
+    {
+        freeMarkState(state);
+        return 0;
+    }
+
+    memset(state->marks, 0, state->nodeCount + 1);
+    memset(state->indexes, 0, buckets * sizeof(uint32_t));
+
+    for (node = jvm->objects, index = 0; node; node = node->next, index++)
+    {
+        uint32_t bucket = hashReference((uint32_t)(uintptr_t)node->obj) & state->indexMask;
+
+        while (state->indexes[bucket])
+            bucket = (bucket + 1) & state->indexMask;
+
+        state->indexes[bucket] = index + 1;
+        state->nodes[index] = node;
+    }
+
+    return 1;
+}
+
+static void markNode(MarkState* state, uint32_t index)
+{
+    if (!state->marks[index])
+    {
+        state->marks[index] = 1;
+        state->stack[state->stackTop++] = index;
+    }
+}
+
+/// @brief Marks the object a value points to, if it is the low 32 bits
+/// of the address of an object.
+static void markValue(MarkState* state, uint32_t value)
+{
+    uint32_t bucket = hashReference(value) & state->indexMask;
+
+    if (!value)
+        return;
+
+    while (state->indexes[bucket])
+    {
+        uint32_t index = state->indexes[bucket] - 1;
+
+        if ((uint32_t)(uintptr_t)state->nodes[index]->obj == value)
+        {
+            markNode(state, index);
+            return;
+        }
+
+        bucket = (bucket + 1) & state->indexMask;
+    }
+}
+
+static void markRoots(JavaVirtualMachine* jvm, MarkState* state)
+{
+    LoadedClasses* lc;
+    FrameStack* node;
+    uint32_t slot, slotCount;
+
+    for (lc = jvm->classes; lc; lc = lc->next)
+    {
+        for (slot = 0; lc->staticFieldsData && slot < lc->jc->staticFieldCount; slot++)
+            markValue(state, (uint32_t)lc->staticFieldsData[slot]);
+    }
+
+    for (node = jvm->frames; node; node = node->next)
+    {
+        Frame* frame = node->frame;
+
+        // The whole register file, as the register IR keeps values in
+        // stack slots above the top
+        slotCount = frame->max_locals + frame->operands.capacity;
+
+        for (slot = 0; frame->localVariables && slot < slotCount; slot++)
+            markValue(state, (uint32_t)frame->localVariables[slot]);
+    }
+}
+
+static void markReachable(MarkState* state)
+{
+    uint32_t index;
+
+    while (state->stackTop)
+    {
+        Reference* obj = state->nodes[state->stack[--state->stackTop]]->obj;
+
+        switch (obj->type)
+        {
+            case REFTYPE_CLASSINSTANCE:
+                for (index = 0; index < obj->ci.c->instanceFieldCount; index++)
+                    markValue(state, (uint32_t)obj->ci.data[index]);
+
+                break;
+
+            case REFTYPE_OBJARRAY:
+                for (index = 0; index < obj->oar.length; index++)
+                    markValue(state, (uint32_t)(uintptr_t)obj->oar.elements[index]);
+
+                break;
+
+            default:
+                break;
+        }
+    }
+}
+
+/// @brief Frees the unmarked objects, only the young ones unless
+/// \c major is set, and ages the young survivors.
+static void sweep(JavaVirtualMachine* jvm, MarkState* state, uint8_t major, GarbageCollection* collection)
+{
+    GarbageCollector* collector = jvm->collector;
+    ReferenceTable** link = &jvm->objects;
+    ReferenceTable* node;
+    uint32_t index = 0;
+
+    while ((node = *link))
+    {
+        uint8_t old = node->age >= GC_TENURING_THRESHOLD;
+        uint32_t bytes;
+
+        if (!major && old)
+        {
+            link = &node->next;
+            index++;
+            continue;
+        }
+
+        bytes = getObjectSize(node->obj);
+
+        if (!state->marks[index])
+        {
+            *link = node->next;
+            deleteReference(node->obj);
+            free(node);
+
+            collection->freed.objects++;
+            collection->freed.bytes += bytes;
+
+            if (old)
+            {
+                collector->old.objects--;
+                collector->old.bytes -= bytes;
+            }
+            else
+            {
+                collector->young.objects--;
+                collector->young.bytes -= bytes;
+            }
+        }
+        else
+        {
+            if (!old && ++node->age == GC_TENURING_THRESHOLD)
+            {
+                collector->young.objects--;
+                collector->young.bytes -= bytes;
+                collector->old.objects++;
+                collector->old.bytes += bytes;
+                collection->promoted.objects++;
+                collection->promoted.bytes += bytes;
+            }
+
+            link = &node->next;
+        }
+
+        index++;
+    }
+}
+
+static void recordPause(GarbageCollector* collector, double pause)
+{
+    if (collector->pauseCount >= collector->pauseCapacity)
+    {
+        uint32_t capacity = collector->pauseCapacity ? collector->pauseCapacity * 2 : 64;
+        double* pauses = (double*)malloc(capacity * sizeof(double));
+
+        if (!pauses)
+            return;
+
+        if (collector->pauses)
+        {
+            memcpy(pauses, collector->pauses, collector->pauseCount * sizeof(double));
+            free(collector->pauses);
+        }
+
+        collector->pauses = pauses;
+        collector->pauseCapacity = capacity;
+    }
+
+    collector->pauses[collector->pauseCount++] = pause;
+}
+
+static void logCollection(GarbageCollector* collector, GarbageCollection* collection)
+{
+    const char* type = collection->major ? "major" : "minor";
+
+    if (collector->textLog)
+    {
+        fprintf(collector->textLog,
+                "GC(%u) %s, %s, at %.3f ms: young %" PRIu64 "->%" PRIu64 " B (%" PRIu64 "->%" PRIu64 " objects), "
+                "old %" PRIu64 "->%" PRIu64 " B (%" PRIu64 "->%" PRIu64 " objects), "
+                "promoted %" PRIu64 " objects %" PRIu64 " B, freed %" PRIu64 " objects %" PRIu64 " B, "
+                "mark %.3f ms, sweep %.3f ms, pause %.3f ms\n",
+                collection->number, type, causeNames[collection->cause], collection->startTime,
+                collection->youngBefore.bytes, collection->youngAfter.bytes,
+                collection->youngBefore.objects, collection->youngAfter.objects,
+                collection->oldBefore.bytes, collection->oldAfter.bytes,
+                collection->oldBefore.objects, collection->oldAfter.objects,
+                collection->promoted.objects, collection->promoted.bytes,
+                collection->freed.objects, collection->freed.bytes,
+                collection->markTime, collection->sweepTime, collection->pauseTime);
+    }
+
+    if (collector->jsonLog)
+    {
+        fprintf(collector->jsonLog,
+                "{\"gc\":%u,\"type\":\"%s\",\"cause\":\"%s\",\"time_ms\":%.3f,"
+                "\"young\":{\"before\":{\"objects\":%" PRIu64 ",\"bytes\":%" PRIu64 "},"
+                "\"after\":{\"objects\":%" PRIu64 ",\"bytes\":%" PRIu64 "}},"
+                "\"old\":{\"before\":{\"objects\":%" PRIu64 ",\"bytes\":%" PRIu64 "},"
+                "\"after\":{\"objects\":%" PRIu64 ",\"bytes\":%" PRIu64 "}},"
+                "\"promoted\":{\"objects\":%" PRIu64 ",\"bytes\":%" PRIu64 "},"
+                "\"freed\":{\"objects\":%" PRIu64 ",\"bytes\":%" PRIu64 "},"
+                "\"mark_ms\":%.3f,\"sweep_ms\":%.3f,\"pause_ms\":%.3f}\n",
+                collection->number, type, causeNames[collection->cause], collection->startTime,
+                collection->youngBefore.objects, collection->youngBefore.bytes,
+                collection->youngAfter.objects, collection->youngAfter.bytes,
+                collection->oldBefore.objects, collection->oldBefore.bytes,
+                collection->oldAfter.objects, collection->oldAfter.bytes,
+                collection->promoted.objects, collection->promoted.bytes,
+                collection->freed.objects, collection->freed.bytes,
+                collection->markTime, collection->sweepTime, collection->pauseTime);
+    }
+}
+
+/// @brief Does the collection asked for by an allocation: a minor one,
+/// or a major one if the old generation is full.
+///
+/// Live references must all be in frame slots, static fields or
+/// objects, which is only true at a safepoint, see GC_SAFEPOINT(). If
+/// there is not enough memory to mark, nothing is freed and the
+/// collection is tried again after another young generation.
+void collectGarbage(JavaVirtualMachine* jvm)
+{
+    GarbageCollector* collector = jvm->collector;
+    GarbageCollection collection;
+    MarkState state;
+    ReferenceTable* node;
+    uint32_t index;
+    double start = getMonotonicTime(), markEnd;
+
+    memset(&collection, 0, sizeof(collection));
+    collection.cause = collector->pendingCause;
+    collection.major = collection.cause == GC_CAUSE_OLD_FULL;
+    collection.startTime = start - jvm->startTime;
+    collection.youngBefore = collector->young;
+    collection.oldBefore = collector->old;
+
+    collector->pendingCause = GC_CAUSE_NONE;
+    collector->allocatedSinceCollection = 0;
+
+    if (!initMarkState(&state, jvm))
+        return;
+
+    markRoots(jvm, &state);
+
+    // Old objects are taken as live by minor collections
+    if (!collection.major)
+    {
+        for (node = jvm->objects, index = 0; node; node = node->next, index++)
+        {
+            if (node->age >= GC_TENURING_THRESHOLD)
+                markNode(&state, index);
+        }
+    }
+
+    markReachable(&state);
+    markEnd = getMonotonicTime();
+
+    sweep(jvm, &state, collection.major, &collection);
+    freeMarkState(&state);
+
+    collection.youngAfter = collector->young;
+    collection.oldAfter = collector->old;
+    collection.markTime = markEnd - start;
+    collection.sweepTime = getMonotonicTime() - markEnd;
+    collection.pauseTime = collection.markTime + collection.sweepTime;
+
+    recordPause(collector, collection.pauseTime);
+
+    if (collection.major)
+    {
+        collector->majorCount++;
+        collector->oldLimit = collector->old.bytes * 2;
+
+        if (collector->oldLimit < collector->youngSize * 4)
+            collector->oldLimit = collector->youngSize * 4;
+    }
+    else
+    {
+        collector->minorCount++;
+
+        if (collector->old.bytes >= collector->oldLimit)
+            collector->pendingCause = GC_CAUSE_OLD_FULL;
+    }
+
+    collection.number = collector->minorCount + collector->majorCount;
+    collector->totalPauseTime += collection.pauseTime;
+    collector->freed.objects += collection.freed.objects;
+    collector->freed.bytes += collection.freed.bytes;
+    collector->promoted.objects += collection.promoted.objects;
+    collector->promoted.bytes += collection.promoted.bytes;
+
+    if (jvm->perfData)
+    {
+        addPerfCounter(jvm->perfData, PERF_GC_COUNT, 1);
+        addPerfCounter(jvm->perfData, PERF_GC_PAUSE_NANOS, (uint64_t)(collection.pauseTime * 1000000));
+    }
+
+    logCollection(collector, &collection);
+}
+
+static int comparePauses(const void* a, const void* b)
+{
+    double pause1 = *(const double*)a;
+    double pause2 = *(const double*)b;
+
+    return pause1 < pause2 ? -1 : (pause1 > pause2 ? 1 : 0);
+}
+
+/// @brief Gets a percentile of sorted pauses, by the nearest rank.
+static double getPercentile(const double* pauses, uint32_t count, double percentile)
+{
+    uint32_t rank = (uint32_t)(percentile / 100 * count + 0.999999);
+
+    if (!count)
+        return 0;
+
+    return pauses[rank ? rank - 1 : 0];
+}
+
+/// @brief Writes the number of collections, the pause percentiles and
+/// histogram and the allocation rate to the logs.
+///
+/// @param double runTime - milliseconds the program ran, for the
+/// allocation rate.
+void printGarbageCollectionSummary(GarbageCollector* collector, double runTime)
+{
+    uint32_t count = collector->pauseCount;
+    uint32_t histogram[PAUSE_BUCKET_COUNT];
+    double p50, p99, max, rate;
+    uint32_t index, bucket;
+
+    memset(histogram, 0, sizeof(histogram));
+
+    if (collector->pauses)
+        qsort(collector->pauses, count, sizeof(double), comparePauses);
+
+    for (index = 0; collector->pauses && index < count; index++)
+    {
+        for (bucket = 0; bucket < PAUSE_BUCKET_COUNT - 1 && collector->pauses[index] >= pauseBuckets[bucket]; bucket++);
+        histogram[bucket]++;
+    }
+
+    p50 = collector->pauses ? getPercentile(collector->pauses, count, 50) : 0;
+    p99 = collector->pauses ? getPercentile(collector->pauses, count, 99) : 0;
+    max = collector->pauses && count ? collector->pauses[count - 1] : 0;
+    rate = runTime > 0 ? collector->allocatedBytes / (runTime / 1000) : 0;
+
+    if (collector->textLog)
+    {
+        FILE* log = collector->textLog;
+
+        fprintf(log, "\nGC summary: %u minor and %u major collections, %.3f ms of pauses in %.3f ms\n",
+                collector->minorCount, collector->majorCount, collector->totalPauseTime, runTime);
+        fprintf(log, "  Pauses: p50 %.3f ms, p99 %.3f ms, max %.3f ms\n", p50, p99, max);
+
+        for (bucket = 0; bucket < PAUSE_BUCKET_COUNT; bucket++)
+        {
+            if (bucket < PAUSE_BUCKET_COUNT - 1)
+                fprintf(log, "    < %8g ms %10u\n", pauseBuckets[bucket], histogram[bucket]);
+            else
+                fprintf(log, "   >= %8g ms %10u\n", pauseBuckets[bucket - 1], histogram[bucket]);
+        }
+
+        fprintf(log, "  Allocated: %" PRIu64 " objects, %" PRIu64 " B, %.0f B/s\n",
+                collector->allocatedObjects, collector->allocatedBytes, rate);
+        fprintf(log, "  Freed: %" PRIu64 " objects, %" PRIu64 " B; promoted: %" PRIu64 " objects, %" PRIu64 " B\n",
+                collector->freed.objects, collector->freed.bytes, collector->promoted.objects, collector->promoted.bytes);
+        fprintf(log, "  Heap: young %" PRIu64 " objects, %" PRIu64 " B; old %" PRIu64 " objects, %" PRIu64 " B\n",
+                collector->young.objects, collector->young.bytes, collector->old.objects, collector->old.bytes);
+        fflush(log);
+    }
+
+    if (collector->jsonLog)
+    {
+        FILE* log = collector->jsonLog;
+
+        fprintf(log, "{\"summary\":{\"minor\":%u,\"major\":%u,\"run_ms\":%.3f,"
+                "\"pause_ms\":{\"total\":%.3f,\"p50\":%.3f,\"p99\":%.3f,\"max\":%.3f,\"histogram\":[",
+                collector->minorCount, collector->majorCount, runTime, collector->totalPauseTime, p50, p99, max);
+
+        for (bucket = 0; bucket < PAUSE_BUCKET_COUNT; bucket++)
+        {
+            if (bucket < PAUSE_BUCKET_COUNT - 1)
+                fprintf(log, "%s{\"below_ms\":%g,\"count\":%u}", bucket ? "," : "", pauseBuckets[bucket], histogram[bucket]);
+            else
+                fprintf(log, ",{\"below_ms\":null,\"count\":%u}", histogram[bucket]);
+        }
+
+        fprintf(log, "]},\"allocated\":{\"objects\":%" PRIu64 ",\"bytes\":%" PRIu64 "},\"allocation_rate_bytes_per_s\":%.0f,"
+                "\"freed\":{\"objects\":%" PRIu64 ",\"bytes\":%" PRIu64 "},"
+                "\"promoted\":{\"objects\":%" PRIu64 ",\"bytes\":%" PRIu64 "}}}\n",
+                collector->allocatedObjects, collector->allocatedBytes, rate,
+                collector->freed.objects, collector->freed.bytes, collector->promoted.objects, collector->promoted.bytes);
+        fflush(log);
+    }
+}
@@ -0,0 +1,139 @@
+#ifndef GARBAGECOLLECTOR_H
+#define GARBAGECOLLECTOR_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+typedef struct GarbageCollector GarbageCollector;
+
+#include "jvm.h"
+
+// Minor collections an object survives before it is promoted
+#define GC_TENURING_THRESHOLD 2
+
+// Default size of the young generation, in bytes
+#define GC_DEFAULT_YOUNG_SIZE 1048576
+
+enum GarbageCollectionCause {
+    GC_CAUSE_NONE,
+    GC_CAUSE_YOUNG_FULL,
+    GC_CAUSE_OLD_FULL
+};
+
+/// @brief Objects and bytes of a generation.
+typedef struct GenerationSize
+{
+    uint64_t objects;
+    uint64_t bytes;
+} GenerationSize;
+
+/// @brief What a collection did, as written to the logs.
+typedef struct GarbageCollection
+{
+    uint32_t number;
+    uint8_t cause;
+    uint8_t major;
+
+    // Milliseconds since the JVM started
+    double startTime;
+
+    GenerationSize youngBefore, youngAfter;
+    GenerationSize oldBefore, oldAfter;
+    GenerationSize promoted;
+    GenerationSize freed;
+
+    // Milliseconds
+    double markTime;
+    double sweepTime;
+    double pauseTime;
+} GarbageCollection;
+
+struct GarbageCollector
+{
+    // Bytes allocated in the young generation before a minor collection
+    uint64_t youngSize;
+
+    // Bytes the old generation can reach before a major collection
+    uint64_t oldLimit;
+
+    GenerationSize young;
+    GenerationSize old;
+
+    // Bytes allocated since the last collection
+    uint64_t allocatedSinceCollection;
+
+    // Cause of the collection to do at the next safepoint, or
+    // GC_CAUSE_NONE
+    uint8_t pendingCause;
+
+    // Logs, or NULL
+    FILE* textLog;
+    FILE* jsonLog;
+
+    uint32_t minorCount;
+    uint32_t majorCount;
+    double totalPauseTime;
+
+    // Pause of every collection, in milliseconds. Pauses that couldn't
+    // be stored are left out, so pauseCount may be less than the number
+    // of collections.
+    double* pauses;
+    uint32_t pauseCount;
+    uint32_t pauseCapacity;
+
+    uint64_t allocatedObjects;
+    uint64_t allocatedBytes;
+    GenerationSize freed;
+    GenerationSize promoted;
+};
+
+/// @brief Collects garbage if an allocation asked for it. Must only be
+/// used where every live reference is in a frame slot, a static field
+/// or an object, see collectGarbage().
+#define GC_SAFEPOINT(jvm) \
+    do { if ((jvm)->collector && (jvm)->collector->pendingCause) collectGarbage(jvm); } while (0)
+
+GarbageCollector* newGarbageCollector(uint64_t youngSize);
+void freeGarbageCollector(GarbageCollector* collector);
+uint8_t openGarbageCollectionLogs(GarbageCollector* collector, const char* textPath, const char* jsonPath);
+void countCollectedAllocation(GarbageCollector* collector, uint32_t bytes);
+void collectGarbage(JavaVirtualMachine* jvm);
+void printGarbageCollectionSummary(GarbageCollector* collector, double runTime);
+
+#endif // GARBAGECOLLECTOR_H
+
+/// @defgroup garbagecollector Garbage collector module
+///
+/// @brief Frees the objects the program can't reach anymore.
+///
+/// Without "-Xgc", objects live until the JVM exits. With it, objects
+/// are born in the young generation, and each one that survives
+/// GC_TENURING_THRESHOLD minor collections is promoted to the old
+/// generation. A minor collection starts once 1 MB has been allocated
+/// since the last collection, or as set by "-Xmn<bytes>", and frees
+/// unreachable young objects. A major collection starts once the old
+/// generation has doubled since the last one, and frees unreachable
+/// objects of both generations.
+///
+/// Both are stop-the-world mark and sweep collections. Marking starts
+/// at the frame slots and static fields, and also at every old object
+/// for minor collections, as there is no remembered set of the old
+/// objects pointing to young ones. Frame slots and instance fields
+/// carry no types, so any value equal to the address of an object keeps
+/// it alive: marking is conservative and never frees a live object,
+/// but a number may keep garbage alive. Object array elements are exact.
+///
+/// Allocations only ask for a collection, which happens at the next
+/// safepoint: when a method is called and before the instructions that
+/// allocate. There, the interpreter has written its cached operands to
+/// the frame, and no C function holds a reference the collector can't
+/// see, as multianewarray does while it fills its outer arrays.
+///
+/// "-Xgclog[:<file>]" writes a line per collection, with its cause,
+/// the generations before and after it, the objects promoted and the
+/// mark, sweep and pause times, to <file> or stderr.
+/// "-Xgclogjson:<file>" writes the same as JSON lines. When the program
+/// ends, both get a summary with the pause percentiles and histogram
+/// and the allocation rate.
+///
+/// @see collectGarbage(), GC_SAFEPOINT()
@@ -0,0 +1,591 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "heapdump.h"
+#include "memoryinspect.h"
+#include <string.h>
+#include <inttypes.h>
+
+// Deepest class hierarchy walked for the fields of an instance
+#define HEAP_MAX_CLASS_DEPTH 64
+
+volatile sig_atomic_t heapDumpRequested = 0;
+
+/// @brief A class or array type found in the object table.
+typedef struct HeapType
+{
+    uint8_t kind;
+    char name[256];
+
+    // Class of the instances of this type, for HEAP_TYPE_CLASS
+    JavaClass* jc;
+
+    uint32_t count;
+    uint64_t bytes;
+} HeapType;
+
+/// @brief Types of the objects and the index of each object, built
+/// before a histogram or dump is written.
+typedef struct HeapSnapshot
+{
+    Reference** objects;
+    uint32_t objectCount;
+
+    // Type of each object
+    uint32_t* objectTypes;
+
+    HeapType* types;
+    uint32_t typeCount;
+    uint32_t typeCapacity;
+
+    // Open addressing table from the low 32 bits of a reference to
+    // the index of the object plus one, 0 being an empty bucket.
+    uint32_t* indexes;
+    uint32_t indexMask;
+} HeapSnapshot;
+
+static uint32_t getArrayElementSize(Opcode_newarray_type type)
+{
+    switch (type)
+    {
+        case T_BOOLEAN:
+        case T_BYTE:
+            return sizeof(uint8_t);
+
+        case T_SHORT:
+        case T_CHAR:
+            return sizeof(uint16_t);
+
+        case T_FLOAT:
+        case T_INT:
+            return sizeof(uint32_t);
+
+        default:
+            return sizeof(uint64_t);
+    }
+}
+
+/// @brief Gets the bytes the JVM allocated for an object and its data,
+/// as counted by the allocation profile.
+uint32_t getObjectSize(Reference* obj)
+{
+    switch (obj->type)
+    {
+        case REFTYPE_STRING:
+            return sizeof(Reference) + obj->str.len;
+
+        case REFTYPE_CLASSINSTANCE:
+            return sizeof(Reference) + obj->ci.c->instanceFieldCount * sizeof(int32_t);
+
+        case REFTYPE_ARRAY:
+            return sizeof(Reference) + obj->arr.length * getArrayElementSize(obj->arr.type);
+
+        case REFTYPE_OBJARRAY:
+            return sizeof(Reference) + obj->oar.utf8_len + obj->oar.length * sizeof(Reference*);
+    }
+
+    return sizeof(Reference);
+}
+
+static void getTypeName(Reference* obj, uint8_t* outKind, char* buffer, size_t size)
+{
+    cp_info* cpi;
+
+    switch (obj->type)
+    {
+        case REFTYPE_STRING:
+            *outKind = HEAP_TYPE_STRING;
+            snprintf(buffer, size, "java/lang/String");
+            break;
+
+        case REFTYPE_CLASSINSTANCE:
+            *outKind = HEAP_TYPE_CLASS;
+            cpi = obj->ci.c->constantPool + obj->ci.c->thisClass - 1;
+            cpi = obj->ci.c->constantPool + cpi->Class.name_index - 1;
+            snprintf(buffer, size, "%.*s", (int)cpi->Utf8.length, cpi->Utf8.bytes);
+            break;
+
+        case REFTYPE_ARRAY:
+            *outKind = HEAP_TYPE_ARRAY;
+            snprintf(buffer, size, "%s[]", decodeOpcodeNewarrayType(obj->arr.type));
+            break;
+
+        case REFTYPE_OBJARRAY:
+            *outKind = HEAP_TYPE_OBJECT_ARRAY;
+            snprintf(buffer, size, "%.*s[]", (int)obj->oar.utf8_len, obj->oar.utf8_className);
+            break;
+    }
+}
+
+static uint32_t findType(HeapSnapshot* snapshot, Reference* obj)
+{
+    char name[256];
+    uint8_t kind = HEAP_TYPE_CLASS;
+    uint32_t index;
+
+    // Instances are told apart by class, without formatting names
+    if (obj->type == REFTYPE_CLASSINSTANCE)
+    {
+        for (index = 0; index < snapshot->typeCount; index++)
+        {
+            if (snapshot->types[index].jc == obj->ci.c)
+                return index;
+        }
+    }
+
+    getTypeName(obj, &kind, name, sizeof(name));
+
+    for (index = 0; index < snapshot->typeCount; index++)
+    {
+        if (snapshot->types[index].kind == kind && !strcmp(snapshot->types[index].name, name))
+            return index;
+    }
+
+    if (snapshot->typeCount == snapshot->typeCapacity)
+    {
+        HeapType* grown = (HeapType*)malloc(snapshot->typeCapacity * 2 * sizeof(HeapType));
+
+        if (!grown)
+            return UINT32_MAX;
+
+        memcpy(grown, snapshot->types, snapshot->typeCapacity * sizeof(HeapType));
+        free(snapshot->types);
+        snapshot->types = grown;
+        snapshot->typeCapacity *= 2;
+    }
+
+    HeapType* type = snapshot->types + snapshot->typeCount;
+
+    type->kind = kind;
+    memcpy(type->name, name, sizeof(name));
+    type->jc = obj->type == REFTYPE_CLASSINSTANCE ? obj->ci.c : NULL;
+    type->count = 0;
+    type->bytes = 0;
+    return snapshot->typeCount++;
+}
+
+static uint32_t hashReference(uint32_t reference)
+{
+    return (reference >> 3) * 2654435761u;
+}
+
+/// @brief Gets the index of the object a slot or field points to.
+/// @return The index, or HEAP_DUMP_NULL if it isn't an object.
+static uint32_t findObject(HeapSnapshot* snapshot, uint32_t reference)
+{
+    uint32_t bucket = hashReference(reference) & snapshot->indexMask;
+
+    if (!reference)
+        return HEAP_DUMP_NULL;
+
+    while (snapshot->indexes[bucket])
+    {
+        uint32_t index = snapshot->indexes[bucket] - 1;
+
+        if ((uint32_t)(uintptr_t)snapshot->objects[index] == reference)
+            return index;
+
+        bucket = (bucket + 1) & snapshot->indexMask;
+    }
+
+    return HEAP_DUMP_NULL;
+}
+
+static void freeHeapSnapshot(HeapSnapshot* snapshot)
+{
+    free(snapshot->objects);
+    free(snapshot->objectTypes);
+    free(snapshot->types);
+    free(snapshot->indexes);
+}
+
+/// @brief Lists the objects of the JVM and their types.
+/// @return 1 on success, 0 if there is not enough memory.
+static uint8_t takeHeapSnapshot(JavaVirtualMachine* jvm, HeapSnapshot* snapshot)
+{
+    ReferenceTable* node;
+    uint32_t index, buckets = 16;
+
+    memset(snapshot, 0, sizeof(HeapSnapshot));
+
+    for (node = jvm->objects; node; node = node->next)
+        snapshot->objectCount++;
+
+    while (buckets < snapshot->objectCount * 2)
+        buckets *= 2;
+
+    snapshot->typeCapacity = 64;
+    snapshot->types = (HeapType*)malloc(snapshot->typeCapacity * sizeof(HeapType));
+    snapshot->objects = (Reference**)malloc((snapshot->objectCount + 1) * sizeof(Reference*));
+    snapshot->objectTypes = (uint32_t*)malloc((snapshot->objectCount + 1) * sizeof(uint32_t));
+    snapshot->indexes = (uint32_t*)malloc(buckets * sizeof(uint32_t));
+    snapshot->indexMask = buckets - 1;
+
+    if (!snapshot->types || !snapshot->objects || !snapshot->objectTypes || !snapshot->indexes)
+    {
+        freeHeapSnapshot(snapshot);
+        return 0;
+    }
+
+    memset(snapshot->indexes, 0, buckets * sizeof(uint32_t));
+
+    // The table lists the newest objects first, so it is read
+    // backwards to number them in allocation order.
+    index = snapshot->objectCount;
+
+    for (node = jvm->objects; node; node = node->next)
+        snapshot->objects[--index] = node->obj;
+
+    for (index = 0; index < snapshot->objectCount; index++)
+    {
+        Reference* obj = snapshot->objects[index];
+        uint32_t type = findType(snapshot, obj);
+        uint32_t bucket = hashReference((uint32_t)(uintptr_t)obj) & snapshot->indexMask;
+
+        if (type == UINT32_MAX)
+        {
+            freeHeapSnapshot(snapshot);
+            return 0;
+        }
+
+        snapshot->objectTypes[index] = type;
+        snapshot->types[type].count++;
+        snapshot->types[type].bytes += getObjectSize(obj);
+
+        while (snapshot->indexes[bucket])
+            bucket = (bucket + 1) & snapshot->indexMask;
+
+        snapshot->indexes[bucket] = index + 1;
+    }
+
+    return 1;
+}
+
+static int compareTypeBytes(const void* a, const void* b)
+{
+    const HeapType* type1 = (const HeapType*)a;
+    const HeapType* type2 = (const HeapType*)b;
+
+    if (type1->bytes != type2->bytes)
+        return type1->bytes < type2->bytes ? 1 : -1;
+
+    return type1->count < type2->count ? 1 : (type1->count > type2->count ? -1 : 0);
+}
+
+/// @brief Prints the instances and bytes of each type in the object
+/// table, the types with the most bytes first.
+void printHeapHistogram(JavaVirtualMachine* jvm, FILE* file)
+{
+    HeapSnapshot snapshot;
+    uint64_t totalBytes = 0;
+    uint32_t index;
+
+    if (!takeHeapSnapshot(jvm, &snapshot))
+    {
+        fprintf(file, "Not enough memory for a heap histogram\n");
+        return;
+    }
+
+    // Only the totals are needed, so the types can be reordered
+    qsort(snapshot.types, snapshot.typeCount, sizeof(HeapType), compareTypeBytes);
+
+    fprintf(file, "\n num     #instances         #bytes  class name\n");
+    fprintf(file, "----------------------------------------------\n");
+
+    for (index = 0; index < snapshot.typeCount; index++)
+    {
+        fprintf(file, "%4u: %14u %14" PRIu64 "  %s\n", index + 1, snapshot.types[index].count,
+                snapshot.types[index].bytes, snapshot.types[index].name);
+        totalBytes += snapshot.types[index].bytes;
+    }
+
+    fprintf(file, "Total %14u %14" PRIu64 "\n", snapshot.objectCount, totalBytes);
+    freeHeapSnapshot(&snapshot);
+}
+
+static void writeU8(FILE* file, uint8_t value)
+{
+    fputc(value, file);
+}
+
+static void writeU16(FILE* file, uint16_t value)
+{
+    fputc(value & 0xFF, file);
+    fputc(value >> 8, file);
+}
+
+static void writeU32(FILE* file, uint32_t value)
+{
+    writeU16(file, (uint16_t)(value & 0xFFFF));
+    writeU16(file, (uint16_t)(value >> 16));
+}
+
+static void writeName(FILE* file, const uint8_t* bytes, uint16_t length)
+{
+    writeU16(file, length);
+    fwrite(bytes, 1, length, file);
+}
+
+/// @brief Lists the instance fields of a class and of its superclasses.
+/// @return The number of fields in \c outFields.
+static uint32_t getInstanceFields(JavaVirtualMachine* jvm, JavaClass* jc, field_info** outFields, JavaClass** outClasses, uint32_t capacity)
+{
+    uint32_t count = 0, depth;
+    uint16_t index;
+    cp_info* cpi;
+    LoadedClasses* super;
+
+    for (depth = 0; jc && depth < HEAP_MAX_CLASS_DEPTH; depth++)
+    {
+        for (index = 0; index < jc->fieldCount && count < capacity; index++)
+        {
+            if (!(jc->fields[index].access_flags & ACC_STATIC))
+            {
+                outFields[count] = jc->fields + index;
+                outClasses[count++] = jc;
+            }
+        }
+
+        if (!jc->superClass)
+            break;
+
+        cpi = jc->constantPool + jc->superClass - 1;
+        cpi = jc->constantPool + cpi->Class.name_index - 1;
+        super = isClassLoaded(jvm, cpi->Utf8.bytes, cpi->Utf8.length);
+        jc = super ? super->jc : NULL;
+    }
+
+    return count;
+}
+
+static uint8_t isReferenceDescriptor(JavaClass* jc, field_info* field)
+{
+    uint8_t first = *jc->constantPool[field->descriptor_index - 1].Utf8.bytes;
+
+    return first == 'L' || first == '[';
+}
+
+static void writeType(JavaVirtualMachine* jvm, FILE* file, HeapType* type)
+{
+    field_info* fields[1024];
+    JavaClass* classes[1024];
+    uint32_t count, index;
+
+    writeU8(file, type->kind);
+    writeName(file, (const uint8_t*)type->name, (uint16_t)strlen(type->name));
+
+    if (type->kind != HEAP_TYPE_CLASS)
+        return;
+
+    count = getInstanceFields(jvm, type->jc, fields, classes, 1024);
+    writeU16(file, type->jc->instanceFieldCount);
+    writeU16(file, (uint16_t)count);
+
+    for (index = 0; index < count; index++)
+    {
+        cp_info* name = classes[index]->constantPool + fields[index]->name_index - 1;
+        cp_info* descriptor = classes[index]->constantPool + fields[index]->descriptor_index - 1;
+
+        writeU16(file, fields[index]->offset);
+        writeU8(file, isReferenceDescriptor(classes[index], fields[index]));
+        writeName(file, name->Utf8.bytes, name->Utf8.length);
+        writeName(file, descriptor->Utf8.bytes, descriptor->Utf8.length);
+    }
+}
+
+static void writeObject(JavaVirtualMachine* jvm, FILE* file, HeapSnapshot* snapshot, uint32_t index)
+{
+    Reference* obj = snapshot->objects[index];
+    HeapType* type = snapshot->types + snapshot->objectTypes[index];
+    field_info* fields[1024];
+    JavaClass* classes[1024];
+    uint32_t count, slot;
+
+    writeU32(file, snapshot->objectTypes[index]);
+    writeU32(file, getObjectSize(obj));
+
+    switch (obj->type)
+    {
+        case REFTYPE_CLASSINSTANCE:
+        {
+            uint8_t isReference[1024];
+            uint16_t slotCount = obj->ci.c->instanceFieldCount;
+
+            memset(isReference, 0, sizeof(isReference));
+            count = getInstanceFields(jvm, type->jc, fields, classes, 1024);
+
+            for (slot = 0; slot < count; slot++)
+            {
+                if (fields[slot]->offset < sizeof(isReference))
+                    isReference[fields[slot]->offset] = isReferenceDescriptor(classes[slot], fields[slot]);
+            }
+
+            writeU32(file, slotCount);
+
+            for (slot = 0; slot < slotCount; slot++)
+            {
+                uint32_t value = (uint32_t)obj->ci.data[slot];
+
+                writeU32(file, slot < sizeof(isReference) && isReference[slot] ? findObject(snapshot, value) : value);
+            }
+
+            break;
+        }
+
+        case REFTYPE_OBJARRAY:
+            writeU32(file, obj->oar.length);
+
+            for (slot = 0; slot < obj->oar.length; slot++)
+                writeU32(file, findObject(snapshot, (uint32_t)(uintptr_t)obj->oar.elements[slot]));
+
+            break;
+
+        case REFTYPE_ARRAY:
+            writeU32(file, obj->arr.length);
+            break;
+
+        case REFTYPE_STRING:
+            writeU32(file, obj->str.len);
+            break;
+    }
+}
+
+/// @brief Writes the static fields and frame slots that point to
+/// objects, or only counts them if \c file is a null pointer.
+/// @return The number of roots.
+static uint32_t writeRoots(JavaVirtualMachine* jvm, FILE* file, HeapSnapshot* snapshot)
+{
+    LoadedClasses* lc;
+    FrameStack* node;
+    uint32_t count = 0, slot, object, slotCount;
+
+    for (lc = jvm->classes; lc; lc = lc->next)
+    {
+        for (slot = 0; lc->staticFieldsData && slot < lc->jc->staticFieldCount; slot++)
+        {
+            object = findObject(snapshot, (uint32_t)lc->staticFieldsData[slot]);
+
+            if (object != HEAP_DUMP_NULL)
+            {
+                if (file)
+                {
+                    writeU8(file, HEAP_ROOT_STATIC_FIELD);
+                    writeU32(file, object);
+                }
+
+                count++;
+            }
+        }
+    }
+
+    for (node = jvm->frames; node; node = node->next)
+    {
+        Frame* frame = node->frame;
+
+        // Locals are followed by the operand stack slots in use
+        slotCount = frame->max_locals + frame->operands.top;
+
+        for (slot = 0; frame->localVariables && slot < slotCount; slot++)
+        {
+            object = findObject(snapshot, (uint32_t)frame->localVariables[slot]);
+
+            if (object != HEAP_DUMP_NULL)
+            {
+                if (file)
+                {
+                    writeU8(file, HEAP_ROOT_FRAME_SLOT);
+                    writeU32(file, object);
+                }
+
+                count++;
+            }
+        }
+    }
+
+    return count;
+}
+
+/// @brief Writes the objects of the JVM, their fields and references,
+/// and the roots that point to them. See @ref heapdump for the format.
+///
+/// @return 1 if the file could be written, 0 otherwise.
+uint8_t writeHeapDump(JavaVirtualMachine* jvm, const char* path)
+{
+    HeapSnapshot snapshot;
+    uint32_t index;
+    FILE* file;
+
+    if (!takeHeapSnapshot(jvm, &snapshot))
+        return 0;
+
+    file = fopen(path, "wb");
+
+    if (!file)
+    {
+        freeHeapSnapshot(&snapshot);
+        return 0;
+    }
+
+    fwrite(HEAP_DUMP_MAGIC, 1, sizeof(HEAP_DUMP_MAGIC), file);
+    writeU32(file, HEAP_DUMP_VERSION);
+    writeU32(file, snapshot.typeCount);
+    writeU32(file, snapshot.objectCount);
+    writeU32(file, writeRoots(jvm, NULL, &snapshot));
+
+    for (index = 0; index < snapshot.typeCount; index++)
+        writeType(jvm, file, snapshot.types + index);
+
+    for (index = 0; index < snapshot.objectCount; index++)
+        writeObject(jvm, file, &snapshot, index);
+
+    writeRoots(jvm, file, &snapshot);
+    freeHeapSnapshot(&snapshot);
+    return fclose(file) == 0;
+}
+
+#ifndef _WIN32
+static void requestHeapDump(int signalNumber)
+{
+    (void)signalNumber;
+    heapDumpRequested = 1;
+}
+#endif
+
+/// @brief Makes SIGUSR1 set heapDumpRequested, for
+/// dumpHeapOnRequest() to take a histogram and dump.
+/// @return 1 on success, 0 where there is no SIGUSR1.
+uint8_t installHeapDumpSignal(void)
+{
+#ifndef _WIN32
+    struct sigaction action;
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = requestHeapDump;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    return sigaction(SIGUSR1, &action, NULL) == 0;
+#else
+    return 0;
+#endif
+}
+
+/// @brief Prints a histogram to stderr and writes a numbered dump, if
+/// the JVM has a dump file, then clears heapDumpRequested.
+void dumpHeapOnRequest(JavaVirtualMachine* jvm)
+{
+    char path[1024];
+
+    heapDumpRequested = 0;
+    printHeapHistogram(jvm, stderr);
+
+    if (jvm->heapDumpPath)
+    {
+        snprintf(path, sizeof(path), "%s.%u", jvm->heapDumpPath, ++jvm->heapDumpCount);
+
+        if (writeHeapDump(jvm, path))
+            fprintf(stderr, "Heap dump written to '%s'\n", path);
+        else
+            fprintf(stderr, "Couldn't write heap dump to '%s'\n", path);
+    }
+}
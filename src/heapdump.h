@@ -0,0 +1,76 @@
+#ifndef HEAPDUMP_H
+#define HEAPDUMP_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <signal.h>
+#include "jvm.h"
+
+#define HEAP_DUMP_MAGIC "JVMHEAP"
+#define HEAP_DUMP_VERSION 1
+
+// Object index written for null references
+#define HEAP_DUMP_NULL 0xFFFFFFFFu
+
+enum HeapTypeKind {
+    HEAP_TYPE_CLASS,
+    HEAP_TYPE_ARRAY,
+    HEAP_TYPE_OBJECT_ARRAY,
+    HEAP_TYPE_STRING
+};
+
+enum HeapRootKind {
+    HEAP_ROOT_STATIC_FIELD,
+    HEAP_ROOT_FRAME_SLOT
+};
+
+// Set by the signal handler, see installHeapDumpSignal()
+extern volatile sig_atomic_t heapDumpRequested;
+
+uint32_t getObjectSize(Reference* obj);
+void printHeapHistogram(JavaVirtualMachine* jvm, FILE* file);
+uint8_t writeHeapDump(JavaVirtualMachine* jvm, const char* path);
+uint8_t installHeapDumpSignal(void);
+void dumpHeapOnRequest(JavaVirtualMachine* jvm);
+
+#endif // HEAPDUMP_H
+
+/// @defgroup heapdump Heap dump module
+///
+/// @brief Shows what the objects of a running program are.
+///
+/// "-Xheaphisto" prints a histogram of the object table when the
+/// program ends, like "jmap -histo": instances and bytes per class, per
+/// primitive array type, per object array type and for strings, the
+/// types with the most bytes first. "-Xheapdump:<file>" writes a heap
+/// dump to <file> when the program ends, which "tools/heapanalyze.c"
+/// reads to compute the memory each object keeps alive.
+///
+/// With either option, SIGUSR1 asks for a histogram, printed to
+/// stderr, and a dump, written to "<file>.1", "<file>.2" and so on,
+/// taken the next time a method is called. The handler only sets
+/// heapDumpRequested, as the object table can't be walked from it.
+///
+/// A dump holds little-endian integers:
+///
+///     "JVMHEAP\0", u32 version, u32 typeCount, u32 objectCount, u32 rootCount
+///     types:   u8 kind, u16 length, name
+///              classes add u16 slotCount, u16 fieldCount, and per field
+///              u16 slot, u8 isReference, u16 length, name,
+///              u16 length, descriptor
+///     objects: u32 type, u32 bytes, u32 length
+///              class instances add u32 values[length], one per slot,
+///              object arrays add u32 elements[length]
+///     roots:   u8 kind, u32 object
+///
+/// References are object indexes, HEAP_DUMP_NULL for null. The slots
+/// of the object arrays and the reference fields are references, the
+/// other slots hold the raw field values. Primitive arrays and strings
+/// are written without their data. Roots are the static fields, local
+/// variables and operand stack slots that point to objects.
+///
+/// References are matched by their low 32 bits, the only ones fields
+/// keep, so a reference field is exact on 32-bit builds and a close
+/// guess elsewhere.
+///
+/// @see printHeapHistogram(), writeHeapDump()
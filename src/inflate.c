@@ -0,0 +1,382 @@
+#include "inflate.h"
+#include "threads.h"
+#include <string.h>
+
+#define MAX_CODE_LENGTH 15
+#define MAX_LITERAL_CODES 288
+#define MAX_DISTANCE_CODES 30
+
+typedef struct InflateState
+{
+    const uint8_t* in;
+    uint32_t inSize;
+    uint32_t inPosition;
+
+    uint32_t bitBuffer;
+    uint8_t bitCount;
+
+    uint8_t* out;
+    uint32_t outSize;
+    uint32_t outPosition;
+} InflateState;
+
+/// @brief A canonical Huffman code.
+typedef struct Huffman
+{
+    // Number of codes of each length
+    uint16_t count[MAX_CODE_LENGTH + 1];
+
+    // Symbols, sorted by code
+    uint16_t symbol[MAX_LITERAL_CODES];
+} Huffman;
+
+static const uint16_t lengthBase[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+
+static const uint8_t lengthExtraBits[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+
+static const uint16_t distanceBase[MAX_DISTANCE_CODES] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+
+static const uint8_t distanceExtraBits[MAX_DISTANCE_CODES] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+/// @brief Reads \c count bits from the stream, least significant first.
+/// @return The bits read, or -1 if the stream ended.
+static int32_t getBits(InflateState* state, uint8_t count)
+{
+    uint32_t value = state->bitBuffer;
+
+    while (state->bitCount < count)
+    {
+        if (state->inPosition == state->inSize)
+            return -1;
+
+        value |= (uint32_t)state->in[state->inPosition++] << state->bitCount;
+        state->bitCount += 8;
+    }
+
+    state->bitBuffer = count < 32 ? value >> count : 0;
+    state->bitCount -= count;
+
+    return (int32_t)(value & ((1u << count) - 1));
+}
+
+/// @brief Builds a canonical Huffman code from the length of the
+/// code of each symbol.
+/// @return 0 if there are more codes than the lengths allow, 1 otherwise.
+static uint8_t buildHuffman(Huffman* huffman, const uint8_t* lengths, uint16_t symbolCount)
+{
+    uint16_t offsets[MAX_CODE_LENGTH + 1];
+    int32_t left = 1;
+    uint16_t symbol;
+    uint8_t length;
+
+    memset(huffman->count, 0, sizeof(huffman->count));
+
+    for (symbol = 0; symbol < symbolCount; symbol++)
+        huffman->count[lengths[symbol]]++;
+
+    for (length = 1; length <= MAX_CODE_LENGTH; length++)
+    {
+        left = left * 2 - huffman->count[length];
+
+        if (left < 0)
+            return 0;
+    }
+
+    offsets[1] = 0;
+
+    for (length = 1; length < MAX_CODE_LENGTH; length++)
+        offsets[length + 1] = offsets[length] + huffman->count[length];
+
+    for (symbol = 0; symbol < symbolCount; symbol++)
+    {
+        if (lengths[symbol])
+            huffman->symbol[offsets[lengths[symbol]]++] = symbol;
+    }
+
+    return 1;
+}
+
+/// @brief Decodes one symbol using a Huffman code.
+/// @return The symbol, or -1 if the stream ended or has an invalid code.
+static int32_t decodeSymbol(InflateState* state, const Huffman* huffman)
+{
+    int32_t code = 0, first = 0, index = 0, bit;
+    uint8_t length;
+
+    for (length = 1; length <= MAX_CODE_LENGTH; length++)
+    {
+        bit = getBits(state, 1);
+
+        if (bit < 0)
+            return -1;
+
+        code |= bit;
+
+        if (code - huffman->count[length] < first)
+            return huffman->symbol[index + code - first];
+
+        index += huffman->count[length];
+        first = (first + huffman->count[length]) << 1;
+        code <<= 1;
+    }
+
+    return -1;
+}
+
+/// @brief Decodes the data of a compressed block until its end.
+static uint8_t inflateCodes(InflateState* state, const Huffman* literals, const Huffman* distances)
+{
+    int32_t symbol, extra;
+    uint32_t length, distance;
+
+    while (1)
+    {
+        symbol = decodeSymbol(state, literals);
+
+        if (symbol < 0)
+            return 0;
+
+        if (symbol < 256)
+        {
+            if (state->outPosition == state->outSize)
+                return 0;
+
+            state->out[state->outPosition++] = (uint8_t)symbol;
+            continue;
+        }
+
+        if (symbol == 256)
+            return 1;
+
+        symbol -= 257;
+
+        if (symbol >= 29 || (extra = getBits(state, lengthExtraBits[symbol])) < 0)
+            return 0;
+
+        length = lengthBase[symbol] + extra;
+        symbol = decodeSymbol(state, distances);
+
+        if (symbol < 0 || symbol >= MAX_DISTANCE_CODES || (extra = getBits(state, distanceExtraBits[symbol])) < 0)
+            return 0;
+
+        distance = distanceBase[symbol] + extra;
+
+        if (distance > state->outPosition || length > state->outSize - state->outPosition)
+            return 0;
+
+        // Copies byte by byte, as the source may overlap the destination
+        while (length--)
+        {
+            state->out[state->outPosition] = state->out[state->outPosition - distance];
+            state->outPosition++;
+        }
+    }
+}
+
+static uint8_t inflateStored(InflateState* state)
+{
+    uint32_t length;
+
+    // Stored blocks start at a byte boundary
+    state->bitBuffer = 0;
+    state->bitCount = 0;
+
+    if (state->inSize - state->inPosition < 4)
+        return 0;
+
+    length = state->in[state->inPosition] | state->in[state->inPosition + 1] << 8;
+
+    if ((length ^ 0xFFFF) != (uint32_t)(state->in[state->inPosition + 2] | state->in[state->inPosition + 3] << 8))
+        return 0;
+
+    state->inPosition += 4;
+
+    if (length > state->inSize - state->inPosition || length > state->outSize - state->outPosition)
+        return 0;
+
+    memcpy(state->out + state->outPosition, state->in + state->inPosition, length);
+    state->inPosition += length;
+    state->outPosition += length;
+
+    return 1;
+}
+
+static Huffman fixedLiterals, fixedDistances;
+static Once fixedCodesOnce = ONCE_INIT;
+
+static void buildFixedCodes(void)
+{
+    uint8_t lengths[MAX_LITERAL_CODES];
+    uint16_t symbol;
+
+    for (symbol = 0; symbol < 144; symbol++)
+        lengths[symbol] = 8;
+    for (; symbol < 256; symbol++)
+        lengths[symbol] = 9;
+    for (; symbol < 280; symbol++)
+        lengths[symbol] = 7;
+    for (; symbol < MAX_LITERAL_CODES; symbol++)
+        lengths[symbol] = 8;
+
+    buildHuffman(&fixedLiterals, lengths, MAX_LITERAL_CODES);
+
+    for (symbol = 0; symbol < MAX_DISTANCE_CODES; symbol++)
+        lengths[symbol] = 5;
+
+    buildHuffman(&fixedDistances, lengths, MAX_DISTANCE_CODES);
+}
+
+static uint8_t inflateFixed(InflateState* state)
+{
+    // Class loader workers may inflate jar entries at the same time
+    runOnce(&fixedCodesOnce, buildFixedCodes);
+    return inflateCodes(state, &fixedLiterals, &fixedDistances);
+}
+
+static uint8_t inflateDynamic(InflateState* state)
+{
+    static const uint8_t order[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+    uint8_t lengths[MAX_LITERAL_CODES + MAX_DISTANCE_CODES];
+    Huffman literals, distances;
+    int32_t literalCount, distanceCount, lengthCodeCount;
+    int32_t index, symbol, repeat, value;
+
+    literalCount = getBits(state, 5);
+    distanceCount = getBits(state, 5);
+    lengthCodeCount = getBits(state, 4);
+
+    if (literalCount < 0 || distanceCount < 0 || lengthCodeCount < 0)
+        return 0;
+
+    literalCount += 257;
+    distanceCount += 1;
+    lengthCodeCount += 4;
+
+    if (literalCount > MAX_LITERAL_CODES || distanceCount > MAX_DISTANCE_CODES)
+        return 0;
+
+    // Lengths of the code used to compress the other code lengths
+    memset(lengths, 0, 19);
+
+    for (index = 0; index < lengthCodeCount; index++)
+    {
+        if ((value = getBits(state, 3)) < 0)
+            return 0;
+
+        lengths[order[index]] = (uint8_t)value;
+    }
+
+    if (!buildHuffman(&literals, lengths, 19))
+        return 0;
+
+    for (index = 0; index < literalCount + distanceCount; )
+    {
+        symbol = decodeSymbol(state, &literals);
+
+        if (symbol < 0)
+            return 0;
+
+        if (symbol < 16)
+        {
+            lengths[index++] = (uint8_t)symbol;
+            continue;
+        }
+
+        value = 0;
+
+        if (symbol == 16)
+        {
+            if (index == 0 || (repeat = getBits(state, 2)) < 0)
+                return 0;
+
+            value = lengths[index - 1];
+            repeat += 3;
+        }
+        else if (symbol == 17)
+        {
+            if ((repeat = getBits(state, 3)) < 0)
+                return 0;
+
+            repeat += 3;
+        }
+        else
+        {
+            if ((repeat = getBits(state, 7)) < 0)
+                return 0;
+
+            repeat += 11;
+        }
+
+        if (index + repeat > literalCount + distanceCount)
+            return 0;
+
+        while (repeat--)
+            lengths[index++] = (uint8_t)value;
+    }
+
+    // A block needs an end of block code
+    if (lengths[256] == 0)
+        return 0;
+
+    if (!buildHuffman(&literals, lengths, (uint16_t)literalCount) ||
+        !buildHuffman(&distances, lengths + literalCount, (uint16_t)distanceCount))
+    {
+        return 0;
+    }
+
+    return inflateCodes(state, &literals, &distances);
+}
+
+/// @brief Decompresses a raw DEFLATE stream.
+///
+/// @param const uint8_t* in - the compressed data.
+/// @param uint32_t inSize - size of the compressed data.
+/// @param uint8_t* out - buffer that receives the decompressed data.
+/// @param uint32_t outSize - expected size of the decompressed data.
+///
+/// @return 1 if the stream is valid and decompresses to exactly
+/// \c outSize bytes, 0 otherwise.
+uint8_t inflateData(const uint8_t* in, uint32_t inSize, uint8_t* out, uint32_t outSize)
+{
+    InflateState state;
+    int32_t last, type;
+    uint8_t success;
+
+    state.in = in;
+    state.inSize = inSize;
+    state.inPosition = 0;
+    state.bitBuffer = 0;
+    state.bitCount = 0;
+    state.out = out;
+    state.outSize = outSize;
+    state.outPosition = 0;
+
+    do {
+        last = getBits(&state, 1);
+        type = getBits(&state, 2);
+
+        switch (type)
+        {
+            case 0: success = inflateStored(&state); break;
+            case 1: success = inflateFixed(&state); break;
+            case 2: success = inflateDynamic(&state); break;
+            default: success = 0; break;
+        }
+
+    } while (success && last == 0);
+
+    return success && last == 1 && state.outPosition == outSize;
+}
@@ -0,0 +1,20 @@
+#ifndef INFLATE_H
+#define INFLATE_H
+
+#include <stdint.h>
+
+uint8_t inflateData(const uint8_t* in, uint32_t inSize, uint8_t* out, uint32_t outSize);
+
+#endif // INFLATE_H
+
+/// @defgroup inflate Inflate module
+///
+/// @brief Decompresses raw DEFLATE streams (RFC 1951), the
+/// compression method of jar files.
+///
+/// Huffman codes are canonical, so a table only needs the number
+/// of codes of each length and the symbols sorted by code. Symbols
+/// are decoded one bit at a time, which is simple and fast enough
+/// for class files.
+///
+/// @see inflateData(), @ref jarfile
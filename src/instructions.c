@@ -2,6 +2,7 @@
 #include "utf8.h"
 #include "jvm.h"
 #include "natives.h"
+#include "superinstructions.h"
 #include <math.h>
 
 // TODO: replace all 'out of memory' status errors with
@@ -18,9 +19,9 @@ uint8_t instfunc_nop(JavaVirtualMachine* jvm, Frame* frame)
 
 uint8_t instfunc_aconst_null(JavaVirtualMachine* jvm, Frame* frame)
 {
-    if (!pushOperand(&frame->operands, 0, OP_REFERENCE))
+    if (!pushOperand(&frame->operands, 0))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -29,12 +30,12 @@ uint8_t instfunc_aconst_null(JavaVirtualMachine* jvm, Frame* frame)
 
 /// @brief Used to automatically generate instructions "iconst_<n>" and
 /// fconst_<n>.
-#define DECLR_CONST_CAT_1_FAMILY(instructionprefix, value, type) \
+#define DECLR_CONST_CAT_1_FAMILY(instructionprefix, value) \
     uint8_t instfunc_##instructionprefix(JavaVirtualMachine* jvm, Frame* frame) \
     { \
-        if (!pushOperand(&frame->operands, value, type)) \
+        if (!pushOperand(&frame->operands, value)) \
         { \
-            jvm->status = JVM_STATUS_OUT_OF_MEMORY; \
+            jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW; \
             return 0; \
         } \
         return 1; \
@@ -42,42 +43,41 @@ uint8_t instfunc_aconst_null(JavaVirtualMachine* jvm, Frame* frame)
 
 /// @brief Used to automatically generate instructions "lconst_<n>" and
 /// dconst_<n>.
-#define DECLR_CONST_CAT_2_FAMILY(instructionprefix, highvalue, lowvalue, type) \
+#define DECLR_CONST_CAT_2_FAMILY(instructionprefix, value) \
     uint8_t instfunc_##instructionprefix(JavaVirtualMachine* jvm, Frame* frame) \
     { \
-        if (!pushOperand(&frame->operands, highvalue, type) || \
-            !pushOperand(&frame->operands, lowvalue,  type)) \
+        if (!pushWideOperand(&frame->operands, value)) \
         { \
-            jvm->status = JVM_STATUS_OUT_OF_MEMORY; \
+            jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW; \
             return 0; \
         } \
         return 1; \
     }
 
-DECLR_CONST_CAT_1_FAMILY(iconst_m1, -1, OP_INTEGER)
-DECLR_CONST_CAT_1_FAMILY(iconst_0, 0, OP_INTEGER)
-DECLR_CONST_CAT_1_FAMILY(iconst_1, 1, OP_INTEGER)
-DECLR_CONST_CAT_1_FAMILY(iconst_2, 2, OP_INTEGER)
-DECLR_CONST_CAT_1_FAMILY(iconst_3, 3, OP_INTEGER)
-DECLR_CONST_CAT_1_FAMILY(iconst_4, 4, OP_INTEGER)
-DECLR_CONST_CAT_1_FAMILY(iconst_5, 5, OP_INTEGER)
+DECLR_CONST_CAT_1_FAMILY(iconst_m1, -1)
+DECLR_CONST_CAT_1_FAMILY(iconst_0, 0)
+DECLR_CONST_CAT_1_FAMILY(iconst_1, 1)
+DECLR_CONST_CAT_1_FAMILY(iconst_2, 2)
+DECLR_CONST_CAT_1_FAMILY(iconst_3, 3)
+DECLR_CONST_CAT_1_FAMILY(iconst_4, 4)
+DECLR_CONST_CAT_1_FAMILY(iconst_5, 5)
 
-DECLR_CONST_CAT_2_FAMILY(lconst_0, 0, 0, OP_LONG)
-DECLR_CONST_CAT_2_FAMILY(lconst_1, 0, 1, OP_LONG)
+DECLR_CONST_CAT_2_FAMILY(lconst_0, 0)
+DECLR_CONST_CAT_2_FAMILY(lconst_1, 1)
 
-DECLR_CONST_CAT_1_FAMILY(fconst_0, 0x00000000, OP_FLOAT)
-DECLR_CONST_CAT_1_FAMILY(fconst_1, 0x3F800000, OP_FLOAT)
-DECLR_CONST_CAT_1_FAMILY(fconst_2, 0x40000000, OP_FLOAT)
+DECLR_CONST_CAT_1_FAMILY(fconst_0, 0x00000000)
+DECLR_CONST_CAT_1_FAMILY(fconst_1, 0x3F800000)
+DECLR_CONST_CAT_1_FAMILY(fconst_2, 0x40000000)
 
-DECLR_CONST_CAT_2_FAMILY(dconst_0, 0x00000000, 0x00000000, OP_DOUBLE)
-DECLR_CONST_CAT_2_FAMILY(dconst_1, 0x3FF00000, 0x00000000, OP_DOUBLE)
+DECLR_CONST_CAT_2_FAMILY(dconst_0, 0x0000000000000000ll)
+DECLR_CONST_CAT_2_FAMILY(dconst_1, 0x3FF0000000000000ll)
 
 
 uint8_t instfunc_bipush(JavaVirtualMachine* jvm, Frame* frame)
 {
-    if (!pushOperand(&frame->operands, (int8_t)NEXT_BYTE, OP_INTEGER))
+    if (!pushOperand(&frame->operands, (int8_t)NEXT_BYTE))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -90,9 +90,9 @@ uint8_t instfunc_sipush(JavaVirtualMachine* jvm, Frame* frame)
     immediate <<= 8;
     immediate |= NEXT_BYTE;
 
-    if (!pushOperand(&frame->operands, immediate, OP_INTEGER))
+    if (!pushOperand(&frame->operands, immediate))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -101,9 +101,9 @@ uint8_t instfunc_sipush(JavaVirtualMachine* jvm, Frame* frame)
 
 uint8_t instfunc_ldc(JavaVirtualMachine* jvm, Frame* frame)
 {
-    uint32_t value = (uint32_t)NEXT_BYTE;
+    GC_SAFEPOINT(jvm);
 
-    enum OperandType type;
+    uint32_t value = (uint32_t)NEXT_BYTE;
 
     cp_info* cpi = frame->jc->constantPool + value - 1;
 
@@ -111,12 +111,10 @@ uint8_t instfunc_ldc(JavaVirtualMachine* jvm, Frame* frame)
     {
         case CONSTANT_Float:
             value = cpi->Float.bytes;
-            type = OP_FLOAT;
             break;
 
         case CONSTANT_Integer:
             value = cpi->Integer.value;
-            type = OP_INTEGER;
             break;
 
         case CONSTANT_String:
@@ -132,7 +130,6 @@ uint8_t instfunc_ldc(JavaVirtualMachine* jvm, Frame* frame)
             }
 
             value = (int32_t)str;
-            type = OP_REFERENCE;
             break;
         }
 
@@ -158,7 +155,6 @@ uint8_t instfunc_ldc(JavaVirtualMachine* jvm, Frame* frame)
             }
 
             value = (int32_t)obj;
-            type = OP_REFERENCE;
             break;
         }
 
@@ -175,9 +171,9 @@ uint8_t instfunc_ldc(JavaVirtualMachine* jvm, Frame* frame)
             return 0;
     }
 
-    if (!pushOperand(&frame->operands, value, type))
+    if (!pushOperand(&frame->operands, value))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -186,24 +182,22 @@ uint8_t instfunc_ldc(JavaVirtualMachine* jvm, Frame* frame)
 
 uint8_t instfunc_ldc_w(JavaVirtualMachine* jvm, Frame* frame)
 {
+    GC_SAFEPOINT(jvm);
+
     uint32_t value = (uint32_t)NEXT_BYTE;
     value <<= 8;
     value |= NEXT_BYTE;
 
-    enum OperandType type;
-
     cp_info* cpi = frame->jc->constantPool + value - 1;
 
     switch (cpi->tag)
     {
         case CONSTANT_Float:
             value = cpi->Float.bytes;
-            type = OP_FLOAT;
             break;
 
         case CONSTANT_Integer:
             value = cpi->Integer.value;
-            type = OP_INTEGER;
             break;
 
         case CONSTANT_String:
@@ -219,7 +213,6 @@ uint8_t instfunc_ldc_w(JavaVirtualMachine* jvm, Frame* frame)
             }
 
             value = (int32_t)str;
-            type = OP_REFERENCE;
             break;
         }
 
@@ -245,7 +238,6 @@ uint8_t instfunc_ldc_w(JavaVirtualMachine* jvm, Frame* frame)
             }
 
             value = (int32_t)obj;
-            type = OP_REFERENCE;
             break;
         }
 
@@ -262,9 +254,9 @@ uint8_t instfunc_ldc_w(JavaVirtualMachine* jvm, Frame* frame)
             return 0;
     }
 
-    if (!pushOperand(&frame->operands, (int32_t)value, type))
+    if (!pushOperand(&frame->operands, (int32_t)value))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -278,8 +270,6 @@ uint8_t instfunc_ldc2_w(JavaVirtualMachine* jvm, Frame* frame)
     lowvalue <<= 8;
     lowvalue |= NEXT_BYTE;
 
-    enum OperandType type;
-
     cp_info* cpi = frame->jc->constantPool + lowvalue - 1;
 
     switch (cpi->tag)
@@ -287,13 +277,11 @@ uint8_t instfunc_ldc2_w(JavaVirtualMachine* jvm, Frame* frame)
         case CONSTANT_Long:
             highvalue = cpi->Long.high;
             lowvalue = cpi->Long.low;
-            type = OP_LONG;
             break;
 
         case CONSTANT_Double:
             highvalue = cpi->Double.high;
             lowvalue = cpi->Double.low;
-            type = OP_DOUBLE;
             break;
 
         default:
@@ -301,10 +289,9 @@ uint8_t instfunc_ldc2_w(JavaVirtualMachine* jvm, Frame* frame)
             return 0;
     }
 
-    if (!pushOperand(&frame->operands, highvalue, type) ||
-        !pushOperand(&frame->operands, lowvalue,  type))
+    if (!pushWideOperand(&frame->operands, (int64_t)highvalue << 32 | lowvalue))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -313,9 +300,9 @@ uint8_t instfunc_ldc2_w(JavaVirtualMachine* jvm, Frame* frame)
 
 uint8_t instfunc_iload(JavaVirtualMachine* jvm, Frame* frame)
 {
-    if (!pushOperand(&frame->operands, *(frame->localVariables + NEXT_BYTE), OP_INTEGER))
+    if (!pushOperand(&frame->operands, *(frame->localVariables + NEXT_BYTE)))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -326,10 +313,9 @@ uint8_t instfunc_lload(JavaVirtualMachine* jvm, Frame* frame)
 {
     uint8_t index = NEXT_BYTE;
 
-    if (!pushOperand(&frame->operands, *(frame->localVariables + index), OP_LONG) ||
-        !pushOperand(&frame->operands, *(frame->localVariables + index + 1), OP_LONG))
+    if (!pushWideOperand(&frame->operands, frame->localVariables[index]))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -338,9 +324,9 @@ uint8_t instfunc_lload(JavaVirtualMachine* jvm, Frame* frame)
 
 uint8_t instfunc_fload(JavaVirtualMachine* jvm, Frame* frame)
 {
-    if (!pushOperand(&frame->operands, *(frame->localVariables + NEXT_BYTE), OP_FLOAT))
+    if (!pushOperand(&frame->operands, *(frame->localVariables + NEXT_BYTE)))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -351,10 +337,9 @@ uint8_t instfunc_dload(JavaVirtualMachine* jvm, Frame* frame)
 {
     uint8_t index = NEXT_BYTE;
 
-    if (!pushOperand(&frame->operands, *(frame->localVariables + index), OP_DOUBLE) ||
-        !pushOperand(&frame->operands, *(frame->localVariables + index + 1), OP_DOUBLE))
+    if (!pushWideOperand(&frame->operands, frame->localVariables[index]))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -363,9 +348,9 @@ uint8_t instfunc_dload(JavaVirtualMachine* jvm, Frame* frame)
 
 uint8_t instfunc_aload(JavaVirtualMachine* jvm, Frame* frame)
 {
-    if (!pushOperand(&frame->operands, *(frame->localVariables + NEXT_BYTE), OP_REFERENCE))
+    if (!pushOperand(&frame->operands, *(frame->localVariables + NEXT_BYTE)))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -374,12 +359,12 @@ uint8_t instfunc_aload(JavaVirtualMachine* jvm, Frame* frame)
 
 /// @brief Used to automatically generate instructions "lload_<n>",
 /// "fload_<n>" and "aload_<n>".
-#define DECLR_CAT_1_LOAD_N_FAMILY(instructionprefix, value, type) \
+#define DECLR_CAT_1_LOAD_N_FAMILY(instructionprefix, value) \
     uint8_t instfunc_##instructionprefix##_##value(JavaVirtualMachine* jvm, Frame* frame) \
     { \
-        if (!pushOperand(&frame->operands, *(frame->localVariables + value), type)) \
+        if (!pushOperand(&frame->operands, *(frame->localVariables + value))) \
         { \
-            jvm->status = JVM_STATUS_OUT_OF_MEMORY; \
+            jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW; \
             return 0; \
         } \
         return 1; \
@@ -387,53 +372,52 @@ uint8_t instfunc_aload(JavaVirtualMachine* jvm, Frame* frame)
 
 /// @brief Used to automatically generate instructions "dload_<n>"
 /// and "lload_<n>".
-#define DECLR_CAT_2_LOAD_N_FAMILY(instructionprefix, value, type) \
+#define DECLR_CAT_2_LOAD_N_FAMILY(instructionprefix, value) \
     uint8_t instfunc_##instructionprefix##_##value(JavaVirtualMachine* jvm, Frame* frame) \
     { \
-        if (!pushOperand(&frame->operands, *(frame->localVariables + value), type) || \
-            !pushOperand(&frame->operands, *(frame->localVariables + value + 1), type)) \
+        if (!pushWideOperand(&frame->operands, frame->localVariables[value])) \
         { \
-            jvm->status = JVM_STATUS_OUT_OF_MEMORY; \
+            jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW; \
             return 0; \
         } \
         return 1; \
     }
 
-DECLR_CAT_1_LOAD_N_FAMILY(iload, 0, OP_INTEGER)
-DECLR_CAT_1_LOAD_N_FAMILY(iload, 1, OP_INTEGER)
-DECLR_CAT_1_LOAD_N_FAMILY(iload, 2, OP_INTEGER)
-DECLR_CAT_1_LOAD_N_FAMILY(iload, 3, OP_INTEGER)
+DECLR_CAT_1_LOAD_N_FAMILY(iload, 0)
+DECLR_CAT_1_LOAD_N_FAMILY(iload, 1)
+DECLR_CAT_1_LOAD_N_FAMILY(iload, 2)
+DECLR_CAT_1_LOAD_N_FAMILY(iload, 3)
 
-DECLR_CAT_2_LOAD_N_FAMILY(lload, 0, OP_LONG)
-DECLR_CAT_2_LOAD_N_FAMILY(lload, 1, OP_LONG)
-DECLR_CAT_2_LOAD_N_FAMILY(lload, 2, OP_LONG)
-DECLR_CAT_2_LOAD_N_FAMILY(lload, 3, OP_LONG)
+DECLR_CAT_2_LOAD_N_FAMILY(lload, 0)
+DECLR_CAT_2_LOAD_N_FAMILY(lload, 1)
+DECLR_CAT_2_LOAD_N_FAMILY(lload, 2)
+DECLR_CAT_2_LOAD_N_FAMILY(lload, 3)
 
-DECLR_CAT_1_LOAD_N_FAMILY(fload, 0, OP_FLOAT)
-DECLR_CAT_1_LOAD_N_FAMILY(fload, 1, OP_FLOAT)
-DECLR_CAT_1_LOAD_N_FAMILY(fload, 2, OP_FLOAT)
-DECLR_CAT_1_LOAD_N_FAMILY(fload, 3, OP_FLOAT)
+DECLR_CAT_1_LOAD_N_FAMILY(fload, 0)
+DECLR_CAT_1_LOAD_N_FAMILY(fload, 1)
+DECLR_CAT_1_LOAD_N_FAMILY(fload, 2)
+DECLR_CAT_1_LOAD_N_FAMILY(fload, 3)
 
-DECLR_CAT_2_LOAD_N_FAMILY(dload, 0, OP_DOUBLE)
-DECLR_CAT_2_LOAD_N_FAMILY(dload, 1, OP_DOUBLE)
-DECLR_CAT_2_LOAD_N_FAMILY(dload, 2, OP_DOUBLE)
-DECLR_CAT_2_LOAD_N_FAMILY(dload, 3, OP_DOUBLE)
+DECLR_CAT_2_LOAD_N_FAMILY(dload, 0)
+DECLR_CAT_2_LOAD_N_FAMILY(dload, 1)
+DECLR_CAT_2_LOAD_N_FAMILY(dload, 2)
+DECLR_CAT_2_LOAD_N_FAMILY(dload, 3)
 
-DECLR_CAT_1_LOAD_N_FAMILY(aload, 0, OP_REFERENCE)
-DECLR_CAT_1_LOAD_N_FAMILY(aload, 1, OP_REFERENCE)
-DECLR_CAT_1_LOAD_N_FAMILY(aload, 2, OP_REFERENCE)
-DECLR_CAT_1_LOAD_N_FAMILY(aload, 3, OP_REFERENCE)
+DECLR_CAT_1_LOAD_N_FAMILY(aload, 0)
+DECLR_CAT_1_LOAD_N_FAMILY(aload, 1)
+DECLR_CAT_1_LOAD_N_FAMILY(aload, 2)
+DECLR_CAT_1_LOAD_N_FAMILY(aload, 3)
 
 /// @brief Used to automatically generate instructions "iaload", "faload",
 /// "baload", "saload" and "caload".
-#define DECLR_ALOAD_CAT_1_FAMILY(instructionname, type, op_type) \
+#define DECLR_ALOAD_CAT_1_FAMILY(instructionname, type) \
     uint8_t instfunc_##instructionname(JavaVirtualMachine* jvm, Frame* frame) \
     { \
         int32_t index; \
         int32_t arrayref; \
         Reference* obj; \
-        popOperand(&frame->operands, &index, NULL); \
-        popOperand(&frame->operands, &arrayref, NULL); \
+        popOperand(&frame->operands, &index); \
+        popOperand(&frame->operands, &arrayref); \
         obj = (Reference*)arrayref; \
         if (obj == NULL) \
         { \
@@ -448,9 +432,9 @@ DECLR_CAT_1_LOAD_N_FAMILY(aload, 3, OP_REFERENCE)
             return 0; \
         } \
         type* ptr = (type*)obj->arr.data; \
-        if (!pushOperand(&frame->operands, ptr[index], op_type)) \
+        if (!pushOperand(&frame->operands, ptr[index])) \
         { \
-            jvm->status = JVM_STATUS_OUT_OF_MEMORY; \
+            jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW; \
             return 0; \
         } \
         return 1; \
@@ -458,14 +442,14 @@ DECLR_CAT_1_LOAD_N_FAMILY(aload, 3, OP_REFERENCE)
 
 /// @brief Used to automatically generate instructions "laload" and
 /// "daload".
-#define DECLR_ALOAD_CAT_2_FAMILY(instructionname, type, op_type) \
+#define DECLR_ALOAD_CAT_2_FAMILY(instructionname, type) \
     uint8_t instfunc_##instructionname(JavaVirtualMachine* jvm, Frame* frame) \
     { \
         int32_t index; \
         int32_t arrayref; \
         Reference* obj; \
-        popOperand(&frame->operands, &index, NULL); \
-        popOperand(&frame->operands, &arrayref, NULL); \
+        popOperand(&frame->operands, &index); \
+        popOperand(&frame->operands, &arrayref); \
         obj = (Reference*)arrayref; \
         if (obj == NULL) \
         { \
@@ -480,22 +464,21 @@ DECLR_CAT_1_LOAD_N_FAMILY(aload, 3, OP_REFERENCE)
             return 0; \
         } \
         type* ptr = (type*)obj->arr.data; \
-        if (!pushOperand(&frame->operands, HIWORD(ptr[index]), op_type) || \
-            !pushOperand(&frame->operands, LOWORD(ptr[index]), op_type)) \
+        if (!pushWideOperand(&frame->operands, ptr[index])) \
         { \
-            jvm->status = JVM_STATUS_OUT_OF_MEMORY; \
+            jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW; \
             return 0; \
         } \
         return 1; \
     }
 
-DECLR_ALOAD_CAT_1_FAMILY(iaload, int32_t, OP_INTEGER)
-DECLR_ALOAD_CAT_2_FAMILY(laload, int64_t, OP_INTEGER)
-DECLR_ALOAD_CAT_1_FAMILY(faload, int32_t, OP_FLOAT)
-DECLR_ALOAD_CAT_2_FAMILY(daload, int64_t, OP_INTEGER)
-DECLR_ALOAD_CAT_1_FAMILY(baload, int8_t, OP_INTEGER)
-DECLR_ALOAD_CAT_1_FAMILY(saload, int16_t, OP_INTEGER)
-DECLR_ALOAD_CAT_1_FAMILY(caload, int16_t, OP_INTEGER)
+DECLR_ALOAD_CAT_1_FAMILY(iaload, int32_t)
+DECLR_ALOAD_CAT_2_FAMILY(laload, int64_t)
+DECLR_ALOAD_CAT_1_FAMILY(faload, int32_t)
+DECLR_ALOAD_CAT_2_FAMILY(daload, int64_t)
+DECLR_ALOAD_CAT_1_FAMILY(baload, int8_t)
+DECLR_ALOAD_CAT_1_FAMILY(saload, int16_t)
+DECLR_ALOAD_CAT_1_FAMILY(caload, int16_t)
 
 uint8_t instfunc_aaload(JavaVirtualMachine* jvm, Frame* frame)
 {
@@ -503,8 +486,8 @@ uint8_t instfunc_aaload(JavaVirtualMachine* jvm, Frame* frame)
     int32_t arrayref;
     Reference* obj;
 
-    popOperand(&frame->operands, &index, NULL);
-    popOperand(&frame->operands, &arrayref, NULL);
+    popOperand(&frame->operands, &index);
+    popOperand(&frame->operands, &arrayref);
 
     obj = (Reference*)arrayref;
 
@@ -524,9 +507,9 @@ uint8_t instfunc_aaload(JavaVirtualMachine* jvm, Frame* frame)
 
     Reference** ptr = (Reference**)obj->oar.elements;
 
-    if (!pushOperand(&frame->operands, (int32_t)ptr[index], OP_REFERENCE))
+    if (!pushOperand(&frame->operands, (int32_t)ptr[index]))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -539,7 +522,7 @@ uint8_t instfunc_aaload(JavaVirtualMachine* jvm, Frame* frame)
     uint8_t instfunc_##instructionprefix(JavaVirtualMachine* jvm, Frame* frame) \
     { \
         int32_t operand; \
-        popOperand(&frame->operands, &operand, NULL); \
+        popOperand(&frame->operands, &operand); \
         *(frame->localVariables + NEXT_BYTE) = operand; \
         return 1; \
     }
@@ -550,12 +533,7 @@ uint8_t instfunc_aaload(JavaVirtualMachine* jvm, Frame* frame)
     uint8_t instfunc_##instructionprefix(JavaVirtualMachine* jvm, Frame* frame) \
     { \
         uint8_t index = NEXT_BYTE; \
-        int32_t highoperand; \
-        int32_t lowoperand; \
-        popOperand(&frame->operands, &lowoperand, NULL); \
-        popOperand(&frame->operands, &highoperand, NULL); \
-        *(frame->localVariables + index) = highoperand; \
-        *(frame->localVariables + index + 1) = lowoperand; \
+        popWideOperand(&frame->operands, frame->localVariables + index); \
         return 1; \
     }
 
@@ -571,7 +549,7 @@ DECLR_STORE_CAT_1_FAMILY(astore)
     uint8_t instfunc_##instructionprefix##_##N(JavaVirtualMachine* jvm, Frame* frame) \
     { \
         int32_t operand; \
-        popOperand(&frame->operands, &operand, NULL); \
+        popOperand(&frame->operands, &operand); \
         *(frame->localVariables + N) = operand; \
         return 1; \
     }
@@ -581,12 +559,7 @@ DECLR_STORE_CAT_1_FAMILY(astore)
 #define DECLR_STORE_N_CAT_2_FAMILY(instructionprefix, N) \
     uint8_t instfunc_##instructionprefix##_##N(JavaVirtualMachine* jvm, Frame* frame) \
     { \
-        int32_t highoperand; \
-        int32_t lowoperand; \
-        popOperand(&frame->operands, &lowoperand, NULL); \
-        popOperand(&frame->operands, &highoperand, NULL); \
-        *(frame->localVariables + N) = highoperand; \
-        *(frame->localVariables + N + 1) = lowoperand; \
+        popWideOperand(&frame->operands, frame->localVariables + N); \
         return 1; \
     }
 
@@ -624,9 +597,9 @@ DECLR_STORE_N_CAT_1_FAMILY(astore, 3)
         int32_t index; \
         int32_t arrayref; \
         Reference* obj; \
-        popOperand(&frame->operands, &operand, NULL); \
-        popOperand(&frame->operands, &index, NULL); \
-        popOperand(&frame->operands, &arrayref, NULL); \
+        popOperand(&frame->operands, &operand); \
+        popOperand(&frame->operands, &index); \
+        popOperand(&frame->operands, &arrayref); \
         obj = (Reference*)arrayref; \
         if (obj == NULL) \
         { \
@@ -656,15 +629,13 @@ DECLR_ASTORE_CAT_1_FAMILY(fastore, int32_t)
 #define DECLR_ASTORE_CAT_2_FAMILY(instructionname) \
     uint8_t instfunc_##instructionname(JavaVirtualMachine* jvm, Frame* frame) \
     { \
-        int32_t highoperand; \
-        int32_t lowoperand; \
+        int64_t operand; \
         int32_t index; \
         int32_t arrayref; \
         Reference* obj; \
-        popOperand(&frame->operands, &lowoperand, NULL); \
-        popOperand(&frame->operands, &highoperand, NULL); \
-        popOperand(&frame->operands, &index, NULL); \
-        popOperand(&frame->operands, &arrayref, NULL); \
+        popWideOperand(&frame->operands, &operand); \
+        popOperand(&frame->operands, &index); \
+        popOperand(&frame->operands, &arrayref); \
         obj = (Reference*)arrayref; \
         if (obj == NULL) \
         { \
@@ -679,7 +650,7 @@ DECLR_ASTORE_CAT_1_FAMILY(fastore, int32_t)
             return 0; \
         } \
         int64_t* ptr = (int64_t*)obj->arr.data; \
-        ptr[index] = ((int64_t)highoperand << 32) | (uint32_t)lowoperand; \
+        ptr[index] = operand; \
         return 1; \
     }
 
@@ -695,9 +666,9 @@ uint8_t instfunc_aastore(JavaVirtualMachine* jvm, Frame* frame)
     Reference* arrayobj;
     Reference* element;
 
-    popOperand(&frame->operands, &operand, NULL);
-    popOperand(&frame->operands, &index, NULL);
-    popOperand(&frame->operands, &arrayref, NULL);
+    popOperand(&frame->operands, &operand);
+    popOperand(&frame->operands, &index);
+    popOperand(&frame->operands, &arrayref);
 
     arrayobj = (Reference*)arrayref;
     element = (Reference*)operand;
@@ -725,22 +696,26 @@ uint8_t instfunc_aastore(JavaVirtualMachine* jvm, Frame* frame)
 
 uint8_t instfunc_pop(JavaVirtualMachine* jvm, Frame* frame)
 {
-    popOperand(&frame->operands, NULL, NULL);
+    popOperand(&frame->operands, NULL);
     return 1;
 }
 
 uint8_t instfunc_pop2(JavaVirtualMachine* jvm, Frame* frame)
 {
-    popOperand(&frame->operands, NULL, NULL);
-    popOperand(&frame->operands, NULL, NULL);
+    popOperand(&frame->operands, NULL);
+    popOperand(&frame->operands, NULL);
     return 1;
 }
 
 uint8_t instfunc_dup(JavaVirtualMachine* jvm, Frame* frame)
 {
-    if (!pushOperand(&frame->operands, frame->operands->value, frame->operands->type))
+    Slot operand;
+
+    peekSlot(&frame->operands, 0, &operand);
+
+    if (!pushSlot(&frame->operands, operand))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
     return 1;
@@ -748,79 +723,57 @@ uint8_t instfunc_dup(JavaVirtualMachine* jvm, Frame* frame)
 
 uint8_t instfunc_dup_x1(JavaVirtualMachine* jvm, Frame* frame)
 {
-    // Suppose our stack is: A -> B -> ...
-    // We want to duplicate A (top node), but moving it down 2 slots
-    // The stack should look like: A -> B -> A -> ...
+    Slot operand1, operand2;
 
+    // Stack is: ..., operand2, operand1
+    // and becomes: ..., operand1, operand2, operand1
+    popSlot(&frame->operands, &operand1);
+    popSlot(&frame->operands, &operand2);
 
-    // We duplicate the top operand, so the stack will be: A -> A -> B -> ...
-    // Calling one of the duplicated A as C, the stack is: A -> C -> B -> ...
-    // And our objective (using node C terminology) is:    A -> B -> C -> ...
-    if (!pushOperand(&frame->operands, frame->operands->value, frame->operands->type))
+    if (!pushSlot(&frame->operands, operand1) ||
+        !pushSlot(&frame->operands, operand2) ||
+        !pushSlot(&frame->operands, operand1))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
-    // Current stack is: A -> C -> B -> ...
-    OperandStack* nodeA = frame->operands;
-    OperandStack* nodeC = nodeA->next;
-    OperandStack* nodeB = nodeC->next;
-
-    // Switching node C and node B:
-    nodeA->next = nodeB;        // Stack: A -> B -> ...  |  C -> B -> ...
-    nodeC->next = nodeB->next;  // Stack: A -> B -> ...  |  C -> ...
-    nodeB->next = nodeC;        // Stack: A -> B -> C -> ...
-
-    // Another implementation (changing content instead of pointers):
-    /*
-    OperandStack temp = *nodeC;
-    *nodeC = *nodeB;
-    *nodeB = temp;
-    */
-
     return 1;
 }
 
 uint8_t instfunc_dup_x2(JavaVirtualMachine* jvm, Frame* frame)
 {
-    // Suppose our stack is: A -> B -> C -> ...
-    // We want to duplicate A (top node), but moving it down 3 slots
-    // The stack should look like: A -> B -> C -> A -> ...
+    Slot operand1, operand2, operand3;
 
+    // Stack is: ..., operand3, operand2, operand1
+    // and becomes: ..., operand1, operand3, operand2, operand1
+    popSlot(&frame->operands, &operand1);
+    popSlot(&frame->operands, &operand2);
+    popSlot(&frame->operands, &operand3);
 
-    // We duplicate the top operand, so the stack will be: A -> A -> B -> C -> ...
-    // Calling one of the duplicated A as D, the stack is: A -> D -> B -> C -> ...
-    // And our objective (using node D terminology) is:    A -> B -> C -> D -> ...
-    if (!pushOperand(&frame->operands, frame->operands->value, frame->operands->type))
+    if (!pushSlot(&frame->operands, operand1) ||
+        !pushSlot(&frame->operands, operand3) ||
+        !pushSlot(&frame->operands, operand2) ||
+        !pushSlot(&frame->operands, operand1))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
-    // Current stack is: A -> D -> B -> C -> ...
-    OperandStack* nodeA = frame->operands;
-    OperandStack* nodeD = nodeA->next;
-    OperandStack* nodeB = nodeD->next;
-    OperandStack* nodeC = nodeB->next;
-
-    // Switching node D and node C:
-    nodeA->next = nodeB;        // Stack: A -> B -> C -> ...  |  D -> B -> C -> ...
-    nodeD->next = nodeC->next;  // Stack: A -> B -> C -> ...  |  D -> ...
-    nodeC->next = nodeD;        // Stack: A -> B -> C -> D -> ...
-
     return 1;
 }
 
 uint8_t instfunc_dup2(JavaVirtualMachine* jvm, Frame* frame)
 {
-    OperandStack* node1 = frame->operands;
-    OperandStack* node2 = node1->next;
+    Slot operand1, operand2;
+
+    peekSlot(&frame->operands, 0, &operand1);
+    peekSlot(&frame->operands, 1, &operand2);
 
-    if (!pushOperand(&frame->operands, node2->value, node2->type) ||
-        !pushOperand(&frame->operands, node1->value, node1->type))
+    if (!pushSlot(&frame->operands, operand2) ||
+        !pushSlot(&frame->operands, operand1))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -829,24 +782,22 @@ uint8_t instfunc_dup2(JavaVirtualMachine* jvm, Frame* frame)
 
 uint8_t instfunc_dup2_x1(JavaVirtualMachine* jvm, Frame* frame)
 {
-    int32_t operand1, operand2, operand3;
-    OperandType type1, type2, type3;
+    Slot operand1, operand2, operand3;
 
     // Pop the operand and then push them again.
     // This method is easier to implement, but it is
-    // less efficient, since there is the need to free
-    // and malloc memory again.
-    popOperand(&frame->operands, &operand1, &type1);
-    popOperand(&frame->operands, &operand2, &type2);
-    popOperand(&frame->operands, &operand3, &type3);
-
-    if (!pushOperand(&frame->operands, operand2, type2) ||
-        !pushOperand(&frame->operands, operand1, type1) ||
-        !pushOperand(&frame->operands, operand3, type3) ||
-        !pushOperand(&frame->operands, operand2, type2) ||
-        !pushOperand(&frame->operands, operand1, type1))
+    // less efficient than moving the slots in place.
+    popSlot(&frame->operands, &operand1);
+    popSlot(&frame->operands, &operand2);
+    popSlot(&frame->operands, &operand3);
+
+    if (!pushSlot(&frame->operands, operand2) ||
+        !pushSlot(&frame->operands, operand1) ||
+        !pushSlot(&frame->operands, operand3) ||
+        !pushSlot(&frame->operands, operand2) ||
+        !pushSlot(&frame->operands, operand1))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -855,26 +806,24 @@ uint8_t instfunc_dup2_x1(JavaVirtualMachine* jvm, Frame* frame)
 
 uint8_t instfunc_dup2_x2(JavaVirtualMachine* jvm, Frame* frame)
 {
-    int32_t operand1, operand2, operand3, operand4;
-    OperandType type1, type2, type3, type4;
+    Slot operand1, operand2, operand3, operand4;
 
     // Pop the operand and then push them again.
     // This method is easier to implement, but it is
-    // less efficient, since there is the need to free
-    // and malloc memory again.
-    popOperand(&frame->operands, &operand1, &type1);
-    popOperand(&frame->operands, &operand2, &type2);
-    popOperand(&frame->operands, &operand3, &type3);
-    popOperand(&frame->operands, &operand4, &type4);
-
-    if (!pushOperand(&frame->operands, operand2, type2) ||
-        !pushOperand(&frame->operands, operand1, type1) ||
-        !pushOperand(&frame->operands, operand4, type4) ||
-        !pushOperand(&frame->operands, operand3, type3) ||
-        !pushOperand(&frame->operands, operand2, type2) ||
-        !pushOperand(&frame->operands, operand1, type1))
+    // less efficient than moving the slots in place.
+    popSlot(&frame->operands, &operand1);
+    popSlot(&frame->operands, &operand2);
+    popSlot(&frame->operands, &operand3);
+    popSlot(&frame->operands, &operand4);
+
+    if (!pushSlot(&frame->operands, operand2) ||
+        !pushSlot(&frame->operands, operand1) ||
+        !pushSlot(&frame->operands, operand4) ||
+        !pushSlot(&frame->operands, operand3) ||
+        !pushSlot(&frame->operands, operand2) ||
+        !pushSlot(&frame->operands, operand1))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -883,12 +832,12 @@ uint8_t instfunc_dup2_x2(JavaVirtualMachine* jvm, Frame* frame)
 
 uint8_t instfunc_swap(JavaVirtualMachine* jvm, Frame* frame)
 {
-    OperandStack* node1 = frame->operands;
-    OperandStack* node2 = node1->next;
+    Slot operand1, operand2;
 
-    frame->operands = node2;
-    node1->next = node2->next;
-    node2->next = node1;
+    popSlot(&frame->operands, &operand1);
+    popSlot(&frame->operands, &operand2);
+    pushSlot(&frame->operands, operand1);
+    pushSlot(&frame->operands, operand2);
     return 1;
 }
 
@@ -898,11 +847,11 @@ uint8_t instfunc_swap(JavaVirtualMachine* jvm, Frame* frame)
     uint8_t instfunc_##instruction(JavaVirtualMachine* jvm, Frame* frame) \
     { \
         int32_t value1, value2; \
-        popOperand(&frame->operands, &value2, NULL); \
-        popOperand(&frame->operands, &value1, NULL); \
-        if (!pushOperand(&frame->operands, value1 op value2, OP_INTEGER)) \
+        popOperand(&frame->operands, &value2); \
+        popOperand(&frame->operands, &value1); \
+        if (!pushOperand(&frame->operands, value1 op value2)) \
         { \
-            jvm->status = JVM_STATUS_OUT_OF_MEMORY; \
+            jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW; \
             return 0; \
         } \
         return 1; \
@@ -921,12 +870,12 @@ uint8_t instfunc_ishl(JavaVirtualMachine* jvm, Frame* frame)
 {
     int32_t value1, value2;
 
-    popOperand(&frame->operands, &value2, NULL);
-    popOperand(&frame->operands, &value1, NULL);
+    popOperand(&frame->operands, &value2);
+    popOperand(&frame->operands, &value1);
 
-    if (!pushOperand(&frame->operands, value1 << (value2 & 0x1F), OP_INTEGER))
+    if (!pushOperand(&frame->operands, value1 << (value2 & 0x1F)))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -937,12 +886,12 @@ uint8_t instfunc_ishr(JavaVirtualMachine* jvm, Frame* frame)
 {
     int32_t value1, value2;
 
-    popOperand(&frame->operands, &value2, NULL);
-    popOperand(&frame->operands, &value1, NULL);
+    popOperand(&frame->operands, &value2);
+    popOperand(&frame->operands, &value1);
 
-    if (!pushOperand(&frame->operands, value1 >> (value2 & 0x1F), OP_INTEGER))
+    if (!pushOperand(&frame->operands, value1 >> (value2 & 0x1F)))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -953,12 +902,12 @@ uint8_t instfunc_iushr(JavaVirtualMachine* jvm, Frame* frame)
 {
     uint32_t value1, value2;
 
-    popOperand(&frame->operands, (int32_t*)&value2, NULL);
-    popOperand(&frame->operands, (int32_t*)&value1, NULL);
+    popOperand(&frame->operands, (int32_t*)&value2);
+    popOperand(&frame->operands, (int32_t*)&value1);
 
-    if (!pushOperand(&frame->operands, value1 >> (value2 & 0x1F), OP_INTEGER))
+    if (!pushOperand(&frame->operands, value1 >> (value2 & 0x1F)))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -971,20 +920,12 @@ uint8_t instfunc_iushr(JavaVirtualMachine* jvm, Frame* frame)
     uint8_t instfunc_##instruction(JavaVirtualMachine* jvm, Frame* frame) \
     { \
         int64_t value1, value2; \
-        int32_t high, low; \
-        popOperand(&frame->operands, &low, NULL); \
-        popOperand(&frame->operands, &high, NULL); \
-        value2 = high; \
-        value2 = value2 << 32 | (uint32_t)low; \
-        popOperand(&frame->operands, &low, NULL); \
-        popOperand(&frame->operands, &high, NULL); \
-        value1 = high; \
-        value1 = value1 << 32 | (uint32_t)low; \
+        popWideOperand(&frame->operands, &value2); \
+        popWideOperand(&frame->operands, &value1); \
         value1 = value1 op value2; \
-        if (!pushOperand(&frame->operands, HIWORD(value1), OP_LONG) || \
-            !pushOperand(&frame->operands, LOWORD(value1), OP_LONG)) \
+        if (!pushWideOperand(&frame->operands, value1)) \
         { \
-            jvm->status = JVM_STATUS_OUT_OF_MEMORY; \
+            jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW; \
             return 0; \
         } \
         return 1; \
@@ -1003,21 +944,15 @@ uint8_t instfunc_lshl(JavaVirtualMachine* jvm, Frame* frame)
 {
     int64_t value1;
     int32_t value2;
-    int32_t high, low;
 
-    popOperand(&frame->operands, &value2, NULL);
-    popOperand(&frame->operands, &low, NULL);
-    popOperand(&frame->operands, &high, NULL);
-
-    value1 = high;
-    value1 = (value1 << 32) | (uint32_t)low;
+    popOperand(&frame->operands, &value2);
+    popWideOperand(&frame->operands, &value1);
 
     value1 = value1 << (value2 & 0x3F);
 
-    if (!pushOperand(&frame->operands, HIWORD(value1), OP_LONG) ||
-        !pushOperand(&frame->operands, LOWORD(value1), OP_LONG))
+    if (!pushWideOperand(&frame->operands, value1))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
     return 1;
@@ -1027,21 +962,15 @@ uint8_t instfunc_lshr(JavaVirtualMachine* jvm, Frame* frame)
 {
     int64_t value1;
     int32_t value2;
-    int32_t high, low;
-
-    popOperand(&frame->operands, &value2, NULL);
-    popOperand(&frame->operands, &low, NULL);
-    popOperand(&frame->operands, &high, NULL);
 
-    value1 = high;
-    value1 = (value1 << 32) | (uint32_t)low;
+    popOperand(&frame->operands, &value2);
+    popWideOperand(&frame->operands, &value1);
 
     value1 = value1 >> (value2 & 0x3F);
 
-    if (!pushOperand(&frame->operands, HIWORD(value1), OP_LONG) ||
-        !pushOperand(&frame->operands, LOWORD(value1), OP_LONG))
+    if (!pushWideOperand(&frame->operands, value1))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
     return 1;
@@ -1049,23 +978,17 @@ uint8_t instfunc_lshr(JavaVirtualMachine* jvm, Frame* frame)
 
 uint8_t instfunc_lushr(JavaVirtualMachine* jvm, Frame* frame)
 {
-    uint64_t value1;
-    uint32_t value2;
-    uint32_t high, low;
-
-    popOperand(&frame->operands, (int32_t*)&value2, NULL);
-    popOperand(&frame->operands, (int32_t*)&low, NULL);
-    popOperand(&frame->operands, (int32_t*)&high, NULL);
+    int64_t value1;
+    int32_t value2;
 
-    value1 = high;
-    value1 = (value1 << 32) | (uint32_t)low;
+    popOperand(&frame->operands, &value2);
+    popWideOperand(&frame->operands, &value1);
 
-    value1 = value1 >> (value2 & 0x3F);
+    value1 = (int64_t)((uint64_t)value1 >> (value2 & 0x3F));
 
-    if (!pushOperand(&frame->operands, HIWORD(value1), OP_LONG) ||
-        !pushOperand(&frame->operands, LOWORD(value1), OP_LONG))
+    if (!pushWideOperand(&frame->operands, value1))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
     return 1;
@@ -1080,12 +1003,12 @@ uint8_t instfunc_lushr(JavaVirtualMachine* jvm, Frame* frame)
             float f; \
             int32_t i; \
         } value1, value2; \
-        popOperand(&frame->operands, &value2.i, NULL); \
-        popOperand(&frame->operands, &value1.i, NULL); \
+        popOperand(&frame->operands, &value2.i); \
+        popOperand(&frame->operands, &value1.i); \
         value1.f = value1.f op value2.f; \
-        if (!pushOperand(&frame->operands, value1.i, OP_FLOAT)) \
+        if (!pushOperand(&frame->operands, value1.i)) \
         { \
-            jvm->status = JVM_STATUS_OUT_OF_MEMORY; \
+            jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW; \
             return 0; \
         } \
         return 1; \
@@ -1105,20 +1028,12 @@ DECLR_FLOAT_MATH_OP(fdiv, /)
             double d; \
             int64_t i; \
         } value1, value2; \
-        int32_t high, low; \
-        popOperand(&frame->operands, &low, NULL); \
-        popOperand(&frame->operands, &high, NULL); \
-        value2.i = high; \
-        value2.i = (value2.i << 32) | (uint32_t)low; \
-        popOperand(&frame->operands, &low, NULL); \
-        popOperand(&frame->operands, &high, NULL); \
-        value1.i = high; \
-        value1.i = (value1.i << 32) | (uint32_t)low; \
+        popWideOperand(&frame->operands, &value2.i); \
+        popWideOperand(&frame->operands, &value1.i); \
         value1.d = value1.d op value2.d; \
-        if (!pushOperand(&frame->operands, HIWORD(value1.i), OP_DOUBLE) || \
-            !pushOperand(&frame->operands, LOWORD(value1.i), OP_DOUBLE)) \
+        if (!pushWideOperand(&frame->operands, value1.i)) \
         { \
-            jvm->status = JVM_STATUS_OUT_OF_MEMORY; \
+            jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW; \
             return 0; \
         } \
         return 1; \
@@ -1136,8 +1051,8 @@ uint8_t instfunc_frem(JavaVirtualMachine* jvm, Frame* frame)
         int32_t i;
     } value1, value2;
 
-    popOperand(&frame->operands, &value2.i, NULL);
-    popOperand(&frame->operands, &value1.i, NULL);
+    popOperand(&frame->operands, &value2.i);
+    popOperand(&frame->operands, &value1.i);
 
     // When the dividend is finite and the divisor is infinity, the result should
     // be equal to the dividend. So we do nothing to 'a'.
@@ -1146,9 +1061,9 @@ uint8_t instfunc_frem(JavaVirtualMachine* jvm, Frame* frame)
     if (!(value1.f != INFINITY && value1.f != -INFINITY && (value2.f == INFINITY || value2.f == -INFINITY)))
         value1.f = fmodf(value1.f, value2.f);
 
-    if (!pushOperand(&frame->operands, value1.i, OP_FLOAT))
+    if (!pushOperand(&frame->operands, value1.i))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -1162,19 +1077,8 @@ uint8_t instfunc_drem(JavaVirtualMachine* jvm, Frame* frame)
         int64_t i;
     } value1, value2;
 
-    int32_t high, low;
-
-    popOperand(&frame->operands, &low, NULL);
-    popOperand(&frame->operands, &high, NULL);
-
-    value2.i = high;
-    value2.i = (value2.i << 32) | (uint32_t)low;
-
-    popOperand(&frame->operands, &low, NULL);
-    popOperand(&frame->operands, &high, NULL);
-
-    value1.i = high;
-    value1.i = (value1.i << 32) | (uint32_t)low;
+    popWideOperand(&frame->operands, &value2.i);
+    popWideOperand(&frame->operands, &value1.i);
 
     // When the dividend is finite and the divisor is infinity, the result should
     // be equal to the dividend. So we do nothing to 'a'.
@@ -1183,10 +1087,9 @@ uint8_t instfunc_drem(JavaVirtualMachine* jvm, Frame* frame)
     if (!(value1.d != INFINITY && value1.d != -INFINITY && (value2.d == INFINITY || value2.d == -INFINITY)))
         value1.d = fmod(value1.d, value2.d);
 
-    if (!pushOperand(&frame->operands, HIWORD(value1.i), OP_DOUBLE) ||
-        !pushOperand(&frame->operands, LOWORD(value1.i), OP_DOUBLE))
+    if (!pushWideOperand(&frame->operands, value1.i))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -1196,12 +1099,12 @@ uint8_t instfunc_drem(JavaVirtualMachine* jvm, Frame* frame)
 uint8_t instfunc_ineg(JavaVirtualMachine* jvm, Frame* frame)
 {
     int32_t value;
-    popOperand(&frame->operands, &value, NULL);
+    popOperand(&frame->operands, &value);
     value = -value;
 
-    if (!pushOperand(&frame->operands, value, OP_INTEGER))
+    if (!pushOperand(&frame->operands, value))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -1211,19 +1114,13 @@ uint8_t instfunc_ineg(JavaVirtualMachine* jvm, Frame* frame)
 uint8_t instfunc_lneg(JavaVirtualMachine* jvm, Frame* frame)
 {
     int64_t value;
-    int32_t high, low;
-
-    popOperand(&frame->operands, &low, NULL);
-    popOperand(&frame->operands, &high, NULL);
 
-    value = high;
-    value = (value << 32) | (uint32_t)low;
+    popWideOperand(&frame->operands, &value);
     value = -value;
 
-    if (!pushOperand(&frame->operands, HIWORD(value), OP_LONG) ||
-        !pushOperand(&frame->operands, LOWORD(value), OP_LONG))
+    if (!pushWideOperand(&frame->operands, value))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -1237,13 +1134,13 @@ uint8_t instfunc_fneg(JavaVirtualMachine* jvm, Frame* frame)
         int32_t i;
     } value;
 
-    popOperand(&frame->operands, &value.i, NULL);
+    popOperand(&frame->operands, &value.i);
 
     value.f = -value.f;
 
-    if (!pushOperand(&frame->operands, value.i, OP_FLOAT))
+    if (!pushOperand(&frame->operands, value.i))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -1257,19 +1154,12 @@ uint8_t instfunc_dneg(JavaVirtualMachine* jvm, Frame* frame)
         int64_t i;
     } value;
 
-    int32_t high, low;
-
-    popOperand(&frame->operands, &low, NULL);
-    popOperand(&frame->operands, &high, NULL);
-
-    value.i = high;
-    value.i = (value.i << 32) | (uint32_t)low;
+    popWideOperand(&frame->operands, &value.i);
     value.d = -value.d;
 
-    if (!pushOperand(&frame->operands, HIWORD(value.i), OP_DOUBLE) ||
-        !pushOperand(&frame->operands, LOWORD(value.i), OP_DOUBLE))
+    if (!pushWideOperand(&frame->operands, value.i))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -1280,7 +1170,7 @@ uint8_t instfunc_iinc(JavaVirtualMachine* jvm, Frame* frame)
 {
     uint8_t index = NEXT_BYTE;
     int8_t immediate = (int8_t)NEXT_BYTE;
-    frame->localVariables[index] += (int32_t)immediate;
+    frame->localVariables[index] = (int32_t)frame->localVariables[index] + immediate;
     return 1;
 }
 
@@ -1289,14 +1179,13 @@ uint8_t instfunc_i2l(JavaVirtualMachine* jvm, Frame* frame)
     int64_t value;
     int32_t temp;
 
-    popOperand(&frame->operands, &temp, NULL);
+    popOperand(&frame->operands, &temp);
 
     value = temp;
 
-    if (!pushOperand(&frame->operands, HIWORD(value), OP_LONG) ||
-        !pushOperand(&frame->operands, LOWORD(value), OP_LONG))
+    if (!pushWideOperand(&frame->operands, value))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -1310,12 +1199,12 @@ uint8_t instfunc_i2f(JavaVirtualMachine* jvm, Frame* frame)
         int32_t i;
     } value;
 
-    popOperand(&frame->operands, &value.i, NULL);
+    popOperand(&frame->operands, &value.i);
     value.f = (float)value.i;
 
-    if (!pushOperand(&frame->operands, value.i, OP_FLOAT))
+    if (!pushOperand(&frame->operands, value.i))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -1331,13 +1220,12 @@ uint8_t instfunc_i2d(JavaVirtualMachine* jvm, Frame* frame)
 
     int32_t temp;
 
-    popOperand(&frame->operands, &temp, NULL);
+    popOperand(&frame->operands, &temp);
     value.d = (double)temp;
 
-    if (!pushOperand(&frame->operands, HIWORD(value.i), OP_DOUBLE) ||
-        !pushOperand(&frame->operands, LOWORD(value.i), OP_DOUBLE))
+    if (!pushWideOperand(&frame->operands, value.i))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -1346,14 +1234,13 @@ uint8_t instfunc_i2d(JavaVirtualMachine* jvm, Frame* frame)
 
 uint8_t instfunc_l2i(JavaVirtualMachine* jvm, Frame* frame)
 {
-    int32_t temp;
+    int64_t value;
 
-    popOperand(&frame->operands, &temp, NULL);
-    popOperand(&frame->operands, NULL, NULL);
+    popWideOperand(&frame->operands, &value);
 
-    if (!pushOperand(&frame->operands, temp, OP_INTEGER))
+    if (!pushOperand(&frame->operands, (int32_t)value))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -1369,18 +1256,12 @@ uint8_t instfunc_l2f(JavaVirtualMachine* jvm, Frame* frame)
         int32_t i;
     } temp;
 
-    int32_t low, high;
-
-    popOperand(&frame->operands, &low, NULL);
-    popOperand(&frame->operands, &high, NULL);
-
-    lval = high;
-    lval = (lval << 32) | (uint32_t)low;
+    popWideOperand(&frame->operands, &lval);
     temp.f = (float)lval;
 
-    if (!pushOperand(&frame->operands, temp.i, OP_FLOAT))
+    if (!pushOperand(&frame->operands, temp.i))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -1394,21 +1275,12 @@ uint8_t instfunc_l2d(JavaVirtualMachine* jvm, Frame* frame)
         int64_t i;
     } val;
 
-    int32_t temp;
-
-    popOperand(&frame->operands, &temp, NULL);
-
-    val.i = temp;
-
-    popOperand(&frame->operands, &temp, NULL);
-
-    val.i = (val.i << 32) | (uint32_t)temp;
+    popWideOperand(&frame->operands, &val.i);
     val.d = (double)val.i;
 
-    if (!pushOperand(&frame->operands, HIWORD(val.i), OP_DOUBLE) ||
-        !pushOperand(&frame->operands, LOWORD(val.i), OP_DOUBLE))
+    if (!pushWideOperand(&frame->operands, val.i))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -1422,12 +1294,12 @@ uint8_t instfunc_f2i(JavaVirtualMachine* jvm, Frame* frame)
         int32_t i;
     } value;
 
-    popOperand(&frame->operands, &value.i, NULL);
+    popOperand(&frame->operands, &value.i);
     value.i = (int32_t)value.f;
 
-    if (!pushOperand(&frame->operands, value.i, OP_INTEGER))
+    if (!pushOperand(&frame->operands, value.i))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -1443,14 +1315,13 @@ uint8_t instfunc_f2l(JavaVirtualMachine* jvm, Frame* frame)
         int32_t i;
     } temp;
 
-    popOperand(&frame->operands, &temp.i, NULL);
+    popOperand(&frame->operands, &temp.i);
 
     lval = (int64_t)temp.f;
 
-    if (!pushOperand(&frame->operands, HIWORD(lval), OP_LONG) ||
-        !pushOperand(&frame->operands, LOWORD(lval), OP_LONG))
+    if (!pushWideOperand(&frame->operands, lval))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -1469,14 +1340,13 @@ uint8_t instfunc_f2d(JavaVirtualMachine* jvm, Frame* frame)
         int32_t i;
     } temp;
 
-    popOperand(&frame->operands, &temp.i, NULL);
+    popOperand(&frame->operands, &temp.i);
 
     dval.d = (double)temp.f;
 
-    if (!pushOperand(&frame->operands, HIWORD(dval.i), OP_DOUBLE) ||
-        !pushOperand(&frame->operands, LOWORD(dval.i), OP_DOUBLE))
+    if (!pushWideOperand(&frame->operands, dval.i))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -1490,19 +1360,15 @@ uint8_t instfunc_d2i(JavaVirtualMachine* jvm, Frame* frame)
         int64_t i;
     } dval;
 
-    int32_t high, low;
-
-    popOperand(&frame->operands, &low, NULL);
-    popOperand(&frame->operands, &high, NULL);
+    int32_t value;
 
-    dval.i = high;
-    dval.i = (dval.i << 32) | (uint32_t)low;
+    popWideOperand(&frame->operands, &dval.i);
 
-    low = (int32_t)dval.d;
+    value = (int32_t)dval.d;
 
-    if (!pushOperand(&frame->operands, low, OP_INTEGER))
+    if (!pushOperand(&frame->operands, value))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -1516,19 +1382,12 @@ uint8_t instfunc_d2l(JavaVirtualMachine* jvm, Frame* frame)
         int64_t i;
     } dval;
 
-    int32_t high, low;
-
-    popOperand(&frame->operands, &low, NULL);
-    popOperand(&frame->operands, &high, NULL);
-
-    dval.i = high;
-    dval.i = (dval.i << 32) | (uint32_t)low;
+    popWideOperand(&frame->operands, &dval.i);
     dval.i = (int64_t)dval.d;
 
-    if (!pushOperand(&frame->operands, HIWORD(dval.i), OP_LONG) ||
-        !pushOperand(&frame->operands, LOWORD(dval.i), OP_LONG))
+    if (!pushWideOperand(&frame->operands, dval.i))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -1547,19 +1406,13 @@ uint8_t instfunc_d2f(JavaVirtualMachine* jvm, Frame* frame)
         int32_t i;
     } temp;
 
-    int32_t low, high;
-
-    popOperand(&frame->operands, &low, NULL);
-    popOperand(&frame->operands, &high, NULL);
-
-    dval.i = high;
-    dval.i = (dval.i << 32) | (uint32_t)low;
+    popWideOperand(&frame->operands, &dval.i);
 
     temp.f = (float)dval.d;
 
-    if (!pushOperand(&frame->operands, temp.i, OP_FLOAT))
+    if (!pushOperand(&frame->operands, temp.i))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -1571,13 +1424,13 @@ uint8_t instfunc_i2b(JavaVirtualMachine* jvm, Frame* frame)
     int32_t value;
     int8_t byte;
 
-    popOperand(&frame->operands, &value, NULL);
+    popOperand(&frame->operands, &value);
 
     byte = (int8_t)value;
 
-    if (!pushOperand(&frame->operands, (int32_t)byte, OP_INTEGER))
+    if (!pushOperand(&frame->operands, (int32_t)byte))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -1589,13 +1442,13 @@ uint8_t instfunc_i2c(JavaVirtualMachine* jvm, Frame* frame)
     int32_t value;
     uint16_t character;
 
-    popOperand(&frame->operands, &value, NULL);
+    popOperand(&frame->operands, &value);
 
     character = (uint16_t)value;
 
-    if (!pushOperand(&frame->operands, (int32_t)character, OP_INTEGER))
+    if (!pushOperand(&frame->operands, (int32_t)character))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -1607,13 +1460,13 @@ uint8_t instfunc_i2s(JavaVirtualMachine* jvm, Frame* frame)
     int32_t value;
     int16_t sval;
 
-    popOperand(&frame->operands, &value, NULL);
+    popOperand(&frame->operands, &value);
 
     sval = (int16_t)value;
 
-    if (!pushOperand(&frame->operands, (int32_t)sval, OP_INTEGER))
+    if (!pushOperand(&frame->operands, (int32_t)sval))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -1622,31 +1475,22 @@ uint8_t instfunc_i2s(JavaVirtualMachine* jvm, Frame* frame)
 
 uint8_t instfunc_lcmp(JavaVirtualMachine* jvm, Frame* frame)
 {
-    int32_t high, low;
+    int32_t result;
     int64_t value1, value2;
 
-    popOperand(&frame->operands, &low, NULL);
-    popOperand(&frame->operands, &high, NULL);
-
-    value2 = high;
-    value2 = (value2 << 32) | (uint32_t)low;
-
-    popOperand(&frame->operands, &low, NULL);
-    popOperand(&frame->operands, &high, NULL);
-
-    value1 = high;
-    value1 = (value1 << 32) | (uint32_t)low;
+    popWideOperand(&frame->operands, &value2);
+    popWideOperand(&frame->operands, &value1);
 
     if (value1 > value2)
-        high = 1;
+        result = 1;
     else if (value1 == value2)
-        high = 0;
+        result = 0;
     else
-        high = -1;
+        result = -1;
 
-    if (!pushOperand(&frame->operands, high, OP_INTEGER))
+    if (!pushOperand(&frame->operands, result))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -1660,8 +1504,8 @@ uint8_t instfunc_fcmpl(JavaVirtualMachine* jvm, Frame* frame)
         float f;
     } value1, value2;
 
-    popOperand(&frame->operands, &value2.i, NULL);
-    popOperand(&frame->operands, &value1.i, NULL);
+    popOperand(&frame->operands, &value2.i);
+    popOperand(&frame->operands, &value1.i);
 
     if (value1.f < value2.f || value1.f == NAN || value2.f == NAN)
         value1.i = -1;
@@ -1670,9 +1514,9 @@ uint8_t instfunc_fcmpl(JavaVirtualMachine* jvm, Frame* frame)
     else
         value1.i = 1;
 
-    if (!pushOperand(&frame->operands, value1.i, OP_INTEGER))
+    if (!pushOperand(&frame->operands, value1.i))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -1686,8 +1530,8 @@ uint8_t instfunc_fcmpg(JavaVirtualMachine* jvm, Frame* frame)
         float f;
     } value1, value2;
 
-    popOperand(&frame->operands, &value2.i, NULL);
-    popOperand(&frame->operands, &value1.i, NULL);
+    popOperand(&frame->operands, &value2.i);
+    popOperand(&frame->operands, &value1.i);
 
     if (value1.f > value2.f || value1.f == NAN || value2.f == NAN)
         value1.i = 1;
@@ -1696,9 +1540,9 @@ uint8_t instfunc_fcmpg(JavaVirtualMachine* jvm, Frame* frame)
     else
         value1.i = -1;
 
-    if (!pushOperand(&frame->operands, value1.i, OP_INTEGER))
+    if (!pushOperand(&frame->operands, value1.i))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -1712,19 +1556,8 @@ uint8_t instfunc_dcmpl(JavaVirtualMachine* jvm, Frame* frame)
         double d;
     } value1, value2;
 
-    int32_t high, low;
-
-    popOperand(&frame->operands, &low, NULL);
-    popOperand(&frame->operands, &high, NULL);
-
-    value2.i = high;
-    value2.i = (value2.i << 32) | (uint32_t)low;
-
-    popOperand(&frame->operands, &low, NULL);
-    popOperand(&frame->operands, &high, NULL);
-
-    value1.i = high;
-    value1.i = (value1.i << 32) | (uint32_t)low;
+    popWideOperand(&frame->operands, &value2.i);
+    popWideOperand(&frame->operands, &value1.i);
 
     if (value1.d < value2.d || value1.d == NAN || value2.d == NAN)
         value1.i = -1;
@@ -1733,9 +1566,9 @@ uint8_t instfunc_dcmpl(JavaVirtualMachine* jvm, Frame* frame)
     else
         value1.i = 1;
 
-    if (!pushOperand(&frame->operands, value1.i, OP_INTEGER))
+    if (!pushOperand(&frame->operands, value1.i))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -1749,19 +1582,8 @@ uint8_t instfunc_dcmpg(JavaVirtualMachine* jvm, Frame* frame)
         double d;
     } value1, value2;
 
-    int32_t high, low;
-
-    popOperand(&frame->operands, &low, NULL);
-    popOperand(&frame->operands, &high, NULL);
-
-    value2.i = high;
-    value2.i = (value2.i << 32) | (uint32_t)low;
-
-    popOperand(&frame->operands, &low, NULL);
-    popOperand(&frame->operands, &high, NULL);
-
-    value1.i = high;
-    value1.i = (value1.i << 32) | (uint32_t)low;
+    popWideOperand(&frame->operands, &value2.i);
+    popWideOperand(&frame->operands, &value1.i);
 
     if (value1.d > value2.d || value1.d == NAN || value2.d == NAN)
         value1.i = 1;
@@ -1770,9 +1592,9 @@ uint8_t instfunc_dcmpg(JavaVirtualMachine* jvm, Frame* frame)
     else
         value1.i = -1;
 
-    if (!pushOperand(&frame->operands, value1.i, OP_INTEGER))
+    if (!pushOperand(&frame->operands, value1.i))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -1787,7 +1609,7 @@ uint8_t instfunc_dcmpg(JavaVirtualMachine* jvm, Frame* frame)
         int32_t value; \
         int16_t offset = NEXT_BYTE; \
         offset = (offset << 8) | NEXT_BYTE; \
-        popOperand(&frame->operands, &value, NULL); \
+        popOperand(&frame->operands, &value); \
         if (value op 0) \
             frame->pc += offset - 3; \
         return 1; \
@@ -1808,8 +1630,8 @@ DECLR_IF_FAMILY(ifge, >=)
         int32_t value1, value2; \
         int16_t offset = NEXT_BYTE; \
         offset = (offset << 8) | NEXT_BYTE; \
-        popOperand(&frame->operands, &value2, NULL); \
-        popOperand(&frame->operands, &value1, NULL); \
+        popOperand(&frame->operands, &value2); \
+        popOperand(&frame->operands, &value1); \
         if (value1 op value2) \
             frame->pc += offset - 3; \
         return 1; \
@@ -1838,9 +1660,9 @@ uint8_t instfunc_jsr(JavaVirtualMachine* jvm, Frame* frame)
     int16_t offset = NEXT_BYTE;
     offset = (offset << 8) | NEXT_BYTE;
 
-    if (!pushOperand(&frame->operands, (int32_t)frame->pc, OP_RETURNADDRESS))
+    if (!pushOperand(&frame->operands, (int32_t)frame->pc))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -1860,7 +1682,7 @@ uint8_t instfunc_tableswitch(JavaVirtualMachine* jvm, Frame* frame)
     uint32_t base = frame->pc - 1;
 
     // Skip padding bytes
-    frame->pc += 4 - (frame->pc % 4);
+    frame->pc += (4 - frame->pc % 4) % 4;
 
     int32_t defaultValue = NEXT_BYTE;
     defaultValue = (defaultValue << 8) | NEXT_BYTE;
@@ -1878,7 +1700,7 @@ uint8_t instfunc_tableswitch(JavaVirtualMachine* jvm, Frame* frame)
     highValue = (highValue << 8) | NEXT_BYTE;
 
     int32_t index;
-    popOperand(&frame->operands, &index, NULL);
+    popOperand(&frame->operands, &index);
 
     if (index >= lowValue && index <= highValue)
     {
@@ -1899,7 +1721,7 @@ uint8_t instfunc_lookupswitch(JavaVirtualMachine* jvm, Frame* frame)
     uint32_t base = frame->pc - 1;
 
     // Skip padding bytes
-    frame->pc += 4 - (frame->pc % 4);
+    frame->pc += (4 - frame->pc % 4) % 4;
 
     int32_t defaultValue = NEXT_BYTE;
     defaultValue = (defaultValue << 8) | NEXT_BYTE;
@@ -1912,7 +1734,7 @@ uint8_t instfunc_lookupswitch(JavaVirtualMachine* jvm, Frame* frame)
     npairs = (npairs << 8) | NEXT_BYTE;
 
     int32_t key, match;
-    popOperand(&frame->operands, &key, NULL);
+    popOperand(&frame->operands, &key);
 
     while (npairs-- > 0)
     {
@@ -1983,9 +1805,9 @@ uint8_t instfunc_getstatic(JavaVirtualMachine* jvm, Frame* frame)
         // with null object in simulation mode.
         if (cmp_UTF8(cpi1->Utf8.bytes, cpi1->Utf8.length, (const uint8_t*)"java/lang/System", 16))
         {
-            if (!pushOperand(&frame->operands, 0, OP_NULL))
+            if (!pushOperand(&frame->operands, 0))
             {
-                jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+                jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
                 return 0;
             }
 
@@ -2020,17 +1842,22 @@ uint8_t instfunc_getstatic(JavaVirtualMachine* jvm, Frame* frame)
         return 0;
     }
 
-    OperandType type;
+
+    // Long and double fields take two words
+    uint8_t isWide = 0;
 
     switch (*cpi2->Utf8.bytes)
     {
-        case 'J': type = OP_LONG; break;
-        case 'D': type = OP_DOUBLE; break;
-        case 'F': type = OP_FLOAT; break;
+        case 'J':
+        case 'D':
+            isWide = 1;
+            break;
+
+        case 'F':
+            break;
 
         case 'L':
         case '[':
-            type = OP_REFERENCE;
             break;
 
         case 'B': // byte
@@ -2038,7 +1865,6 @@ uint8_t instfunc_getstatic(JavaVirtualMachine* jvm, Frame* frame)
         case 'I': // int
         case 'S': // short
         case 'Z': // boolean
-            type = OP_INTEGER;
             break;
 
         default:
@@ -2047,20 +1873,19 @@ uint8_t instfunc_getstatic(JavaVirtualMachine* jvm, Frame* frame)
             return 0;
     }
 
-    if (!pushOperand(&frame->operands, fieldLoadedClass->staticFieldsData[fi->offset], type))
-    {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
-        return 0;
-    }
+    int32_t* data = fieldLoadedClass->staticFieldsData + fi->offset;
+    uint8_t success;
 
-    // If the field is category 2, push the second part operand from the static data
-    if (type == OP_LONG || type == OP_DOUBLE)
+    // Category 2 fields are stored in two words, high word first
+    if (isWide)
+        success = pushWideOperand(&frame->operands, (int64_t)data[0] << 32 | (uint32_t)data[1]);
+    else
+        success = pushOperand(&frame->operands, data[0]);
+
+    if (!success)
     {
-        if (!pushOperand(&frame->operands, fieldLoadedClass->staticFieldsData[fi->offset + 1], type))
-        {
-            jvm->status = JVM_STATUS_OUT_OF_MEMORY;
-            return 0;
-        }
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
+        return 0;
     }
 
     // TODO: check if the field isn't static and isn't in an interface,
@@ -2111,17 +1936,22 @@ uint8_t instfunc_putstatic(JavaVirtualMachine* jvm, Frame* frame)
         return 0;
     }
 
-    OperandType type;
+
+    // Long and double fields take two words
+    uint8_t isWide = 0;
 
     switch (*cpi2->Utf8.bytes)
     {
-        case 'J': type = OP_LONG; break;
-        case 'D': type = OP_DOUBLE; break;
-        case 'F': type = OP_FLOAT; break;
+        case 'J':
+        case 'D':
+            isWide = 1;
+            break;
+
+        case 'F':
+            break;
 
         case 'L':
         case '[':
-            type = OP_REFERENCE;
             break;
 
         case 'B': // byte
@@ -2129,7 +1959,6 @@ uint8_t instfunc_putstatic(JavaVirtualMachine* jvm, Frame* frame)
         case 'I': // int
         case 'S': // short
         case 'Z': // boolean
-            type = OP_INTEGER;
             break;
 
         default:
@@ -2138,23 +1967,21 @@ uint8_t instfunc_putstatic(JavaVirtualMachine* jvm, Frame* frame)
             return 0;
     }
 
-    int32_t operand;
-
-    popOperand(&frame->operands, &operand, NULL);
-
     // If the field is category 2, set the following index too
-    if (type == OP_LONG || type == OP_DOUBLE)
+    if (isWide)
     {
-        fieldLoadedClass->staticFieldsData[fi->offset + 1] = operand;
-        popOperand(&frame->operands, &operand, NULL);
-        fieldLoadedClass->staticFieldsData[fi->offset] = operand;
+        int64_t operand;
+        popWideOperand(&frame->operands, &operand);
+        fieldLoadedClass->staticFieldsData[fi->offset] = HIWORD(operand);
+        fieldLoadedClass->staticFieldsData[fi->offset + 1] = LOWORD(operand);
     }
     else
     {
+        int32_t operand;
+        popOperand(&frame->operands, &operand);
         fieldLoadedClass->staticFieldsData[fi->offset] = operand;
     }
 
-
     // TODO: check if the field isn't static and isn't in an interface,
     // throwing IncompatibleClassChangeError
 
@@ -2208,17 +2035,22 @@ uint8_t instfunc_getfield(JavaVirtualMachine* jvm, Frame* frame)
         return 0;
     }
 
-    OperandType type;
+
+    // Long and double fields take two words
+    uint8_t isWide = 0;
 
     switch (*cpi2->Utf8.bytes)
     {
-        case 'J': type = OP_LONG; break;
-        case 'D': type = OP_DOUBLE; break;
-        case 'F': type = OP_FLOAT; break;
+        case 'J':
+        case 'D':
+            isWide = 1;
+            break;
+
+        case 'F':
+            break;
 
         case 'L':
         case '[':
-            type = OP_REFERENCE;
             break;
 
         case 'B': // byte
@@ -2226,7 +2058,6 @@ uint8_t instfunc_getfield(JavaVirtualMachine* jvm, Frame* frame)
         case 'I': // int
         case 'S': // short
         case 'Z': // boolean
-            type = OP_INTEGER;
             break;
 
         default:
@@ -2239,7 +2070,7 @@ uint8_t instfunc_getfield(JavaVirtualMachine* jvm, Frame* frame)
     int32_t object_address;
 
     // Get the objectref
-    popOperand(&frame->operands, &object_address, NULL);
+    popOperand(&frame->operands, &object_address);
     object = (Reference*)object_address;
 
     if (!object)
@@ -2249,21 +2080,19 @@ uint8_t instfunc_getfield(JavaVirtualMachine* jvm, Frame* frame)
         return 0;
     }
 
-    //if (!pushOperand(&frame->operands, *(int32_t*)(object->ci.data + sizeof(int32_t) * fi->offset), type))
-    if (!pushOperand(&frame->operands, object->ci.data[fi->offset], type))
-    {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
-        return 0;
-    }
+    int32_t* data = object->ci.data + fi->offset;
+    uint8_t success;
 
-    if (type == OP_LONG || type == OP_DOUBLE)
+    // Category 2 fields are stored in two words, high word first
+    if (isWide)
+        success = pushWideOperand(&frame->operands, (int64_t)data[0] << 32 | (uint32_t)data[1]);
+    else
+        success = pushOperand(&frame->operands, data[0]);
+
+    if (!success)
     {
-        //if (!pushOperand(&frame->operands, *(int32_t*)(object->ci.data + sizeof(int32_t) * (fi->offset + 1)), type))
-        if (!pushOperand(&frame->operands, object->ci.data[fi->offset + 1], type))
-        {
-            jvm->status = JVM_STATUS_OUT_OF_MEMORY;
-            return 0;
-        }
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
+        return 0;
     }
 
     return 1;
@@ -2306,17 +2135,22 @@ uint8_t instfunc_putfield(JavaVirtualMachine* jvm, Frame* frame)
         return 0;
     }
 
-    OperandType type;
+
+    // Long and double fields take two words
+    uint8_t isWide = 0;
 
     switch (*cpi2->Utf8.bytes)
     {
-        case 'J': type = OP_LONG; break;
-        case 'D': type = OP_DOUBLE; break;
-        case 'F': type = OP_FLOAT; break;
+        case 'J':
+        case 'D':
+            isWide = 1;
+            break;
+
+        case 'F':
+            break;
 
         case 'L':
         case '[':
-            type = OP_REFERENCE;
             break;
 
         case 'B': // byte
@@ -2324,7 +2158,6 @@ uint8_t instfunc_putfield(JavaVirtualMachine* jvm, Frame* frame)
         case 'I': // int
         case 'S': // short
         case 'Z': // boolean
-            type = OP_INTEGER;
             break;
 
         default:
@@ -2334,18 +2167,23 @@ uint8_t instfunc_putfield(JavaVirtualMachine* jvm, Frame* frame)
     }
 
     Reference* object;
-    int32_t lo_operand;
-    int32_t hi_operand;
+    int64_t operand;
     int32_t object_address;
 
-    popOperand(&frame->operands, &lo_operand, NULL);
-
-    // If the field is category 2, pop the other operand too
-    if (type == OP_LONG || type == OP_DOUBLE)
-        popOperand(&frame->operands, &hi_operand, NULL);
+    // Category 2 values take both slots, the others only one
+    if (isWide)
+    {
+        popWideOperand(&frame->operands, &operand);
+    }
+    else
+    {
+        int32_t value;
+        popOperand(&frame->operands, &value);
+        operand = value;
+    }
 
     // Get the objectref
-    popOperand(&frame->operands, &object_address, NULL);
+    popOperand(&frame->operands, &object_address);
     object = (Reference*)object_address;
 
     if (!object)
@@ -2355,17 +2193,14 @@ uint8_t instfunc_putfield(JavaVirtualMachine* jvm, Frame* frame)
         return 0;
     }
 
-    if (type == OP_LONG || type == OP_DOUBLE)
+    if (isWide)
     {
-        //*(int32_t*)(object->ci.data + sizeof(int32_t) * fi->offset) = hi_operand;
-        //*(int32_t*)(object->ci.data + sizeof(int32_t) * (fi->offset + 1)) = lo_operand;
-        object->ci.data[fi->offset] = hi_operand;
-        object->ci.data[fi->offset + 1] = lo_operand;
+        object->ci.data[fi->offset] = HIWORD(operand);
+        object->ci.data[fi->offset + 1] = LOWORD(operand);
     }
     else
     {
-        //*(int32_t*)(object->ci.data + sizeof(int32_t) * fi->offset) = lo_operand;
-        object->ci.data[fi->offset] = lo_operand;
+        object->ci.data[fi->offset] = (int32_t)operand;
    }
 
     return 1;
@@ -2417,18 +2252,19 @@ uint8_t instfunc_invokevirtual(JavaVirtualMachine* jvm, Frame* frame)
     cpi1 = frame->jc->constantPool + cpi2->NameAndType.name_index - 1;          // name
     cpi2 = frame->jc->constantPool + cpi2->NameAndType.descriptor_index - 1;    // descriptor
 
-    uint8_t operandIndex;
     uint8_t parameterCount = getMethodDescriptorParameterCount(cpi2->Utf8.bytes, cpi2->Utf8.length);
-    OperandStack* node = frame->operands;
+    Slot objectref;
+    peekSlot(&frame->operands, parameterCount, &objectref);
 
-    for (operandIndex = 0; operandIndex < parameterCount; operandIndex++)
-        node = node->next;
+    Reference* object = (Reference*)(int32_t)objectref;
 
-    Reference* object = (Reference*)node->value;
+    // Class that declares the method that runs, which may override
+    // the resolved one
+    JavaClass* jc = NULL;
 
     if (object)
     {
-        JavaClass* jc = object->ci.c;
+        jc = object->ci.c;
 
         while (jc)
         {
@@ -2455,10 +2291,9 @@ uint8_t instfunc_invokevirtual(JavaVirtualMachine* jvm, Frame* frame)
         return 0;
     }
 
-
     // TODO: if the method is static, throw IncompatibleClassChangeError
 
-    return runMethod(jvm, methodLoadedClass->jc, mi, 1 + parameterCount);
+    return runMethod(jvm, jc, mi, 1 + parameterCount);
 }
 
 uint8_t instfunc_invokespecial(JavaVirtualMachine* jvm, Frame* frame)
@@ -2483,6 +2318,9 @@ uint8_t instfunc_invokespecial(JavaVirtualMachine* jvm, Frame* frame)
         return 0;
     }
 
+    // Class that declares the method that runs
+    JavaClass* methodClass = methodLoadedClass->jc;
+
     // Get the name of the method and its descriptor
     cpi2 = frame->jc->constantPool + method->Methodref.name_and_type_index - 1;
     cpi1 = frame->jc->constantPool + cpi2->NameAndType.name_index - 1;          // name
@@ -2513,6 +2351,8 @@ uint8_t instfunc_invokespecial(JavaVirtualMachine* jvm, Frame* frame)
             DEBUG_REPORT_INSTRUCTION_ERROR
             return 0;
         }
+
+        methodClass = super;
     }
     else
     {
@@ -2530,7 +2370,7 @@ uint8_t instfunc_invokespecial(JavaVirtualMachine* jvm, Frame* frame)
     // We add one to the parameter count to pop the objectref at the stack as well.
     uint8_t parameterCount = 1 + getMethodDescriptorParameterCount(cpi2->Utf8.bytes, cpi2->Utf8.length);
 
-    return runMethod(jvm, methodLoadedClass->jc, mi, parameterCount);
+    return runMethod(jvm, methodClass, mi, parameterCount);
 }
 
 uint8_t instfunc_invokestatic(JavaVirtualMachine* jvm, Frame* frame)
@@ -2608,6 +2448,8 @@ uint8_t instfunc_invokedynamic(JavaVirtualMachine* jvm, Frame* frame)
 
 uint8_t instfunc_new(JavaVirtualMachine* jvm, Frame* frame)
 {
+    GC_SAFEPOINT(jvm);
+
     uint16_t index;
     cp_info* cp;
     LoadedClasses* instanceLoadedClass;
@@ -2634,9 +2476,9 @@ uint8_t instfunc_new(JavaVirtualMachine* jvm, Frame* frame)
 
     Reference* instance = newClassInstance(jvm, instanceLoadedClass);
 
-    if (!instance || !pushOperand(&frame->operands, (int32_t)instance, OP_REFERENCE))
+    if (!instance || !pushOperand(&frame->operands, (int32_t)instance))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = instance ? JVM_STATUS_OPERAND_STACK_OVERFLOW : JVM_STATUS_OUT_OF_MEMORY;
         return 0;
     }
 
@@ -2645,10 +2487,12 @@ uint8_t instfunc_new(JavaVirtualMachine* jvm, Frame* frame)
 
 uint8_t instfunc_newarray(JavaVirtualMachine* jvm, Frame* frame)
 {
+    GC_SAFEPOINT(jvm);
+
     uint8_t type = NEXT_BYTE;
     int32_t count;
 
-    popOperand(&frame->operands, &count, NULL);
+    popOperand(&frame->operands, &count);
 
     if (count < 0)
     {
@@ -2659,9 +2503,9 @@ uint8_t instfunc_newarray(JavaVirtualMachine* jvm, Frame* frame)
 
     Reference* arrayref = newArray(jvm, (uint32_t)count, (Opcode_newarray_type)type);
 
-    if (!arrayref || !pushOperand(&frame->operands, (int32_t)arrayref, OP_REFERENCE))
+    if (!arrayref || !pushOperand(&frame->operands, (int32_t)arrayref))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = arrayref ? JVM_STATUS_OPERAND_STACK_OVERFLOW : JVM_STATUS_OUT_OF_MEMORY;
         return 0;
     }
 
@@ -2670,6 +2514,8 @@ uint8_t instfunc_newarray(JavaVirtualMachine* jvm, Frame* frame)
 
 uint8_t instfunc_anewarray(JavaVirtualMachine* jvm, Frame* frame)
 {
+    GC_SAFEPOINT(jvm);
+
     uint16_t index;
     int32_t count;
     cp_info* cp;
@@ -2677,7 +2523,7 @@ uint8_t instfunc_anewarray(JavaVirtualMachine* jvm, Frame* frame)
     index = NEXT_BYTE;
     index = (index << 8) | NEXT_BYTE;
 
-    popOperand(&frame->operands, &count, NULL);
+    popOperand(&frame->operands, &count);
 
     if (count < 0)
     {
@@ -2700,9 +2546,9 @@ uint8_t instfunc_anewarray(JavaVirtualMachine* jvm, Frame* frame)
 
     Reference* aarray = newObjectArray(jvm, count, cp->Utf8.bytes, cp->Utf8.length);
 
-    if (!aarray || !pushOperand(&frame->operands, (int32_t)aarray, OP_REFERENCE))
+    if (!aarray || !pushOperand(&frame->operands, (int32_t)aarray))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = aarray ? JVM_STATUS_OPERAND_STACK_OVERFLOW : JVM_STATUS_OUT_OF_MEMORY;
         return 0;
     }
 
@@ -2714,7 +2560,7 @@ uint8_t instfunc_arraylength(JavaVirtualMachine* jvm, Frame* frame)
     int32_t operand;
     Reference* object;
 
-    popOperand(&frame->operands, &operand, NULL);
+    popOperand(&frame->operands, &operand);
 
     object = (Reference*)operand;
 
@@ -2740,9 +2586,9 @@ uint8_t instfunc_arraylength(JavaVirtualMachine* jvm, Frame* frame)
         return 0;
     }
 
-    if (!pushOperand(&frame->operands, operand, OP_INTEGER))
+    if (!pushOperand(&frame->operands, operand))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -2791,6 +2637,8 @@ uint8_t instfunc_wide(JavaVirtualMachine* jvm, Frame* frame)
 
 uint8_t instfunc_multianewarray(JavaVirtualMachine* jvm, Frame* frame)
 {
+    GC_SAFEPOINT(jvm);
+
     uint16_t index;
     uint8_t numberOfDimensions;
     int32_t* dimensions;
@@ -2812,7 +2660,7 @@ uint8_t instfunc_multianewarray(JavaVirtualMachine* jvm, Frame* frame)
 
     while (dimensionIndex--)
     {
-        popOperand(&frame->operands, dimensions + dimensionIndex, NULL);
+        popOperand(&frame->operands, dimensions + dimensionIndex);
 
         if (dimensions[dimensionIndex] < 0)
         {
@@ -2847,10 +2695,10 @@ uint8_t instfunc_multianewarray(JavaVirtualMachine* jvm, Frame* frame)
 
     Reference* aarray = newObjectMultiArray(jvm, dimensions, numberOfDimensions, cp->Utf8.bytes, cp->Utf8.length);
 
-    if (!aarray || !pushOperand(&frame->operands, (int32_t)aarray, OP_REFERENCE))
+    if (!aarray || !pushOperand(&frame->operands, (int32_t)aarray))
     {
         free(dimensions);
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = aarray ? JVM_STATUS_OPERAND_STACK_OVERFLOW : JVM_STATUS_OUT_OF_MEMORY;
         return 0;
     }
 
@@ -2865,7 +2713,7 @@ uint8_t instfunc_ifnull(JavaVirtualMachine* jvm, Frame* frame)
 
     int32_t address;
 
-    popOperand(&frame->operands, &address, NULL);
+    popOperand(&frame->operands, &address);
 
     if (!address)
         frame->pc += branch - 3;
@@ -2880,7 +2728,7 @@ uint8_t instfunc_ifnonnull(JavaVirtualMachine* jvm, Frame* frame)
 
     int32_t address;
 
-    popOperand(&frame->operands, &address, NULL);
+    popOperand(&frame->operands, &address);
 
     if (address)
         frame->pc += branch - 3;
@@ -2905,9 +2753,9 @@ uint8_t instfunc_jsr_w(JavaVirtualMachine* jvm, Frame* frame)
     offset = (offset << 8) | NEXT_BYTE;
     offset = (offset << 8) | NEXT_BYTE;
 
-    if (!pushOperand(&frame->operands, (int32_t)frame->pc, OP_RETURNADDRESS))
+    if (!pushOperand(&frame->operands, (int32_t)frame->pc))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -2915,15 +2763,50 @@ uint8_t instfunc_jsr_w(JavaVirtualMachine* jvm, Frame* frame)
     return 1;
 }
 
+// Superinstructions run their component instructions one after the
+// other. Each component reads its own operands from the bytecode, so
+// only the opcode byte of the following component has to be skipped.
+#define SUPERINSTRUCTION_2(a, b) \
+    uint8_t instfunc_##a##_##b(JavaVirtualMachine* jvm, Frame* frame) \
+    { \
+        jvm->superinstructionCount[SUPERINSTRUCTION_INDEX(opcode_##a##_##b)]++; \
+        return instfunc_##a(jvm, frame) && \
+               (frame->pc++, instfunc_##b(jvm, frame)); \
+    }
+#define SUPERINSTRUCTION_3(a, b, c) \
+    uint8_t instfunc_##a##_##b##_##c(JavaVirtualMachine* jvm, Frame* frame) \
+    { \
+        jvm->superinstructionCount[SUPERINSTRUCTION_INDEX(opcode_##a##_##b##_##c)]++; \
+        return instfunc_##a(jvm, frame) && \
+               (frame->pc++, instfunc_##b(jvm, frame)) && \
+               (frame->pc++, instfunc_##c(jvm, frame)); \
+    }
+#define SUPERINSTRUCTION_4(a, b, c, d) \
+    uint8_t instfunc_##a##_##b##_##c##_##d(JavaVirtualMachine* jvm, Frame* frame) \
+    { \
+        jvm->superinstructionCount[SUPERINSTRUCTION_INDEX(opcode_##a##_##b##_##c##_##d)]++; \
+        return instfunc_##a(jvm, frame) && \
+               (frame->pc++, instfunc_##b(jvm, frame)) && \
+               (frame->pc++, instfunc_##c(jvm, frame)) && \
+               (frame->pc++, instfunc_##d(jvm, frame)); \
+    }
+#include "superinstructions.def"
+#undef SUPERINSTRUCTION_2
+#undef SUPERINSTRUCTION_3
+#undef SUPERINSTRUCTION_4
+
 /// @brief Retrieves the instruction function for a given
 /// instruction opcode.
 /// @return The function that needs to be called for the
 /// instruction to be executed if there is one for the given
 /// opcode. Otherwise, returns NULL.
-/// @see Opcodes, getOpcodeMnemonic()
+///
+/// Opcodes above jsr_w are only valid if they are superinstructions
+/// created by the predecoder.
+/// @see Opcodes, Superinstructions, getOpcodeMnemonic()
 InstructionFunction fetchOpcodeFunction(uint8_t opcode)
 {
-    const InstructionFunction opcodeFunctions[202] = {
+    static const InstructionFunction opcodeFunctions[256] = {
         instfunc_nop, instfunc_aconst_null, instfunc_iconst_m1,
         instfunc_iconst_0, instfunc_iconst_1, instfunc_iconst_2,
         instfunc_iconst_3, instfunc_iconst_4, instfunc_iconst_5,
@@ -2991,11 +2874,16 @@ InstructionFunction fetchOpcodeFunction(uint8_t opcode)
         instfunc_checkcast, instfunc_instanceof, instfunc_monitorenter,
         instfunc_monitorexit, instfunc_wide, instfunc_multianewarray,
         instfunc_ifnull, instfunc_ifnonnull, instfunc_goto_w,
-        instfunc_jsr_w
+        instfunc_jsr_w,
+
+        #define SUPERINSTRUCTION_2(a, b) [opcode_##a##_##b] = instfunc_##a##_##b,
+        #define SUPERINSTRUCTION_3(a, b, c) [opcode_##a##_##b##_##c] = instfunc_##a##_##b##_##c,
+        #define SUPERINSTRUCTION_4(a, b, c, d) [opcode_##a##_##b##_##c##_##d] = instfunc_##a##_##b##_##c##_##d,
+        #include "superinstructions.def"
+        #undef SUPERINSTRUCTION_2
+        #undef SUPERINSTRUCTION_3
+        #undef SUPERINSTRUCTION_4
     };
 
-    if (opcode > 201)
-        return NULL;
-
     return opcodeFunctions[opcode];
 }
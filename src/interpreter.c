@@ -0,0 +1,681 @@
+#include "interpreter.h"
+#include "instructions.h"
+#include "opcodes.h"
+#include "superinstructions.h"
+#include "registerir.h"
+#include "typemap.h"
+#include <inttypes.h>
+
+#define NEXT_BYTE (*(frame->code + frame->pc++))
+// The top of stack cache holds up to two operand slots: tos0 is the
+// slot at the top of the stack and tos1 is the slot right below it.
+// 'cached' tells how many of them are valid, and these three states
+// decide how each instruction moves slots between the cache and the
+// operand stack in memory.
+//
+// The slots in memory plus the cached ones never exceed the capacity
+// of the operand stack, so spilling the cache can't fail.
+
+/// @brief Checks that the stack has at least \c n slots, counting
+/// the cached ones. Always true for verified methods.
+#define TOS_HAS(n) (verified || stack->top + cached >= (n))
+
+/// @brief Checks that \c n slots can be pushed without exceeding
+/// the max_stack of the method. Always true for verified methods.
+#define TOS_ROOM(n) (verified || stack->top + cached + (n) <= stack->capacity)
+
+/// @brief Writes all cached slots back to the operand stack.
+#define TOS_SPILL() \
+    do { \
+        if (cached == 2) \
+        { \
+            stack->values[stack->top++] = tos1; \
+        } \
+        if (cached >= 1) \
+        { \
+            stack->values[stack->top++] = tos0; \
+        } \
+        cached = 0; \
+    } while (0)
+
+/// @brief Makes sure the top slot is cached.
+#define TOS_FILL_1() \
+    do { \
+        if (cached == 0) \
+        { \
+            stack->top--; \
+            tos0 = stack->values[stack->top]; \
+            cached = 1; \
+        } \
+    } while (0)
+
+/// @brief Makes sure the two top slots are cached.
+#define TOS_FILL_2() \
+    do { \
+        TOS_FILL_1(); \
+        if (cached == 1) \
+        { \
+            stack->top--; \
+            tos1 = stack->values[stack->top]; \
+            cached = 2; \
+        } \
+    } while (0)
+
+/// @brief Pushes a slot to the cache. If the cache is full, the slot
+/// at its bottom is moved to the operand stack.
+#define TOS_PUSH(newValue) \
+    do { \
+        if (cached == 2) \
+        { \
+            stack->values[stack->top++] = tos1; \
+            cached = 1; \
+        } \
+        tos1 = tos0; \
+        tos0 = (newValue); \
+        cached++; \
+    } while (0)
+
+/// @brief Removes the top slot, which must be cached.
+#define TOS_DROP_1() \
+    do { \
+        tos0 = tos1; \
+        cached--; \
+    } while (0)
+
+/// @brief Generates the cases of instructions "iconst_<n>" and "fconst_<n>".
+#define CASE_CONST_CAT_1(instruction, value) \
+    case opcode_##instruction: \
+        if (!TOS_ROOM(1)) \
+            break; \
+        TOS_PUSH(value); \
+        continue;
+
+/// @brief Generates the cases of instructions "lconst_<n>" and "dconst_<n>".
+#define CASE_CONST_CAT_2(instruction, value) \
+    case opcode_##instruction: \
+        if (!TOS_ROOM(2)) \
+            break; \
+        TOS_PUSH(value); \
+        TOS_PUSH(0); \
+        continue;
+
+/// @brief Generates the cases of instructions "iload", "fload",
+/// "iload_<n>" and "fload_<n>".
+#define CASE_LOAD_CAT_1(instruction, index) \
+    case opcode_##instruction: \
+    { \
+        if (!TOS_ROOM(1)) \
+            break; \
+        uint8_t localIndex = index; \
+        TOS_PUSH(frame->localVariables[localIndex]); \
+        continue; \
+    }
+
+/// @brief Generates the cases of instructions "lload", "dload",
+/// "lload_<n>" and "dload_<n>".
+#define CASE_LOAD_CAT_2(instruction, index) \
+    case opcode_##instruction: \
+    { \
+        if (!TOS_ROOM(2)) \
+            break; \
+        uint8_t localIndex = index; \
+        TOS_PUSH(frame->localVariables[localIndex]); \
+        TOS_PUSH(0); \
+        continue; \
+    }
+
+/// @brief Generates the cases of instructions "istore", "fstore",
+/// "istore_<n>" and "fstore_<n>".
+#define CASE_STORE_CAT_1(instruction, index) \
+    case opcode_##instruction: \
+        if (!TOS_HAS(1)) \
+            break; \
+        TOS_FILL_1(); \
+        frame->localVariables[index] = tos0; \
+        TOS_DROP_1(); \
+        continue;
+
+/// @brief Generates the cases of instructions "lstore", "dstore",
+/// "lstore_<n>" and "dstore_<n>".
+#define CASE_STORE_CAT_2(instruction, index) \
+    case opcode_##instruction: \
+    { \
+        if (!TOS_HAS(2)) \
+            break; \
+        uint8_t localIndex = index; \
+        TOS_FILL_2(); \
+        frame->localVariables[localIndex] = tos1; \
+        cached = 0; \
+        continue; \
+    }
+
+/// @brief Generates the cases of the integer math instructions.
+/// The expression uses \c value1 and \c value2 as operands.
+#define CASE_INTEGER_MATH_OP(instruction, expression) \
+    case opcode_##instruction: \
+    { \
+        if (!TOS_HAS(2)) \
+            break; \
+        TOS_FILL_2(); \
+        int32_t value1 = (int32_t)tos1, value2 = (int32_t)tos0; \
+        tos0 = (expression); \
+        cached = 1; \
+        continue; \
+    }
+
+/// @brief Generates the cases of the float math instructions.
+#define CASE_FLOAT_MATH_OP(instruction, op) \
+    case opcode_##instruction: \
+    { \
+        if (!TOS_HAS(2)) \
+            break; \
+        TOS_FILL_2(); \
+        tos0 = floatToBits(bitsToFloat((int32_t)tos1) op bitsToFloat((int32_t)tos0)); \
+        cached = 1; \
+        continue; \
+    }
+
+// Category 2 operands take both cached slots, with the value in tos1
+// and padding in tos0, so the first operand of long and double math
+// instructions is read from the stack in memory.
+
+/// @brief Generates the cases of the long math instructions.
+#define CASE_LONG_MATH_OP(instruction, op) \
+    case opcode_##instruction: \
+    { \
+        if (!TOS_HAS(4)) \
+            break; \
+        TOS_FILL_2(); \
+        stack->top -= 2; \
+        tos1 = stack->values[stack->top] op tos1; \
+        continue; \
+    }
+
+/// @brief Generates the cases of the double math instructions.
+#define CASE_DOUBLE_MATH_OP(instruction, op) \
+    case opcode_##instruction: \
+    { \
+        if (!TOS_HAS(4)) \
+            break; \
+        TOS_FILL_2(); \
+        stack->top -= 2; \
+        tos1 = doubleToBits(bitsToDouble(stack->values[stack->top]) op bitsToDouble(tos1)); \
+        continue; \
+    }
+
+static float bitsToFloat(int32_t bits)
+{
+    union {
+        float f;
+        int32_t i;
+    } value;
+
+    value.i = bits;
+    return value.f;
+}
+
+static int32_t floatToBits(float f)
+{
+    union {
+        float f;
+        int32_t i;
+    } value;
+
+    value.f = f;
+    return value.i;
+}
+
+static double bitsToDouble(int64_t bits)
+{
+    union {
+        double d;
+        int64_t i;
+    } value;
+
+    value.i = bits;
+    return value.d;
+}
+
+static int64_t doubleToBits(double d)
+{
+    union {
+        double d;
+        int64_t i;
+    } value;
+
+    value.d = d;
+    return value.i;
+}
+
+/// @brief Records an instruction about to run, with the operand stack,
+/// bottom first, and the local variables, as "value.type". Slots held
+/// by the top of stack cache are shown in brackets.
+static void traceInstruction(JavaVirtualMachine* jvm, Frame* frame, uint8_t opcode, Slot tos0, Slot tos1, uint8_t cached)
+{
+    OperandStack* stack = &frame->operands;
+    const uint8_t* types = getSlotTypes(frame->types, frame->pc - 1, NULL);
+    TraceEvent* event = beginTraceEvent(jvm->tracer, TRACE_INSTRUCTION);
+    uint32_t index;
+
+    #define TRACE_TYPE(slot) (types ? getOperandTypeName(types[slot]) : "?")
+
+    appendTraceText(event, "%u %s | stack:", frame->pc - 1, getSuperinstructionMnemonic(opcode));
+
+    for (index = 0; index < stack->top; index++)
+        appendTraceText(event, " %" PRId64 ".%s", stack->values[index], TRACE_TYPE(frame->max_locals + index));
+
+    if (cached == 2)
+        appendTraceText(event, " [%" PRId64 ".%s]", tos1, TRACE_TYPE(frame->max_locals + stack->top));
+
+    if (cached >= 1)
+        appendTraceText(event, " [%" PRId64 ".%s]", tos0, TRACE_TYPE(frame->max_locals + stack->top + cached - 1));
+
+    appendTraceText(event, " | locals:");
+
+    for (index = 0; index < frame->max_locals; index++)
+        appendTraceText(event, " %" PRId64 ".%s", frame->localVariables[index], TRACE_TYPE(index));
+
+    #undef TRACE_TYPE
+
+    commitTraceEvent(jvm->tracer);
+}
+
+/// @brief Executes the bytecode of a frame until the method returns.
+///
+/// @param JavaVirtualMachine* jvm - pointer to the JVM executing the method.
+/// @param Frame* frame - frame of the method, already pushed to the
+/// JVM frame stack and with its parameters stored in the local variables.
+///
+/// @return 0 if an instruction failed. Otherwise, returns 1, even
+/// if an unknown instruction was found, in which case the JVM status
+/// is set to JVM_STATUS_UNKNOWN_INSTRUCTION.
+/// @see runMethod()
+uint8_t interpretFrame(JavaVirtualMachine* jvm, Frame* frame)
+{
+    OperandStack* stack = &frame->operands;
+    InstructionFunction function;
+    uint8_t opcode;
+
+    Slot tos0 = 0, tos1 = 0;
+    uint8_t cached = 0;
+    const uint8_t verified = frame->verified;
+    OpcodeProfile* const opcodeProfile = jvm->opcodeProfile;
+    const uint8_t traceInstructions = TRACING(jvm, TRACE_INSTRUCTION);
+    PerfData* const perfData = jvm->perfData;
+
+    while (frame->pc < frame->code_length)
+    {
+
+        if (frame->executionCounters)
+            frame->executionCounters[frame->pc]++;
+
+        opcode = NEXT_BYTE;
+        jvm->dispatchCount++;
+
+        if (perfData && !(jvm->dispatchCount & PERF_DATA_PUBLISH_MASK))
+            setPerfCounter(perfData, PERF_BYTECODES, jvm->dispatchCount);
+
+        if (opcodeProfile)
+            profileOpcode(opcodeProfile, opcode);
+
+        if (traceInstructions)
+            traceInstruction(jvm, frame, opcode, tos0, tos1, cached);
+
+        // Instructions handled here "continue" to the next one. The
+        // others, or these when the stack would overflow or underflow,
+        // "break" to the instruction functions below.
+        switch (opcode)
+        {
+            CASE_CONST_CAT_1(iconst_m1, -1)
+            CASE_CONST_CAT_1(iconst_0, 0)
+            CASE_CONST_CAT_1(iconst_1, 1)
+            CASE_CONST_CAT_1(iconst_2, 2)
+            CASE_CONST_CAT_1(iconst_3, 3)
+            CASE_CONST_CAT_1(iconst_4, 4)
+            CASE_CONST_CAT_1(iconst_5, 5)
+            CASE_CONST_CAT_2(lconst_0, 0)
+            CASE_CONST_CAT_2(lconst_1, 1)
+            CASE_CONST_CAT_1(fconst_0, 0x00000000)
+            CASE_CONST_CAT_1(fconst_1, 0x3F800000)
+            CASE_CONST_CAT_1(fconst_2, 0x40000000)
+            CASE_CONST_CAT_2(dconst_0, 0x0000000000000000ll)
+            CASE_CONST_CAT_2(dconst_1, 0x3FF0000000000000ll)
+
+            case opcode_bipush:
+                if (!TOS_ROOM(1))
+                    break;
+                TOS_PUSH((int8_t)NEXT_BYTE);
+                continue;
+
+            case opcode_sipush:
+            {
+                if (!TOS_ROOM(1))
+                    break;
+                int16_t value = NEXT_BYTE;
+                value = (value << 8) | NEXT_BYTE;
+                TOS_PUSH(value);
+                continue;
+            }
+
+            CASE_LOAD_CAT_1(iload, NEXT_BYTE)
+            CASE_LOAD_CAT_1(iload_0, 0)
+            CASE_LOAD_CAT_1(iload_1, 1)
+            CASE_LOAD_CAT_1(iload_2, 2)
+            CASE_LOAD_CAT_1(iload_3, 3)
+            CASE_LOAD_CAT_1(fload, NEXT_BYTE)
+            CASE_LOAD_CAT_1(fload_0, 0)
+            CASE_LOAD_CAT_1(fload_1, 1)
+            CASE_LOAD_CAT_1(fload_2, 2)
+            CASE_LOAD_CAT_1(fload_3, 3)
+            CASE_LOAD_CAT_2(lload, NEXT_BYTE)
+            CASE_LOAD_CAT_2(lload_0, 0)
+            CASE_LOAD_CAT_2(lload_1, 1)
+            CASE_LOAD_CAT_2(lload_2, 2)
+            CASE_LOAD_CAT_2(lload_3, 3)
+            CASE_LOAD_CAT_2(dload, NEXT_BYTE)
+            CASE_LOAD_CAT_2(dload_0, 0)
+            CASE_LOAD_CAT_2(dload_1, 1)
+            CASE_LOAD_CAT_2(dload_2, 2)
+            CASE_LOAD_CAT_2(dload_3, 3)
+
+            CASE_STORE_CAT_1(istore, NEXT_BYTE)
+            CASE_STORE_CAT_1(istore_0, 0)
+            CASE_STORE_CAT_1(istore_1, 1)
+            CASE_STORE_CAT_1(istore_2, 2)
+            CASE_STORE_CAT_1(istore_3, 3)
+            CASE_STORE_CAT_1(fstore, NEXT_BYTE)
+            CASE_STORE_CAT_1(fstore_0, 0)
+            CASE_STORE_CAT_1(fstore_1, 1)
+            CASE_STORE_CAT_1(fstore_2, 2)
+            CASE_STORE_CAT_1(fstore_3, 3)
+            CASE_STORE_CAT_2(lstore, NEXT_BYTE)
+            CASE_STORE_CAT_2(lstore_0, 0)
+            CASE_STORE_CAT_2(lstore_1, 1)
+            CASE_STORE_CAT_2(lstore_2, 2)
+            CASE_STORE_CAT_2(lstore_3, 3)
+            CASE_STORE_CAT_2(dstore, NEXT_BYTE)
+            CASE_STORE_CAT_2(dstore_0, 0)
+            CASE_STORE_CAT_2(dstore_1, 1)
+            CASE_STORE_CAT_2(dstore_2, 2)
+            CASE_STORE_CAT_2(dstore_3, 3)
+
+            CASE_INTEGER_MATH_OP(iadd, value1 + value2)
+            CASE_INTEGER_MATH_OP(isub, value1 - value2)
+            CASE_INTEGER_MATH_OP(imul, value1 * value2)
+            CASE_INTEGER_MATH_OP(idiv, value1 / value2)
+            CASE_INTEGER_MATH_OP(irem, value1 % value2)
+            CASE_INTEGER_MATH_OP(iand, value1 & value2)
+            CASE_INTEGER_MATH_OP(ior, value1 | value2)
+            CASE_INTEGER_MATH_OP(ixor, value1 ^ value2)
+            CASE_INTEGER_MATH_OP(ishl, value1 << (value2 & 0x1F))
+            CASE_INTEGER_MATH_OP(ishr, value1 >> (value2 & 0x1F))
+            CASE_INTEGER_MATH_OP(iushr, (int32_t)((uint32_t)value1 >> (value2 & 0x1F)))
+
+            case opcode_ineg:
+                if (!TOS_HAS(1))
+                    break;
+                TOS_FILL_1();
+                tos0 = -(int32_t)tos0;
+                continue;
+
+            CASE_LONG_MATH_OP(ladd, +)
+            CASE_LONG_MATH_OP(lsub, -)
+            CASE_LONG_MATH_OP(lmul, *)
+            CASE_LONG_MATH_OP(ldiv, /)
+            CASE_LONG_MATH_OP(lrem, %)
+            CASE_LONG_MATH_OP(land, &)
+            CASE_LONG_MATH_OP(lor, |)
+            CASE_LONG_MATH_OP(lxor, ^)
+
+            case opcode_lneg:
+                if (!TOS_HAS(2))
+                    break;
+                TOS_FILL_2();
+                tos1 = -tos1;
+                continue;
+
+            CASE_FLOAT_MATH_OP(fadd, +)
+            CASE_FLOAT_MATH_OP(fsub, -)
+            CASE_FLOAT_MATH_OP(fmul, *)
+            CASE_FLOAT_MATH_OP(fdiv, /)
+
+            case opcode_fneg:
+                if (!TOS_HAS(1))
+                    break;
+                TOS_FILL_1();
+                tos0 = floatToBits(-bitsToFloat((int32_t)tos0));
+                continue;
+
+            CASE_DOUBLE_MATH_OP(dadd, +)
+            CASE_DOUBLE_MATH_OP(dsub, -)
+            CASE_DOUBLE_MATH_OP(dmul, *)
+            CASE_DOUBLE_MATH_OP(ddiv, /)
+
+            case opcode_dneg:
+                if (!TOS_HAS(2))
+                    break;
+                TOS_FILL_2();
+                tos1 = doubleToBits(-bitsToDouble(tos1));
+                continue;
+
+            default:
+                break;
+        }
+
+        TOS_SPILL();
+        function = fetchOpcodeFunction(opcode);
+
+        if (function == NULL)
+        {
+            jvm->status = JVM_STATUS_UNKNOWN_INSTRUCTION;
+            break;
+        }
+        else if (!function(jvm, frame))
+        {
+            return 0;
+        }
+    }
+
+    TOS_SPILL();
+    return 1;
+}
+
+#define IR_INTEGER_OP(irOpcode, expression) \
+    case irOpcode: \
+    { \
+        int32_t value1 = (int32_t)r[instruction->b], value2 = (int32_t)r[instruction->c]; \
+        r[instruction->a] = (expression); \
+        break; \
+    }
+
+#define IR_FLOAT_OP(irOpcode, op) \
+    case irOpcode: \
+        r[instruction->a] = floatToBits(bitsToFloat((int32_t)r[instruction->b]) op bitsToFloat((int32_t)r[instruction->c])); \
+        break;
+
+// Long and double values are held whole in the first register of
+// their pair, so they take a single operation.
+
+#define IR_LONG_OP(irOpcode, op) \
+    case irOpcode: \
+        r[instruction->a] = r[instruction->b] op r[instruction->c]; \
+        break;
+
+#define IR_DOUBLE_OP(irOpcode, op) \
+    case irOpcode: \
+        r[instruction->a] = doubleToBits(bitsToDouble(r[instruction->b]) op bitsToDouble(r[instruction->c])); \
+        break;
+
+#define IR_BRANCH(irOpcode, condition) \
+    case irOpcode: \
+        if (condition) \
+            ip = (uint32_t)instruction->immediate; \
+        break;
+
+/// @brief Executes the register IR of a frame until the method returns.
+///
+/// Registers are the frame's local variables followed by its operand
+/// stack slots. Instructions without an IR equivalent are escapes
+/// that call the instruction function of the original bytecode. If
+/// an escape leaves the frame somewhere the IR can't continue from,
+/// such as an offset that isn't mapped to IR, execution continues
+/// on the bytecode interpreter.
+///
+/// @param JavaVirtualMachine* jvm - pointer to the JVM executing the method.
+/// @param Frame* frame - frame of the method, with its register IR
+/// in frame->ir and its parameters stored in the local variables.
+///
+/// @return 0 if an instruction failed, 1 otherwise.
+/// @see interpretFrame(), translateMethod()
+uint8_t interpretIR(JavaVirtualMachine* jvm, Frame* frame)
+{
+    IRMethod* ir = frame->ir;
+    Slot* r = frame->localVariables;
+    IRInstruction* instruction;
+    InstructionFunction function;
+    uint32_t ip = 0;
+    const uint8_t traceInstructions = TRACING(jvm, TRACE_INSTRUCTION);
+    PerfData* const perfData = jvm->perfData;
+
+    while (ip < ir->length)
+    {
+        instruction = ir->code + ip++;
+        jvm->dispatchCount++;
+
+        if (perfData && !(jvm->dispatchCount & PERF_DATA_PUBLISH_MASK))
+            setPerfCounter(perfData, PERF_BYTECODES, jvm->dispatchCount);
+
+        if (traceInstructions)
+        {
+            traceEvent(jvm->tracer, TRACE_INSTRUCTION, "IR %u %s %u, %u, %u, %" PRId64, ip - 1,
+                       getIROpcodeMnemonic(instruction->opcode), instruction->a, instruction->b, instruction->c,
+                       instruction->immediate);
+        }
+
+        switch (instruction->opcode)
+        {
+            case ir_move:
+                r[instruction->a] = r[instruction->b];
+                break;
+
+            case ir_const:
+                r[instruction->a] = instruction->immediate;
+                break;
+
+            IR_INTEGER_OP(ir_iadd, value1 + value2)
+            IR_INTEGER_OP(ir_isub, value1 - value2)
+            IR_INTEGER_OP(ir_imul, value1 * value2)
+            IR_INTEGER_OP(ir_idiv, value1 / value2)
+            IR_INTEGER_OP(ir_irem, value1 % value2)
+            IR_INTEGER_OP(ir_iand, value1 & value2)
+            IR_INTEGER_OP(ir_ior, value1 | value2)
+            IR_INTEGER_OP(ir_ixor, value1 ^ value2)
+            IR_INTEGER_OP(ir_ishl, value1 << (value2 & 0x1F))
+            IR_INTEGER_OP(ir_ishr, value1 >> (value2 & 0x1F))
+            IR_INTEGER_OP(ir_iushr, (int32_t)((uint32_t)value1 >> (value2 & 0x1F)))
+
+            case ir_ineg:
+                r[instruction->a] = -(int32_t)r[instruction->b];
+                break;
+
+            IR_LONG_OP(ir_ladd, +)
+            IR_LONG_OP(ir_lsub, -)
+            IR_LONG_OP(ir_lmul, *)
+            IR_LONG_OP(ir_ldiv, /)
+            IR_LONG_OP(ir_lrem, %)
+            IR_LONG_OP(ir_land, &)
+            IR_LONG_OP(ir_lor, |)
+            IR_LONG_OP(ir_lxor, ^)
+
+            case ir_lneg:
+                r[instruction->a] = -r[instruction->b];
+                break;
+
+            IR_FLOAT_OP(ir_fadd, +)
+            IR_FLOAT_OP(ir_fsub, -)
+            IR_FLOAT_OP(ir_fmul, *)
+            IR_FLOAT_OP(ir_fdiv, /)
+
+            case ir_fneg:
+                r[instruction->a] = floatToBits(-bitsToFloat((int32_t)r[instruction->b]));
+                break;
+
+            IR_DOUBLE_OP(ir_dadd, +)
+            IR_DOUBLE_OP(ir_dsub, -)
+            IR_DOUBLE_OP(ir_dmul, *)
+            IR_DOUBLE_OP(ir_ddiv, /)
+
+            case ir_dneg:
+                r[instruction->a] = doubleToBits(-bitsToDouble(r[instruction->b]));
+                break;
+
+            case ir_iinc:
+                r[instruction->a] = (int32_t)r[instruction->a] + (int32_t)instruction->immediate;
+                break;
+
+            IR_BRANCH(ir_ifeq, r[instruction->a] == 0)
+            IR_BRANCH(ir_ifne, r[instruction->a] != 0)
+            IR_BRANCH(ir_iflt, r[instruction->a] < 0)
+            IR_BRANCH(ir_ifge, r[instruction->a] >= 0)
+            IR_BRANCH(ir_ifgt, r[instruction->a] > 0)
+            IR_BRANCH(ir_ifle, r[instruction->a] <= 0)
+            IR_BRANCH(ir_if_icmpeq, r[instruction->a] == r[instruction->b])
+            IR_BRANCH(ir_if_icmpne, r[instruction->a] != r[instruction->b])
+            IR_BRANCH(ir_if_icmplt, r[instruction->a] < r[instruction->b])
+            IR_BRANCH(ir_if_icmpge, r[instruction->a] >= r[instruction->b])
+            IR_BRANCH(ir_if_icmpgt, r[instruction->a] > r[instruction->b])
+            IR_BRANCH(ir_if_icmple, r[instruction->a] <= r[instruction->b])
+
+            case ir_goto:
+                ip = (uint32_t)instruction->immediate;
+                break;
+
+            case ir_escape:
+            {
+                uint32_t pc = (uint32_t)instruction->immediate;
+
+                if (frame->executionCounters)
+                    frame->executionCounters[pc]++;
+
+                function = fetchOpcodeFunction(frame->code[pc]);
+
+                if (function == NULL)
+                {
+                    jvm->status = JVM_STATUS_UNKNOWN_INSTRUCTION;
+                    return 1;
+                }
+
+                frame->pc = pc + 1;
+                frame->operands.top = instruction->a;
+
+                if (!function(jvm, frame))
+                    return 0;
+
+                if (frame->pc >= frame->code_length)
+                    return 1;
+
+                // Continue on the IR only if the escape left the stack
+                // and the pc where the translator expected them
+                if (frame->operands.top == instruction->b)
+                {
+                    if (frame->pc == pc + getInstructionLength(frame->code, pc, frame->code_length))
+                        break;
+
+                    if (ir->pcMap[frame->pc] != IR_NO_INDEX)
+                    {
+                        ip = ir->pcMap[frame->pc];
+                        break;
+                    }
+                }
+
+                return interpretFrame(jvm, frame);
+            }
+
+            default:
+                jvm->status = JVM_STATUS_UNKNOWN_INSTRUCTION;
+                return 1;
+        }
+    }
+
+    return 1;
+}
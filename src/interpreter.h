@@ -0,0 +1,33 @@
+#ifndef INTERPRETER_H
+#define INTERPRETER_H
+
+#include <stdint.h>
+#include "jvm.h"
+#include "framestack.h"
+
+uint8_t interpretFrame(JavaVirtualMachine* jvm, Frame* frame);
+uint8_t interpretIR(JavaVirtualMachine* jvm, Frame* frame);
+
+#endif // INTERPRETER_H
+
+/// @defgroup interpreter Interpreter module
+///
+/// @brief Dispatch loop that executes the bytecode of a frame.
+///
+/// Most instructions are executed by calling their instruction
+/// function (see instructions.c). Loads, stores, constants and the
+/// integer, long, float and double math instructions are executed
+/// inside the loop instead, keeping the top one or two operand slots
+/// in local variables that the compiler can place in registers. A
+/// sequence like "iload_1 iload_2 iadd istore_3" then never touches
+/// the operand stack in memory.
+///
+/// The cached slots are written back to the operand stack before any
+/// other instruction function is called, so instruction functions
+/// always see the complete stack.
+///
+/// Methods translated to register IR (see @ref registerir) are
+/// executed by a second loop, which hands the frame back to the
+/// bytecode loop when it can't continue on the IR.
+///
+/// @see interpretFrame(), interpretIR()
@@ -0,0 +1,308 @@
+#include "jarfile.h"
+#include "inflate.h"
+#include "threads.h"
+#include "memoryinspect.h"
+#include <string.h>
+
+#define ZIP_END_OF_CENTRAL_DIRECTORY 0x06054B50
+#define ZIP_CENTRAL_DIRECTORY_HEADER 0x02014B50
+#define ZIP_LOCAL_FILE_HEADER 0x04034B50
+
+#define ZIP_METHOD_STORED 0
+#define ZIP_METHOD_DEFLATED 8
+
+// The end of central directory record has 22 bytes, followed by a
+// comment of up to 65535 bytes
+#define ZIP_END_RECORD_SIZE 22
+#define ZIP_MAX_COMMENT_LENGTH 65535
+
+static uint16_t readLE16(const uint8_t* bytes)
+{
+    return (uint16_t)(bytes[0] | bytes[1] << 8);
+}
+
+static uint32_t readLE32(const uint8_t* bytes)
+{
+    return (uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 | (uint32_t)bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+}
+
+static uint32_t hashEntryName(const uint8_t* name, uint32_t length)
+{
+    uint32_t hash = 2166136261u;
+
+    while (length--)
+    {
+        hash ^= *name++;
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+static uint32_t crcTable[256];
+static Once crcTableOnce = ONCE_INIT;
+
+static void buildCRC32Table(void)
+{
+    uint32_t crc, index;
+    uint8_t bit;
+
+    for (index = 0; index < 256; index++)
+    {
+        crc = index;
+
+        for (bit = 0; bit < 8; bit++)
+            crc = crc & 1 ? 0xEDB88320u ^ (crc >> 1) : crc >> 1;
+
+        crcTable[index] = crc;
+    }
+}
+
+static uint32_t computeCRC32(const uint8_t* bytes, uint32_t length)
+{
+    uint32_t crc;
+
+    // Class loader workers may read jar entries at the same time
+    runOnce(&crcTableOnce, buildCRC32Table);
+
+    crc = 0xFFFFFFFFu;
+
+    while (length--)
+        crc = crcTable[(crc ^ *bytes++) & 0xFF] ^ (crc >> 8);
+
+    return crc ^ 0xFFFFFFFFu;
+}
+
+/// @brief Finds the end of central directory record, which is
+/// at the end of the file, before the archive comment.
+static const uint8_t* findEndRecord(JarFile* jar)
+{
+    const uint8_t* data = jar->file.data;
+    uint32_t size = jar->file.size;
+    uint32_t offset, lowest;
+
+    if (size < ZIP_END_RECORD_SIZE)
+        return NULL;
+
+    offset = size - ZIP_END_RECORD_SIZE;
+    lowest = offset > ZIP_MAX_COMMENT_LENGTH ? offset - ZIP_MAX_COMMENT_LENGTH : 0;
+
+    do {
+        if (readLE32(data + offset) == ZIP_END_OF_CENTRAL_DIRECTORY &&
+            offset + ZIP_END_RECORD_SIZE + readLE16(data + offset + 20) == size)
+        {
+            return data + offset;
+        }
+    } while (offset-- > lowest);
+
+    return NULL;
+}
+
+/// @brief Reads the central directory of the jar into the hash index.
+static uint8_t readCentralDirectory(JarFile* jar)
+{
+    const uint8_t* endRecord = findEndRecord(jar);
+    const uint8_t* header;
+    uint32_t entryCount, directorySize, directoryOffset;
+    uint32_t offset, index, bucket;
+    JarEntry* entry;
+
+    if (!endRecord)
+        return 0;
+
+    entryCount = readLE16(endRecord + 10);
+    directorySize = readLE32(endRecord + 12);
+    directoryOffset = readLE32(endRecord + 16);
+
+    if (directoryOffset > jar->file.size || directorySize > jar->file.size - directoryOffset)
+        return 0;
+
+    for (jar->bucketCount = 16; jar->bucketCount < entryCount * 2; jar->bucketCount *= 2);
+
+    jar->entries = (JarEntry*)malloc(sizeof(JarEntry) * (entryCount ? entryCount : 1));
+    jar->buckets = (uint32_t*)malloc(sizeof(uint32_t) * jar->bucketCount);
+
+    if (!jar->entries || !jar->buckets)
+        return 0;
+
+    for (index = 0; index < jar->bucketCount; index++)
+        jar->buckets[index] = JAR_NO_ENTRY;
+
+    offset = directoryOffset;
+
+    for (index = 0; index < entryCount; index++)
+    {
+        if (directoryOffset + directorySize - offset < 46)
+            return 0;
+
+        header = jar->file.data + offset;
+
+        if (readLE32(header) != ZIP_CENTRAL_DIRECTORY_HEADER)
+            return 0;
+
+        entry = jar->entries + jar->entryCount;
+        entry->method = readLE16(header + 10);
+        entry->crc32 = readLE32(header + 16);
+        entry->compressedSize = readLE32(header + 20);
+        entry->uncompressedSize = readLE32(header + 24);
+        entry->nameLength = readLE16(header + 28);
+        entry->localHeaderOffset = readLE32(header + 42);
+        entry->name = header + 46;
+
+        offset += 46 + entry->nameLength + readLE16(header + 30) + readLE16(header + 32);
+
+        if (offset > directoryOffset + directorySize)
+            return 0;
+
+        // Directories and encrypted entries can't be read, so they
+        // aren't indexed
+        if ((entry->nameLength > 0 && entry->name[entry->nameLength - 1] == '/') || (readLE16(header + 8) & 1))
+            continue;
+
+        bucket = hashEntryName(entry->name, entry->nameLength) & (jar->bucketCount - 1);
+        entry->next = jar->buckets[bucket];
+        jar->buckets[bucket] = jar->entryCount++;
+    }
+
+    return 1;
+}
+
+/// @brief Opens a jar file and indexes its entries.
+///
+/// @param JarFile* jar - receives the opened jar.
+/// @param const char* path - path of the jar file.
+///
+/// @return 1 in case of success, 0 if the file couldn't be mapped
+/// or isn't a valid zip file. The jar must be closed with
+/// closeJarFile() either way.
+/// @see findJarEntry(), readJarEntry()
+uint8_t openJarFile(JarFile* jar, const char* path)
+{
+    jar->entries = NULL;
+    jar->entryCount = 0;
+    jar->buckets = NULL;
+    jar->bucketCount = 0;
+
+    if (!mapFile(&jar->file, path))
+        return 0;
+
+    if (!readCentralDirectory(jar))
+    {
+        jar->entryCount = 0;
+        return 0;
+    }
+
+    return 1;
+}
+
+void closeJarFile(JarFile* jar)
+{
+    if (jar->entries)
+        free(jar->entries);
+
+    if (jar->buckets)
+        free(jar->buckets);
+
+    jar->entries = NULL;
+    jar->buckets = NULL;
+    jar->entryCount = 0;
+    unmapFile(&jar->file);
+}
+
+/// @brief Looks an entry up by its name, such as "java/lang/Object.class".
+/// @return The entry, or a null pointer if the jar doesn't have it.
+JarEntry* findJarEntry(JarFile* jar, const uint8_t* name, uint32_t nameLength)
+{
+    uint32_t index;
+    JarEntry* entry;
+
+    if (jar->entryCount == 0)
+        return NULL;
+
+    index = jar->buckets[hashEntryName(name, nameLength) & (jar->bucketCount - 1)];
+
+    while (index != JAR_NO_ENTRY)
+    {
+        entry = jar->entries + index;
+
+        if (entry->nameLength == nameLength && !memcmp(entry->name, name, nameLength))
+            return entry;
+
+        index = entry->next;
+    }
+
+    return NULL;
+}
+
+/// @brief Gets the contents of an entry of the jar.
+///
+/// @param JarFile* jar - the jar containing the entry.
+/// @param JarEntry* entry - entry obtained from findJarEntry().
+/// @param [out] uint8_t* outAllocated - set to 1 if the contents were
+/// inflated into a buffer that the caller must free, or to 0 if they
+/// point into the mapping of the jar, which is valid until the jar
+/// is closed.
+///
+/// @return Pointer to entry->uncompressedSize bytes, or a null pointer
+/// if the entry is corrupted or uses an unsupported compression method.
+uint8_t* readJarEntry(JarFile* jar, JarEntry* entry, uint8_t* outAllocated)
+{
+    const uint8_t* header;
+    uint8_t* data;
+    uint32_t offset = entry->localHeaderOffset;
+
+    *outAllocated = 0;
+
+    if (offset > jar->file.size || jar->file.size - offset < 30)
+        return NULL;
+
+    header = jar->file.data + offset;
+
+    if (readLE32(header) != ZIP_LOCAL_FILE_HEADER)
+        return NULL;
+
+    // The local header may have a different extra field than the
+    // central directory
+    offset += 30 + readLE16(header + 26) + readLE16(header + 28);
+
+    if (offset > jar->file.size || jar->file.size - offset < entry->compressedSize)
+        return NULL;
+
+    if (entry->method == ZIP_METHOD_STORED)
+    {
+        if (entry->compressedSize != entry->uncompressedSize)
+            return NULL;
+
+        data = jar->file.data + offset;
+    }
+    else if (entry->method == ZIP_METHOD_DEFLATED)
+    {
+        data = (uint8_t*)malloc(entry->uncompressedSize ? entry->uncompressedSize : 1);
+
+        if (!data)
+            return NULL;
+
+        if (!inflateData(jar->file.data + offset, entry->compressedSize, data, entry->uncompressedSize))
+        {
+            free(data);
+            return NULL;
+        }
+
+        *outAllocated = 1;
+    }
+    else
+    {
+        return NULL;
+    }
+
+    if (computeCRC32(data, entry->uncompressedSize) != entry->crc32)
+    {
+        if (*outAllocated)
+            free(data);
+
+        *outAllocated = 0;
+        return NULL;
+    }
+
+    return data;
+}
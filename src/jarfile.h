@@ -0,0 +1,60 @@
+#ifndef JARFILE_H
+#define JARFILE_H
+
+#include <stdint.h>
+#include "mappedfile.h"
+
+typedef struct JarEntry
+{
+    // Name of the entry, pointing into the central directory
+    const uint8_t* name;
+    uint16_t nameLength;
+
+    // 0 if stored, 8 if compressed with DEFLATE
+    uint16_t method;
+    uint32_t crc32;
+    uint32_t compressedSize;
+    uint32_t uncompressedSize;
+    uint32_t localHeaderOffset;
+
+    // Next entry in the same hash bucket, or JAR_NO_ENTRY
+    uint32_t next;
+} JarEntry;
+
+#define JAR_NO_ENTRY 0xFFFFFFFF
+
+typedef struct JarFile
+{
+    MappedFile file;
+
+    JarEntry* entries;
+    uint32_t entryCount;
+
+    // Hash index of the entries by name. bucketCount is a power
+    // of two, and each bucket holds the first entry of its chain.
+    uint32_t* buckets;
+    uint32_t bucketCount;
+} JarFile;
+
+uint8_t openJarFile(JarFile* jar, const char* path);
+void closeJarFile(JarFile* jar);
+JarEntry* findJarEntry(JarFile* jar, const uint8_t* name, uint32_t nameLength);
+uint8_t* readJarEntry(JarFile* jar, JarEntry* entry, uint8_t* outAllocated);
+
+#endif // JARFILE_H
+
+/// @defgroup jarfile Jar file module
+///
+/// @brief Reads classes from jar (zip) files.
+///
+/// When a jar is opened, it is mapped into memory and its central
+/// directory is read once into a hash index of entry names, so
+/// looking a class up doesn't touch the rest of the file.
+///
+/// Stored entries are handed out as pointers into the mapping, so
+/// the class file parser reads them without any copy. Compressed
+/// entries are inflated on demand into a buffer, see @ref inflate.
+///
+/// Zip64 archives and encrypted entries aren't supported.
+///
+/// @see openJarFile(), readJarEntry()
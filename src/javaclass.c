@@ -5,30 +5,19 @@
 #include "validity.h"
 #include "memoryinspect.h"
 
-/// @brief Opens a class file and parse it, storing the class
-/// information in the JavaClass structure.
-/// @param JavaClass* jc - pointer to the structure that will
-/// hold the class data
-/// @param const char* path - string containing the path to the
-/// class file to be read
-///
-/// This function opens the .class file and reads its content
-/// from the file by filling in the fields of the JavaClass struct.
-/// A bunch of other functions from different modules are called
-/// to read some pieces of the class file. Various checks are made
-/// during the parsing of the read data.
-///
-/// @see closeClassFile, printClassFileInfo(), printClassFileDebugInfo()
-/// @hidecallergraph
-void openClassFile(JavaClass* jc, const char* path)
+/// @brief Sets up an empty JavaClass structure, which can be
+/// closed with closeClassFile() without having been opened.
+/// @param JavaClass* jc - pointer to the structure.
+/// @see openClassFile()
+void initJavaClass(JavaClass* jc)
 {
-    if (!jc)
-        return;
+    jc->file.data = NULL;
+    jc->file.size = 0;
+    jc->fileOwnership = CLASS_FILE_BORROWED;
+    jc->trusted = 0;
+    jc->verifiedMethods = NULL;
+    initArena(&jc->arena, 0);
 
-    uint32_t u32;
-    uint16_t u16;
-
-    jc->file = fopen(path, "rb");
     jc->minorVersion = jc->majorVersion = jc->constantPoolCount = 0;
     jc->constantPool = NULL;
     jc->interfaces = NULL;
@@ -54,12 +43,21 @@ void openClassFile(JavaClass* jc, const char* path)
     jc->currentMethodEntryIndex = -1;
     jc->currentAttributeEntryIndex = -1;
     jc->currentValidityEntryIndex = -1;
+}
 
-    if (!jc->file)
-    {
-        jc->status = CLASS_STATUS_FILE_COULDNT_BE_OPENED;
-        return;
-    }
+/// @brief Parses the class file bytes in jc->file.
+/// @param JavaClass* jc - pointer to the structure that will
+/// hold the class data
+/// @param const char* path - path of the class file, checked
+/// against the name of the class.
+static void readClassFile(JavaClass* jc, const char* path)
+{
+    uint32_t u32;
+    uint16_t u16;
+
+    // The tables of a class take about as much memory as its file,
+    // so a single block usually holds all of them
+    initArena(&jc->arena, jc->file.size);
 
     if (!readu4(jc, &u32) || u32 != 0xCAFEBABE)
     {
@@ -89,7 +87,7 @@ void openClassFile(JavaClass* jc, const char* path)
 
     if (jc->constantPoolCount > 1)
     {
-        jc->constantPool = (cp_info*)malloc(sizeof(cp_info) * (jc->constantPoolCount - 1));
+        jc->constantPool = (cp_info*)allocFromArena(&jc->arena, sizeof(cp_info) * (jc->constantPoolCount - 1));
 
         if (!jc->constantPool)
         {
@@ -113,7 +111,7 @@ void openClassFile(JavaClass* jc, const char* path)
             jc->constantPoolEntriesRead++;
         }
 
-        if (!checkConstantPoolValidity(jc))
+        if (!jc->trusted && !checkConstantPoolValidity(jc))
             return;
     }
 
@@ -125,7 +123,7 @@ void openClassFile(JavaClass* jc, const char* path)
         return;
     }
 
-    if (!checkClassIndexAndAccessFlags(jc))
+    if (!jc->trusted && !checkClassIndexAndAccessFlags(jc))
         return;
 
     if (!checkClassNameFileNameMatch(jc, path))
@@ -139,7 +137,7 @@ void openClassFile(JavaClass* jc, const char* path)
 
     if (jc->interfaceCount > 0)
     {
-        jc->interfaces = (uint16_t*)malloc(sizeof(uint16_t) * jc->interfaceCount);
+        jc->interfaces = (uint16_t*)allocFromArena(&jc->arena, sizeof(uint16_t) * jc->interfaceCount);
 
         if (!jc->interfaces)
         {
@@ -174,7 +172,7 @@ void openClassFile(JavaClass* jc, const char* path)
 
     if (jc->fieldCount > 0)
     {
-        jc->fields = (field_info*)malloc(sizeof(field_info) * jc->fieldCount);
+        jc->fields = (field_info*)allocFromArena(&jc->arena, sizeof(field_info) * jc->fieldCount);
 
         if (!jc->fields)
         {
@@ -220,7 +218,7 @@ void openClassFile(JavaClass* jc, const char* path)
 
     if (jc->methodCount > 0)
     {
-        jc->methods = (method_info*)malloc(sizeof(method_info) * jc->methodCount);
+        jc->methods = (method_info*)allocFromArena(&jc->arena, sizeof(method_info) * jc->methodCount);
 
         if (!jc->methods)
         {
@@ -248,7 +246,7 @@ void openClassFile(JavaClass* jc, const char* path)
 
     if (jc->attributeCount > 0)
     {
-        jc->attributes = (attribute_info*)malloc(sizeof(attribute_info) * jc->attributeCount);
+        jc->attributes = (attribute_info*)allocFromArena(&jc->arena, sizeof(attribute_info) * jc->attributeCount);
 
         if (!jc->attributes)
         {
@@ -271,16 +269,72 @@ void openClassFile(JavaClass* jc, const char* path)
         }
     }
 
-    if (fgetc(jc->file) != EOF)
-    {
+    if (jc->totalBytesRead != jc->file.size)
         jc->status = FILE_CONTAINS_UNEXPECTED_DATA;
-    }
-    else
+}
+
+/// @brief Opens a class file and parse it, storing the class
+/// information in the JavaClass structure.
+/// @param JavaClass* jc - pointer to the structure that will
+/// hold the class data
+/// @param const char* path - string containing the path to the
+/// class file to be read
+///
+/// This function maps the .class file into memory and reads its
+/// content by filling in the fields of the JavaClass struct.
+/// Constant pool strings and method bytecode point into the
+/// mapping instead of being copied, so it is kept until the
+/// class is closed.
+/// A bunch of other functions from different modules are called
+/// to read some pieces of the class file. Various checks are made
+/// during the parsing of the read data.
+///
+/// @see closeClassFile, openClassData(), printClassFileInfo(), printClassFileDebugInfo()
+/// @hidecallergraph
+void openClassFile(JavaClass* jc, const char* path)
+{
+    if (!jc)
+        return;
+
+    initJavaClass(jc);
+
+    if (!mapFile(&jc->file, path))
     {
-        fclose(jc->file);
-        jc->file = NULL;
+        jc->status = CLASS_STATUS_FILE_COULDNT_BE_OPENED;
+        return;
     }
 
+    jc->fileOwnership = CLASS_FILE_MAPPED;
+    readClassFile(jc, path);
+}
+
+/// @brief Parses a class file that is already in memory, such as
+/// an entry of a jar file.
+/// @param JavaClass* jc - pointer to the structure that will
+/// hold the class data
+/// @param const char* path - name of the class file, checked
+/// against the name of the class.
+/// @param uint8_t* data - the bytes of the class file, which must
+/// stay valid until the class is closed.
+/// @param uint32_t size - the number of bytes.
+/// @param enum ClassFileOwnership ownership - CLASS_FILE_ALLOCATED
+/// if closeClassFile() must free the bytes, CLASS_FILE_BORROWED if
+/// they belong to someone else.
+/// @param uint8_t trusted - non-zero if the bytes have already been
+/// validated, such as classes of a shared archive, in which case
+/// the constant pool and class checks are skipped.
+/// @see openClassFile()
+void openClassData(JavaClass* jc, const char* path, uint8_t* data, uint32_t size, enum ClassFileOwnership ownership, uint8_t trusted)
+{
+    if (!jc)
+        return;
+
+    initJavaClass(jc);
+    jc->file.data = data;
+    jc->file.size = size;
+    jc->fileOwnership = ownership;
+    jc->trusted = trusted;
+    readClassFile(jc, path);
 }
 
 /// @brief Closes the .class file and releases resources used by
@@ -294,60 +348,24 @@ void closeClassFile(JavaClass* jc)
     if (!jc)
         return;
 
-    uint16_t i;
-
-    if (jc->file)
-    {
-        fclose(jc->file);
-        jc->file = NULL;
-    }
-
-    if (jc->interfaces)
-    {
-        free(jc->interfaces);
-        jc->interfaces = NULL;
-        jc->interfaceCount = 0;
-    }
-
-    if (jc->constantPool)
-    {
-        for (i = 0; i < jc->constantPoolCount - 1; i++)
-        {
-            if (jc->constantPool[i].tag == CONSTANT_Utf8 && jc->constantPool[i].Utf8.bytes)
-                free(jc->constantPool[i].Utf8.bytes);
-        }
-
-        free(jc->constantPool);
-        jc->constantPool = NULL;
-        jc->constantPoolCount = 0;
-    }
-
-    if (jc->methods)
-    {
-        for (i = 0; i < jc->methodCount; i++)
-            freeMethodAttributes(jc->methods + i);
-
-        free(jc->methods);
-        jc->methodCount = 0;
-    }
-
-    if (jc->fields)
-    {
-        for (i = 0; i < jc->fieldCount; i++)
-            freeFieldAttributes(jc->fields + i);
+    freeArena(&jc->arena);
 
-        free(jc->fields);
-        jc->fieldCount = 0;
-    }
+    jc->interfaces = NULL;
+    jc->constantPool = NULL;
+    jc->methods = NULL;
+    jc->fields = NULL;
+    jc->attributes = NULL;
+    jc->interfaceCount = jc->constantPoolCount = jc->methodCount = jc->fieldCount = jc->attributeCount = 0;
 
-    if (jc->attributes)
-    {
-        for (i = 0; i < jc->attributeCount; i++)
-            freeAttributeInfo(jc->attributes + i);
+    // Strings and bytecode pointing into the class file bytes
+    // have all been released by now
+    if (jc->fileOwnership == CLASS_FILE_MAPPED)
+        unmapFile(&jc->file);
+    else if (jc->fileOwnership == CLASS_FILE_ALLOCATED && jc->file.data)
+        free(jc->file.data);
 
-        free(jc->attributes);
-        jc->attributeCount = 0;
-    }
+    jc->file.data = NULL;
+    jc->file.size = 0;
 }
 
 /// @brief Decodes JavaClassStatus enumeration elements
@@ -397,6 +415,7 @@ const char* decodeJavaClassStatus(enum JavaClassStatus status)
         case ATTRIBUTE_INVALID_INNERCLASS_INDEXES: return "InnerClass has at least one invalid index";
         case ATTRIBUTE_INVALID_EXCEPTIONS_CLASS_INDEX: return "Exceptions has an index that doesn't point to a valid class";
         case ATTRIBUTE_INVALID_CODE_LENGTH: return "Attribute code must have a length greater than 0 and less than 65536 bytes";
+        case ATTRIBUTE_INVALID_STACKMAPTABLE: return "StackMapTable has an invalid frame type or verification type";
 
         case FILE_CONTAINS_UNEXPECTED_DATA: return "class file contains more data than expected, which wasn't processed";
 
@@ -5,10 +5,12 @@ typedef struct JavaClass JavaClass;
 
 #include <stdio.h>
 #include <stdint.h>
+#include "arena.h"
 #include "constantpool.h"
 #include "attributes.h"
 #include "fields.h"
 #include "methods.h"
+#include "mappedfile.h"
 
 enum AccessFlagsType {
     ACCT_CLASS,
@@ -89,13 +91,33 @@ enum JavaClassStatus {
     ATTRIBUTE_INVALID_INNERCLASS_INDEXES,
     ATTRIBUTE_INVALID_EXCEPTIONS_CLASS_INDEX,
     ATTRIBUTE_INVALID_CODE_LENGTH,
+    ATTRIBUTE_INVALID_STACKMAPTABLE,
 
     FILE_CONTAINS_UNEXPECTED_DATA
 };
 
+/// @brief What closeClassFile() does with the bytes of a class file.
+enum ClassFileOwnership {
+    CLASS_FILE_MAPPED,
+    CLASS_FILE_ALLOCATED,
+    CLASS_FILE_BORROWED
+};
+
 struct JavaClass {
     // General
-    FILE* file;
+    MappedFile file;
+    uint8_t fileOwnership;
+
+    // Holds the tables of the class, so they are all released at once
+    Arena arena;
+
+    // Set for classes read from a shared archive, which were
+    // validated and verified when the archive was dumped
+    uint8_t trusted;
+
+    // Verification flag of each method of a trusted class, given
+    // to its Code attribute when it is decoded, or NULL
+    const uint8_t* verifiedMethods;
     enum JavaClassStatus status;
     uint8_t classNameMismatch;
 
@@ -133,7 +155,9 @@ struct JavaClass {
 
 };
 
+void initJavaClass(JavaClass* jc);
 void openClassFile(JavaClass* jc, const char* path);
+void openClassData(JavaClass* jc, const char* path, uint8_t* data, uint32_t size, enum ClassFileOwnership ownership, uint8_t trusted);
 void closeClassFile(JavaClass* jc);
 const char* decodeJavaClassStatus(enum JavaClassStatus);
 void decodeAccessFlags(uint16_t flags, char* buffer, int32_t buffer_len, enum AccessFlagsType acctype);
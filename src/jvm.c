@@ -2,6 +2,12 @@
 #include "utf8.h"
 #include "natives.h"
 #include "instructions.h"
+#include "interpreter.h"
+#include "registerir.h"
+#include "typemap.h"
+#include "verifier.h"
+#include "threads.h"
+#include "heapdump.h"
 
 #include "memoryinspect.h"
 #include <string.h>
@@ -21,7 +27,36 @@ void initJVM(JavaVirtualMachine* jvm)
     jvm->classes = NULL;
     jvm->objects = NULL;
 
-    jvm->classPath[0] = '\0';
+    initClassPath(&jvm->classPath);
+
+    jvm->useSuperinstructions = 1;
+    jvm->useRegisterIR = 0;
+    jvm->superinstructionSites = 0;
+    jvm->dispatchCount = 0;
+    jvm->ngramProfile = NULL;
+    jvm->opcodeProfile = NULL;
+    jvm->sampler = NULL;
+    jvm->tracer = NULL;
+    jvm->allocationProfile = NULL;
+    jvm->heapDumpPath = NULL;
+    jvm->heapDumpCount = 0;
+    jvm->perfData = NULL;
+    jvm->perfMap = NULL;
+    jvm->collector = NULL;
+    jvm->verifyClasses = 1;
+    jvm->verifyCachePath = NULL;
+    jvm->sharedArchive = NULL;
+    jvm->prefetcher = NULL;
+    jvm->classList = NULL;
+    jvm->loadedClassCount = 0;
+    jvm->sharedClassCount = 0;
+    jvm->verifiedClassCount = 0;
+    jvm->cachedVerificationCount = 0;
+    jvm->startTime = getMonotonicTime();
+    jvm->firstInstructionTime = 0;
+    jvm->mainStartTime = 0;
+    jvm->mainExitTime = 0;
+    memset(jvm->superinstructionCount, 0, sizeof(jvm->superinstructionCount));
 
     // We need to simulate those two classes, and their support is
     // highly limited. Reading them from the Oracle .class files
@@ -36,11 +71,32 @@ void initJVM(JavaVirtualMachine* jvm)
 /// deallocated.
 ///
 /// All loaded classes and objects created during the execution of the JVM
-/// will be freed.
+/// will be freed. This is only needed by programs that keep running
+/// after the JVM, as exitJVM() is much faster when the process ends.
 ///
-/// @see initJVM()
+/// @see initJVM(), exitJVM()
 void deinitJVM(JavaVirtualMachine* jvm)
 {
+    // The sampler reads the frame stack
+    if (jvm->sampler)
+    {
+        freeMethodSampler(jvm->sampler);
+        jvm->sampler = NULL;
+    }
+
+    if (jvm->tracer)
+    {
+        freeTracer(jvm->tracer);
+        jvm->tracer = NULL;
+    }
+
+    // Workers read from the class path, so they are stopped first
+    if (jvm->prefetcher)
+    {
+        freeClassPrefetcher(jvm->prefetcher);
+        jvm->prefetcher = NULL;
+    }
+
     freeFrameStack(&jvm->frames);
 
     LoadedClasses* classnode = jvm->classes;
@@ -50,6 +106,8 @@ void deinitJVM(JavaVirtualMachine* jvm)
     {
         classtmp = classnode;
         classnode = classnode->next;
+        freeClassIR(classtmp->jc);
+        freeClassTypes(classtmp->jc);
         closeClassFile(classtmp->jc);
         free(classtmp->jc);
 
@@ -70,8 +128,30 @@ void deinitJVM(JavaVirtualMachine* jvm)
         free(reftmp);
     }
 
+    if (jvm->ngramProfile)
+        freeNgramProfile(jvm->ngramProfile);
+
+    if (jvm->classList)
+        freeClassList(jvm->classList);
+
+    if (jvm->opcodeProfile)
+        freeOpcodeProfile(jvm->opcodeProfile);
+
+    if (jvm->allocationProfile)
+        freeAllocationProfile(jvm->allocationProfile);
+
+    if (jvm->perfMap)
+        freePerfMap(jvm->perfMap);
+
+    if (jvm->collector)
+        freeGarbageCollector(jvm->collector);
+
+    // Classes read from jars without being copied are closed by now
+    freeClassPath(&jvm->classPath);
+
     jvm->objects = NULL;
     jvm->classes = NULL;
+    jvm->ngramProfile = NULL;
 }
 
 /// @brief Executes the main method of a given class.
@@ -120,10 +200,172 @@ void executeJVM(JavaVirtualMachine* jvm, LoadedClasses* mainClass)
         return;
     }
 
+    jvm->mainStartTime = getMonotonicTime() - jvm->startTime;
+
     if (!runMethod(jvm, mainClass->jc, method, 0))
         return;
+
+    jvm->mainExitTime = getMonotonicTime() - jvm->startTime;
+}
+
+/// @brief Ends the process once the JVM has run, letting the operating
+/// system release the heap, the arenas and the mappings of the classes
+/// at once, instead of freeing every object and class.
+///
+/// Output is flushed and the class loader workers are stopped first.
+/// Files such as profiles and the shared archive must have been written
+/// before. In DEBUG builds, the JVM is deinitialized as usual, so the
+/// memory inspect report still finds leaks.
+///
+/// @param JavaVirtualMachine* jvm - the JVM, which is not usable anymore.
+///
+/// @see deinitJVM()
+void exitJVM(JavaVirtualMachine* jvm)
+{
+#ifdef DEBUG
+    SharedArchive* archive = jvm->sharedArchive;
+
+    deinitJVM(jvm);
+
+    if (archive)
+        closeSharedArchive(archive);
+#else
+    if (jvm->prefetcher)
+        stopClassPrefetcher(jvm->prefetcher);
+
+    // Writes the events still in the buffer
+    if (jvm->tracer)
+        stopTracer(jvm->tracer);
+#endif // DEBUG
+
+    fflush(stdout);
+    fflush(stderr);
+    exit(0);
 }
 
+/// @brief Prints how many classes were loaded, how many of them came
+/// from the shared archive, how many were verified and how long it
+/// took to run the first instruction, to reach the main method and to
+/// return from it.
+/// @param JavaVirtualMachine* jvm - pointer to a JVM that has executed
+/// its main class.
+/// @see executeJVM(), openClassFromArchive()
+void printStartupReport(JavaVirtualMachine* jvm)
+{
+    printf("Classes loaded: %u (%u from the shared archive)\n", jvm->loadedClassCount, jvm->sharedClassCount);
+
+    if (jvm->verifyClasses)
+    {
+        printf("Classes verified: %u (%u from the verification cache)\n", jvm->verifiedClassCount,
+               jvm->cachedVerificationCount);
+    }
+
+    if (jvm->firstInstructionTime)
+        printf("Time to first instruction: %.3f ms\n", jvm->firstInstructionTime);
+    else
+        printf("Time to first instruction: no instruction ran\n");
+
+    if (jvm->mainStartTime)
+        printf("Time to main: %.3f ms\n", jvm->mainStartTime);
+    else
+        printf("Time to main: main wasn't reached\n");
+
+    if (jvm->mainExitTime)
+        printf("Time to main exit: %.3f ms\n", jvm->mainExitTime);
+    else
+        printf("Time to main exit: main didn't return\n");
+
+    if (jvm->classList && jvm->classList->replayedCount)
+        printf("Classes replayed from the class list: %u\n", jvm->classList->replayedCount);
+
+    if (jvm->prefetcher)
+    {
+        uint32_t parsed, used;
+        getPrefetchStatistics(jvm->prefetcher, &parsed, &used);
+        printf("Classes parsed ahead: %u (%u used)\n", parsed, used);
+    }
+}
+
+/// @brief Opens the .class file of a class, from the shared archive
+/// if it has the class, or else from the class path.
+///
+/// This only parses the class, so it may be called by any thread.
+///
+/// @param JavaVirtualMachine* jvm - the JVM whose class path is used.
+/// @param JavaClass* jc - receives the class, whose status tells
+/// whether it could be opened.
+/// @param const uint8_t* className_utf8_bytes - the class name.
+/// @param int32_t utf8_len - length of the class name.
+/// @see resolveClass(), takePrefetchedClass()
+void loadClassFile(JavaVirtualMachine* jvm, JavaClass* jc, const uint8_t* className_utf8_bytes, int32_t utf8_len)
+{
+    if (!jvm->sharedArchive || !openClassFromArchive(jvm->sharedArchive, &jvm->classPath, jc, className_utf8_bytes, utf8_len))
+        openClassFromClassPath(&jvm->classPath, jc, className_utf8_bytes, utf8_len);
+}
+
+/// @brief Queues the class at a CONSTANT_Class index of a class
+/// to be parsed by the prefetcher, unless it is already loaded.
+static void prefetchClassAt(JavaVirtualMachine* jvm, JavaClass* jc, uint16_t index)
+{
+    cp_info* cpi = jc->constantPool + index - 1;
+    const uint8_t* name;
+    int32_t length;
+
+    cpi = jc->constantPool + cpi->Class.name_index - 1;
+    name = cpi->Utf8.bytes;
+    length = cpi->Utf8.length;
+
+    while (length > 0 && *name == '[')
+    {
+        name++;
+        length--;
+    }
+
+    if (length != cpi->Utf8.length)
+    {
+        // Arrays of primitive types have no class to parse
+        if (length < 2 || *name != 'L')
+            return;
+
+        name++;
+        length -= 2;
+    }
+
+    if (jvm->simulatingSystemAndStringClasses &&
+        cmp_UTF8(name, length, (const uint8_t*)"java/lang/String", 16))
+    {
+        return;
+    }
+
+    if (!isClassLoaded(jvm, name, length))
+        prefetchClass(jvm->prefetcher, name, length);
+}
+
+/// @brief Queues the classes referenced by a class to be parsed by
+/// the prefetcher, in the order they are likely to be resolved:
+/// the superclass, the interfaces and then the rest of the constant pool.
+static void prefetchReferencedClasses(JavaVirtualMachine* jvm, JavaClass* jc)
+{
+    uint16_t u16;
+
+    if (jc->superClass)
+        prefetchClassAt(jvm, jc, jc->superClass);
+
+    for (u16 = 0; u16 < jc->interfaceCount; u16++)
+        prefetchClassAt(jvm, jc, jc->interfaces[u16]);
+
+    for (u16 = 1; u16 < jc->constantPoolCount; u16++)
+    {
+        if (jc->constantPool[u16 - 1].tag == CONSTANT_Class && u16 != jc->thisClass)
+            prefetchClassAt(jvm, jc, u16);
+    }
+}
+
+/// @brief Adds the current directory and the directory of the main
+/// class to the class path, before any other entry.
+/// @param JavaVirtualMachine* jvm - pointer to an initialized JVM.
+/// @param const char* path - path of the main class file.
+/// @see addClassPathEntries()
 void setClassPath(JavaVirtualMachine* jvm, const char* path)
 {
     uint32_t index;
@@ -135,10 +377,10 @@ void setClassPath(JavaVirtualMachine* jvm, const char* path)
             lastSlash = index;
     }
 
+    addClassPathEntry(&jvm->classPath, "", 0);
+
     if (lastSlash)
-        memcpy(jvm->classPath, path, lastSlash + 1);
-    else
-        jvm->classPath[0] = '\0';
+        addClassPathEntry(&jvm->classPath, path, lastSlash + 1);
 }
 
 /// @brief Loads a .class file.
@@ -148,7 +390,6 @@ uint8_t resolveClass(JavaVirtualMachine* jvm, const uint8_t* className_utf8_byte
 {
     JavaClass* jc;
     cp_info* cpi;
-    char path[1024];
     uint8_t success = 1;
     uint16_t u16;
 
@@ -200,33 +441,26 @@ uint8_t resolveClass(JavaVirtualMachine* jvm, const uint8_t* className_utf8_byte
         return 1;
     }
 
-#ifdef DEBUG
-    printf("debug resolveClass %.*s\n", utf8_len, className_utf8_bytes);
-#endif // DEBUG
-
-    snprintf(path, sizeof(path), "%.*s.class", utf8_len, className_utf8_bytes);
-
     jc = (JavaClass*)malloc(sizeof(JavaClass));
-    openClassFile(jc, path);
 
-    if (jc->status == CLASS_STATUS_FILE_COULDNT_BE_OPENED && jvm->classPath[0])
-    {
-        snprintf(path, sizeof(path), "%s%.*s.class", jvm->classPath, utf8_len, className_utf8_bytes);
-        openClassFile(jc, path);
-    }
+    if (!jvm->prefetcher || !takePrefetchedClass(jvm->prefetcher, className_utf8_bytes, utf8_len, jc))
+        loadClassFile(jvm, jc, className_utf8_bytes, utf8_len);
 
     if (jc->status != CLASS_STATUS_OK)
     {
-
-#ifdef DEBUG
-    printf("   class '%.*s' loading failed\n", utf8_len, className_utf8_bytes);
-    printf("   status: %s\n", decodeJavaClassStatus(jc->status));
-#endif // DEBUG
+        if (TRACING(jvm, TRACE_CLASS))
+        {
+            traceEvent(jvm->tracer, TRACE_CLASS, "%.*s failed: %s", (int)utf8_len, className_utf8_bytes,
+                       decodeJavaClassStatus(jc->status));
+        }
 
         success = 0;
     }
     else
     {
+        if (jvm->prefetcher)
+            prefetchReferencedClasses(jvm, jc);
+
         if (jc->superClass)
         {
             cpi = jc->constantPool + jc->superClass - 1;
@@ -251,6 +485,11 @@ uint8_t resolveClass(JavaVirtualMachine* jvm, const uint8_t* className_utf8_byte
         }
     }
 
+    // Classes are verified before being added, so that one failing
+    // verification is never used.
+    if (success)
+        success = verifyClass(jvm, jc);
+
     if (success)
     {
         loadedClass = addClassToLoadedClasses(jvm, jc);
@@ -259,17 +498,32 @@ uint8_t resolveClass(JavaVirtualMachine* jvm, const uint8_t* className_utf8_byte
 
     if (success)
     {
+        if (TRACING(jvm, TRACE_CLASS))
+        {
+            traceEvent(jvm->tracer, TRACE_CLASS, "%.*s loaded%s", (int)utf8_len, className_utf8_bytes,
+                       jc->trusted ? " from the shared archive" : "");
+        }
 
-#ifdef DEBUG
-    printf("   class file '%s' loaded\n", path);
-#endif // DEBUG
+        jvm->loadedClassCount++;
+        jvm->sharedClassCount += jc->trusted;
+
+        if (jvm->perfData)
+            addPerfCounter(jvm->perfData, PERF_CLASSES_LOADED, 1);
+
+        if (jvm->classList)
+            recordLoadedClass(jvm->classList, className_utf8_bytes, utf8_len, getMonotonicTime() - jvm->startTime);
 
         if (outClass)
             *outClass = loadedClass;
     }
     else
     {
-        jvm->status = JVM_STATUS_CLASS_RESOLUTION_FAILED;
+        if (jvm->status == JVM_STATUS_OK)
+            jvm->status = JVM_STATUS_CLASS_RESOLUTION_FAILED;
+
+        if (jc->status == CLASS_STATUS_OK)
+            freeClassTypes(jc);
+
         closeClassFile(jc);
         free(jc);
     }
@@ -277,24 +531,24 @@ uint8_t resolveClass(JavaVirtualMachine* jvm, const uint8_t* className_utf8_byte
     return success;
 }
 
+/// @brief Records the resolution of a method or field reference as
+/// "kind Class.name:descriptor".
+static void traceReference(JavaVirtualMachine* jvm, JavaClass* jc, const char* kind, uint16_t class_index, uint16_t name_and_type_index)
+{
+    cp_info* className = jc->constantPool + class_index - 1;
+    cp_info* nameAndType = jc->constantPool + name_and_type_index - 1;
+    cp_info* name = jc->constantPool + nameAndType->NameAndType.name_index - 1;
+    cp_info* descriptor = jc->constantPool + nameAndType->NameAndType.descriptor_index - 1;
+
+    className = jc->constantPool + className->Class.name_index - 1;
+    traceEvent(jvm->tracer, TRACE_RESOLVE, "%s %.*s.%.*s:%.*s", kind, (int)className->Utf8.length, className->Utf8.bytes,
+               (int)name->Utf8.length, name->Utf8.bytes, (int)descriptor->Utf8.length, descriptor->Utf8.bytes);
+}
+
 uint8_t resolveMethod(JavaVirtualMachine* jvm, JavaClass* jc, cp_info* cp_method, LoadedClasses** outClass)
 {
-#ifdef DEBUG
-    {
-        char debugbuffer[256];
-        uint32_t length = 0;
-        cp_info* debugcpi = jc->constantPool + cp_method->Methodref.class_index - 1;
-        debugcpi = jc->constantPool + debugcpi->Class.name_index - 1;
-        length += snprintf(debugbuffer + length, sizeof(debugbuffer) - length, "%.*s.", debugcpi->Utf8.length, debugcpi->Utf8.bytes);
-        debugcpi = jc->constantPool + cp_method->Methodref.name_and_type_index - 1;
-        debugcpi = jc->constantPool + debugcpi->NameAndType.name_index - 1;
-        length += snprintf(debugbuffer + length, sizeof(debugbuffer) - length, "%.*s:", debugcpi->Utf8.length, debugcpi->Utf8.bytes);
-        debugcpi = jc->constantPool + cp_method->Methodref.name_and_type_index - 1;
-        debugcpi = jc->constantPool + debugcpi->NameAndType.descriptor_index - 1;
-        length += snprintf(debugbuffer + length, sizeof(debugbuffer) - length, "%.*s", debugcpi->Utf8.length, debugcpi->Utf8.bytes);
-        printf("debug resolveMethod %s\n", debugbuffer);
-    }
-#endif // DEBUG
+    if (TRACING(jvm, TRACE_RESOLVE))
+        traceReference(jvm, jc, "method", cp_method->Methodref.class_index, cp_method->Methodref.name_and_type_index);
 
     cp_info* cpi;
 
@@ -350,23 +604,8 @@ uint8_t resolveMethod(JavaVirtualMachine* jvm, JavaClass* jc, cp_info* cp_method
 
 uint8_t resolveField(JavaVirtualMachine* jvm, JavaClass* jc, cp_info* cp_field, LoadedClasses** outClass)
 {
-
-#ifdef DEBUG
-    {
-        char debugbuffer[256];
-        uint32_t length = 0;
-        cp_info* debugcpi = jc->constantPool + cp_field->Fieldref.class_index - 1;
-        debugcpi = jc->constantPool + debugcpi->Class.name_index - 1;
-        length += snprintf(debugbuffer + length, sizeof(debugbuffer) - length, "%.*s.", debugcpi->Utf8.length, debugcpi->Utf8.bytes);
-        debugcpi = jc->constantPool + cp_field->Fieldref.name_and_type_index - 1;
-        debugcpi = jc->constantPool + debugcpi->NameAndType.name_index - 1;
-        length += snprintf(debugbuffer + length, sizeof(debugbuffer) - length, "%.*s:", debugcpi->Utf8.length, debugcpi->Utf8.bytes);
-        debugcpi = jc->constantPool + cp_field->Fieldref.name_and_type_index - 1;
-        debugcpi = jc->constantPool + debugcpi->NameAndType.descriptor_index - 1;
-        length += snprintf(debugbuffer + length, sizeof(debugbuffer) - length, "%.*s", debugcpi->Utf8.length, debugcpi->Utf8.bytes);
-        printf("debug resolveField %s\n", debugbuffer);
-    }
-#endif // DEBUG
+    if (TRACING(jvm, TRACE_RESOLVE))
+        traceReference(jvm, jc, "field", cp_field->Fieldref.class_index, cp_field->Fieldref.name_and_type_index);
 
     cp_info* cpi;
 
@@ -402,23 +641,109 @@ uint8_t resolveField(JavaVirtualMachine* jvm, JavaClass* jc, cp_info* cp_field,
     return 1;
 }
 
-uint8_t runMethod(JavaVirtualMachine* jvm, JavaClass* jc, method_info* method, uint8_t numberOfParameters)
+/// @brief Decodes and links the code of a method the first time
+/// it runs.
+///
+/// Linking computes the type map of the method, unless verification
+/// already did, then translates it to register IR and fuses its
+/// instruction sequences, if the JVM uses them. Methods that never
+/// run are never decoded.
+///
+/// @param JavaVirtualMachine* jvm - the JVM running the method.
+/// @param JavaClass* jc - class the method belongs to.
+/// @param method_info* method - the method about to run.
+///
+/// @return 0 if the method has a Code attribute that is invalid,
+/// 1 otherwise.
+/// @see getMethodCode()
+static uint8_t linkMethod(JavaVirtualMachine* jvm, JavaClass* jc, method_info* method)
 {
-#ifdef DEBUG
+    att_Code_info* code = getMethodCode(jc, method);
+
+    if (!code)
+        return !getAttributeByType(method->attributes, method->attributes_count, ATTR_Code);
+
+    if (code->linked)
+        return 1;
+
+    if (!code->types)
+        code->types = analyzeMethodTypes(jc, method, code);
+
+    // The IR is translated from the original instructions, before
+    // any of them are fused.
+    if (jvm->useRegisterIR)
     {
-        char debugbuffer[256];
-        decodeAccessFlags(method->access_flags, debugbuffer, sizeof(debugbuffer), ACCT_METHOD);
-        cp_info* debug_cpi = jc->constantPool + method->name_index - 1;
-        printf("debug runMethod %s %.*s, params: %u",  debugbuffer, debug_cpi->Utf8.length, debug_cpi->Utf8.bytes, numberOfParameters);
+        code->ir = translateMethod(jc, code);
+
+        if (code->ir && jvm->perfData)
+            addPerfCounter(jvm->perfData, PERF_COMPILED_METHODS, 1);
     }
-#endif // DEBUG
+
+    if (jvm->useSuperinstructions)
+        predecodeMethod(jvm, code);
+
+    code->linked = 1;
+
+    if (TRACING(jvm, TRACE_CLASS))
+    {
+        TraceEvent* event = beginTraceEvent(jvm->tracer, TRACE_CLASS);
+
+        appendTraceText(event, "linked ");
+        appendTraceMethod(event, jc, method);
+        appendTraceText(event, ": %s, %s%s", code->types ? "analyzed" : "no type map",
+                        code->ir ? "translated" : "kept as bytecode", code->verified ? ", verified" : "");
+        commitTraceEvent(jvm->tracer);
+    }
+
+    return 1;
+}
+
+/// @brief Records a method entered, with its access flags and the
+/// parameter slots passed, or a method left.
+static void traceInvoke(JavaVirtualMachine* jvm, Frame* frame, uint8_t entering, uint8_t numberOfParameters)
+{
+    TraceEvent* event = beginTraceEvent(jvm->tracer, TRACE_INVOKE);
+    char flags[256];
+
+    appendTraceText(event, entering ? "enter " : "leave ");
+    appendTraceMethod(event, frame->jc, frame->method);
+
+    if (entering)
+    {
+        decodeAccessFlags(frame->method->access_flags, flags, sizeof(flags), ACCT_METHOD);
+        appendTraceText(event, " %s%s, %u parameter slots", flags, frame->code ? "" : " native", numberOfParameters);
+    }
+
+    commitTraceEvent(jvm->tracer);
+}
+
+uint8_t runMethod(JavaVirtualMachine* jvm, JavaClass* jc, method_info* method, uint8_t numberOfParameters)
+{
+    // Method calls are where SIGUSR1 dumps are taken, as the object
+    // table and frames are consistent here
+    if (heapDumpRequested)
+        dumpHeapOnRequest(jvm);
+
+    GC_SAFEPOINT(jvm);
 
     Frame* callerFrame = jvm->frames ? jvm->frames->frame : NULL;
+
+    if (!linkMethod(jvm, jc, method))
+    {
+        jvm->status = JVM_STATUS_INVALID_CODE_ATTRIBUTE;
+        return 0;
+    }
+
     Frame* frame = newFrame(jc, method);
 
-#ifdef DEBUG
-    printf(", len: %u, frame %X%s\n", frame->code_length, (uint32_t)frame, frame->code_length == 0 ? " ####### Native Method": "");
-#endif // DEBUG
+    if (!jvm->firstInstructionTime)
+        jvm->firstInstructionTime = getMonotonicTime() - jvm->startTime;
+
+    if (jvm->perfData)
+    {
+        addPerfCounter(jvm->perfData, PERF_INVOCATIONS, 1);
+        setPerfCounter(jvm->perfData, PERF_BYTECODES, jvm->dispatchCount);
+    }
 
     if (!frame || !pushFrame(&jvm->frames, frame))
     {
@@ -426,12 +751,23 @@ uint8_t runMethod(JavaVirtualMachine* jvm, JavaClass* jc, method_info* method, u
         return 0;
     }
 
+    if (jvm->tracer)
+    {
+        frame->traced = isMethodTraced(jvm->tracer, jc, method);
+
+        if (TRACING(jvm, TRACE_INVOKE))
+            traceInvoke(jvm, frame, 1, numberOfParameters);
+    }
+
+    if (jvm->ngramProfile && frame->code)
+        frame->executionCounters = getExecutionCounters(jvm->ngramProfile, frame->code, frame->code_length);
+
     uint8_t parameterIndex;
-    int32_t parameter;
+    Slot parameter;
 
     for (parameterIndex = 0; parameterIndex < numberOfParameters; parameterIndex++)
     {
-        popOperand(&callerFrame->operands, &parameter, NULL);
+        popSlot(&callerFrame->operands, &parameter);
         frame->localVariables[numberOfParameters - parameterIndex - 1] = parameter;
     }
 
@@ -451,65 +787,26 @@ uint8_t runMethod(JavaVirtualMachine* jvm, JavaClass* jc, method_info* method, u
     }
     else
     {
-        InstructionFunction function;
-
-        while (frame->pc < frame->code_length)
-        {
-
-#ifdef DEBUG
-    OperandStack* node;
-    node = frame->operands;
-    printf("\ndebug operand stack:\n");
-    if (!node) printf("empty.");
-    else while (node)
-    {
-        printf("%d.%d ", node->value, node->type);
-        node = node->next;
-    }
-    uint16_t ii;
-    printf("\ndebug localvars:\n");
-    if (!frame->localVariables) printf("empty.");
-    else for (ii = 0; ii < frame->max_locals; ii++)
-        printf("%d ", frame->localVariables[ii]);
-    printf("\n");
-#endif // DEBUG
-
-            uint8_t opcode = *(frame->code + frame->pc++);
-            function = fetchOpcodeFunction(opcode);
-
-#ifdef DEBUG
-    printf("   instruction '%s' at offset %u of frame %X\n", getOpcodeMnemonic(opcode), frame->pc - 1, (uint32_t)frame);
-#endif // DEBUG
+        InterpreterFunction interpret = frame->ir ? interpretIR : interpretFrame;
+        InterpreterTrampoline trampoline = jvm->perfMap ? getMethodTrampoline(jvm->perfMap, jc, method) : NULL;
 
-            if (function == NULL)
-            {
-
-#ifdef DEBUG
-    printf("   unknown instruction '%s'\n", getOpcodeMnemonic(opcode));
-#endif // DEBUG
-
-                jvm->status = JVM_STATUS_UNKNOWN_INSTRUCTION;
-                break;
-            }
-            else if (!function(jvm, frame))
-            {
-                return 0;
-            }
-        }
+        // Through the trampoline, perf sees which Java method runs
+        if (trampoline ? !trampoline(jvm, frame, interpret) : !interpret(jvm, frame))
+            return 0;
     }
 
     if (frame->returnCount > 0 && callerFrame)
     {
         // At most, two operands can be returned
-        OperandStack parameters[2];
+        Slot parameters[2];
         uint8_t index;
 
         for (index = 0; index < frame->returnCount; index++)
-            popOperand(&frame->operands, &parameters[index].value, &parameters[index].type);
+            popSlot(&frame->operands, parameters + index);
 
         while (frame->returnCount-- > 0)
         {
-            if (!pushOperand(&callerFrame->operands, parameters[frame->returnCount].value, parameters[frame->returnCount].type))
+            if (!pushSlot(&callerFrame->operands, parameters[frame->returnCount]))
             {
                 jvm->status = JVM_STATUS_OUT_OF_MEMORY;
                 return 0;
@@ -517,6 +814,9 @@ uint8_t runMethod(JavaVirtualMachine* jvm, JavaClass* jc, method_info* method, u
         }
     }
 
+    if (TRACING(jvm, TRACE_INVOKE))
+        traceInvoke(jvm, frame, 0, 0);
+
     popFrame(&jvm->frames, NULL);
     freeFrame(frame);
     return jvm->status == JVM_STATUS_OK;
@@ -736,6 +1036,22 @@ uint8_t initClass(JavaVirtualMachine* jvm, LoadedClasses* lc)
     return 1;
 }
 
+/// @brief Counts a new object for the performance counters and the
+/// young generation.
+static void countNewObject(JavaVirtualMachine* jvm, Reference* r)
+{
+    uint32_t bytes = getObjectSize(r);
+
+    if (jvm->perfData)
+    {
+        addPerfCounter(jvm->perfData, PERF_OBJECTS_ALLOCATED, 1);
+        addPerfCounter(jvm->perfData, PERF_BYTES_ALLOCATED, bytes);
+    }
+
+    if (jvm->collector)
+        countCollectedAllocation(jvm->collector, bytes);
+}
+
 Reference* newString(JavaVirtualMachine* jvm, const uint8_t* str, int32_t strlen)
 {
     Reference* r = (Reference*)malloc(sizeof(Reference));
@@ -772,8 +1088,18 @@ Reference* newString(JavaVirtualMachine* jvm, const uint8_t* str, int32_t strlen
 
     node->next = jvm->objects;
     node->obj = r;
+    node->age = 0;
     jvm->objects = node;
 
+    if (jvm->perfData || jvm->collector)
+        countNewObject(jvm, r);
+
+    if (jvm->allocationProfile && countAllocation(jvm->allocationProfile, sizeof(Reference) + strlen))
+        sampleAllocation(jvm->allocationProfile, jvm->frames, sizeof(Reference) + strlen, (const uint8_t*)"java/lang/String", 16, 0);
+
+    if (TRACING(jvm, TRACE_ALLOC))
+        traceEvent(jvm->tracer, TRACE_ALLOC, "%p string of %d bytes", (void*)r, (int)strlen);
+
     return r;
 }
 
@@ -807,6 +1133,9 @@ Reference* newClassInstance(JavaVirtualMachine* jvm, LoadedClasses* lc)
             free(node);
             return NULL;
         }
+
+        // Fields start at their default values, zero or null
+        memset(r->ci.data, 0, sizeof(int32_t) * jc->instanceFieldCount);
     }
     else
     {
@@ -815,13 +1144,31 @@ Reference* newClassInstance(JavaVirtualMachine* jvm, LoadedClasses* lc)
 
     node->next = jvm->objects;
     node->obj = r;
+    node->age = 0;
     jvm->objects = node;
 
-#ifdef DEBUG
-    cp_info* cpi = jc->constantPool + jc->thisClass - 1;
-    cpi = jc->constantPool + cpi->Class.name_index - 1;
-    printf("debug New class instance %d->%d of type %.*s\n", (int)r, (int)r->ci.data, cpi->Utf8.length, cpi->Utf8.bytes);
-#endif
+    if (jvm->perfData || jvm->collector)
+        countNewObject(jvm, r);
+
+    if (jvm->allocationProfile)
+    {
+        uint32_t bytes = sizeof(Reference) + jc->instanceFieldCount * sizeof(int32_t);
+
+        if (countAllocation(jvm->allocationProfile, bytes))
+        {
+            cp_info* cpi = jc->constantPool + jc->thisClass - 1;
+            cpi = jc->constantPool + cpi->Class.name_index - 1;
+            sampleAllocation(jvm->allocationProfile, jvm->frames, bytes, cpi->Utf8.bytes, cpi->Utf8.length, 0);
+        }
+    }
+
+    if (TRACING(jvm, TRACE_ALLOC))
+    {
+        cp_info* cpi = jc->constantPool + jc->thisClass - 1;
+        cpi = jc->constantPool + cpi->Class.name_index - 1;
+        traceEvent(jvm->tracer, TRACE_ALLOC, "%p %.*s, %u fields", (void*)r, (int)cpi->Utf8.length, cpi->Utf8.bytes,
+                   (uint32_t)jc->instanceFieldCount);
+    }
 
     return r;
 }
@@ -895,8 +1242,24 @@ Reference* newArray(JavaVirtualMachine* jvm, uint32_t length, Opcode_newarray_ty
 
     node->next = jvm->objects;
     node->obj = r;
+    node->age = 0;
     jvm->objects = node;
 
+    if (jvm->perfData || jvm->collector)
+        countNewObject(jvm, r);
+
+    if (jvm->allocationProfile)
+    {
+        uint32_t bytes = sizeof(Reference) + elementSize * r->arr.length;
+        const char* typeName = decodeOpcodeNewarrayType(type);
+
+        if (countAllocation(jvm->allocationProfile, bytes))
+            sampleAllocation(jvm->allocationProfile, jvm->frames, bytes, (const uint8_t*)typeName, (int32_t)strlen(typeName), 1);
+    }
+
+    if (TRACING(jvm, TRACE_ALLOC))
+        traceEvent(jvm->tracer, TRACE_ALLOC, "%p %s[%u]", (void*)r, decodeOpcodeNewarrayType(type), r->arr.length);
+
     return r;
 }
 
@@ -970,8 +1333,26 @@ Reference* newObjectArray(JavaVirtualMachine* jvm, uint32_t length, const uint8_
 
     node->next = jvm->objects;
     node->obj = r;
+    node->age = 0;
     jvm->objects = node;
 
+    if (jvm->perfData || jvm->collector)
+        countNewObject(jvm, r);
+
+    if (jvm->allocationProfile)
+    {
+        uint32_t bytes = sizeof(Reference) + r->oar.utf8_len + r->oar.length * sizeof(Reference*);
+
+        if (countAllocation(jvm->allocationProfile, bytes))
+            sampleAllocation(jvm->allocationProfile, jvm->frames, bytes, r->oar.utf8_className, r->oar.utf8_len, 1);
+    }
+
+    if (TRACING(jvm, TRACE_ALLOC))
+    {
+        traceEvent(jvm->tracer, TRACE_ALLOC, "%p %.*s[%u]", (void*)r, (int)r->oar.utf8_len, r->oar.utf8_className,
+                   r->oar.length);
+    }
+
     return r;
 }
 
@@ -1039,8 +1420,24 @@ Reference* newObjectMultiArray(JavaVirtualMachine* jvm, int32_t* dimensions, uin
 
     node->next = jvm->objects;
     node->obj = r;
+    node->age = 0;
     jvm->objects = node;
 
+    if (jvm->perfData || jvm->collector)
+        countNewObject(jvm, r);
+
+    // The class name is the descriptor of this array, such as "[[I"
+    if (jvm->allocationProfile)
+    {
+        uint32_t bytes = sizeof(Reference) + utf8_len + r->oar.length * sizeof(Reference*);
+
+        if (countAllocation(jvm->allocationProfile, bytes))
+            sampleAllocation(jvm->allocationProfile, jvm->frames, bytes, utf8_className, utf8_len, 0);
+    }
+
+    if (TRACING(jvm, TRACE_ALLOC))
+        traceEvent(jvm->tracer, TRACE_ALLOC, "%p %.*s[%d]", (void*)r, (int)utf8_len, utf8_className, dimensions[0]);
+
     return r;
 }
 
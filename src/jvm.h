@@ -8,6 +8,18 @@ typedef struct Reference Reference;
 #include "javaclass.h"
 #include "opcodes.h"
 #include "framestack.h"
+#include "superinstructions.h"
+#include "classpath.h"
+#include "sharedarchive.h"
+#include "classprefetch.h"
+#include "classlist.h"
+#include "opcodeprofile.h"
+#include "methodsampler.h"
+#include "trace.h"
+#include "allocprofile.h"
+#include "perfdata.h"
+#include "perfmap.h"
+#include "garbagecollector.h"
 
 enum JVMStatus {
     JVM_STATUS_OK,
@@ -19,7 +31,12 @@ enum JVMStatus {
     JVM_STATUS_UNKNOWN_INSTRUCTION,
     JVM_STATUS_OUT_OF_MEMORY,
     JVM_STATUS_MAIN_METHOD_NOT_FOUND,
-    JVM_STATUS_INVALID_INSTRUCTION_PARAMETERS
+    JVM_STATUS_INVALID_INSTRUCTION_PARAMETERS,
+    JVM_STATUS_VERIFICATION_FAILED,
+    JVM_STATUS_INVALID_CODE_ATTRIBUTE,
+
+    // A method pushed more operands than its max_stack
+    JVM_STATUS_OPERAND_STACK_OVERFLOW
 };
 
 typedef struct ClassInstance
@@ -72,6 +89,10 @@ typedef struct ReferenceTable
 {
     Reference* obj;
     struct ReferenceTable* next;
+
+    /// @brief Minor collections the object survived, see
+    /// GC_TENURING_THRESHOLD.
+    uint8_t age;
 } ReferenceTable;
 
 /// @brief Linked list data struct that holds information about a
@@ -125,19 +146,131 @@ struct JavaVirtualMachine
     /// resolved by the JVM.
     LoadedClasses* classes;
 
-    /// @brief Path to look for files when opening classes.
-    ///
-    /// If an attempt to open a class file in the
-    /// current directory fails, then this classPath
-    /// is used to build another directory to look for
-    /// the class file.
-    char classPath[256];
+    /// @brief Directories and jar files to look for files when
+    /// opening classes: the current directory, the directory of
+    /// the main class and those given with "-cp".
+    /// @see setClassPath(), openClassFromClassPath()
+    ClassPath classPath;
+
+    /// @brief Boolean telling if the predecoder should fuse common
+    /// instruction sequences into superinstructions when methods
+    /// are linked.
+    /// @see predecodeMethod()
+    uint8_t useSuperinstructions;
+
+    /// @brief Boolean telling if methods should be translated to
+    /// register IR when they are linked.
+    /// @see translateMethod()
+    uint8_t useRegisterIR;
+
+    /// @brief Number of instructions that the predecoder replaced
+    /// with superinstructions.
+    uint32_t superinstructionSites;
+
+    /// @brief Number of instruction dispatches done by the interpreter.
+    uint64_t dispatchCount;
+
+    /// @brief Number of times each superinstruction has been executed.
+    uint64_t superinstructionCount[SUPERINSTRUCTION_COUNT];
+
+    /// @brief Profile of the instruction sequences executed by the JVM,
+    /// or a null pointer if n-gram profiling is disabled.
+    /// @see saveNgramProfile()
+    NgramProfile* ngramProfile;
+
+    /// @brief Executions and time per opcode, or a null pointer if
+    /// opcodes aren't profiled.
+    /// @see profileOpcode()
+    OpcodeProfile* opcodeProfile;
+
+    /// @brief Sampler of the frame stack, or a null pointer if
+    /// methods aren't sampled.
+    /// @see startMethodSampler()
+    MethodSampler* sampler;
+
+    /// @brief Records the events selected by "-Xtrace", or a null
+    /// pointer if nothing is traced.
+    /// @see TRACING()
+    Tracer* tracer;
+
+    /// @brief Sampled allocations by site and type, or a null pointer
+    /// if allocations aren't profiled.
+    /// @see countAllocation()
+    AllocationProfile* allocationProfile;
+
+    /// @brief File heap dumps are written to, or a null pointer if
+    /// they aren't, and number of dumps asked for by SIGUSR1.
+    /// @see writeHeapDump(), dumpHeapOnRequest()
+    const char* heapDumpPath;
+    uint32_t heapDumpCount;
+
+    /// @brief Counters shared with other processes, or a null pointer
+    /// if they aren't published.
+    /// @see openPerfData(), addPerfCounter()
+    PerfData* perfData;
+
+    /// @brief Names the trampolines of Java methods for Linux perf, or
+    /// a null pointer if methods are called without trampolines.
+    /// @see getMethodTrampoline()
+    PerfMap* perfMap;
+
+    /// @brief Frees unreachable objects, or a null pointer if objects
+    /// live until the JVM exits.
+    /// @see collectGarbage()
+    GarbageCollector* collector;
+
+    /// @brief Boolean telling if classes are verified when they
+    /// are linked.
+    /// @see verifyClass()
+    uint8_t verifyClasses;
+
+    /// @brief Directory where verification results are cached, or
+    /// a null pointer if they aren't.
+    const char* verifyCachePath;
+
+    /// @brief Archive that classes are read from before looking for
+    /// their files, or a null pointer.
+    /// @see openClassFromArchive()
+    SharedArchive* sharedArchive;
+
+    /// @brief Worker threads parsing classes before they are
+    /// resolved, or a null pointer if classes are only parsed when
+    /// needed.
+    /// @see takePrefetchedClass()
+    ClassPrefetcher* prefetcher;
+
+    /// @brief Classes loaded so far, saved for the next run to parse
+    /// ahead, or a null pointer if they aren't recorded.
+    /// @see recordLoadedClass(), replayClassList()
+    ClassList* classList;
+
+    /// @brief Number of classes loaded, and how many of them came
+    /// from the shared archive.
+    uint32_t loadedClassCount;
+    uint32_t sharedClassCount;
+
+    /// @brief Number of classes verified, and how many of them had
+    /// their result read from the verification cache.
+    uint32_t verifiedClassCount;
+    uint32_t cachedVerificationCount;
+
+    /// @brief Time when the JVM was initialized, as given by
+    /// getMonotonicTime(), and the milliseconds elapsed since then
+    /// until the first instruction ran, the main method started and
+    /// the main method returned, or 0 if that hasn't happened.
+    double startTime;
+    double firstInstructionTime;
+    double mainStartTime;
+    double mainExitTime;
 };
 
 void initJVM(JavaVirtualMachine* jvm);
 void deinitJVM(JavaVirtualMachine* jvm);
+void exitJVM(JavaVirtualMachine* jvm);
 void executeJVM(JavaVirtualMachine* jvm, LoadedClasses* mainClass);
 void setClassPath(JavaVirtualMachine* jvm, const char* path);
+void printStartupReport(JavaVirtualMachine* jvm);
+void loadClassFile(JavaVirtualMachine* jvm, JavaClass* jc, const uint8_t* className_utf8_bytes, int32_t utf8_len);
 uint8_t resolveClass(JavaVirtualMachine* jvm, const uint8_t* className_utf8_bytes, int32_t utf8_len, LoadedClasses** outClass);
 uint8_t resolveMethod(JavaVirtualMachine* jvm, JavaClass* jc, cp_info* cp_method, LoadedClasses** outClass);
 uint8_t resolveField(JavaVirtualMachine* jvm, JavaClass* jc, cp_info* cp_field, LoadedClasses** outClass);
@@ -1,9 +1,13 @@
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 #include "javaclass.h"
 #include "jvm.h"
 #include "memoryinspect.h"
+#include "threads.h"
+#include "heapdump.h"
+#include "benchmark.h"
 
 int main(int argc, char* args[])
 {
@@ -14,6 +18,38 @@ int main(int argc, char* args[])
         printf(" -c \t Shows the content of the .class file\n");
         printf(" -e \t Execute the method 'main' from the class\n");
         printf(" -b \t Adds UTF-8 BOM to the output\n");
+        printf(" -cp <path> \t Directories and jar files to search for classes, separated by '%c'\n", CLASSPATH_SEPARATOR);
+        printf(" -Xnosuperinstructions \t Don't fuse instruction sequences\n");
+        printf(" -Xir \t Executes methods translated to a register IR\n");
+        printf(" -Xngrams:<file> \t Records executed instruction sequences to <file>\n");
+        printf(" -Xdispatchreport \t Prints dispatch statistics when the program ends\n");
+        printf(" -Xsample:<file> \t Samples the running methods, writing collapsed stacks to <file>\n");
+        printf(" -Xsampleinterval:<us> \t Processor time between samples (default: 1000)\n");
+        printf(" -Xtrace:<categories> \t Traces class, resolve, invoke, alloc, instruction or all, separated by ','\n");
+        printf(" -Xtracemethod:<pattern> \t Only traces while methods matching 'Class.method' run, '*' matching any text\n");
+        printf(" -Xtracefile:<file> \t Writes the trace to <file> instead of stderr\n");
+        printf(" -Xallocprofile \t Prints the bytes and objects allocated by site and by type\n");
+        printf(" -Xallocsampleinterval:<bytes> \t Bytes allocated between samples, 1 for all allocations (default: 4096)\n");
+        printf(" -Xheaphisto \t Prints the instances and bytes per class when the program ends, or on SIGUSR1\n");
+        printf(" -Xheapdump:<file> \t Writes a heap dump to <file> when the program ends, or to <file>.<n> on SIGUSR1\n");
+        printf(" -Xgc \t Frees unreachable objects with a generational mark and sweep collector\n");
+        printf(" -Xmn<bytes> \t Bytes allocated between minor collections (default: 1048576)\n");
+        printf(" -Xgclog[:<file>] \t Collects garbage and logs each collection and a summary to <file> or stderr\n");
+        printf(" -Xgclogjson:<file> \t Collects garbage and logs the same as JSON lines to <file>\n");
+        printf(" -Xperfmap \t Names a trampoline per Java method in /tmp/perf-<pid>.map, for Linux perf\n");
+        printf(" -Xjitdump \t Like -Xperfmap, also writing /tmp/jit-<pid>.dump for perf inject --jit\n");
+        printf(" -Xperfdata[:<file>] \t Publishes counters for tools/perfstat.c in <file> (default: /tmp/jvmperf_<pid>, removed at exit)\n");
+        printf(" -Xbench:<file> \t Times repeated runs of main, appending the results to <file> as JSON lines\n");
+        printf(" -Xbenchwarmup:<n> \t Runs of main before timing with -Xbench (default: 3)\n");
+        printf(" -Xbenchiterations:<n> \t Runs of main timed with -Xbench (default: 10)\n");
+        printf(" -Xopcodeprofile:<file> \t Prints the time spent per opcode, and writes it to <file> as CSV\n");
+        printf(" -Xverify:none \t Doesn't verify the bytecode of loaded classes\n");
+        printf(" -Xverifycache:<dir> \t Caches verification results in <dir>\n");
+        printf(" -Xshare:off|auto|on|dump \t Reads classes from, or dumps them to, the shared archive ('on' fails without it)\n");
+        printf(" -Xsharedarchive:<file> \t Path of the shared archive (default: classes.jsa)\n");
+        printf(" -Xstartupreport \t Prints the number of classes loaded and the time to main\n");
+        printf(" -Xclasslist:<file> \t Parses the classes listed in <file> ahead of use, and lists the classes loaded to it\n");
+        printf(" -Xloaderthreads:<n> \t Threads parsing classes ahead of use, 0 to disable (default: one less than the processors, up to 4)\n");
         return 0;
     }
 
@@ -44,6 +80,41 @@ int main(int argc, char* args[])
     uint8_t printClassContent = 0;
     uint8_t executeClassMain = 0;
     uint8_t includeBOM = 0;
+    uint8_t useSuperinstructions = 1;
+    uint8_t useRegisterIR = 0;
+    uint8_t printDispatchStatistics = 0;
+    const char* ngramProfilePath = NULL;
+    const char* opcodeProfilePath = NULL;
+    const char* samplePath = NULL;
+    uint32_t sampleInterval = 1000;
+    uint8_t profileAllocations = 0;
+    uint32_t allocationInterval = 4096;
+    uint8_t printHeapHistogramAtExit = 0;
+    const char* heapDumpPath = NULL;
+    uint8_t useGarbageCollector = 0;
+    uint64_t youngSize = GC_DEFAULT_YOUNG_SIZE;
+    const char* gcLogPath = NULL;
+    const char* gcJsonLogPath = NULL;
+    uint8_t usePerfMap = 0;
+    uint8_t writeJitdump = 0;
+    uint8_t publishPerfData = 0;
+    const char* perfDataPath = NULL;
+    char defaultPerfDataPath[300];
+    const char* benchmarkPath = NULL;
+    uint32_t benchmarkWarmup = BENCHMARK_DEFAULT_WARMUP;
+    uint32_t benchmarkIterations = BENCHMARK_DEFAULT_ITERATIONS;
+    uint32_t traceCategories = 0;
+    const char* traceMethods[TRACE_MAX_FILTERS];
+    uint32_t traceMethodCount = 0;
+    const char* tracePath = NULL;
+    uint8_t verifyClasses = 1;
+    const char* verifyCachePath = NULL;
+    const char* classPathList = NULL;
+    uint8_t shareMode = SHARE_OFF;
+    const char* sharedArchivePath = "classes.jsa";
+    uint8_t printStartupStatistics = 0;
+    int loaderThreads = -1;
+    const char* classListPath = NULL;
 
     int argIndex;
 
@@ -55,6 +126,103 @@ int main(int argc, char* args[])
             executeClassMain = 1;
         else if (!strcmp(args[argIndex], "-b"))
             includeBOM = 1;
+        else if (!strcmp(args[argIndex], "-cp") && argIndex + 1 < argc)
+            classPathList = args[++argIndex];
+        else if (!strcmp(args[argIndex], "-Xnosuperinstructions"))
+            useSuperinstructions = 0;
+        else if (!strncmp(args[argIndex], "-Xngrams:", 9) && args[argIndex][9])
+            ngramProfilePath = args[argIndex] + 9;
+        else if (!strncmp(args[argIndex], "-Xopcodeprofile:", 16) && args[argIndex][16])
+            opcodeProfilePath = args[argIndex] + 16;
+        else if (!strncmp(args[argIndex], "-Xsample:", 9) && args[argIndex][9])
+            samplePath = args[argIndex] + 9;
+        else if (!strncmp(args[argIndex], "-Xsampleinterval:", 17) && args[argIndex][17])
+            sampleInterval = (uint32_t)strtoul(args[argIndex] + 17, NULL, 10);
+        else if (!strncmp(args[argIndex], "-Xtrace:", 8) && args[argIndex][8])
+        {
+            traceCategories = parseTraceCategories(args[argIndex] + 8);
+
+            if (!traceCategories)
+                printf("Unknown trace category in '%s'\n", args[argIndex]);
+        }
+        else if (!strncmp(args[argIndex], "-Xtracemethod:", 14) && args[argIndex][14])
+        {
+            if (traceMethodCount < TRACE_MAX_FILTERS)
+                traceMethods[traceMethodCount++] = args[argIndex] + 14;
+            else
+                printf("Too many trace filters, ignoring '%s'\n", args[argIndex]);
+        }
+        else if (!strncmp(args[argIndex], "-Xtracefile:", 12) && args[argIndex][12])
+            tracePath = args[argIndex] + 12;
+        else if (!strcmp(args[argIndex], "-Xallocprofile"))
+            profileAllocations = 1;
+        else if (!strncmp(args[argIndex], "-Xallocsampleinterval:", 22) && args[argIndex][22])
+            allocationInterval = (uint32_t)strtoul(args[argIndex] + 22, NULL, 10);
+        else if (!strcmp(args[argIndex], "-Xheaphisto"))
+            printHeapHistogramAtExit = 1;
+        else if (!strncmp(args[argIndex], "-Xheapdump:", 11) && args[argIndex][11])
+            heapDumpPath = args[argIndex] + 11;
+        else if (!strcmp(args[argIndex], "-Xgc"))
+            useGarbageCollector = 1;
+        else if (!strncmp(args[argIndex], "-Xmn", 4) && args[argIndex][4])
+            youngSize = strtoull(args[argIndex] + 4, NULL, 10);
+        else if (!strcmp(args[argIndex], "-Xgclog"))
+        {
+            // An empty path stands for stderr
+            useGarbageCollector = 1;
+            gcLogPath = "";
+        }
+        else if (!strncmp(args[argIndex], "-Xgclog:", 8) && args[argIndex][8])
+        {
+            useGarbageCollector = 1;
+            gcLogPath = args[argIndex] + 8;
+        }
+        else if (!strncmp(args[argIndex], "-Xgclogjson:", 12) && args[argIndex][12])
+        {
+            useGarbageCollector = 1;
+            gcJsonLogPath = args[argIndex] + 12;
+        }
+        else if (!strcmp(args[argIndex], "-Xperfmap"))
+            usePerfMap = 1;
+        else if (!strcmp(args[argIndex], "-Xjitdump"))
+            usePerfMap = writeJitdump = 1;
+        else if (!strcmp(args[argIndex], "-Xperfdata"))
+            publishPerfData = 1;
+        else if (!strncmp(args[argIndex], "-Xperfdata:", 11) && args[argIndex][11])
+        {
+            publishPerfData = 1;
+            perfDataPath = args[argIndex] + 11;
+        }
+        else if (!strncmp(args[argIndex], "-Xbench:", 8) && args[argIndex][8])
+            benchmarkPath = args[argIndex] + 8;
+        else if (!strncmp(args[argIndex], "-Xbenchwarmup:", 14) && args[argIndex][14])
+            benchmarkWarmup = (uint32_t)strtoul(args[argIndex] + 14, NULL, 10);
+        else if (!strncmp(args[argIndex], "-Xbenchiterations:", 18) && args[argIndex][18])
+            benchmarkIterations = (uint32_t)strtoul(args[argIndex] + 18, NULL, 10);
+        else if (!strcmp(args[argIndex], "-Xir"))
+            useRegisterIR = 1;
+        else if (!strcmp(args[argIndex], "-Xdispatchreport"))
+            printDispatchStatistics = 1;
+        else if (!strcmp(args[argIndex], "-Xshare:off"))
+            shareMode = SHARE_OFF;
+        else if (!strcmp(args[argIndex], "-Xshare:auto"))
+            shareMode = SHARE_AUTO;
+        else if (!strcmp(args[argIndex], "-Xshare:on"))
+            shareMode = SHARE_ON;
+        else if (!strcmp(args[argIndex], "-Xshare:dump"))
+            shareMode = SHARE_DUMP;
+        else if (!strncmp(args[argIndex], "-Xsharedarchive:", 16) && args[argIndex][16])
+            sharedArchivePath = args[argIndex] + 16;
+        else if (!strcmp(args[argIndex], "-Xstartupreport"))
+            printStartupStatistics = 1;
+        else if (!strncmp(args[argIndex], "-Xclasslist:", 12) && args[argIndex][12])
+            classListPath = args[argIndex] + 12;
+        else if (!strncmp(args[argIndex], "-Xloaderthreads:", 16) && args[argIndex][16])
+            loaderThreads = atoi(args[argIndex] + 16);
+        else if (!strcmp(args[argIndex], "-Xverify:none"))
+            verifyClasses = 0;
+        else if (!strncmp(args[argIndex], "-Xverifycache:", 14) && args[argIndex][14])
+            verifyCachePath = args[argIndex] + 14;
         else
             printf("Unknown argument #%d ('%s')\n", argIndex, args[argIndex]);
     }
@@ -89,6 +257,90 @@ int main(int argc, char* args[])
         JavaVirtualMachine jvm;
         initJVM(&jvm);
 
+        jvm.useSuperinstructions = useSuperinstructions;
+        jvm.verifyClasses = verifyClasses;
+        jvm.verifyCachePath = verifyCachePath;
+
+        // Escapes from the IR run the original instructions,
+        // so they can't be fused either.
+        if (useRegisterIR)
+        {
+            jvm.useRegisterIR = 1;
+            jvm.useSuperinstructions = 0;
+        }
+
+        // The archive must hold the class files as they were read,
+        // so nothing can be patched in place while it is dumped.
+        if (shareMode == SHARE_DUMP)
+            jvm.useSuperinstructions = 0;
+
+        SharedArchive archive;
+
+        if (shareMode == SHARE_AUTO || shareMode == SHARE_ON)
+        {
+            if (openSharedArchive(&archive, sharedArchivePath, jvm.verifyClasses))
+            {
+                jvm.sharedArchive = &archive;
+            }
+            else if (shareMode == SHARE_ON)
+            {
+                printf("Shared archive '%s' can't be used\n", sharedArchivePath);
+                deinitJVM(&jvm);
+                return 1;
+            }
+        }
+
+        if (ngramProfilePath)
+        {
+            // The profile has to see the original instructions,
+            // so nothing can be fused while it is recorded.
+            jvm.ngramProfile = newNgramProfile(ngramProfilePath);
+            jvm.useSuperinstructions = 0;
+            jvm.useRegisterIR = 0;
+        }
+
+        if (opcodeProfilePath)
+        {
+            // Only the bytecode interpreter is profiled
+            jvm.opcodeProfile = newOpcodeProfile(opcodeProfilePath);
+            jvm.useRegisterIR = 0;
+        }
+
+        jvm.heapDumpPath = heapDumpPath;
+
+        if ((printHeapHistogramAtExit || heapDumpPath) && !installHeapDumpSignal())
+            printf("Heap dumps can't be asked for with a signal\n");
+
+        if (profileAllocations)
+            jvm.allocationProfile = newAllocationProfile(allocationInterval);
+
+        if (useGarbageCollector)
+        {
+            jvm.collector = newGarbageCollector(youngSize);
+
+            if (!jvm.collector)
+                printf("Garbage can't be collected\n");
+            else if (!openGarbageCollectionLogs(jvm.collector, gcLogPath, gcJsonLogPath))
+                printf("Couldn't write the garbage collection logs\n");
+        }
+
+        if (usePerfMap)
+        {
+            jvm.perfMap = newPerfMap(writeJitdump);
+
+            if (!jvm.perfMap)
+                printf("Java methods can't be named for perf\n");
+        }
+
+        if (publishPerfData)
+        {
+            getDefaultPerfDataPath(defaultPerfDataPath, sizeof(defaultPerfDataPath));
+            jvm.perfData = openPerfData(perfDataPath ? perfDataPath : defaultPerfDataPath);
+
+            if (!jvm.perfData)
+                printf("Couldn't publish counters to '%s'\n", perfDataPath ? perfDataPath : defaultPerfDataPath);
+        }
+
         size_t inputLength = strlen(args[1]);
 
         // This is to remove the ".class" from the file name. Example:
@@ -107,14 +359,158 @@ int main(int argc, char* args[])
 
         setClassPath(&jvm, args[1]);
 
+        if (classPathList)
+            addClassPathEntries(&jvm.classPath, classPathList);
+
+        // The main thread needs a processor of its own, and more than
+        // a few workers only contend for the class path.
+        if (loaderThreads < 0)
+        {
+            loaderThreads = (int)getProcessorCount() - 1;
+
+            if (loaderThreads > 4)
+                loaderThreads = 4;
+
+            // A list to replay needs a thread even on a single processor
+            if (loaderThreads == 0 && classListPath)
+                loaderThreads = 1;
+        }
+
+        if (loaderThreads > 0)
+            jvm.prefetcher = newClassPrefetcher(&jvm, (uint32_t)loaderThreads);
+
+        if (classListPath)
+        {
+            jvm.classList = newClassList(classListPath);
+
+            if (jvm.classList && jvm.prefetcher)
+                replayClassList(jvm.classList, jvm.prefetcher);
+        }
+
+        if (traceCategories)
+        {
+            jvm.tracer = newTracer(tracePath, traceCategories);
+
+            if (jvm.tracer)
+            {
+                uint32_t filterIndex;
+
+                for (filterIndex = 0; filterIndex < traceMethodCount; filterIndex++)
+                    addTraceFilter(jvm.tracer, traceMethods[filterIndex]);
+
+                startTracer(jvm.tracer);
+            }
+            else
+            {
+                printf("Couldn't write the trace to '%s'\n", tracePath ? tracePath : "stderr");
+            }
+        }
+
+        if (samplePath)
+        {
+            jvm.sampler = newMethodSampler(&jvm, samplePath, sampleInterval);
+
+            if (!jvm.sampler || !startMethodSampler(jvm.sampler))
+                printf("Methods can't be sampled\n");
+        }
+
         if (resolveClass(&jvm, (const uint8_t*)args[1], inputLength, &mainLoadedClass))
-            executeJVM(&jvm, mainLoadedClass);
+        {
+            if (benchmarkPath)
+            {
+                // Names the benchmark after the class file, without
+                // its directory and extension
+                char benchmarkName[256];
+                const char* fileName = args[1] + inputLength;
+                uint32_t nameLength = 0;
+
+                while (fileName > args[1] && fileName[-1] != '/' && fileName[-1] != '\\')
+                    fileName--;
+
+                while (fileName[nameLength] && fileName[nameLength] != '.' && nameLength < sizeof(benchmarkName) - 1)
+                {
+                    benchmarkName[nameLength] = fileName[nameLength];
+                    nameLength++;
+                }
+
+                benchmarkName[nameLength] = '\0';
+
+                if (!runBenchmark(&jvm, mainLoadedClass, benchmarkName, benchmarkWarmup, benchmarkIterations, benchmarkPath) &&
+                    jvm.status == JVM_STATUS_OK)
+                    printf("Couldn't write benchmark results to '%s'\n", benchmarkPath);
+            }
+            else
+            {
+                executeJVM(&jvm, mainLoadedClass);
+            }
+        }
+
+        // Writes the end of the jitdump file
+        if (jvm.perfMap)
+        {
+            freePerfMap(jvm.perfMap);
+            jvm.perfMap = NULL;
+        }
+
+        // Readers of a named file see the final counters
+        if (jvm.perfData)
+        {
+            setPerfCounter(jvm.perfData, PERF_BYTECODES, jvm.dispatchCount);
+            closePerfData(jvm.perfData, perfDataPath ? perfDataPath : defaultPerfDataPath, !perfDataPath);
+            jvm.perfData = NULL;
+        }
+
+        if (jvm.sampler)
+        {
+            stopMethodSampler(jvm.sampler);
+
+            if (!saveMethodSamples(jvm.sampler))
+                printf("Couldn't write method samples to '%s'\n", samplePath);
+
+            printMethodSampleReport(jvm.sampler, 20);
+        }
+
+        if (jvm.collector)
+            printGarbageCollectionSummary(jvm.collector, getMonotonicTime() - jvm.startTime);
+
+        if (printHeapHistogramAtExit)
+            printHeapHistogram(&jvm, stderr);
+
+        if (heapDumpPath && !writeHeapDump(&jvm, heapDumpPath))
+            printf("Couldn't write heap dump to '%s'\n", heapDumpPath);
+
+        if (jvm.allocationProfile)
+            printAllocationReport(jvm.allocationProfile, 20);
+
+        if (jvm.ngramProfile && !saveNgramProfile(jvm.ngramProfile))
+            printf("Couldn't write n-gram profile to '%s'\n", ngramProfilePath);
+
+        if (printDispatchStatistics)
+            printDispatchReport(&jvm, args[1]);
+
+        if (jvm.opcodeProfile)
+        {
+            if (!saveOpcodeProfile(jvm.opcodeProfile))
+                printf("Couldn't write opcode profile to '%s'\n", opcodeProfilePath);
+
+            printOpcodeProfile(jvm.opcodeProfile);
+        }
+
+        if (jvm.classList && !saveClassList(jvm.classList))
+            printf("Couldn't write class list to '%s'\n", classListPath);
+
+        if (shareMode == SHARE_DUMP && !dumpSharedArchive(&jvm, sharedArchivePath))
+            printf("Couldn't write shared archive to '%s'\n", sharedArchivePath);
+
+        if (printStartupStatistics)
+            printStartupReport(&jvm);
 
 #ifdef DEBUG
         printf("Execution finished. Status: %d\n", jvm.status);
 #endif // DEBUG
 
-        deinitJVM(&jvm);
+        // Doesn't return
+        exitJVM(&jvm);
     }
 
     return 0;
@@ -158,6 +554,21 @@ int main(int argc, char* args[])
 /// memory), resolve and look for classes, and create new objects
 /// (arrays, class instances, strings).
 /// <br>
+/// When a method first runs, common instruction sequences are fused into
+/// superinstructions, which execute the whole sequence with a single
+/// dispatch. The list of superinstructions is generated from a profile of
+/// executed instruction sequences, see @ref superinstructions.
+/// <br>
+/// Loads, stores, constants and math instructions are also executed inside
+/// the dispatch loop itself, keeping the top of the operand stack in
+/// registers, see @ref interpreter.
+/// <br>
+/// With "-Xir", methods are instead translated to a register IR the first
+/// time they run, which removes most operand stack traffic, see @ref registerir.
+/// <br>
+/// Classes are verified before being linked, and the interpreter relies on
+/// that to skip operand stack checks, see @ref verifier.
+/// <br>
 ///
 ///
 /// @section limitations Limitations
@@ -0,0 +1,145 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "mappedfile.h"
+#include <stddef.h>
+#include <stdio.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <errno.h>
+#endif
+
+/// @brief Maps a whole file into memory.
+///
+/// Pages are copy-on-write, so the mapping can be modified, as
+/// the predecoder does when it fuses instructions of a method.
+///
+/// @param MappedFile* file - receives the mapping.
+/// @param const char* path - path of the file to be mapped.
+///
+/// @return 1 in case of success, 0 if the file couldn't be opened
+/// or mapped. An empty file is mapped with a null data pointer.
+/// @see unmapFile()
+uint8_t mapFile(MappedFile* file, const char* path)
+{
+    file->data = NULL;
+    file->size = 0;
+
+#ifdef _WIN32
+    LARGE_INTEGER size;
+    HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    HANDLE mapping;
+
+    if (handle == INVALID_HANDLE_VALUE)
+        return 0;
+
+    if (!GetFileSizeEx(handle, &size) || size.QuadPart > 0xFFFFFFFF)
+    {
+        CloseHandle(handle);
+        return 0;
+    }
+
+    if (size.QuadPart > 0)
+    {
+        mapping = CreateFileMappingA(handle, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+
+        if (mapping)
+        {
+            file->data = (uint8_t*)MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+            CloseHandle(mapping);
+        }
+
+        if (!file->data)
+        {
+            CloseHandle(handle);
+            return 0;
+        }
+    }
+
+    CloseHandle(handle);
+    file->size = (uint32_t)size.QuadPart;
+#else
+    struct stat status;
+    void* data;
+    int descriptor = open(path, O_RDONLY);
+
+    if (descriptor < 0)
+        return 0;
+
+    if (fstat(descriptor, &status) || !S_ISREG(status.st_mode) || (uint64_t)status.st_size > 0xFFFFFFFF)
+    {
+        close(descriptor);
+        return 0;
+    }
+
+    if (status.st_size > 0)
+    {
+        data = mmap(NULL, (size_t)status.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, descriptor, 0);
+
+        if (data == MAP_FAILED)
+        {
+            close(descriptor);
+            return 0;
+        }
+
+        file->data = (uint8_t*)data;
+    }
+
+    // The mapping stays valid after the file is closed
+    close(descriptor);
+    file->size = (uint32_t)status.st_size;
+#endif
+
+    return 1;
+}
+
+/// @brief Releases a mapping created by mapFile().
+void unmapFile(MappedFile* file)
+{
+    if (file->data)
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(file->data);
+#else
+        munmap(file->data, file->size);
+#endif
+    }
+
+    file->data = NULL;
+    file->size = 0;
+}
+
+#ifndef _WIN32
+
+/// @brief Creates a file readable and writable by its owner only,
+/// for writing at a path other users may know in advance.
+///
+/// The file must not exist when it is created, and links are never
+/// followed, so a link another user planted at the path can't make
+/// the JVM overwrite the file it points to. A file or link already
+/// there, such as one left by a process with the same pid, is removed
+/// first; that fails in a sticky directory like "/tmp" unless the
+/// current user owns it.
+///
+/// @param const char* path - path of the file to be created.
+///
+/// @return A descriptor open for reading and writing, or -1 if the
+/// file couldn't be created.
+int createNewFile(const char* path)
+{
+    int descriptor = open(path, O_RDWR | O_CREAT | O_EXCL | O_NOFOLLOW, 0600);
+
+    if (descriptor < 0 && errno == EEXIST && !remove(path))
+        descriptor = open(path, O_RDWR | O_CREAT | O_EXCL | O_NOFOLLOW, 0600);
+
+    return descriptor;
+}
+
+#endif // _WIN32
@@ -0,0 +1,38 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <stdint.h>
+
+/// @brief A file mapped into memory.
+///
+/// The mapping is private: writes to it change the memory of
+/// the process, never the file.
+typedef struct MappedFile
+{
+    uint8_t* data;
+    uint32_t size;
+} MappedFile;
+
+uint8_t mapFile(MappedFile* file, const char* path);
+void unmapFile(MappedFile* file);
+
+#ifndef _WIN32
+int createNewFile(const char* path);
+#endif
+
+#endif // MAPPEDFILE_H
+
+/// @defgroup mappedfile Mapped file module
+///
+/// @brief Maps whole files into memory, using mmap() on POSIX
+/// systems and file mapping objects on Windows.
+///
+/// The class file parser decodes values straight from the
+/// mapping, and constant pool strings and method bytecode
+/// point into it, so the mapping lives as long as the class.
+///
+/// Files the JVM writes at predictable paths in shared directories,
+/// such as "/tmp/jvmperf_<pid>", are made with createNewFile(), which
+/// never writes through a link planted there by another user.
+///
+/// @see mapFile(), openClassFile(), createNewFile()
@@ -1,6 +1,7 @@
 #ifdef DEBUG
 
 #include "memoryinspect.h"
+#include "threads.h"
 #undef malloc
 #undef free
 #define _malloc(b) malloc(b)
@@ -17,10 +18,22 @@ typedef struct MemoryPtrStack
 } MemoryPtrStack;
 
 MemoryPtrStack* _MEMSTACK = NULL;
+size_t _ALLOCATIONS = 0;
+size_t _ALLOCATED_BYTES = 0;
+
+// Class loader workers allocate memory too
+Mutex _MEMLOCK;
+Once _MEMLOCK_ONCE = ONCE_INIT;
+
+static void initMemoryLock(void)
+{
+    initMutex(&_MEMLOCK);
+}
 
 void checkMemoryLeak(void)
 {
     printf("\n#### Memory Inspect Report ####\n");
+    printf("Allocations: %lu, %lu bytes.\n", (unsigned long)_ALLOCATIONS, (unsigned long)_ALLOCATED_BYTES);
 
     if (_MEMSTACK == NULL)
     {
@@ -50,6 +63,9 @@ void* memalloc(size_t bytes, const char* file, int line, const char* call)
     }
     void* ptr = _malloc(bytes);
 
+    runOnce(&_MEMLOCK_ONCE, initMemoryLock);
+    lockMutex(&_MEMLOCK);
+
     if (ptr)
     {
         MemoryPtrStack* node = (MemoryPtrStack*)_malloc(sizeof(MemoryPtrStack));
@@ -63,19 +79,25 @@ void* memalloc(size_t bytes, const char* file, int line, const char* call)
             node->bytes = bytes;
             node->next = _MEMSTACK;
             _MEMSTACK = node;
+            _ALLOCATIONS++;
+            _ALLOCATED_BYTES += bytes;
         }
         else
         {
             _free(ptr);
-            return NULL;
+            ptr = NULL;
         }
     }
 
+    unlockMutex(&_MEMLOCK);
     return ptr;
 }
 
 void memfree(void* ptr, const char* file, int line, const char* call)
 {
+    runOnce(&_MEMLOCK_ONCE, initMemoryLock);
+    lockMutex(&_MEMLOCK);
+
     MemoryPtrStack* node = _MEMSTACK;
     MemoryPtrStack* previous = NULL;
 
@@ -88,6 +110,7 @@ void memfree(void* ptr, const char* file, int line, const char* call)
             else
                 previous->next = node->next;
 
+            unlockMutex(&_MEMLOCK);
             _free(node);
             _free(ptr);
             return;
@@ -97,6 +120,8 @@ void memfree(void* ptr, const char* file, int line, const char* call)
         node = node->next;
     }
 
+    unlockMutex(&_MEMLOCK);
+
     printf("\n\n#### Memory Inspect Warning ####\nAttempt to free invalid pointer\n");
     printf(" At %s:%d, call: %s\n\n", file, line, call);
     _free(ptr);
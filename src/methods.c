@@ -51,7 +51,7 @@ char readMethod(JavaClass* jc, method_info* entry)
 
     if (entry->attributes_count > 0)
     {
-        entry->attributes = (attribute_info*)malloc(sizeof(attribute_info) * entry->attributes_count);
+        entry->attributes = (attribute_info*)allocFromArena(&jc->arena, sizeof(attribute_info) * entry->attributes_count);
 
         if (!entry->attributes)
         {
@@ -81,29 +81,6 @@ char readMethod(JavaClass* jc, method_info* entry)
     return 1;
 }
 
-/// @brief Releases attributes used by the method_info struct
-///
-/// @param method_info* entry - pointer to the method_info that 
-/// contains the attributes
-///
-/// @note This function does not free the @b *entry pointer, 
-/// just attributes
-void freeMethodAttributes(method_info* entry)
-{
-    uint32_t i;
-
-    if (entry->attributes != NULL)
-    {
-        for (i = 0; i < entry->attributes_count; i++)
-            freeAttributeInfo(entry->attributes + i);
-
-        free(entry->attributes);
-
-        entry->attributes_count = 0;
-        entry->attributes = NULL;
-    }
-}
-
 /// @brief Function to print all methods of the class file. 
 ///
 /// @param JavaClass *jc - pointer to JavaClass structure that must already
@@ -157,6 +134,76 @@ void printMethods(JavaClass* jc)
     }
 }
 
+/// @brief Gets the Code attribute of a method, decoding it the
+/// first time it is requested.
+///
+/// @param JavaClass* jc - class the method belongs to.
+/// @param method_info* method - the method.
+///
+/// @return The decoded Code attribute, or NULL if the method has
+/// none, as abstract and native methods, or if it is invalid, in
+/// which case the class status tells why.
+/// @see decodeAttribute()
+att_Code_info* getMethodCode(JavaClass* jc, method_info* method)
+{
+    attribute_info* codeAttribute = getAttributeByType(method->attributes, method->attributes_count, ATTR_Code);
+
+    if (!codeAttribute || !decodeAttribute(jc, codeAttribute))
+        return NULL;
+
+    att_Code_info* code = (att_Code_info*)codeAttribute->info;
+
+    if (jc->verifiedMethods)
+        code->verified = jc->verifiedMethods[method - jc->methods];
+
+    return code;
+}
+
+/// @brief Gets the source line of an instruction of a method, from
+/// the LineNumberTable attributes of its code.
+///
+/// @param JavaClass* jc - class the method belongs to.
+/// @param method_info* method - the method.
+/// @param uint32_t pc - offset of the instruction in the code.
+///
+/// @return The line number, or 0 if the method has no line numbers.
+uint16_t getMethodLineNumber(JavaClass* jc, method_info* method, uint32_t pc)
+{
+    att_Code_info* code = getMethodCode(jc, method);
+    att_LineNumberTable_info* info;
+    uint16_t line = 0;
+    uint16_t closestStart = 0;
+    uint16_t index, entry;
+
+    if (!code)
+        return 0;
+
+    // The table may be split across several attributes
+    for (index = 0; index < code->attributes_count; index++)
+    {
+        if (code->attributes[index].attributeType != ATTR_LineNumberTable ||
+            !decodeAttribute(jc, code->attributes + index))
+        {
+            continue;
+        }
+
+        info = (att_LineNumberTable_info*)code->attributes[index].info;
+
+        for (entry = 0; entry < info->line_number_table_length; entry++)
+        {
+            LineNumberTableEntry* lnte = info->line_number_table + entry;
+
+            if (lnte->start_pc <= pc && (!line || lnte->start_pc >= closestStart))
+            {
+                line = lnte->line_number;
+                closestStart = lnte->start_pc;
+            }
+        }
+    }
+
+    return line;
+}
+
 method_info* getMethodMatching(JavaClass* jc, const uint8_t* name, int32_t name_len, const uint8_t* descriptor,
                                int32_t descriptor_len, uint16_t flag_mask)
 {
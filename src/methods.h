@@ -16,8 +16,9 @@ struct method_info {
 };
 
 char readMethod(JavaClass* jc, method_info* entry);
-void freeMethodAttributes(method_info* entry);
 void printMethods(JavaClass* jc);
+att_Code_info* getMethodCode(JavaClass* jc, method_info* method);
+uint16_t getMethodLineNumber(JavaClass* jc, method_info* method, uint32_t pc);
 
 method_info* getMethodMatching(JavaClass* jc, const uint8_t* name, int32_t name_len, const uint8_t* descriptor,
                                int32_t descriptor_len, uint16_t flag_mask);
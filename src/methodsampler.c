@@ -0,0 +1,429 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "methodsampler.h"
+#include "memoryinspect.h"
+#include "utf8.h"
+#include <string.h>
+#include <inttypes.h>
+
+#ifndef _WIN32
+#include <signal.h>
+#include <errno.h>
+#include <sys/time.h>
+#endif
+
+// Room for about a minute of samples at the default interval
+#define SAMPLER_SAMPLE_CAPACITY 65536
+#define SAMPLER_FRAME_CAPACITY (1 << 20)
+
+// Length of the longest collapsed stack written
+#define SAMPLER_STACK_LENGTH (SAMPLER_MAX_DEPTH * 96)
+
+typedef struct SampledFrame
+{
+    JavaClass* jc;
+    method_info* method;
+    uint32_t pc;
+} SampledFrame;
+
+typedef struct Sample
+{
+    uint32_t firstFrame;
+    uint16_t depth;
+} Sample;
+
+/// @brief Samples of a method, for the report.
+typedef struct MethodSamples
+{
+    JavaClass* jc;
+    method_info* method;
+    uint32_t selfCount;
+    uint32_t totalCount;
+
+    // Last sample counted in totalCount, so recursion counts once
+    uint32_t lastSample;
+} MethodSamples;
+
+struct MethodSampler
+{
+    JavaVirtualMachine* jvm;
+    const char* path;
+    uint32_t interval;
+
+    // Written only by the signal handler while the sampler runs
+    Sample* samples;
+    SampledFrame* frames;
+    volatile uint32_t sampleCount;
+    volatile uint32_t frameCount;
+    volatile uint32_t droppedCount;
+
+    uint8_t running;
+
+#ifndef _WIN32
+    struct sigaction previousAction;
+#endif
+};
+
+#ifndef _WIN32
+// The sampler the SIGPROF handler records to
+static MethodSampler* volatile activeSampler = NULL;
+
+static void takeSample(int signalNumber)
+{
+    MethodSampler* sampler = activeSampler;
+    int savedErrno = errno;
+
+    (void)signalNumber;
+
+    if (!sampler)
+        return;
+
+    FrameStack* node = *(FrameStack* volatile*)&sampler->jvm->frames;
+    uint32_t first = sampler->frameCount;
+    uint32_t depth = 0;
+
+    if (sampler->sampleCount >= SAMPLER_SAMPLE_CAPACITY || first + SAMPLER_MAX_DEPTH > SAMPLER_FRAME_CAPACITY)
+    {
+        sampler->droppedCount++;
+        errno = savedErrno;
+        return;
+    }
+
+    for (; node && depth < SAMPLER_MAX_DEPTH; node = node->next, depth++)
+    {
+        SampledFrame* frame = sampler->frames + first + depth;
+
+        frame->jc = node->frame->jc;
+        frame->method = node->frame->method;
+        frame->pc = node->frame->pc;
+    }
+
+    sampler->samples[sampler->sampleCount].firstFrame = first;
+    sampler->samples[sampler->sampleCount].depth = (uint16_t)depth;
+    sampler->frameCount = first + depth;
+    sampler->sampleCount++;
+
+    errno = savedErrno;
+}
+#endif
+
+/// @brief Creates a sampler of the frame stack of a JVM.
+///
+/// @param JavaVirtualMachine* jvm - the JVM to sample.
+/// @param const char* path - file the collapsed stacks are written to.
+/// The string must outlive the sampler.
+/// @param uint32_t intervalMicroseconds - processor time between samples.
+///
+/// @return The sampler, to be freed with freeMethodSampler(), or NULL if
+/// there is not enough memory.
+MethodSampler* newMethodSampler(JavaVirtualMachine* jvm, const char* path, uint32_t intervalMicroseconds)
+{
+    MethodSampler* sampler = (MethodSampler*)malloc(sizeof(MethodSampler));
+
+    if (!sampler)
+        return NULL;
+
+    sampler->samples = (Sample*)malloc(SAMPLER_SAMPLE_CAPACITY * sizeof(Sample));
+    sampler->frames = (SampledFrame*)malloc(SAMPLER_FRAME_CAPACITY * sizeof(SampledFrame));
+
+    if (!sampler->samples || !sampler->frames)
+    {
+        if (sampler->samples)
+            free(sampler->samples);
+
+        if (sampler->frames)
+            free(sampler->frames);
+
+        free(sampler);
+        return NULL;
+    }
+
+    sampler->jvm = jvm;
+    sampler->path = path;
+    sampler->interval = intervalMicroseconds ? intervalMicroseconds : 1;
+    sampler->sampleCount = 0;
+    sampler->frameCount = 0;
+    sampler->droppedCount = 0;
+    sampler->running = 0;
+
+    return sampler;
+}
+
+void freeMethodSampler(MethodSampler* sampler)
+{
+    stopMethodSampler(sampler);
+    free(sampler->samples);
+    free(sampler->frames);
+    free(sampler);
+}
+
+/// @brief Installs the SIGPROF handler and starts the timer.
+///
+/// Only one sampler can run at a time.
+///
+/// @return 1 if sampling started, 0 otherwise.
+uint8_t startMethodSampler(MethodSampler* sampler)
+{
+#ifdef _WIN32
+    (void)sampler;
+    return 0;
+#else
+    struct sigaction action;
+    struct itimerval timer;
+
+    if (sampler->running || activeSampler)
+        return 0;
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = takeSample;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+
+    activeSampler = sampler;
+
+    if (sigaction(SIGPROF, &action, &sampler->previousAction))
+    {
+        activeSampler = NULL;
+        return 0;
+    }
+
+    timer.it_interval.tv_sec = sampler->interval / 1000000;
+    timer.it_interval.tv_usec = sampler->interval % 1000000;
+    timer.it_value = timer.it_interval;
+
+    if (setitimer(ITIMER_PROF, &timer, NULL))
+    {
+        sigaction(SIGPROF, &sampler->previousAction, NULL);
+        activeSampler = NULL;
+        return 0;
+    }
+
+    sampler->running = 1;
+    return 1;
+#endif
+}
+
+/// @brief Stops the timer and restores the previous SIGPROF handler.
+void stopMethodSampler(MethodSampler* sampler)
+{
+#ifndef _WIN32
+    struct itimerval timer;
+
+    if (!sampler->running)
+        return;
+
+    memset(&timer, 0, sizeof(timer));
+    setitimer(ITIMER_PROF, &timer, NULL);
+    sigaction(SIGPROF, &sampler->previousAction, NULL);
+    activeSampler = NULL;
+    sampler->running = 0;
+#else
+    (void)sampler;
+#endif
+}
+
+/// @brief Writes "class.method", followed by ":line" if \c pc is
+/// given and the method has line numbers.
+/// @return The number of characters written, not counting the null.
+static size_t formatMethodName(char* buffer, size_t size, JavaClass* jc, method_info* method, const uint32_t* pc)
+{
+    cp_info* className = jc->constantPool + jc->thisClass - 1;
+    cp_info* methodName = jc->constantPool + method->name_index - 1;
+    uint16_t line = 0;
+    int written;
+
+    className = jc->constantPool + className->Class.name_index - 1;
+
+    // The pc is already past the opcode being executed
+    if (pc)
+        line = getMethodLineNumber(jc, method, *pc ? *pc - 1 : 0);
+
+    if (line)
+        written = snprintf(buffer, size, "%.*s.%.*s:%u", (int)className->Utf8.length, className->Utf8.bytes,
+                           (int)methodName->Utf8.length, methodName->Utf8.bytes, line);
+    else
+        written = snprintf(buffer, size, "%.*s.%.*s", (int)className->Utf8.length, className->Utf8.bytes,
+                           (int)methodName->Utf8.length, methodName->Utf8.bytes);
+
+    if (written < 0)
+        return 0;
+
+    return (size_t)written < size ? (size_t)written : size - 1;
+}
+
+static int compareStrings(const void* a, const void* b)
+{
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+/// @brief Writes the samples to the file of the sampler as collapsed
+/// stacks, "root;...;leaf count", sorted by stack.
+///
+/// @return 1 if the file could be written, 0 otherwise.
+uint8_t saveMethodSamples(MethodSampler* sampler)
+{
+    char buffer[SAMPLER_STACK_LENGTH];
+    char** stacks;
+    uint32_t sampleCount = sampler->sampleCount;
+    uint32_t index, count;
+    size_t length;
+    int32_t depth;
+    uint8_t success = 1;
+    FILE* file;
+
+    stacks = (char**)malloc((sampleCount ? sampleCount : 1) * sizeof(char*));
+
+    if (!stacks)
+        return 0;
+
+    for (index = 0; index < sampleCount; index++)
+    {
+        Sample* sample = sampler->samples + index;
+
+        length = 0;
+
+        if (sample->depth == 0)
+            length = (size_t)snprintf(buffer, sizeof(buffer), "[jvm]");
+
+        // Frames were recorded from the innermost, stacks start at the root
+        for (depth = sample->depth - 1; depth >= 0 && length + 1 < sizeof(buffer); depth--)
+        {
+            SampledFrame* frame = sampler->frames + sample->firstFrame + depth;
+
+            length += formatMethodName(buffer + length, sizeof(buffer) - length, frame->jc, frame->method, &frame->pc);
+
+            if (depth > 0 && length + 1 < sizeof(buffer))
+                buffer[length++] = ';';
+        }
+
+        buffer[length] = '\0';
+        stacks[index] = (char*)malloc(length + 1);
+
+        if (!stacks[index])
+        {
+            while (index-- > 0)
+                free(stacks[index]);
+
+            free(stacks);
+            return 0;
+        }
+
+        memcpy(stacks[index], buffer, length + 1);
+    }
+
+    qsort(stacks, sampleCount, sizeof(char*), compareStrings);
+
+    file = fopen(sampler->path, "w");
+
+    for (index = 0; index < sampleCount; index += count)
+    {
+        for (count = 1; index + count < sampleCount && !strcmp(stacks[index], stacks[index + count]); count++);
+
+        if (file)
+            fprintf(file, "%s %u\n", stacks[index], count);
+    }
+
+    for (index = 0; index < sampleCount; index++)
+        free(stacks[index]);
+
+    free(stacks);
+
+    if (!file || fclose(file))
+        success = 0;
+
+    return success;
+}
+
+static int compareSelfCounts(const void* a, const void* b)
+{
+    const MethodSamples* method1 = (const MethodSamples*)a;
+    const MethodSamples* method2 = (const MethodSamples*)b;
+
+    if (method1->selfCount != method2->selfCount)
+        return method1->selfCount < method2->selfCount ? 1 : -1;
+
+    return method1->totalCount < method2->totalCount ? 1 : (method1->totalCount > method2->totalCount ? -1 : 0);
+}
+
+/// @brief Prints the methods with the most samples to stderr, with
+/// their self and total samples.
+///
+/// @param MethodSampler* sampler - the sampler, already stopped.
+/// @param uint32_t methodCount - number of methods to print.
+void printMethodSampleReport(MethodSampler* sampler, uint32_t methodCount)
+{
+    char name[512];
+    uint32_t sampleCount = sampler->sampleCount;
+    uint32_t capacity = 64, distinct = 0, idleCount = 0;
+    uint32_t index, depth, search;
+    MethodSamples* methods = (MethodSamples*)malloc(capacity * sizeof(MethodSamples));
+
+    if (!methods)
+        return;
+
+    for (index = 0; index < sampleCount; index++)
+    {
+        Sample* sample = sampler->samples + index;
+
+        if (sample->depth == 0)
+            idleCount++;
+
+        for (depth = 0; depth < sample->depth; depth++)
+        {
+            SampledFrame* frame = sampler->frames + sample->firstFrame + depth;
+
+            for (search = 0; search < distinct && methods[search].method != frame->method; search++);
+
+            if (search == distinct)
+            {
+                if (distinct == capacity)
+                {
+                    MethodSamples* grown = (MethodSamples*)malloc(capacity * 2 * sizeof(MethodSamples));
+
+                    if (!grown)
+                        continue;
+
+                    memcpy(grown, methods, capacity * sizeof(MethodSamples));
+                    free(methods);
+                    methods = grown;
+                    capacity *= 2;
+                }
+
+                methods[distinct].jc = frame->jc;
+                methods[distinct].method = frame->method;
+                methods[distinct].selfCount = 0;
+                methods[distinct].totalCount = 0;
+                methods[distinct].lastSample = UINT32_MAX;
+                distinct++;
+            }
+
+            if (depth == 0)
+                methods[search].selfCount++;
+
+            if (methods[search].lastSample != index)
+            {
+                methods[search].totalCount++;
+                methods[search].lastSample = index;
+            }
+        }
+    }
+
+    qsort(methods, distinct, sizeof(MethodSamples), compareSelfCounts);
+
+    fprintf(stderr, "\nMethod samples: %u (%u dropped, %u outside Java methods), every %u us\n",
+            sampleCount, (uint32_t)sampler->droppedCount, idleCount, sampler->interval);
+    fprintf(stderr, "\n  %-60s %10s %7s %10s %7s\n", "Method", "Self", "%", "Total", "%");
+
+    for (index = 0; index < distinct && index < methodCount; index++)
+    {
+        formatMethodName(name, sizeof(name), methods[index].jc, methods[index].method, NULL);
+
+        fprintf(stderr, "  %-60s %10u %6.2f%% %10u %6.2f%%\n", name,
+                methods[index].selfCount, sampleCount ? 100.0 * methods[index].selfCount / sampleCount : 0.0,
+                methods[index].totalCount, sampleCount ? 100.0 * methods[index].totalCount / sampleCount : 0.0);
+    }
+
+    free(methods);
+}
@@ -0,0 +1,49 @@
+#ifndef METHODSAMPLER_H
+#define METHODSAMPLER_H
+
+#include <stdint.h>
+
+typedef struct MethodSampler MethodSampler;
+
+#include "jvm.h"
+
+// Frames recorded per sample, from the innermost one
+#define SAMPLER_MAX_DEPTH 128
+
+MethodSampler* newMethodSampler(JavaVirtualMachine* jvm, const char* path, uint32_t intervalMicroseconds);
+void freeMethodSampler(MethodSampler* sampler);
+uint8_t startMethodSampler(MethodSampler* sampler);
+void stopMethodSampler(MethodSampler* sampler);
+uint8_t saveMethodSamples(MethodSampler* sampler);
+void printMethodSampleReport(MethodSampler* sampler, uint32_t methodCount);
+
+#endif // METHODSAMPLER_H
+
+/// @defgroup methodsampler Method sampler module
+///
+/// @brief Finds the hot Java methods by sampling the frame stack.
+///
+/// "-Xsample:<file>" arms a SIGPROF timer, every millisecond of
+/// processor time by default or as set by "-Xsampleinterval:<us>".
+/// The signal handler copies the class, method and pc of each frame
+/// on the JVM frame stack into buffers allocated beforehand. It
+/// doesn't allocate, lock or decode anything, so it is safe wherever
+/// the signal lands. Frames are linked into the stack only once they
+/// are complete, see pushFrame(). The class loader workers block the
+/// signal, so it always interrupts the JVM thread.
+///
+/// When the program ends, the samples are resolved to
+/// "class.method:line" names, using the LineNumberTable attributes,
+/// and written to <file> as collapsed stacks, one
+/// "root;...;leaf count" line per distinct stack, which flamegraph.pl
+/// turns into a flame graph. The methods with the most samples are
+/// also printed to stderr, with the samples where they were running
+/// (self) and where they were on the stack (total). Samples taken
+/// while no Java method is running, such as during class loading,
+/// are counted as "[jvm]".
+///
+/// Methods running on the register IR don't update the pc of their
+/// frame, so their lines are where they were entered or where they
+/// last left the IR. Sampling isn't available on Windows.
+///
+/// @see startMethodSampler(), saveMethodSamples()
@@ -7,13 +7,10 @@
 #include <inttypes.h>
 #include <time.h>
 
-#define HIWORD(x) ((int32_t)(x >> 32))
-#define LOWORD(x) ((int32_t)(x & 0xFFFFFFFFll))
-
 uint8_t native_println(JavaVirtualMachine* jvm, Frame* frame, const uint8_t* descriptor_utf8, int32_t utf8_len)
 {
     int64_t longvalue = 0;
-    int32_t high, low;
+    int32_t low;
 
     if (utf8_len < 2)
     {
@@ -26,17 +23,17 @@ uint8_t native_println(JavaVirtualMachine* jvm, Frame* frame, const uint8_t* des
         case ')': break;
 
         case 'Z':
-            popOperand(&frame->operands, &low, NULL);
+            popOperand(&frame->operands, &low);
             printf("%s", (int8_t)low ? "true" : "false");
             break;
 
         case 'B':
-            popOperand(&frame->operands, &low, NULL);
+            popOperand(&frame->operands, &low);
             printf("%d", (int8_t)low);
             break;
 
         case 'C':
-            popOperand(&frame->operands, &low, NULL);
+            popOperand(&frame->operands, &low);
             if (low <= 127)
                 printf("%c", (char)low);
             else
@@ -45,10 +42,7 @@ uint8_t native_println(JavaVirtualMachine* jvm, Frame* frame, const uint8_t* des
 
         case 'D':
         case 'J':
-            popOperand(&frame->operands, &low, NULL);
-            popOperand(&frame->operands, &high, NULL);
-            longvalue = high;
-            longvalue = (longvalue << 32) | (uint32_t)low;
+            popWideOperand(&frame->operands, &longvalue);
 
             if (descriptor_utf8[1] == 'D')
                 printf("%#f", readDoubleFromUint64(longvalue));
@@ -58,18 +52,18 @@ uint8_t native_println(JavaVirtualMachine* jvm, Frame* frame, const uint8_t* des
             break;
 
         case 'F':
-            popOperand(&frame->operands, &low, NULL);
+            popOperand(&frame->operands, &low);
             printf("%#f", readFloatFromUint32(low));
             break;
 
         case 'I':
-            popOperand(&frame->operands, &low, NULL);
+            popOperand(&frame->operands, &low);
             printf("%d", low);
             break;
 
         case 'L':
         {
-            popOperand(&frame->operands, &low, NULL);
+            popOperand(&frame->operands, &low);
             Reference* obj = (Reference*)low;
 
             if (obj->type == REFTYPE_STRING)
@@ -88,7 +82,7 @@ uint8_t native_println(JavaVirtualMachine* jvm, Frame* frame, const uint8_t* des
         }
 
         case '[':
-            popOperand(&frame->operands, &low, NULL);
+            popOperand(&frame->operands, &low);
             printf("0x%X", low);
             break;
 
@@ -99,7 +93,7 @@ uint8_t native_println(JavaVirtualMachine* jvm, Frame* frame, const uint8_t* des
     printf("\n");
 
     // Pop out the "java/lang/System.out" static field
-    popOperand(&frame->operands, NULL, NULL);
+    popOperand(&frame->operands, NULL);
 
     return 1;
 }
@@ -108,10 +102,9 @@ uint8_t native_currentTimeMillis(JavaVirtualMachine* jvm, Frame* frame, const ui
 {
     int64_t seconds = (int64_t)time(NULL) * 1000;
 
-    if (!pushOperand(&frame->operands, HIWORD(seconds), OP_LONG) ||
-        !pushOperand(&frame->operands, LOWORD(seconds), OP_LONG))
+    if (!pushWideOperand(&frame->operands, seconds))
     {
-        jvm->status = JVM_STATUS_OUT_OF_MEMORY;
+        jvm->status = JVM_STATUS_OPERAND_STACK_OVERFLOW;
         return 0;
     }
 
@@ -0,0 +1,245 @@
+#include "opcodeprofile.h"
+#include "superinstructions.h"
+#include "memoryinspect.h"
+#include <string.h>
+#include <inttypes.h>
+
+enum OpcodeFamily {
+    FAMILY_CONSTANT,
+    FAMILY_LOAD,
+    FAMILY_STORE,
+    FAMILY_STACK,
+    FAMILY_ARITHMETIC,
+    FAMILY_CONVERSION,
+    FAMILY_BRANCH,
+    FAMILY_CONTROL,
+    FAMILY_FIELD,
+    FAMILY_INVOKE,
+    FAMILY_OBJECT,
+    FAMILY_EXCEPTION,
+    FAMILY_SUPERINSTRUCTION,
+    FAMILY_OTHER,
+    FAMILY_COUNT
+};
+
+static const char* familyNames[FAMILY_COUNT] = {
+    "constant", "load", "store", "stack", "arithmetic", "conversion", "branch",
+    "control", "field", "invoke", "object", "exception", "superinstruction", "other"
+};
+
+static enum OpcodeFamily getFamily(uint8_t opcode)
+{
+    if (isSuperinstruction(opcode))
+        return FAMILY_SUPERINSTRUCTION;
+
+    if (opcode <= opcode_ldc2_w)
+        return opcode == opcode_nop ? FAMILY_OTHER : FAMILY_CONSTANT;
+
+    if (opcode <= opcode_saload)
+        return FAMILY_LOAD;
+
+    if (opcode <= opcode_sastore)
+        return FAMILY_STORE;
+
+    if (opcode <= opcode_swap)
+        return FAMILY_STACK;
+
+    if (opcode <= opcode_iinc)
+        return FAMILY_ARITHMETIC;
+
+    if (opcode <= opcode_i2s)
+        return FAMILY_CONVERSION;
+
+    if (opcode <= opcode_if_acmpne || opcode == opcode_ifnull || opcode == opcode_ifnonnull)
+        return FAMILY_BRANCH;
+
+    if (opcode <= opcode_return || opcode == opcode_goto_w || opcode == opcode_jsr_w)
+        return FAMILY_CONTROL;
+
+    if (opcode <= opcode_putfield)
+        return FAMILY_FIELD;
+
+    if (opcode <= opcode_invokedynamic)
+        return FAMILY_INVOKE;
+
+    if (opcode == opcode_athrow || opcode == opcode_monitorenter || opcode == opcode_monitorexit)
+        return FAMILY_EXCEPTION;
+
+    if (opcode <= opcode_instanceof || opcode == opcode_multianewarray)
+        return FAMILY_OBJECT;
+
+    return FAMILY_OTHER;
+}
+
+/// @brief Gets the name of the family of an opcode, such as "load"
+/// or "invoke".
+const char* getOpcodeFamily(uint8_t opcode)
+{
+    return familyNames[getFamily(opcode)];
+}
+
+/// @brief Creates an empty opcode profile.
+///
+/// @param const char* path - file the CSV is written to. The string
+/// must outlive the profile.
+///
+/// @return The profile, to be freed with freeOpcodeProfile(), or NULL
+/// if there is not enough memory.
+OpcodeProfile* newOpcodeProfile(const char* path)
+{
+    OpcodeProfile* profile = (OpcodeProfile*)malloc(sizeof(OpcodeProfile));
+
+    if (profile)
+    {
+        memset(profile, 0, sizeof(OpcodeProfile));
+        profile->path = path;
+    }
+
+    return profile;
+}
+
+void freeOpcodeProfile(OpcodeProfile* profile)
+{
+    free(profile);
+}
+
+// Opcodes sorted by time, for the qsort comparison
+static const OpcodeProfile* sortedProfile;
+
+static int compareOpcodeTimes(const void* a, const void* b)
+{
+    uint64_t time1 = sortedProfile->time[*(const uint8_t*)a];
+    uint64_t time2 = sortedProfile->time[*(const uint8_t*)b];
+
+    if (time1 != time2)
+        return time1 < time2 ? 1 : -1;
+
+    return (int)*(const uint8_t*)a - (int)*(const uint8_t*)b;
+}
+
+/// @brief Lists the opcodes that ran, sorted by time.
+/// @return The number of opcodes in \c outOpcodes.
+static uint32_t sortOpcodes(OpcodeProfile* profile, uint8_t* outOpcodes)
+{
+    uint32_t count = 0;
+    uint32_t opcode;
+
+    // Charges the last instruction up to now, once
+    if (profile->started)
+    {
+        profile->time[profile->lastOpcode] += readProfileTime() - profile->lastTime;
+        profile->started = 0;
+    }
+
+    for (opcode = 0; opcode < 256; opcode++)
+    {
+        if (profile->counts[opcode])
+            outOpcodes[count++] = (uint8_t)opcode;
+    }
+
+    sortedProfile = profile;
+    qsort(outOpcodes, count, 1, compareOpcodeTimes);
+    return count;
+}
+
+static void sumFamilies(OpcodeProfile* profile, uint64_t* outCounts, uint64_t* outTime)
+{
+    uint32_t opcode;
+
+    memset(outCounts, 0, FAMILY_COUNT * sizeof(uint64_t));
+    memset(outTime, 0, FAMILY_COUNT * sizeof(uint64_t));
+
+    for (opcode = 0; opcode < 256; opcode++)
+    {
+        outCounts[getFamily((uint8_t)opcode)] += profile->counts[opcode];
+        outTime[getFamily((uint8_t)opcode)] += profile->time[opcode];
+    }
+}
+
+/// @brief Prints the time per family and per opcode to stderr,
+/// sorted by time.
+void printOpcodeProfile(OpcodeProfile* profile)
+{
+    uint8_t opcodes[256];
+    uint64_t familyCounts[FAMILY_COUNT], familyTime[FAMILY_COUNT];
+    uint64_t totalTime = 0;
+    uint32_t count = sortOpcodes(profile, opcodes);
+    uint32_t index, family, best;
+
+    sumFamilies(profile, familyCounts, familyTime);
+
+    for (family = 0; family < FAMILY_COUNT; family++)
+        totalTime += familyTime[family];
+
+    fprintf(stderr, "\nOpcode profile (time in %s)\n", OPCODE_PROFILE_TIME_UNIT);
+    fprintf(stderr, "\n  %-20s %14s %16s %7s %10s\n", "Family", "Executions", "Time", "%", "Per exec.");
+
+    // Few families, so they are sorted by picking the largest each time
+    for (index = 0; index < FAMILY_COUNT; index++)
+    {
+        best = FAMILY_COUNT;
+
+        for (family = 0; family < FAMILY_COUNT; family++)
+        {
+            if (familyCounts[family] && (best == FAMILY_COUNT || familyTime[family] > familyTime[best]))
+                best = family;
+        }
+
+        if (best == FAMILY_COUNT)
+            break;
+
+        fprintf(stderr, "  %-20s %14" PRIu64 " %16" PRIu64 " %6.2f%% %10.1f\n", familyNames[best], familyCounts[best],
+                familyTime[best], totalTime ? 100.0 * familyTime[best] / totalTime : 0.0,
+                (double)familyTime[best] / familyCounts[best]);
+
+        familyCounts[best] = 0;
+    }
+
+    fprintf(stderr, "\n  %-40s %-16s %14s %16s %7s %10s\n", "Opcode", "Family", "Executions", "Time", "%", "Per exec.");
+
+    for (index = 0; index < count; index++)
+    {
+        uint8_t opcode = opcodes[index];
+
+        fprintf(stderr, "  %-40s %-16s %14" PRIu64 " %16" PRIu64 " %6.2f%% %10.1f\n", getSuperinstructionMnemonic(opcode),
+                getOpcodeFamily(opcode), profile->counts[opcode], profile->time[opcode],
+                totalTime ? 100.0 * profile->time[opcode] / totalTime : 0.0,
+                (double)profile->time[opcode] / profile->counts[opcode]);
+    }
+}
+
+/// @brief Writes the profile to its file as CSV, with one line per
+/// family followed by one line per opcode, sorted by time.
+///
+/// @return 1 if the file could be written, 0 otherwise.
+uint8_t saveOpcodeProfile(OpcodeProfile* profile)
+{
+    uint8_t opcodes[256];
+    uint64_t familyCounts[FAMILY_COUNT], familyTime[FAMILY_COUNT];
+    uint32_t count = sortOpcodes(profile, opcodes);
+    uint32_t index;
+    FILE* file = fopen(profile->path, "w");
+
+    if (!file)
+        return 0;
+
+    sumFamilies(profile, familyCounts, familyTime);
+
+    fprintf(file, "kind,opcode,name,family,executions,%s\n", OPCODE_PROFILE_TIME_UNIT);
+
+    for (index = 0; index < FAMILY_COUNT; index++)
+    {
+        if (familyCounts[index])
+            fprintf(file, "family,,%s,%s,%" PRIu64 ",%" PRIu64 "\n", familyNames[index], familyNames[index], familyCounts[index], familyTime[index]);
+    }
+
+    for (index = 0; index < count; index++)
+    {
+        uint8_t opcode = opcodes[index];
+
+        fprintf(file, "opcode,%u,%s,%s,%" PRIu64 ",%" PRIu64 "\n", opcode, getSuperinstructionMnemonic(opcode),
+                getOpcodeFamily(opcode), profile->counts[opcode], profile->time[opcode]);
+    }
+
+    return fclose(file) == 0;
+}
@@ -0,0 +1,91 @@
+#ifndef OPCODEPROFILE_H
+#define OPCODEPROFILE_H
+
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define OPCODE_PROFILE_TIME_UNIT "cycles"
+#else
+#include <time.h>
+#define OPCODE_PROFILE_TIME_UNIT "ns"
+#endif
+
+/// @brief Executions and time spent per opcode, including the
+/// superinstructions.
+typedef struct OpcodeProfile
+{
+    // File the CSV is written to
+    const char* path;
+
+    uint64_t counts[256];
+    uint64_t time[256];
+
+    // When the last instruction was dispatched, and its opcode,
+    // which is charged the time until the next dispatch
+    uint64_t lastTime;
+    uint8_t lastOpcode;
+    uint8_t started;
+} OpcodeProfile;
+
+/// @brief Reads the time stamp counter, or a nanosecond clock where
+/// there is no counter.
+static inline uint64_t readProfileTime(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+#endif
+}
+
+/// @brief Counts an instruction about to run, and charges the time
+/// since the previous dispatch to the previous instruction.
+///
+/// Time spent in called methods is charged to the instructions of
+/// those methods, as their dispatches go through here too. Only native
+/// methods are included in the time of the invoke that calls them.
+static inline void profileOpcode(OpcodeProfile* profile, uint8_t opcode)
+{
+    uint64_t now = readProfileTime();
+
+    if (profile->started)
+        profile->time[profile->lastOpcode] += now - profile->lastTime;
+
+    profile->counts[opcode]++;
+    profile->lastTime = now;
+    profile->lastOpcode = opcode;
+    profile->started = 1;
+}
+
+OpcodeProfile* newOpcodeProfile(const char* path);
+void freeOpcodeProfile(OpcodeProfile* profile);
+const char* getOpcodeFamily(uint8_t opcode);
+void printOpcodeProfile(OpcodeProfile* profile);
+uint8_t saveOpcodeProfile(OpcodeProfile* profile);
+
+#endif // OPCODEPROFILE_H
+
+/// @defgroup opcodeprofile Opcode profile module
+///
+/// @brief Shows where the interpreter spends its time, by opcode and
+/// by family of opcodes.
+///
+/// "-Xopcodeprofile:<file>" counts every instruction dispatched by the
+/// bytecode interpreter and the time until the next dispatch, read from
+/// the time stamp counter on x86 or a monotonic clock elsewhere. When
+/// the program ends, the opcodes and families are printed to stderr,
+/// sorted by time, and written to <file> as CSV. Families group the
+/// instruction functions, such as loads, field accesses or invokes, to
+/// tell which ones are worth optimizing first.
+///
+/// The register IR is disabled while profiling, as its instructions
+/// aren't bytecode. Superinstructions are profiled as themselves; run
+/// with "-Xnosuperinstructions" to see the original instructions.
+/// Without the option, the interpreter only tests a null pointer per
+/// dispatch.
+///
+/// @see profileOpcode(), saveOpcodeProfile()
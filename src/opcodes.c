@@ -59,3 +59,102 @@ const char* getOpcodeMnemonic(uint8_t opcode)
 
     return mnemonics[opcode] ? mnemonics[opcode] : "- unknown opcode -";
 }
+
+/// @brief Calculates how many bytes the instruction at a given
+/// offset of a method's bytecode occupies, including the opcode
+/// and all of its parameters.
+///
+/// @param const uint8_t* code - pointer to the method's bytecode.
+/// @param uint32_t pc - offset of the instruction's opcode.
+/// @param uint32_t code_length - length of the method's bytecode.
+///
+/// @return The length of the instruction in bytes. If the opcode
+/// is unknown or the instruction doesn't fit within \c code_length,
+/// zero is returned.
+uint32_t getInstructionLength(const uint8_t* code, uint32_t pc, uint32_t code_length)
+{
+    uint32_t length;
+    int32_t low, high, npairs;
+
+    if (pc >= code_length)
+        return 0;
+
+    #define OPCODE_INTERVAL(begin, end) (opcode >= opcode_##begin && opcode <= opcode_##end)
+    #define READ_S4(offset) ((int32_t)((uint32_t)code[offset] << 24 | (uint32_t)code[(offset) + 1] << 16 | \
+                                       (uint32_t)code[(offset) + 2] << 8 | (uint32_t)code[(offset) + 3]))
+
+    uint8_t opcode = code[pc];
+
+    if (OPCODE_INTERVAL(iload, aload) || OPCODE_INTERVAL(istore, astore) ||
+        opcode == opcode_bipush || opcode == opcode_ldc ||
+        opcode == opcode_ret || opcode == opcode_newarray)
+    {
+        length = 2;
+    }
+    else if (OPCODE_INTERVAL(ifeq, jsr) || OPCODE_INTERVAL(getstatic, invokestatic) ||
+             opcode == opcode_sipush || opcode == opcode_ldc_w || opcode == opcode_ldc2_w ||
+             opcode == opcode_iinc || opcode == opcode_new || opcode == opcode_anewarray ||
+             opcode == opcode_checkcast || opcode == opcode_instanceof ||
+             opcode == opcode_ifnull || opcode == opcode_ifnonnull)
+    {
+        length = 3;
+    }
+    else if (opcode == opcode_multianewarray)
+    {
+        length = 4;
+    }
+    else if (opcode == opcode_invokeinterface || opcode == opcode_invokedynamic ||
+             opcode == opcode_goto_w || opcode == opcode_jsr_w)
+    {
+        length = 5;
+    }
+    else if (opcode == opcode_wide)
+    {
+        if (pc + 1 >= code_length)
+            return 0;
+
+        length = code[pc + 1] == opcode_iinc ? 6 : 4;
+    }
+    else if (opcode == opcode_tableswitch || opcode == opcode_lookupswitch)
+    {
+        // Padding bytes make the first parameter start
+        // at an offset that is multiple of 4
+        length = 1 + (3 - pc % 4);
+
+        if (pc + length + 12 > code_length)
+            return 0;
+
+        if (opcode == opcode_tableswitch)
+        {
+            low = READ_S4(pc + length + 4);
+            high = READ_S4(pc + length + 8);
+
+            if (low > high || (uint32_t)(high - low) >= code_length)
+                return 0;
+
+            length += 12 + 4 * (uint32_t)(high - low + 1);
+        }
+        else
+        {
+            npairs = READ_S4(pc + length + 4);
+
+            if (npairs < 0 || (uint32_t)npairs >= code_length)
+                return 0;
+
+            length += 8 + 8 * (uint32_t)npairs;
+        }
+    }
+    else if (opcode <= opcode_jsr_w)
+    {
+        length = 1;
+    }
+    else
+    {
+        return 0;
+    }
+
+    #undef READ_S4
+    #undef OPCODE_INTERVAL
+
+    return pc + length <= code_length ? length : 0;
+}
@@ -91,5 +91,6 @@ typedef enum Opcode_newarray_type {
 
 const char* decodeOpcodeNewarrayType(uint8_t type);
 const char* getOpcodeMnemonic(uint8_t opcode);
+uint32_t getInstructionLength(const uint8_t* code, uint32_t pc, uint32_t code_length);
 
 #endif // OPCODES_H
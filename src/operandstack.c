@@ -1,51 +1,118 @@
 #include "operandstack.h"
-#include "memoryinspect.h"
 
-uint8_t pushOperand(OperandStack** os, int32_t value, enum OperandType type)
+/// @brief Initializes an operand stack.
+///
+/// @param OperandStack* os - pointer to the stack to be initialized.
+/// @param Slot* values - memory where the values of the operands
+/// will be stored, with room for \c capacity operands. It is owned
+/// by the frame, not by the stack.
+/// @param uint16_t capacity - maximum number of operands the stack
+/// can hold, which is the max_stack of the method being executed.
+void initOperandStack(OperandStack* os, Slot* values, uint16_t capacity)
 {
-    OperandStack* node = (OperandStack*)malloc(sizeof(OperandStack));
+    os->values = values;
+    os->top = 0;
+    os->capacity = capacity;
+}
+
+/// @brief Pushes a category 1 operand to the top of the stack.
+/// @return 1 in case of success, 0 if the stack is full.
+uint8_t pushOperand(OperandStack* os, int32_t value)
+{
+    return pushSlot(os, value);
+}
+
+/// @brief Removes the category 1 operand at the top of the stack.
+///
+/// \c outPtr can be NULL if the value of the operand isn't needed.
+///
+/// @return 1 in case of success, 0 if the stack is empty.
+uint8_t popOperand(OperandStack* os, int32_t* outPtr)
+{
+    Slot value;
+
+    if (!popSlot(os, &value))
+        return 0;
+
+    if (outPtr)
+        *outPtr = (int32_t)value;
+
+    return 1;
+}
 
-    if (node)
-    {
-        node->value = value;
-        node->type = type;
-        node->next = *os;
-        *os = node;
-    }
+/// @brief Pushes a long or double operand, which takes two slots
+/// with the value in the first one.
+/// @return 1 in case of success, 0 if the stack doesn't have room
+/// for two slots.
+uint8_t pushWideOperand(OperandStack* os, int64_t value)
+{
+    if (os->top + 2 > os->capacity)
+        return 0;
+
+    os->values[os->top] = value;
+    os->values[os->top + 1] = 0;
+    os->top += 2;
+    return 1;
+}
+
+/// @brief Removes the long or double operand at the top of the stack.
+/// @return 1 in case of success, 0 if the stack has less than two slots.
+/// @see pushWideOperand()
+uint8_t popWideOperand(OperandStack* os, int64_t* outPtr)
+{
+    if (os->top < 2)
+        return 0;
 
-    return node != NULL;
+    os->top -= 2;
+
+    if (outPtr)
+        *outPtr = os->values[os->top];
+
+    return 1;
 }
 
-uint8_t popOperand(OperandStack** os, int32_t* outPtr, enum OperandType* outType)
+/// @brief Pushes a slot as it is, whatever its category. Used by
+/// instructions that move slots without looking at them.
+/// @return 1 in case of success, 0 if the stack is full.
+uint8_t pushSlot(OperandStack* os, Slot value)
 {
-    OperandStack* node = *os;
+    if (os->top >= os->capacity)
+        return 0;
 
-    if (node)
-    {
-        if (outPtr)
-            *outPtr = node->value;
+    os->values[os->top++] = value;
+    return 1;
+}
+
+/// @brief Removes the slot at the top of the stack as it is.
+/// @return 1 in case of success, 0 if the stack is empty.
+/// @see pushSlot()
+uint8_t popSlot(OperandStack* os, Slot* outPtr)
+{
+    if (os->top == 0)
+        return 0;
 
-        if (outType)
-            *outType = node->type;
+    os->top--;
 
-        *os = node->next;
-        free(node);
-    }
+    if (outPtr)
+        *outPtr = os->values[os->top];
 
-    return node != NULL;
+    return 1;
 }
 
-void freeOperandStack(OperandStack** os)
+/// @brief Reads a slot without removing it from the stack.
+///
+/// @param uint16_t depth - how many slots are above the wanted
+/// one. Zero is the slot at the top of the stack.
+///
+/// @return 1 in case of success, 0 if the stack doesn't have
+/// that many slots.
+uint8_t peekSlot(OperandStack* os, uint16_t depth, Slot* outPtr)
 {
-    OperandStack* node = *os;
-    OperandStack* tmp;
+    if (depth >= os->top)
+        return 0;
 
-    while (node)
-    {
-        tmp = node;
-        node = node->next;
-        free(tmp);
-    }
+    if (outPtr)
+        *outPtr = os->values[os->top - depth - 1];
 
-    *os = NULL;
+    return 1;
 }
@@ -5,20 +5,38 @@ typedef struct OperandStack OperandStack;
 
 #include <stdint.h>
 
-typedef enum OperandType {
-    OP_INTEGER, OP_FLOAT, OP_LONG, OP_DOUBLE,
-    OP_NULL, OP_REFERENCE, OP_RETURNADDRESS
-} OperandType;
+// Operand stack slots and local variables are 64 bits wide.
+// Category 1 values (int, float, reference) are stored sign extended
+// from 32 bits. Long and double values still take two slots, so
+// max_locals, max_stack and the dup2 family work as in the class
+// file, but the whole value is held in the first of them. The
+// second slot is padding that is only ever copied.
+//
+// Slots carry no type. The type of each slot at each instruction is
+// computed once when the method is linked, see typemap.h.
+typedef int64_t Slot;
 
+// The stack has room for the max_stack operands of the method.
+// values[0] is the bottom of the stack and values[top - 1] is
+// the operand at the top.
+//
+// The values are stored right after the local variables of the
+// frame, so locals and stack slots form a single register file
+// (see registerir.h).
 struct OperandStack
 {
-    int32_t value;
-    OperandType type;
-    OperandStack* next;
+    Slot* values;
+    uint16_t top;
+    uint16_t capacity;
 };
 
-uint8_t pushOperand(OperandStack** os, int32_t value, OperandType type);
-uint8_t popOperand(OperandStack** os, int32_t* outPtr, OperandType* outType);
-void freeOperandStack(OperandStack** os);
+void initOperandStack(OperandStack* os, Slot* values, uint16_t capacity);
+uint8_t pushOperand(OperandStack* os, int32_t value);
+uint8_t popOperand(OperandStack* os, int32_t* outPtr);
+uint8_t pushWideOperand(OperandStack* os, int64_t value);
+uint8_t popWideOperand(OperandStack* os, int64_t* outPtr);
+uint8_t pushSlot(OperandStack* os, Slot value);
+uint8_t popSlot(OperandStack* os, Slot* outPtr);
+uint8_t peekSlot(OperandStack* os, uint16_t depth, Slot* outPtr);
 
 #endif // OPERAND_STACK
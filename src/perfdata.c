@@ -0,0 +1,146 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "perfdata.h"
+#include "threads.h"
+#include "mappedfile.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <process.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+static const char* const counterNames[PERF_COUNTER_COUNT] = {
+    "jvm.bytecodes",
+    "jvm.invocations",
+    "jvm.classes.loaded",
+    "heap.objects.allocated",
+    "heap.bytes.allocated",
+    "gc.collections",
+    "gc.pause.ns",
+    "compiler.methods"
+};
+
+/// @brief Writes the path of the counters file of this process,
+/// "/tmp/jvmperf_<pid>", or "%TEMP%\jvmperf_<pid>" on Windows.
+void getDefaultPerfDataPath(char* buffer, uint32_t size)
+{
+#ifdef _WIN32
+    char directory[MAX_PATH + 1];
+    DWORD length = GetTempPathA(sizeof(directory), directory);
+
+    if (!length || length > MAX_PATH)
+        strcpy(directory, ".\\");
+
+    snprintf(buffer, size, "%sjvmperf_%d", directory, _getpid());
+#else
+    snprintf(buffer, size, "/tmp/jvmperf_%ld", (long)getpid());
+#endif
+}
+
+/// @brief Creates a counters file and maps it shared.
+///
+/// @param const char* path - file to be created, replacing any file
+/// with that name. On POSIX systems, the file is only readable by the
+/// current user, and is never written through a link, see
+/// createNewFile().
+///
+/// @return The mapping, with every counter at zero, to be closed with
+/// closePerfData(), or NULL if the file couldn't be created or mapped.
+PerfData* openPerfData(const char* path)
+{
+    PerfData* perfData = NULL;
+    uint32_t index;
+
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL,
+                                CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    HANDLE mapping;
+
+    if (handle == INVALID_HANDLE_VALUE)
+        return NULL;
+
+    mapping = CreateFileMappingA(handle, NULL, PAGE_READWRITE, 0, sizeof(PerfData), NULL);
+
+    if (mapping)
+    {
+        perfData = (PerfData*)MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, sizeof(PerfData));
+        CloseHandle(mapping);
+    }
+
+    CloseHandle(handle);
+
+    if (!perfData)
+        return NULL;
+#else
+    void* data;
+    int descriptor = createNewFile(path);
+
+    if (descriptor < 0)
+        return NULL;
+
+    // The file is extended with zeros, so every counter starts at zero
+    if (ftruncate(descriptor, sizeof(PerfData)))
+    {
+        close(descriptor);
+        return NULL;
+    }
+
+    data = mmap(NULL, sizeof(PerfData), PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    close(descriptor);
+
+    if (data == MAP_FAILED)
+        return NULL;
+
+    perfData = (PerfData*)data;
+#endif
+
+    memcpy(perfData->magic, PERF_DATA_MAGIC, sizeof(PERF_DATA_MAGIC));
+    perfData->version = PERF_DATA_VERSION;
+    perfData->headerSize = (uint32_t)((uint8_t*)perfData->entries - (uint8_t*)perfData);
+    perfData->entrySize = sizeof(PerfDataEntry);
+    perfData->entryCount = PERF_COUNTER_COUNT;
+#ifdef _WIN32
+    perfData->pid = (uint32_t)_getpid();
+#else
+    perfData->pid = (uint32_t)getpid();
+#endif
+    perfData->startTime = (uint64_t)time(NULL);
+
+    for (index = 0; index < PERF_COUNTER_COUNT; index++)
+        strncpy(perfData->entries[index].name, counterNames[index], PERF_DATA_NAME_LENGTH - 1);
+
+    // Readers skip the entries until the header is complete
+    storeRelease(&perfData->state, PERF_DATA_RUNNING);
+    return perfData;
+}
+
+/// @brief Marks the counters as final and unmaps them.
+///
+/// @param const char* path - file given to openPerfData().
+/// @param uint8_t removeFile - whether the file is removed, as readers
+/// only need it while the JVM runs.
+void closePerfData(PerfData* perfData, const char* path, uint8_t removeFile)
+{
+    storeRelease(&perfData->state, PERF_DATA_EXITED);
+
+#ifdef _WIN32
+    UnmapViewOfFile(perfData);
+
+    if (removeFile)
+        DeleteFileA(path);
+#else
+    munmap(perfData, sizeof(PerfData));
+
+    if (removeFile)
+        unlink(path);
+#endif
+}
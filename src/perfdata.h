@@ -0,0 +1,121 @@
+#ifndef PERFDATA_H
+#define PERFDATA_H
+
+#include <stdint.h>
+
+#define PERF_DATA_MAGIC "JVMPERF"
+#define PERF_DATA_VERSION 1
+
+// Longest counter name, with its terminating null character
+#define PERF_DATA_NAME_LENGTH 40
+
+// The bytecode counter is published every 65536 dispatches
+#define PERF_DATA_PUBLISH_MASK 0xFFFF
+
+enum PerfDataState {
+    PERF_DATA_STARTING,
+    PERF_DATA_RUNNING,
+    PERF_DATA_EXITED
+};
+
+typedef enum PerfCounter {
+    PERF_BYTECODES,
+    PERF_INVOCATIONS,
+    PERF_CLASSES_LOADED,
+    PERF_OBJECTS_ALLOCATED,
+    PERF_BYTES_ALLOCATED,
+    PERF_GC_COUNT,
+    PERF_GC_PAUSE_NANOS,
+    PERF_COMPILED_METHODS,
+    PERF_COUNTER_COUNT
+} PerfCounter;
+
+typedef struct PerfDataEntry
+{
+    char name[PERF_DATA_NAME_LENGTH];
+    uint64_t value;
+} PerfDataEntry;
+
+/// @brief Layout of a counters file, as mapped by the JVM and by
+/// readers. Every field is little-endian on the usual targets, as
+/// the file is only read on the machine that writes it.
+typedef struct PerfData
+{
+    char magic[8];
+    uint32_t version;
+
+    // Sizes readers check before using the entries
+    uint32_t headerSize;
+    uint32_t entrySize;
+    uint32_t entryCount;
+
+    uint32_t pid;
+
+    // One of PerfDataState, written last when the JVM starts or exits
+    uint32_t state;
+
+    // Seconds since 1970 when the JVM started
+    uint64_t startTime;
+
+    PerfDataEntry entries[PERF_COUNTER_COUNT];
+} PerfData;
+
+/// @brief Reads a counter with no ordering constraint, the value
+/// being whole even while the JVM updates it.
+static inline uint64_t readPerfCounter(const uint64_t* value)
+{
+#if defined(_MSC_VER)
+    return *(const volatile uint64_t*)value;
+#else
+    return __atomic_load_n(value, __ATOMIC_RELAXED);
+#endif
+}
+
+/// @brief Sets a counter for readers in other processes.
+static inline void setPerfCounter(PerfData* perfData, PerfCounter counter, uint64_t value)
+{
+#if defined(_MSC_VER)
+    *(volatile uint64_t*)&perfData->entries[counter].value = value;
+#else
+    __atomic_store_n(&perfData->entries[counter].value, value, __ATOMIC_RELAXED);
+#endif
+}
+
+/// @brief Adds to a counter. Only the thread running the program
+/// writes counters, so no read-modify-write instruction is needed.
+static inline void addPerfCounter(PerfData* perfData, PerfCounter counter, uint64_t amount)
+{
+    setPerfCounter(perfData, counter, readPerfCounter(&perfData->entries[counter].value) + amount);
+}
+
+PerfData* openPerfData(const char* path);
+void closePerfData(PerfData* perfData, const char* path, uint8_t removeFile);
+void getDefaultPerfDataPath(char* buffer, uint32_t size);
+
+#endif // PERFDATA_H
+
+/// @defgroup perfdata Performance counters module
+///
+/// @brief Lets other processes watch a running JVM.
+///
+/// "-Xperfdata" creates the file "/tmp/jvmperf_<pid>", or "<file>"
+/// with "-Xperfdata:<file>", and maps it shared, like the hsperfdata
+/// files of HotSpot. The JVM updates counters in it while the program
+/// runs, and "tools/perfstat.c" maps the file to print them, to print
+/// their rates while the program runs, or to diff two copies of it.
+/// The default file is removed when the JVM exits, a named one is kept.
+/// Only the user running the JVM can read the file, and a link at its
+/// path is replaced rather than written through.
+///
+/// The file is a PerfData header followed by named 64-bit counters,
+/// so readers find counters by name and ignore those they don't know.
+/// A new layout changes PERF_DATA_VERSION.
+///
+/// Counters are written with relaxed atomic stores, which keeps readers
+/// from seeing half-written values without slowing the interpreter.
+/// The bytecode counter is the number of dispatches, published when a
+/// method is called and every PERF_DATA_PUBLISH_MASK + 1 dispatches.
+/// Compiled methods are the methods translated to register IR. The
+/// garbage collection counters stay at zero without "-Xgc".
+///
+/// @see openPerfData(), addPerfCounter()
@@ -0,0 +1,376 @@
+#ifndef _WIN32
+#define _DEFAULT_SOURCE
+#endif
+
+#include "perfmap.h"
+#include "mappedfile.h"
+#include "memoryinspect.h"
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__linux__) && (defined(__x86_64__) || defined(__i386__))
+#define PERF_MAP_SUPPORTED
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+// Bytes reserved for each trampoline, keeping them 16-byte aligned
+#define TRAMPOLINE_SIZE 16
+
+// Bytes of executable memory mapped at a time
+#define CODE_CHUNK_SIZE 65536
+
+#define JITDUMP_MAGIC 0x4A695444
+#define JITDUMP_VERSION 1
+#define JITDUMP_CODE_LOAD 0
+#define JITDUMP_CODE_CLOSE 3
+
+#if defined(__x86_64__)
+#define JITDUMP_MACHINE 62
+
+// push rbp; mov rbp, rsp; call rdx; pop rbp; ret
+// The jvm and frame arguments are already in rdi and rsi.
+static const uint8_t trampolineCode[] = {
+    0x55, 0x48, 0x89, 0xE5, 0xFF, 0xD2, 0x5D, 0xC3
+};
+#else
+#define JITDUMP_MACHINE 3
+
+// push ebp; mov ebp, esp; push [ebp + 12]; push [ebp + 8];
+// call [ebp + 16]; leave; ret
+static const uint8_t trampolineCode[] = {
+    0x55, 0x89, 0xE5, 0xFF, 0x75, 0x0C, 0xFF, 0x75, 0x08, 0xFF, 0x55, 0x10, 0xC9, 0xC3
+};
+#endif
+
+/// @brief Executable memory holding trampolines.
+typedef struct CodeChunk
+{
+    uint8_t* code;
+    uint32_t used;
+    struct CodeChunk* next;
+} CodeChunk;
+
+struct PerfMap
+{
+    FILE* mapFile;
+
+    // Jitdump file, or NULL, and the page of it mapped executable,
+    // which is how perf finds the file
+    FILE* jitdumpFile;
+    void* jitdumpMarker;
+    long pageSize;
+
+    uint64_t codeIndex;
+
+    // The first chunk is the one being filled
+    CodeChunk* chunks;
+};
+
+#ifdef PERF_MAP_SUPPORTED
+
+// Jitdump timestamps must use the clock given to "perf record -k"
+static uint64_t getJitdumpTimestamp(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+static void writeJitdumpHeader(PerfMap* perfMap)
+{
+    struct
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t totalSize;
+        uint32_t machine;
+        uint32_t padding;
+        uint32_t pid;
+        uint64_t timestamp;
+        uint64_t flags;
+    } header;
+
+    header.magic = JITDUMP_MAGIC;
+    header.version = JITDUMP_VERSION;
+    header.totalSize = sizeof(header);
+    header.machine = JITDUMP_MACHINE;
+    header.padding = 0;
+    header.pid = (uint32_t)getpid();
+    header.timestamp = getJitdumpTimestamp();
+    header.flags = 0;
+    fwrite(&header, sizeof(header), 1, perfMap->jitdumpFile);
+}
+
+static void writeJitdumpRecord(PerfMap* perfMap, uint32_t id, uint32_t size)
+{
+    struct
+    {
+        uint32_t id;
+        uint32_t totalSize;
+        uint64_t timestamp;
+    } record;
+
+    record.id = id;
+    record.totalSize = sizeof(record) + size;
+    record.timestamp = getJitdumpTimestamp();
+    fwrite(&record, sizeof(record), 1, perfMap->jitdumpFile);
+}
+
+static void writeJitdumpCodeLoad(PerfMap* perfMap, const uint8_t* code, const char* name)
+{
+    struct
+    {
+        uint32_t pid;
+        uint32_t tid;
+        uint64_t vma;
+        uint64_t codeAddress;
+        uint64_t codeSize;
+        uint64_t codeIndex;
+    } load;
+
+    uint32_t nameLength = (uint32_t)strlen(name) + 1;
+
+    // Java methods run on the main thread, whose id is the process id
+    load.pid = (uint32_t)getpid();
+    load.tid = load.pid;
+    load.vma = (uint64_t)(uintptr_t)code;
+    load.codeAddress = load.vma;
+    load.codeSize = sizeof(trampolineCode);
+    load.codeIndex = perfMap->codeIndex++;
+
+    writeJitdumpRecord(perfMap, JITDUMP_CODE_LOAD, sizeof(load) + nameLength + sizeof(trampolineCode));
+    fwrite(&load, sizeof(load), 1, perfMap->jitdumpFile);
+    fwrite(name, nameLength, 1, perfMap->jitdumpFile);
+    fwrite(code, sizeof(trampolineCode), 1, perfMap->jitdumpFile);
+}
+
+static uint8_t openJitdump(PerfMap* perfMap)
+{
+    char path[64];
+    void* marker;
+    int descriptor;
+
+    snprintf(path, sizeof(path), "/tmp/jit-%ld.dump", (long)getpid());
+
+    // The file is mapped, so it must be readable too
+    descriptor = createNewFile(path);
+    perfMap->jitdumpFile = descriptor < 0 ? NULL : fdopen(descriptor, "w+b");
+
+    if (!perfMap->jitdumpFile)
+    {
+        if (descriptor >= 0)
+            close(descriptor);
+
+        return 0;
+    }
+
+    marker = mmap(NULL, (size_t)perfMap->pageSize, PROT_READ | PROT_EXEC, MAP_PRIVATE, fileno(perfMap->jitdumpFile), 0);
+
+    if (marker == MAP_FAILED)
+    {
+        fclose(perfMap->jitdumpFile);
+        perfMap->jitdumpFile = NULL;
+        remove(path);
+        return 0;
+    }
+
+    perfMap->jitdumpMarker = marker;
+    writeJitdumpHeader(perfMap);
+    return 1;
+}
+
+#endif // PERF_MAP_SUPPORTED
+
+/// @brief Creates "/tmp/perf-<pid>.map" for the trampolines of Java
+/// methods.
+///
+/// @param uint8_t writeJitdump - whether "/tmp/jit-<pid>.dump" is
+/// written too.
+///
+/// @return The perf map, to be freed with freePerfMap(), or NULL if
+/// trampolines aren't supported on this system or the files couldn't
+/// be created.
+PerfMap* newPerfMap(uint8_t writeJitdump)
+{
+#ifdef PERF_MAP_SUPPORTED
+    char path[64];
+    int descriptor;
+    PerfMap* perfMap = (PerfMap*)malloc(sizeof(PerfMap));
+
+    if (!perfMap)
+        return NULL;
+
+    perfMap->jitdumpFile = NULL;
+    perfMap->jitdumpMarker = NULL;
+    perfMap->pageSize = sysconf(_SC_PAGESIZE);
+    perfMap->codeIndex = 0;
+    perfMap->chunks = NULL;
+
+    snprintf(path, sizeof(path), "/tmp/perf-%ld.map", (long)getpid());
+    descriptor = createNewFile(path);
+    perfMap->mapFile = descriptor < 0 ? NULL : fdopen(descriptor, "w");
+
+    if (!perfMap->mapFile || (writeJitdump && !openJitdump(perfMap)))
+    {
+        if (perfMap->mapFile)
+            fclose(perfMap->mapFile);
+        else if (descriptor >= 0)
+            close(descriptor);
+
+        free(perfMap);
+        return NULL;
+    }
+
+    return perfMap;
+#else
+    return NULL;
+#endif
+}
+
+/// @brief Closes the perf map files and unmaps the trampolines.
+///
+/// The files are kept, as perf reads them after the program ends.
+/// The trampolines can't be running when this is called.
+void freePerfMap(PerfMap* perfMap)
+{
+#ifdef PERF_MAP_SUPPORTED
+    CodeChunk* chunk;
+
+    fclose(perfMap->mapFile);
+
+    if (perfMap->jitdumpFile)
+    {
+        writeJitdumpRecord(perfMap, JITDUMP_CODE_CLOSE, 0);
+        munmap(perfMap->jitdumpMarker, (size_t)perfMap->pageSize);
+        fclose(perfMap->jitdumpFile);
+    }
+
+    while ((chunk = perfMap->chunks))
+    {
+        perfMap->chunks = chunk->next;
+        munmap(chunk->code, CODE_CHUNK_SIZE);
+        free(chunk);
+    }
+#endif
+
+    free(perfMap);
+}
+
+#ifdef PERF_MAP_SUPPORTED
+
+/// @brief Copies the trampoline code into executable memory. Pages
+/// are never writable and executable at once.
+///
+/// A chunk that can't be made executable again is dropped if it only
+/// holds the new trampoline. Otherwise, the trampolines before it may
+/// be on the call stack, and returning into them would crash, so the
+/// JVM aborts.
+static uint8_t* allocateTrampoline(PerfMap* perfMap)
+{
+    CodeChunk* chunk = perfMap->chunks;
+    uint8_t* code;
+
+    if (!chunk || chunk->used + TRAMPOLINE_SIZE > CODE_CHUNK_SIZE)
+    {
+        void* memory = mmap(NULL, CODE_CHUNK_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+        if (memory == MAP_FAILED)
+            return NULL;
+
+        chunk = (CodeChunk*)malloc(sizeof(CodeChunk));
+
+        if (!chunk)
+        {
+            munmap(memory, CODE_CHUNK_SIZE);
+            return NULL;
+        }
+
+        chunk->code = (uint8_t*)memory;
+        chunk->used = 0;
+        chunk->next = perfMap->chunks;
+        perfMap->chunks = chunk;
+    }
+    else if (mprotect(chunk->code, CODE_CHUNK_SIZE, PROT_READ | PROT_WRITE))
+    {
+        return NULL;
+    }
+
+    code = chunk->code + chunk->used;
+    memcpy(code, trampolineCode, sizeof(trampolineCode));
+    chunk->used += TRAMPOLINE_SIZE;
+
+    if (mprotect(chunk->code, CODE_CHUNK_SIZE, PROT_READ | PROT_EXEC))
+    {
+        if (chunk->used > TRAMPOLINE_SIZE)
+        {
+            fprintf(stderr, "Couldn't make the method trampolines executable again\n");
+            abort();
+        }
+
+        perfMap->chunks = chunk->next;
+        munmap(chunk->code, CODE_CHUNK_SIZE);
+        free(chunk);
+        return NULL;
+    }
+
+    __builtin___clear_cache((char*)code, (char*)code + sizeof(trampolineCode));
+    return code;
+}
+
+#endif // PERF_MAP_SUPPORTED
+
+/// @brief Gets the trampoline of a method, creating it and naming it
+/// in the perf map the first time.
+///
+/// @return The trampoline, or NULL if it couldn't be created, in which
+/// case the interpreter loop is called directly.
+/// @see InterpreterTrampoline
+InterpreterTrampoline getMethodTrampoline(PerfMap* perfMap, JavaClass* jc, method_info* method)
+{
+#ifdef PERF_MAP_SUPPORTED
+    att_Code_info* code = getMethodCode(jc, method);
+    cp_info* className;
+    cp_info* methodName;
+    cp_info* descriptor;
+    uint8_t* trampoline;
+    char name[512];
+
+    if (!code)
+        return NULL;
+
+    if (code->trampoline)
+        return (InterpreterTrampoline)code->trampoline;
+
+    trampoline = allocateTrampoline(perfMap);
+
+    if (!trampoline)
+        return NULL;
+
+    className = jc->constantPool + jc->thisClass - 1;
+    className = jc->constantPool + className->Class.name_index - 1;
+    methodName = jc->constantPool + method->name_index - 1;
+    descriptor = jc->constantPool + method->descriptor_index - 1;
+
+    snprintf(name, sizeof(name), "java::%.*s.%.*s%.*s", (int)className->Utf8.length, className->Utf8.bytes,
+             (int)methodName->Utf8.length, methodName->Utf8.bytes, (int)descriptor->Utf8.length,
+             descriptor->Utf8.bytes);
+
+    // Flushed at once, so a killed program still has its symbols
+    fprintf(perfMap->mapFile, "%lx %x %s\n", (unsigned long)(uintptr_t)trampoline, (unsigned)sizeof(trampolineCode), name);
+    fflush(perfMap->mapFile);
+
+    if (perfMap->jitdumpFile)
+    {
+        writeJitdumpCodeLoad(perfMap, trampoline, name);
+        fflush(perfMap->jitdumpFile);
+    }
+
+    code->trampoline = trampoline;
+    return (InterpreterTrampoline)code->trampoline;
+#else
+    return NULL;
+#endif
+}
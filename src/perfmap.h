@@ -0,0 +1,55 @@
+#ifndef PERFMAP_H
+#define PERFMAP_H
+
+#include <stdint.h>
+
+typedef struct PerfMap PerfMap;
+
+#include "jvm.h"
+
+/// @brief A loop executing a frame, interpretFrame() or interpretIR().
+typedef uint8_t (*InterpreterFunction)(JavaVirtualMachine* jvm, Frame* frame);
+
+/// @brief Machine code, one copy per Java method, that calls
+/// \c function with \c jvm and \c frame and returns its result.
+typedef uint8_t (*InterpreterTrampoline)(JavaVirtualMachine* jvm, Frame* frame, InterpreterFunction function);
+
+PerfMap* newPerfMap(uint8_t writeJitdump);
+void freePerfMap(PerfMap* perfMap);
+InterpreterTrampoline getMethodTrampoline(PerfMap* perfMap, JavaClass* jc, method_info* method);
+
+#endif // PERFMAP_H
+
+/// @defgroup perfmap Perf map module
+///
+/// @brief Shows Java methods in the profiles of Linux perf.
+///
+/// Without help, perf only sees the C functions of the interpreter,
+/// so every Java method is "interpretFrame". "-Xperfmap" gives each
+/// Java method a trampoline of its own when it is linked: a few
+/// instructions of machine code, copied into an executable page, that
+/// set up a frame pointer and call the interpreter loop. runMethod()
+/// calls the loop through the trampoline, so the call chain of every
+/// sample taken in the interpreter passes through the trampoline of
+/// the Java method being run.
+///
+/// Trampolines are named in "/tmp/perf-<pid>.map", which perf reads
+/// to name addresses outside of any file, as "java::Class.method(desc)".
+/// "-Xjitdump" also writes "/tmp/jit-<pid>.dump", a jitdump file with
+/// a code load record per trampoline, for "perf inject --jit".
+///
+/// The time of a Java method is the time spent below its trampoline,
+/// so profiles need call chains. For example, with a JVM built by
+/// "make perf":
+///
+///     perf record -g jvmprof.exe Main.class -e -Xperfmap
+///     perf report --children
+///
+/// or, with "-Xjitdump", "perf record -k mono" and "perf inject --jit"
+/// before "perf report".
+///
+/// Trampolines exist for x86-64 and x86 on Linux. Elsewhere, or when
+/// the code pages can't be mapped, the options are ignored with a
+/// message.
+///
+/// @see getMethodTrampoline()
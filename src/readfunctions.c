@@ -2,14 +2,24 @@
 #include "utf8.h"
 #include "validity.h"
 #include <math.h>
+#include <string.h>
 
-/// @cond
-static const union {
-    uint16_t value;
-    uint8_t bytes[2];
-} byte_order = {1};
-#define IS_LITTLE_ENDIAN byte_order.bytes[1]
-/// @endcond
+/// @brief Reads a one-byte unsigned integer from the JavaClass file
+/// @param JavaClass* jc - poiter to an already open JavaClass file
+/// @param [out] uint8_t* out - pointer to variable that will receive
+/// the value read, if non null.
+/// @return 1 in case of success, 0 in case of failure
+uint8_t readu1(JavaClass* jc, uint8_t* out)
+{
+    if (jc->file.size - jc->totalBytesRead < 1)
+        return 0;
+
+    if (out)
+        *out = jc->file.data[jc->totalBytesRead];
+
+    jc->totalBytesRead++;
+    return 1;
+}
 
 /// @brief Reads a four-byte unsigned integer from the JavaClass file
 /// @param JavaClass* jc - poiter to an already open JavaClass file
@@ -18,19 +28,15 @@ static const union {
 /// @return 1 in case of success, 0 in case of failure
 uint8_t readu4(JavaClass* jc, uint32_t* out)
 {
-    uint32_t u4 = 0;
-
-    if (fread(&u4, sizeof(uint32_t), 1, jc->file) != 1)
+    if (jc->file.size - jc->totalBytesRead < 4)
         return 0;
 
-    jc->totalBytesRead += 4;
-
-    if (!IS_LITTLE_ENDIAN)
-        u4 = (u4 >> 24) | ((u4 & 0xFF0000) >> 8) | ((u4 & 0xFF00) << 8) | ((u4 & 0xFF) << 24);
+    const uint8_t* bytes = jc->file.data + jc->totalBytesRead;
 
     if (out)
-        *out = u4;
+        *out = (uint32_t)bytes[0] << 24 | (uint32_t)bytes[1] << 16 | (uint32_t)bytes[2] << 8 | bytes[3];
 
+    jc->totalBytesRead += 4;
     return 1;
 }
 
@@ -41,22 +47,35 @@ uint8_t readu4(JavaClass* jc, uint32_t* out)
 /// @return 1 in case of success, 0 in case of failure
 uint8_t readu2(JavaClass* jc, uint16_t* out)
 {
-    uint16_t u2 = 0;
-
-    if (fread(&u2, sizeof(uint16_t), 1, jc->file) != 1)
+    if (jc->file.size - jc->totalBytesRead < 2)
         return 0;
 
-    jc->totalBytesRead += 2;
-
-    if (!IS_LITTLE_ENDIAN)
-        u2 = (u2 >> 8) | ((u2 & 0xFF) << 8);
+    const uint8_t* bytes = jc->file.data + jc->totalBytesRead;
 
     if (out)
-        *out = u2;
+        *out = (uint16_t)(bytes[0] << 8 | bytes[1]);
 
+    jc->totalBytesRead += 2;
     return 1;
 }
 
+/// @brief Reads a sequence of bytes from the JavaClass file, without
+/// copying them.
+/// @param JavaClass* jc - poiter to an already open JavaClass file
+/// @param uint32_t count - number of bytes to be read
+/// @return Pointer to the bytes in the mapping of the file, which
+/// remains valid until the class is closed, or a null pointer if
+/// the file ends before \c count bytes.
+uint8_t* readBytes(JavaClass* jc, uint32_t count)
+{
+    if (jc->file.size - jc->totalBytesRead < count)
+        return NULL;
+
+    uint8_t* bytes = jc->file.data + jc->totalBytesRead;
+    jc->totalBytesRead += count;
+    return bytes;
+}
+
 // This function tries to read a field descriptor from the UTF-8 stream.
 // It will only read valid field descriptor characters. The return value is
 // 0 if the reading fails. It could fail due to the string being empty or the
@@ -94,19 +113,33 @@ int32_t readFieldDescriptor(uint8_t* utf8_bytes, int32_t utf8_len, char checkVal
             uint8_t* identifierBegin = utf8_bytes;
             int32_t identifierLength = 0;
 
-            do
+            // Class names are usually ASCII, where the ';' can be
+            // searched for without decoding every character
+            uint8_t* semicolon = (uint8_t*)memchr(utf8_bytes, ';', countLeadingASCII(utf8_bytes, utf8_len));
+
+            if (semicolon)
+            {
+                identifierLength = (int32_t)(semicolon - utf8_bytes) + 1;
+                utf8_bytes += identifierLength;
+                utf8_len -= identifierLength;
+                totalBytesRead += identifierLength;
+            }
+            else
             {
-                used_bytes = nextUTF8Character(utf8_bytes, utf8_len, &utf8_char);
+                do
+                {
+                    used_bytes = nextUTF8Character(utf8_bytes, utf8_len, &utf8_char);
 
-                if (used_bytes == 0)
-                    return 0;
+                    if (used_bytes == 0)
+                        return 0;
 
-                utf8_bytes += used_bytes;
-                utf8_len -= used_bytes;
-                totalBytesRead += used_bytes;
-                identifierLength += used_bytes;
+                    utf8_bytes += used_bytes;
+                    utf8_len -= used_bytes;
+                    totalBytesRead += used_bytes;
+                    identifierLength += used_bytes;
 
-            } while (utf8_char != ';');
+                } while (utf8_char != ';');
+            }
 
             if (checkValidClassIdentifier && !isValidJavaIdentifier(identifierBegin, identifierLength - 1, 1))
                 return 0;
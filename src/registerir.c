@@ -0,0 +1,1058 @@
+#include "registerir.h"
+#include "opcodes.h"
+#include "memoryinspect.h"
+#include <string.h>
+
+#define UNKNOWN_DEPTH 0xFFFF
+
+/// @brief An operand stack slot during translation. It is either
+/// a constant or the register currently holding the value, which
+/// is the slot's own stack register once it has been materialized.
+typedef struct
+{
+    uint16_t reg;
+    uint8_t isConstant;
+    int64_t constant;
+} SymbolicSlot;
+
+typedef struct
+{
+    JavaClass* jc;
+    att_Code_info* code;
+    IRMethod* ir;
+    uint32_t capacity;
+
+    SymbolicSlot* stack;
+    uint16_t depth;
+
+    // Whether each bytecode offset is a branch target or an
+    // exception handler, and the stack depth expected there.
+    uint8_t* isTarget;
+    uint16_t* targetDepth;
+
+    // Last IR instruction whose result is at the top of the
+    // stack and can still be written to a local instead.
+    uint32_t lastResult;
+    uint8_t lastResultWidth;
+} Translator;
+
+#define STACK_REGISTER(t, index) ((uint16_t)((t)->code->max_locals + (index)))
+
+static uint8_t emit(Translator* t, uint8_t opcode, uint16_t a, uint16_t b, uint16_t c, int64_t immediate)
+{
+    IRMethod* ir = t->ir;
+
+    if (ir->length == t->capacity)
+    {
+        uint32_t capacity = t->capacity ? t->capacity * 2 : 64;
+        IRInstruction* code = (IRInstruction*)malloc(capacity * sizeof(IRInstruction));
+
+        if (!code)
+            return 0;
+
+        if (ir->code)
+        {
+            memcpy(code, ir->code, ir->length * sizeof(IRInstruction));
+            free(ir->code);
+        }
+
+        ir->code = code;
+        t->capacity = capacity;
+    }
+
+    IRInstruction* instruction = ir->code + ir->length++;
+    instruction->opcode = opcode;
+    instruction->a = a;
+    instruction->b = b;
+    instruction->c = c;
+    instruction->immediate = immediate;
+
+    t->lastResult = IR_NO_INDEX;
+    return 1;
+}
+
+/// @brief Writes a symbolic slot to its stack register.
+static uint8_t materialize(Translator* t, uint16_t index)
+{
+    SymbolicSlot* slot = t->stack + index;
+    uint16_t reg = STACK_REGISTER(t, index);
+
+    if (slot->isConstant)
+    {
+        if (!emit(t, ir_const, reg, 0, 0, slot->constant))
+            return 0;
+    }
+    else if (slot->reg != reg)
+    {
+        if (!emit(t, ir_move, reg, slot->reg, 0, 0))
+            return 0;
+    }
+
+    slot->isConstant = 0;
+    slot->reg = reg;
+    return 1;
+}
+
+/// @brief Writes all symbolic slots to their stack registers.
+static uint8_t flushStack(Translator* t)
+{
+    uint16_t index;
+
+    for (index = 0; index < t->depth; index++)
+    {
+        if (!materialize(t, index))
+            return 0;
+    }
+
+    return 1;
+}
+
+/// @brief Materializes the slots below \c limit that still refer to
+/// local variables about to be overwritten.
+static uint8_t materializeLocal(Translator* t, uint16_t local, uint16_t count, uint16_t limit)
+{
+    uint16_t index;
+
+    for (index = 0; index < limit; index++)
+    {
+        SymbolicSlot* slot = t->stack + index;
+
+        if (!slot->isConstant && slot->reg >= local && slot->reg < local + count &&
+            !materialize(t, index))
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static uint8_t pushRegister(Translator* t, uint16_t reg)
+{
+    if (t->depth >= t->code->max_stack)
+        return 0;
+
+    t->stack[t->depth].reg = reg;
+    t->stack[t->depth].isConstant = 0;
+    t->depth++;
+    return 1;
+}
+
+static uint8_t pushConstant(Translator* t, int64_t constant)
+{
+    if (t->depth >= t->code->max_stack)
+        return 0;
+
+    t->stack[t->depth].isConstant = 1;
+    t->stack[t->depth].constant = constant;
+    t->depth++;
+    return 1;
+}
+
+/// @brief Gets the register holding a stack slot, materializing
+/// the slot if it is a constant.
+static uint8_t getOperand(Translator* t, uint16_t index, uint16_t* outReg)
+{
+    if (t->stack[index].isConstant && !materialize(t, index))
+        return 0;
+
+    *outReg = t->stack[index].reg;
+    return 1;
+}
+
+static uint8_t translateArithmetic(Translator* t, uint8_t irOpcode, uint8_t width, uint8_t operandCount)
+{
+    uint16_t first, b, c = 0;
+
+    if (t->depth < width * operandCount)
+        return 0;
+
+    first = t->depth - width * operandCount;
+
+    // A category 2 operand is read from the first slot of its pair
+    if (!getOperand(t, first, &b) ||
+        (operandCount == 2 && !getOperand(t, first + width, &c)))
+    {
+        return 0;
+    }
+
+    t->depth = first;
+
+    uint16_t destination = STACK_REGISTER(t, first);
+
+    if (!emit(t, irOpcode, destination, b, c, 0) ||
+        !pushRegister(t, destination) ||
+        (width == 2 && !pushRegister(t, destination + 1)))
+    {
+        return 0;
+    }
+
+    t->lastResult = t->ir->length - 1;
+    t->lastResultWidth = width;
+    return 1;
+}
+
+static uint8_t translateLoad(Translator* t, uint16_t local, uint8_t width)
+{
+    if (local + width > t->code->max_locals)
+        return 0;
+
+    return pushRegister(t, local) && (width == 1 || pushRegister(t, local + 1));
+}
+
+static uint8_t translateStore(Translator* t, uint16_t local, uint8_t width)
+{
+    uint16_t top;
+
+    if (t->depth < width || local + width > t->code->max_locals)
+        return 0;
+
+    top = t->depth - width;
+
+    // Values still waiting on the stack must not see the new value
+    if (!materializeLocal(t, local, width, top))
+        return 0;
+
+    SymbolicSlot* slot = t->stack + top;
+
+    // The value was just computed into its stack register, so the
+    // instruction can write it straight to the local instead.
+    if (t->lastResult != IR_NO_INDEX && t->lastResult == t->ir->length - 1 &&
+        t->lastResultWidth == width && !slot->isConstant &&
+        slot->reg == STACK_REGISTER(t, top) &&
+        t->ir->code[t->lastResult].a == slot->reg)
+    {
+        t->ir->code[t->lastResult].a = local;
+        t->lastResult = IR_NO_INDEX;
+        t->depth = top;
+        return 1;
+    }
+
+    // Only the first slot of a category 2 value is moved, the
+    // second one being padding
+    if (slot->isConstant)
+    {
+        if (!emit(t, ir_const, local, 0, 0, slot->constant))
+            return 0;
+    }
+    else if (slot->reg != local)
+    {
+        if (!emit(t, ir_move, local, slot->reg, 0, 0))
+            return 0;
+    }
+
+    t->depth = top;
+    return 1;
+}
+
+static uint8_t recordTarget(Translator* t, int64_t target, uint16_t depth)
+{
+    if (target < 0 || target >= t->code->code_length || !t->isTarget[target])
+        return 0;
+
+    if (t->targetDepth[target] == UNKNOWN_DEPTH)
+        t->targetDepth[target] = depth;
+
+    return t->targetDepth[target] == depth;
+}
+
+static uint8_t translateBranch(Translator* t, uint8_t irOpcode, uint8_t operandCount, int64_t target)
+{
+    uint16_t a = 0, b = 0;
+
+    if (t->depth < operandCount)
+        return 0;
+
+    if ((operandCount >= 1 && !getOperand(t, t->depth - operandCount, &a)) ||
+        (operandCount == 2 && !getOperand(t, t->depth - 1, &b)))
+    {
+        return 0;
+    }
+
+    t->depth -= operandCount;
+
+    // The stack must be in its registers when the target is reached
+    return flushStack(t) &&
+           recordTarget(t, target, t->depth) &&
+           emit(t, irOpcode, a, b, 0, target);
+}
+
+static int32_t readS2(const uint8_t* code)
+{
+    return (int16_t)(code[0] << 8 | code[1]);
+}
+
+static int32_t readS4(const uint8_t* code)
+{
+    return (int32_t)((uint32_t)code[0] << 24 | (uint32_t)code[1] << 16 | (uint32_t)code[2] << 8 | (uint32_t)code[3]);
+}
+
+/// @brief Gets how many targets a tableswitch or lookupswitch has,
+/// counting the default one.
+static uint32_t getSwitchTargetCount(const uint8_t* code, uint32_t pc)
+{
+    uint32_t base = pc + 1 + (3 - pc % 4);
+
+    if (code[pc] == opcode_tableswitch)
+        return (uint32_t)(readS4(code + base + 8) - readS4(code + base + 4)) + 2;
+
+    return (uint32_t)readS4(code + base + 4) + 1;
+}
+
+static int64_t getSwitchTarget(const uint8_t* code, uint32_t pc, uint32_t index)
+{
+    uint32_t base = pc + 1 + (3 - pc % 4);
+
+    if (index == 0)
+        return (int64_t)pc + readS4(code + base);
+
+    if (code[pc] == opcode_tableswitch)
+        return (int64_t)pc + readS4(code + base + 12 + 4 * (index - 1));
+
+    return (int64_t)pc + readS4(code + base + 8 + 8 * (index - 1) + 4);
+}
+
+/// @brief Gets how many slots a field type or a method return
+/// type takes on the operand stack.
+static uint8_t getDescriptorSize(uint8_t c)
+{
+    if (c == 'V')
+        return 0;
+
+    return (c == 'J' || c == 'D') ? 2 : 1;
+}
+
+/// @brief Gets the descriptor of the field or method referenced by
+/// the constant pool entry at the given index.
+static cp_info* getReferenceDescriptor(JavaClass* jc, uint16_t index)
+{
+    if (index == 0 || index > jc->constantPoolCount)
+        return NULL;
+
+    cp_info* cpi = jc->constantPool + index - 1;
+    cpi = jc->constantPool + cpi->Methodref.name_and_type_index - 1;
+    return jc->constantPool + cpi->NameAndType.descriptor_index - 1;
+}
+
+/// @brief Gets how many operands an instruction pops from the stack
+/// and pushes to it, for instructions executed by escapes.
+/// @return 0 if the effect of the instruction isn't known.
+static uint8_t getStackEffect(JavaClass* jc, const uint8_t* code, uint32_t pc, uint16_t* outPops, uint16_t* outPushes)
+{
+    uint8_t opcode = code[pc];
+    uint16_t pops = 0, pushes = 0;
+    cp_info* descriptor;
+
+    switch (opcode)
+    {
+        case opcode_aconst_null: case opcode_ldc: case opcode_ldc_w:
+        case opcode_new:
+            pushes = 1;
+            break;
+
+        case opcode_ldc2_w:
+            pushes = 2;
+            break;
+
+        case opcode_iaload: case opcode_faload: case opcode_aaload:
+        case opcode_baload: case opcode_caload: case opcode_saload:
+        case opcode_fcmpl: case opcode_fcmpg: case opcode_frem:
+            pops = 2; pushes = 1;
+            break;
+
+        case opcode_laload: case opcode_daload:
+            pops = 2; pushes = 2;
+            break;
+
+        case opcode_iastore: case opcode_fastore: case opcode_aastore:
+        case opcode_bastore: case opcode_castore: case opcode_sastore:
+            pops = 3;
+            break;
+
+        case opcode_lastore: case opcode_dastore:
+            pops = 4;
+            break;
+
+        case opcode_dup_x1: pops = 2; pushes = 3; break;
+        case opcode_dup_x2: pops = 3; pushes = 4; break;
+        case opcode_dup2: pops = 2; pushes = 4; break;
+        case opcode_dup2_x1: pops = 3; pushes = 5; break;
+        case opcode_dup2_x2: pops = 4; pushes = 6; break;
+        case opcode_swap: pops = 2; pushes = 2; break;
+
+        case opcode_drem:
+            pops = 4; pushes = 2;
+            break;
+
+        case opcode_lshl: case opcode_lshr: case opcode_lushr:
+            pops = 3; pushes = 2;
+            break;
+
+        case opcode_i2l: case opcode_i2d: case opcode_f2l: case opcode_f2d:
+            pops = 1; pushes = 2;
+            break;
+
+        case opcode_i2f: case opcode_f2i: case opcode_i2b: case opcode_i2c: case opcode_i2s:
+        case opcode_newarray: case opcode_anewarray: case opcode_arraylength:
+        case opcode_checkcast: case opcode_instanceof:
+            pops = 1; pushes = 1;
+            break;
+
+        case opcode_l2i: case opcode_l2f: case opcode_d2i: case opcode_d2f:
+            pops = 2; pushes = 1;
+            break;
+
+        case opcode_l2d: case opcode_d2l:
+            pops = 2; pushes = 2;
+            break;
+
+        case opcode_lcmp: case opcode_dcmpl: case opcode_dcmpg:
+            pops = 4; pushes = 1;
+            break;
+
+        case opcode_tableswitch: case opcode_lookupswitch:
+        case opcode_ireturn: case opcode_freturn: case opcode_areturn:
+        case opcode_athrow: case opcode_monitorenter: case opcode_monitorexit:
+            pops = 1;
+            break;
+
+        case opcode_lreturn: case opcode_dreturn:
+            pops = 2;
+            break;
+
+        case opcode_return:
+            break;
+
+        case opcode_getstatic: case opcode_putstatic:
+        case opcode_getfield: case opcode_putfield:
+        {
+            descriptor = getReferenceDescriptor(jc, (uint16_t)(code[pc + 1] << 8 | code[pc + 2]));
+
+            if (!descriptor || descriptor->Utf8.length == 0)
+                return 0;
+
+            uint8_t size = getDescriptorSize(descriptor->Utf8.bytes[0]);
+
+            if (opcode == opcode_getstatic)
+                pushes = size;
+            else if (opcode == opcode_putstatic)
+                pops = size;
+            else if (opcode == opcode_getfield)
+                pops = 1, pushes = size;
+            else
+                pops = 1 + size;
+
+            break;
+        }
+
+        case opcode_invokevirtual: case opcode_invokespecial:
+        case opcode_invokestatic: case opcode_invokeinterface:
+        {
+            descriptor = getReferenceDescriptor(jc, (uint16_t)(code[pc + 1] << 8 | code[pc + 2]));
+
+            if (!descriptor)
+                return 0;
+
+            uint8_t* returnType = memchr(descriptor->Utf8.bytes, ')', descriptor->Utf8.length);
+
+            if (!returnType || returnType + 1 >= descriptor->Utf8.bytes + descriptor->Utf8.length)
+                return 0;
+
+            pops = getMethodDescriptorParameterCount(descriptor->Utf8.bytes, descriptor->Utf8.length);
+            pushes = getDescriptorSize(returnType[1]);
+
+            if (opcode != opcode_invokestatic)
+                pops++;
+
+            break;
+        }
+
+        case opcode_multianewarray:
+            pops = code[pc + 3];
+            pushes = 1;
+            break;
+
+        default:
+            return 0;
+    }
+
+    *outPops = pops;
+    *outPushes = pushes;
+    return 1;
+}
+
+static uint8_t translateEscape(Translator* t, uint32_t pc)
+{
+    uint16_t pops, pushes, index;
+    uint16_t depth = t->depth;
+
+    if (!getStackEffect(t->jc, t->code->code, pc, &pops, &pushes) ||
+        depth < pops || depth - pops + pushes > t->code->max_stack)
+    {
+        return 0;
+    }
+
+    if (!flushStack(t) || !emit(t, ir_escape, depth, depth - pops + pushes, 0, (int32_t)pc))
+        return 0;
+
+    t->depth = depth - pops;
+
+    for (index = 0; index < pushes; index++)
+        pushRegister(t, STACK_REGISTER(t, t->depth));
+
+    return 1;
+}
+
+/// @brief Finds the branch targets and exception handlers of a method.
+/// @return 0 if the code can't be translated.
+static uint8_t findTargets(Translator* t)
+{
+    const uint8_t* code = t->code->code;
+    uint32_t code_length = t->code->code_length;
+    uint32_t pc, length, index, count;
+    uint8_t opcode;
+
+    for (pc = 0; pc < code_length; pc += length)
+    {
+        length = getInstructionLength(code, pc, code_length);
+        opcode = code[pc];
+
+        if (length == 0)
+            return 0;
+
+        if ((opcode >= opcode_ifeq && opcode <= opcode_goto) ||
+            opcode == opcode_ifnull || opcode == opcode_ifnonnull)
+        {
+            int64_t target = (int64_t)pc + readS2(code + pc + 1);
+
+            if (target < 0 || target >= code_length)
+                return 0;
+
+            t->isTarget[target] = 1;
+        }
+        else if (opcode == opcode_goto_w)
+        {
+            int64_t target = (int64_t)pc + readS4(code + pc + 1);
+
+            if (target < 0 || target >= code_length)
+                return 0;
+
+            t->isTarget[target] = 1;
+        }
+        else if (opcode == opcode_tableswitch || opcode == opcode_lookupswitch)
+        {
+            count = getSwitchTargetCount(code, pc);
+
+            for (index = 0; index < count; index++)
+            {
+                int64_t target = getSwitchTarget(code, pc, index);
+
+                if (target < 0 || target >= code_length)
+                    return 0;
+
+                t->isTarget[target] = 1;
+            }
+        }
+    }
+
+    for (index = 0; index < t->code->exception_table_length; index++)
+    {
+        ExceptionTableEntry* entry = t->code->exception_table + index;
+
+        if (entry->handler_pc >= code_length)
+            return 0;
+
+        // The exception object is the only operand of a handler
+        t->isTarget[entry->handler_pc] = 1;
+        t->targetDepth[entry->handler_pc] = 1;
+    }
+
+    return 1;
+}
+
+static uint8_t getBranchOpcode(uint8_t opcode, uint8_t* outIROpcode, uint8_t* outOperandCount)
+{
+    if (opcode >= opcode_ifeq && opcode <= opcode_ifle)
+    {
+        *outIROpcode = ir_ifeq + (opcode - opcode_ifeq);
+        *outOperandCount = 1;
+    }
+    else if (opcode >= opcode_if_icmpeq && opcode <= opcode_if_icmple)
+    {
+        *outIROpcode = ir_if_icmpeq + (opcode - opcode_if_icmpeq);
+        *outOperandCount = 2;
+    }
+    else if (opcode == opcode_if_acmpeq || opcode == opcode_if_acmpne)
+    {
+        // References are compared as integers
+        *outIROpcode = opcode == opcode_if_acmpeq ? ir_if_icmpeq : ir_if_icmpne;
+        *outOperandCount = 2;
+    }
+    else if (opcode == opcode_ifnull || opcode == opcode_ifnonnull)
+    {
+        *outIROpcode = opcode == opcode_ifnull ? ir_ifeq : ir_ifne;
+        *outOperandCount = 1;
+    }
+    else if (opcode == opcode_goto || opcode == opcode_goto_w)
+    {
+        *outIROpcode = ir_goto;
+        *outOperandCount = 0;
+    }
+    else
+    {
+        return 0;
+    }
+
+    return 1;
+}
+
+/// @brief Gets the IR opcode of an arithmetic instruction.
+static uint8_t getArithmeticOpcode(uint8_t opcode, uint8_t* outIROpcode, uint8_t* outWidth, uint8_t* outOperandCount)
+{
+    // Bytecodes from iadd to ddiv come in groups of four:
+    // int, long, float and double.
+    static const uint8_t binaryOpcodes[] = {
+        ir_iadd, ir_ladd, ir_fadd, ir_dadd,
+        ir_isub, ir_lsub, ir_fsub, ir_dsub,
+        ir_imul, ir_lmul, ir_fmul, ir_dmul,
+        ir_idiv, ir_ldiv, ir_fdiv, ir_ddiv,
+        ir_irem, ir_lrem
+    };
+
+    static const uint8_t unaryOpcodes[] = { ir_ineg, ir_lneg, ir_fneg, ir_dneg };
+
+    *outOperandCount = 2;
+
+    if (opcode >= opcode_iadd && opcode <= opcode_lrem)
+    {
+        *outIROpcode = binaryOpcodes[opcode - opcode_iadd];
+        *outWidth = ((opcode - opcode_iadd) % 4) % 2 ? 2 : 1;
+        return 1;
+    }
+
+    if (opcode >= opcode_ineg && opcode <= opcode_dneg)
+    {
+        *outIROpcode = unaryOpcodes[opcode - opcode_ineg];
+        *outWidth = (opcode - opcode_ineg) % 2 ? 2 : 1;
+        *outOperandCount = 1;
+        return 1;
+    }
+
+    *outWidth = 1;
+
+    switch (opcode)
+    {
+        case opcode_ishl: *outIROpcode = ir_ishl; break;
+        case opcode_ishr: *outIROpcode = ir_ishr; break;
+        case opcode_iushr: *outIROpcode = ir_iushr; break;
+        case opcode_iand: *outIROpcode = ir_iand; break;
+        case opcode_ior: *outIROpcode = ir_ior; break;
+        case opcode_ixor: *outIROpcode = ir_ixor; break;
+        case opcode_land: *outIROpcode = ir_land; *outWidth = 2; break;
+        case opcode_lor: *outIROpcode = ir_lor; *outWidth = 2; break;
+        case opcode_lxor: *outIROpcode = ir_lxor; *outWidth = 2; break;
+        default: return 0;
+    }
+
+    return 1;
+}
+
+/// @brief Translates one bytecode instruction.
+/// @return 0 if the instruction can't be translated.
+static uint8_t translateInstruction(Translator* t, uint32_t pc, uint8_t* reachable)
+{
+    const uint8_t* code = t->code->code;
+    uint8_t opcode = code[pc];
+    uint8_t irOpcode, width, operandCount;
+    uint32_t index, count;
+
+    if (opcode >= opcode_iconst_m1 && opcode <= opcode_iconst_5)
+        return pushConstant(t, opcode - opcode_iconst_0);
+
+    if (opcode >= opcode_iload_0 && opcode <= opcode_aload_3)
+    {
+        index = (opcode - opcode_iload_0) / 4;
+        width = (index == 1 || index == 3) ? 2 : 1;
+        return translateLoad(t, (opcode - opcode_iload_0) % 4, width);
+    }
+
+    if (opcode >= opcode_istore_0 && opcode <= opcode_astore_3)
+    {
+        index = (opcode - opcode_istore_0) / 4;
+        width = (index == 1 || index == 3) ? 2 : 1;
+        return translateStore(t, (opcode - opcode_istore_0) % 4, width);
+    }
+
+    if (getArithmeticOpcode(opcode, &irOpcode, &width, &operandCount))
+        return translateArithmetic(t, irOpcode, width, operandCount);
+
+    if (getBranchOpcode(opcode, &irOpcode, &operandCount))
+    {
+        int64_t target = (int64_t)pc + (opcode == opcode_goto_w ? readS4(code + pc + 1) : readS2(code + pc + 1));
+
+        if (irOpcode == ir_goto)
+            *reachable = 0;
+
+        return translateBranch(t, irOpcode, operandCount, target);
+    }
+
+    switch (opcode)
+    {
+        case opcode_nop:
+            return 1;
+
+        case opcode_lconst_0: case opcode_lconst_1:
+            return pushConstant(t, opcode - opcode_lconst_0) && pushConstant(t, 0);
+
+        case opcode_fconst_0: return pushConstant(t, 0x00000000);
+        case opcode_fconst_1: return pushConstant(t, 0x3F800000);
+        case opcode_fconst_2: return pushConstant(t, 0x40000000);
+
+        case opcode_dconst_0: return pushConstant(t, 0x0000000000000000ll) && pushConstant(t, 0);
+        case opcode_dconst_1: return pushConstant(t, 0x3FF0000000000000ll) && pushConstant(t, 0);
+
+        case opcode_bipush: return pushConstant(t, (int8_t)code[pc + 1]);
+        case opcode_sipush: return pushConstant(t, readS2(code + pc + 1));
+
+        case opcode_iload: case opcode_fload: case opcode_aload:
+            return translateLoad(t, code[pc + 1], 1);
+
+        case opcode_lload: case opcode_dload:
+            return translateLoad(t, code[pc + 1], 2);
+
+        case opcode_istore: case opcode_fstore: case opcode_astore:
+            return translateStore(t, code[pc + 1], 1);
+
+        case opcode_lstore: case opcode_dstore:
+            return translateStore(t, code[pc + 1], 2);
+
+        case opcode_iinc:
+            return code[pc + 1] < t->code->max_locals &&
+                   materializeLocal(t, code[pc + 1], 1, t->depth) &&
+                   emit(t, ir_iinc, code[pc + 1], 0, 0, (int8_t)code[pc + 2]);
+
+        case opcode_pop:
+            if (t->depth < 1)
+                return 0;
+            t->depth--;
+            return 1;
+
+        case opcode_pop2:
+            if (t->depth < 2)
+                return 0;
+            t->depth -= 2;
+            return 1;
+
+        case opcode_dup:
+            if (t->depth < 1 || t->depth >= t->code->max_stack)
+                return 0;
+            t->stack[t->depth] = t->stack[t->depth - 1];
+            t->depth++;
+            return 1;
+
+        case opcode_tableswitch: case opcode_lookupswitch:
+            if (!translateEscape(t, pc))
+                return 0;
+
+            count = getSwitchTargetCount(code, pc);
+
+            for (index = 0; index < count; index++)
+            {
+                if (!recordTarget(t, getSwitchTarget(code, pc, index), t->depth))
+                    return 0;
+            }
+
+            *reachable = 0;
+            return 1;
+
+        case opcode_ireturn: case opcode_lreturn: case opcode_freturn:
+        case opcode_dreturn: case opcode_areturn: case opcode_return:
+        case opcode_athrow:
+            *reachable = 0;
+            return translateEscape(t, pc);
+
+        default:
+            return translateEscape(t, pc);
+    }
+}
+
+/// @brief Remaps the exception and line number tables of the Code
+/// attribute to IR indexes.
+static uint8_t remapTables(Translator* t)
+{
+    IRMethod* ir = t->ir;
+    att_Code_info* code = t->code;
+    uint32_t index, entry;
+
+    if (code->exception_table_length > 0)
+    {
+        ir->exception_table = (IRExceptionTableEntry*)malloc(code->exception_table_length * sizeof(IRExceptionTableEntry));
+
+        if (!ir->exception_table)
+            return 0;
+
+        for (index = 0; index < code->exception_table_length; index++)
+        {
+            ExceptionTableEntry* source = code->exception_table + index;
+            IRExceptionTableEntry* destination = ir->exception_table + index;
+
+            if (source->start_pc >= code->code_length || source->end_pc > code->code_length)
+                return 0;
+
+            destination->start = ir->pcMap[source->start_pc];
+            destination->end = source->end_pc == code->code_length ? ir->length : ir->pcMap[source->end_pc];
+            destination->handler = ir->pcMap[source->handler_pc];
+            destination->catch_type = source->catch_type;
+
+            if (destination->start == IR_NO_INDEX || destination->end == IR_NO_INDEX ||
+                destination->handler == IR_NO_INDEX)
+            {
+                return 0;
+            }
+        }
+
+        ir->exception_table_length = code->exception_table_length;
+    }
+
+    uint32_t lineCount = 0;
+
+    // Line numbers are decoded here, the first time they are needed,
+    // and invalid tables are ignored
+    for (index = 0; index < code->attributes_count; index++)
+    {
+        if (code->attributes[index].attributeType == ATTR_LineNumberTable &&
+            decodeAttribute(t->jc, code->attributes + index))
+            lineCount += ((att_LineNumberTable_info*)code->attributes[index].info)->line_number_table_length;
+    }
+
+    if (lineCount == 0 || lineCount > 0xFFFF)
+        return 1;
+
+    ir->line_number_table = (IRLineNumberTableEntry*)malloc(lineCount * sizeof(IRLineNumberTableEntry));
+
+    if (!ir->line_number_table)
+        return 0;
+
+    for (index = 0; index < code->attributes_count; index++)
+    {
+        if (code->attributes[index].attributeType != ATTR_LineNumberTable || !code->attributes[index].info)
+            continue;
+
+        att_LineNumberTable_info* lines = (att_LineNumberTable_info*)code->attributes[index].info;
+
+        for (entry = 0; entry < lines->line_number_table_length; entry++)
+        {
+            uint16_t start_pc = lines->line_number_table[entry].start_pc;
+
+            if (start_pc >= code->code_length || ir->pcMap[start_pc] == IR_NO_INDEX)
+                continue;
+
+            ir->line_number_table[ir->line_number_table_length].start = ir->pcMap[start_pc];
+            ir->line_number_table[ir->line_number_table_length].line_number = lines->line_number_table[entry].line_number;
+            ir->line_number_table_length++;
+        }
+    }
+
+    return 1;
+}
+
+/// @brief Translates the bytecode of a method into register IR.
+///
+/// @param JavaClass* jc - class the method belongs to.
+/// @param att_Code_info* code - the Code attribute of the method.
+///
+/// @return The translated method, or NULL if the method uses
+/// instructions that the translator doesn't support, in which
+/// case it should be executed by the bytecode interpreter.
+/// @see freeIRMethod()
+IRMethod* translateMethod(JavaClass* jc, att_Code_info* code)
+{
+    Translator t;
+    uint32_t pc, length;
+    uint8_t reachable = 1;
+    uint8_t success = 1;
+
+    if (code->code_length == 0)
+        return NULL;
+
+    t.jc = jc;
+    t.code = code;
+    t.capacity = 0;
+    t.depth = 0;
+    t.lastResult = IR_NO_INDEX;
+    t.lastResultWidth = 0;
+    t.ir = (IRMethod*)malloc(sizeof(IRMethod));
+    t.stack = (SymbolicSlot*)malloc((code->max_stack + 1) * sizeof(SymbolicSlot));
+    t.isTarget = (uint8_t*)malloc(code->code_length * sizeof(uint8_t));
+    t.targetDepth = (uint16_t*)malloc(code->code_length * sizeof(uint16_t));
+
+    if (t.ir)
+    {
+        t.ir->code = NULL;
+        t.ir->length = 0;
+        t.ir->code_length = code->code_length;
+        t.ir->pcMap = (uint32_t*)malloc(code->code_length * sizeof(uint32_t));
+        t.ir->exception_table = NULL;
+        t.ir->exception_table_length = 0;
+        t.ir->line_number_table = NULL;
+        t.ir->line_number_table_length = 0;
+    }
+
+    if (!t.ir || !t.ir->pcMap || !t.stack || !t.isTarget || !t.targetDepth)
+    {
+        success = 0;
+    }
+    else
+    {
+        memset(t.isTarget, 0, code->code_length * sizeof(uint8_t));
+
+        for (pc = 0; pc < code->code_length; pc++)
+        {
+            t.targetDepth[pc] = UNKNOWN_DEPTH;
+            t.ir->pcMap[pc] = IR_NO_INDEX;
+        }
+
+        success = findTargets(&t);
+    }
+
+    for (pc = 0; success && pc < code->code_length; pc += length)
+    {
+        length = getInstructionLength(code->code, pc, code->code_length);
+
+        if (t.isTarget[pc])
+        {
+            if (reachable)
+            {
+                success = flushStack(&t) && recordTarget(&t, pc, t.depth);
+            }
+            else if (t.targetDepth[pc] != UNKNOWN_DEPTH)
+            {
+                // Only reached by branches, which leave the
+                // stack in its registers
+                for (t.depth = 0; t.depth < t.targetDepth[pc]; t.depth++)
+                {
+                    t.stack[t.depth].reg = STACK_REGISTER(&t, t.depth);
+                    t.stack[t.depth].isConstant = 0;
+                }
+
+                reachable = 1;
+            }
+
+            t.lastResult = IR_NO_INDEX;
+        }
+
+        // Unreachable code, or a backward branch target only
+        // reached from below
+        if (!success || !reachable)
+        {
+            success = 0;
+            break;
+        }
+
+        t.ir->pcMap[pc] = t.ir->length;
+        success = translateInstruction(&t, pc, &reachable);
+    }
+
+    // Execution can't fall off the end of the code
+    if (success && reachable)
+        success = 0;
+
+    // Replace bytecode offsets by IR indexes in branches
+    for (pc = 0; success && pc < t.ir->length; pc++)
+    {
+        IRInstruction* instruction = t.ir->code + pc;
+
+        if (instruction->opcode >= ir_ifeq && instruction->opcode <= ir_goto)
+        {
+            instruction->immediate = t.ir->pcMap[instruction->immediate];
+            success = (uint32_t)instruction->immediate != IR_NO_INDEX;
+        }
+    }
+
+    if (success)
+        success = remapTables(&t);
+
+    if (t.stack)
+        free(t.stack);
+
+    if (t.isTarget)
+        free(t.isTarget);
+
+    if (t.targetDepth)
+        free(t.targetDepth);
+
+    if (!success && t.ir)
+    {
+        freeIRMethod(t.ir);
+        t.ir = NULL;
+    }
+
+    return t.ir;
+}
+
+void freeIRMethod(IRMethod* ir)
+{
+    if (ir->code)
+        free(ir->code);
+
+    if (ir->pcMap)
+        free(ir->pcMap);
+
+    if (ir->exception_table)
+        free(ir->exception_table);
+
+    if (ir->line_number_table)
+        free(ir->line_number_table);
+
+    free(ir);
+}
+
+/// @brief Frees the register IR of all methods of a class.
+void freeClassIR(JavaClass* jc)
+{
+    uint16_t index;
+    method_info* method;
+    attribute_info* codeAttribute;
+    att_Code_info* code;
+
+    for (index = 0; index < jc->methodCount; index++)
+    {
+        method = jc->methods + index;
+        codeAttribute = getAttributeByType(method->attributes, method->attributes_count, ATTR_Code);
+
+        // Methods whose code was never decoded have no IR
+        if (!codeAttribute || !codeAttribute->info)
+            continue;
+
+        code = (att_Code_info*)codeAttribute->info;
+
+        if (code->ir)
+        {
+            freeIRMethod(code->ir);
+            code->ir = NULL;
+        }
+    }
+}
+
+const char* getIROpcodeMnemonic(uint8_t opcode)
+{
+    static const char* mnemonics[] = {
+        "move", "const",
+        "iadd", "isub", "imul", "idiv", "irem",
+        "iand", "ior", "ixor", "ishl", "ishr", "iushr", "ineg",
+        "ladd", "lsub", "lmul", "ldiv", "lrem",
+        "land", "lor", "lxor", "lneg",
+        "fadd", "fsub", "fmul", "fdiv", "fneg",
+        "dadd", "dsub", "dmul", "ddiv", "dneg",
+        "iinc",
+        "ifeq", "ifne", "iflt", "ifge", "ifgt", "ifle",
+        "if_icmpeq", "if_icmpne", "if_icmplt", "if_icmpge", "if_icmpgt", "if_icmple",
+        "goto",
+        "escape"
+    };
+
+    if (opcode > ir_escape)
+        return "- unknown IR opcode -";
+
+    return mnemonics[opcode];
+}
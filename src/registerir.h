@@ -0,0 +1,123 @@
+#ifndef REGISTERIR_H
+#define REGISTERIR_H
+
+#include <stdint.h>
+#include "attributes.h"
+
+/// @brief Opcodes of the register IR.
+///
+/// Registers are indexes into the frame's register file: the
+/// local variables come first, followed by one register per
+/// operand stack slot. Long and double values use two
+/// consecutive registers, the whole value being held in the
+/// first one, so they are moved and computed as one register.
+enum IROpcodes {
+    ir_move, ir_const,
+
+    ir_iadd, ir_isub, ir_imul, ir_idiv, ir_irem,
+    ir_iand, ir_ior, ir_ixor, ir_ishl, ir_ishr, ir_iushr, ir_ineg,
+
+    ir_ladd, ir_lsub, ir_lmul, ir_ldiv, ir_lrem,
+    ir_land, ir_lor, ir_lxor, ir_lneg,
+
+    ir_fadd, ir_fsub, ir_fmul, ir_fdiv, ir_fneg,
+    ir_dadd, ir_dsub, ir_dmul, ir_ddiv, ir_dneg,
+
+    ir_iinc,
+
+    ir_ifeq, ir_ifne, ir_iflt, ir_ifge, ir_ifgt, ir_ifle,
+    ir_if_icmpeq, ir_if_icmpne, ir_if_icmplt, ir_if_icmpge, ir_if_icmpgt, ir_if_icmple,
+    ir_goto,
+
+    ir_escape
+};
+
+/// @brief A three-address instruction of the register IR.
+///
+/// Arithmetic instructions compute "a = b op c". Conditional
+/// branches compare "a" to zero or to "b" and jump to the IR
+/// index in "immediate". Constants and iinc increments are
+/// also held in "immediate".
+///
+/// Instructions without an IR equivalent are executed by an
+/// ir_escape, which calls the instruction function of the
+/// bytecode at offset "immediate" with "a" operands on the
+/// stack, leaving "b" operands on it.
+typedef struct
+{
+    uint8_t opcode;
+    uint16_t a, b, c;
+    int64_t immediate;
+} IRInstruction;
+
+typedef struct
+{
+    uint32_t start;
+    uint32_t end;
+    uint32_t handler;
+    uint16_t catch_type;
+} IRExceptionTableEntry;
+
+typedef struct
+{
+    uint32_t start;
+    uint16_t line_number;
+} IRLineNumberTableEntry;
+
+struct IRMethod
+{
+    IRInstruction* code;
+    uint32_t length;
+
+    // IR index of each bytecode instruction, indexed by its
+    // bytecode offset, or IR_NO_INDEX for offsets that aren't
+    // the start of an instruction.
+    uint32_t* pcMap;
+    uint32_t code_length;
+
+    // The exception and line number tables of the Code
+    // attribute, with offsets remapped to IR indexes.
+    IRExceptionTableEntry* exception_table;
+    uint16_t exception_table_length;
+    IRLineNumberTableEntry* line_number_table;
+    uint16_t line_number_table_length;
+};
+
+#define IR_NO_INDEX 0xFFFFFFFF
+
+#include "jvm.h"
+
+IRMethod* translateMethod(JavaClass* jc, att_Code_info* code);
+void freeIRMethod(IRMethod* ir);
+void freeClassIR(JavaClass* jc);
+const char* getIROpcodeMnemonic(uint8_t opcode);
+
+#endif // REGISTERIR_H
+
+/// @defgroup registerir Register IR module
+///
+/// @brief Translates stack bytecode into a register IR.
+///
+/// Stack bytecode spends most of its dispatches moving values
+/// between local variables and the operand stack: the sequence
+/// "iload_1 iload_2 iadd istore_3" becomes the single IR
+/// instruction "iadd 3, 1, 2".
+///
+/// The translator keeps a symbolic operand stack while it walks
+/// the bytecode. Loads and constants only push the register or
+/// constant they refer to, arithmetic reads its operands straight
+/// from those, and a store redirects the result of the instruction
+/// that computed it. Symbolic slots are written to their stack
+/// registers before branch targets, branches and escapes, so the
+/// operand stack is complete whenever control leaves straight-line
+/// code.
+///
+/// Because the stack registers are the frame's own operand stack,
+/// the interpreter can hand a frame back to the bytecode interpreter
+/// after any escape. Methods using jsr/ret, wide or unreachable code
+/// aren't translated and always run on the bytecode interpreter.
+///
+/// Translation is enabled with "-Xir" and happens the first time
+/// each method runs.
+///
+/// @see interpretIR()
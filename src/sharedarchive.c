@@ -0,0 +1,352 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "sharedarchive.h"
+#include "verifier.h"
+#include "memoryinspect.h"
+#include <string.h>
+#include <stdio.h>
+#include <sys/stat.h>
+
+static uint32_t hashClassName(const uint8_t* name, uint32_t length)
+{
+    uint32_t hash = 2166136261u;
+
+    while (length--)
+    {
+        hash ^= *name++;
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+static uint8_t isRangeValid(const SharedArchive* archive, uint32_t offset, uint32_t length)
+{
+    return offset <= archive->file.size && length <= archive->file.size - offset;
+}
+
+/// @brief Maps a shared archive and checks that it can be used.
+///
+/// @param SharedArchive* archive - receives the archive.
+/// @param const char* path - path of the archive file.
+/// @param uint8_t requireVerified - non-zero if the JVM verifies
+/// classes, in which case an archive dumped without verification
+/// can't be used.
+///
+/// @return 1 in case of success, 0 if the archive is missing,
+/// invalid or can't be used.
+/// @see closeSharedArchive()
+uint8_t openSharedArchive(SharedArchive* archive, const char* path, uint8_t requireVerified)
+{
+    const SharedArchiveHeader* header;
+    const SharedClassRecord* record;
+    uint32_t index;
+
+    archive->header = NULL;
+
+    if (!mapFile(&archive->file, path))
+        return 0;
+
+    header = (const SharedArchiveHeader*)archive->file.data;
+
+    if (archive->file.size < sizeof(SharedArchiveHeader) ||
+        memcmp(header->magic, SHARED_ARCHIVE_MAGIC, sizeof(header->magic)) ||
+        header->version != SHARED_ARCHIVE_VERSION ||
+        header->size != archive->file.size ||
+        (header->bucketCount & (header->bucketCount - 1)) ||
+        (requireVerified && !header->verified) ||
+        // Counts are bounded by the file size before any multiplication,
+        // which can't overflow then
+        header->classCount > (archive->file.size - sizeof(SharedArchiveHeader)) / sizeof(SharedClassRecord) ||
+        header->bucketCount > (archive->file.size - sizeof(SharedArchiveHeader) -
+                               header->classCount * sizeof(SharedClassRecord)) / sizeof(uint32_t))
+    {
+        unmapFile(&archive->file);
+        return 0;
+    }
+
+    archive->header = header;
+    archive->classes = (const SharedClassRecord*)(header + 1);
+    archive->buckets = (const uint32_t*)(archive->classes + header->classCount);
+
+    for (index = 0; index < header->classCount; index++)
+    {
+        record = archive->classes + index;
+
+        if (!isRangeValid(archive, record->nameOffset, record->nameLength) ||
+            !isRangeValid(archive, record->sourceOffset, record->sourceLength) ||
+            !isRangeValid(archive, record->dataOffset, record->dataSize) ||
+            !isRangeValid(archive, record->verifiedOffset, record->methodCount) ||
+            (record->next != SHARED_ARCHIVE_NO_CLASS && record->next >= header->classCount))
+        {
+            closeSharedArchive(archive);
+            return 0;
+        }
+    }
+
+    for (index = 0; index < header->bucketCount; index++)
+    {
+        if (archive->buckets[index] != SHARED_ARCHIVE_NO_CLASS && archive->buckets[index] >= header->classCount)
+        {
+            closeSharedArchive(archive);
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+void closeSharedArchive(SharedArchive* archive)
+{
+    unmapFile(&archive->file);
+    archive->header = NULL;
+}
+
+static const SharedClassRecord* findSharedClass(SharedArchive* archive, const uint8_t* name, uint32_t length)
+{
+    const SharedClassRecord* record;
+    uint32_t index;
+
+    if (!archive->header || archive->header->bucketCount == 0)
+        return NULL;
+
+    index = archive->buckets[hashClassName(name, length) & (archive->header->bucketCount - 1)];
+
+    while (index != SHARED_ARCHIVE_NO_CLASS)
+    {
+        record = archive->classes + index;
+
+        if (record->nameLength == length && !memcmp(archive->file.data + record->nameOffset, name, length))
+            return record;
+
+        index = record->next;
+    }
+
+    return NULL;
+}
+
+/// @brief Opens a class from the shared archive, if it is there and
+/// still matches the file the class path would load it from.
+///
+/// @param SharedArchive* archive - the archive.
+/// @param ClassPath* classPath - the class path of the JVM.
+/// @param JavaClass* jc - receives the class, parsed from the archive
+/// mapping, with the methods that passed verification flagged.
+/// @param const uint8_t* className_utf8_bytes - the class name.
+/// @param int32_t utf8_len - length of the class name.
+///
+/// @return 1 if the class was opened from the archive, 0 otherwise,
+/// in which case \c jc is left empty, to be opened from its file.
+uint8_t openClassFromArchive(SharedArchive* archive, ClassPath* classPath, JavaClass* jc, const uint8_t* className_utf8_bytes, int32_t utf8_len)
+{
+    const SharedClassRecord* record = findSharedClass(archive, className_utf8_bytes, (uint32_t)utf8_len);
+    char source[1024];
+    struct stat status;
+
+    if (!record || !getClassSource(classPath, className_utf8_bytes, utf8_len, source, sizeof(source)))
+        return 0;
+
+    if (strlen(source) != record->sourceLength ||
+        memcmp(source, archive->file.data + record->sourceOffset, record->sourceLength) ||
+        stat(source, &status) ||
+        (int64_t)status.st_mtime != record->sourceModificationTime ||
+        (uint64_t)status.st_size != record->sourceSize)
+    {
+        return 0;
+    }
+
+    // The hash is checked before the class is parsed without checks
+    initJavaClass(jc);
+    jc->file.data = archive->file.data + record->dataOffset;
+    jc->file.size = record->dataSize;
+
+    if (hashClassFile(jc) != record->dataHash)
+        return 0;
+
+    openClassData(jc, source, jc->file.data, jc->file.size, CLASS_FILE_BORROWED, 1);
+
+    if (jc->status != CLASS_STATUS_OK || jc->methodCount != record->methodCount)
+    {
+        closeClassFile(jc);
+        return 0;
+    }
+
+    // Methods are flagged when their code is decoded
+    jc->verifiedMethods = archive->file.data + record->verifiedOffset;
+    return 1;
+}
+
+static cp_info* getThisClassName(JavaClass* jc)
+{
+    cp_info* cpi = jc->constantPool + jc->thisClass - 1;
+    return jc->constantPool + cpi->Class.name_index - 1;
+}
+
+static uint8_t writeSharedArchive(FILE* file, const SharedArchiveHeader* header, const SharedClassRecord* records,
+                                  const uint32_t* buckets, JavaClass** classes, char** sources)
+{
+    uint32_t index;
+    uint16_t method;
+    uint8_t verified;
+    JavaClass* jc;
+    attribute_info* codeAttribute;
+
+    if (fwrite(header, sizeof(SharedArchiveHeader), 1, file) != 1 ||
+        fwrite(records, sizeof(SharedClassRecord), header->classCount, file) != header->classCount ||
+        fwrite(buckets, sizeof(uint32_t), header->bucketCount, file) != header->bucketCount)
+    {
+        return 0;
+    }
+
+    for (index = 0; index < header->classCount; index++)
+    {
+        jc = classes[index];
+
+        if (fwrite(getThisClassName(jc)->Utf8.bytes, 1, records[index].nameLength, file) != records[index].nameLength ||
+            fwrite(sources[index], 1, records[index].sourceLength, file) != records[index].sourceLength ||
+            fwrite(jc->file.data, 1, jc->file.size, file) != jc->file.size)
+        {
+            return 0;
+        }
+
+        for (method = 0; method < jc->methodCount; method++)
+        {
+            codeAttribute = getAttributeByType(jc->methods[method].attributes, jc->methods[method].attributes_count, ATTR_Code);
+            verified = codeAttribute && codeAttribute->info && ((att_Code_info*)codeAttribute->info)->verified;
+
+            if (fwrite(&verified, 1, 1, file) != 1)
+                return 0;
+        }
+    }
+
+    return 1;
+}
+
+/// @brief Writes all classes loaded by the JVM to a shared archive.
+///
+/// The class file bytes must be the ones that were read, so the JVM
+/// must not have fused instructions, which patches them in place.
+///
+/// @param JavaVirtualMachine* jvm - the JVM, after running the program.
+/// @param const char* path - path of the archive file.
+///
+/// @return 1 in case of success, 0 otherwise.
+/// @see openSharedArchive()
+uint8_t dumpSharedArchive(JavaVirtualMachine* jvm, const char* path)
+{
+    SharedArchiveHeader header;
+    SharedClassRecord* records;
+    SharedClassRecord* record;
+    JavaClass** classes;
+    char** sources;
+    uint32_t* buckets;
+    LoadedClasses* node;
+    cp_info* name;
+    struct stat status;
+    char source[1024];
+    uint32_t count = 0, index, bucket, offset;
+    uint8_t success = 0;
+    FILE* file;
+
+    for (node = jvm->classes; node; node = node->next)
+        count++;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SHARED_ARCHIVE_MAGIC, sizeof(header.magic));
+    header.version = SHARED_ARCHIVE_VERSION;
+    header.verified = jvm->verifyClasses;
+
+    for (header.bucketCount = 16; header.bucketCount < count * 2; header.bucketCount *= 2);
+
+    records = (SharedClassRecord*)malloc(sizeof(SharedClassRecord) * (count + 1));
+    classes = (JavaClass**)malloc(sizeof(JavaClass*) * (count + 1));
+    sources = (char**)malloc(sizeof(char*) * (count + 1));
+    buckets = (uint32_t*)malloc(sizeof(uint32_t) * header.bucketCount);
+
+    if (records && classes && sources && buckets)
+    {
+        // Only classes whose file the class path finds can be checked
+        // when the archive is used
+        for (node = jvm->classes; node; node = node->next)
+        {
+            name = getThisClassName(node->jc);
+
+            if (!getClassSource(&jvm->classPath, name->Utf8.bytes, name->Utf8.length, source, sizeof(source)) ||
+                stat(source, &status))
+            {
+                continue;
+            }
+
+            sources[header.classCount] = (char*)malloc(strlen(source) + 1);
+
+            if (!sources[header.classCount])
+                continue;
+
+            strcpy(sources[header.classCount], source);
+            classes[header.classCount] = node->jc;
+            records[header.classCount].sourceModificationTime = (int64_t)status.st_mtime;
+            records[header.classCount].sourceSize = (uint32_t)status.st_size;
+            header.classCount++;
+        }
+
+        for (index = 0; index < header.bucketCount; index++)
+            buckets[index] = SHARED_ARCHIVE_NO_CLASS;
+
+        // The records and hash chains are followed by the name,
+        // source, bytes and verification flags of each class
+        offset = sizeof(SharedArchiveHeader) + sizeof(SharedClassRecord) * header.classCount + sizeof(uint32_t) * header.bucketCount;
+
+        for (index = 0; index < header.classCount; index++)
+        {
+            record = records + index;
+            name = getThisClassName(classes[index]);
+
+            record->dataHash = hashClassFile(classes[index]);
+            record->nameOffset = offset;
+            record->nameLength = name->Utf8.length;
+            record->sourceOffset = record->nameOffset + record->nameLength;
+            record->sourceLength = (uint32_t)strlen(sources[index]);
+            record->dataOffset = record->sourceOffset + record->sourceLength;
+            record->dataSize = classes[index]->file.size;
+            record->verifiedOffset = record->dataOffset + record->dataSize;
+            record->methodCount = classes[index]->methodCount;
+            offset = record->verifiedOffset + record->methodCount;
+
+            bucket = hashClassName(name->Utf8.bytes, name->Utf8.length) & (header.bucketCount - 1);
+            record->next = buckets[bucket];
+            buckets[bucket] = index;
+        }
+
+        header.size = offset;
+        file = fopen(path, "wb");
+
+        if (file)
+        {
+            success = writeSharedArchive(file, &header, records, buckets, classes, sources);
+
+            if (fclose(file))
+                success = 0;
+        }
+    }
+
+    if (sources)
+    {
+        for (index = 0; index < header.classCount; index++)
+            free(sources[index]);
+
+        free(sources);
+    }
+
+    if (records)
+        free(records);
+
+    if (classes)
+        free(classes);
+
+    if (buckets)
+        free(buckets);
+
+    return success;
+}
@@ -0,0 +1,108 @@
+#ifndef SHAREDARCHIVE_H
+#define SHAREDARCHIVE_H
+
+#include <stdint.h>
+#include "mappedfile.h"
+
+#define SHARED_ARCHIVE_MAGIC "JVMSHARE"
+#define SHARED_ARCHIVE_VERSION 1
+#define SHARED_ARCHIVE_NO_CLASS 0xFFFFFFFF
+
+/// @brief How the JVM uses the shared archive, set with "-Xshare:<mode>".
+enum SharedArchiveMode {
+    SHARE_OFF,
+    SHARE_AUTO,
+    SHARE_ON,
+    SHARE_DUMP
+};
+
+/// @brief Start of a shared archive file.
+///
+/// All offsets in the archive are relative to its start, so it can
+/// be mapped anywhere.
+typedef struct SharedArchiveHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t size;
+    uint32_t classCount;
+
+    // Power of two number of hash chains of classes by name
+    uint32_t bucketCount;
+
+    // Whether the classes were verified when the archive was dumped
+    uint8_t verified;
+    uint8_t padding[7];
+} SharedArchiveHeader;
+
+/// @brief A class in a shared archive.
+typedef struct SharedClassRecord
+{
+    // FNV-1a hash of the class file bytes
+    uint64_t dataHash;
+
+    // The file the class was loaded from, a class file or a jar,
+    // which must still be where the class path finds the class,
+    // with the same modification time and size.
+    int64_t sourceModificationTime;
+    uint32_t sourceSize;
+    uint32_t sourceOffset;
+    uint32_t sourceLength;
+
+    uint32_t nameOffset;
+    uint32_t nameLength;
+
+    // The class file bytes, as they were read
+    uint32_t dataOffset;
+    uint32_t dataSize;
+
+    // One byte per method, telling if it passed verification
+    uint32_t verifiedOffset;
+    uint32_t methodCount;
+
+    // Next class in the same hash chain
+    uint32_t next;
+} SharedClassRecord;
+
+typedef struct SharedArchive
+{
+    MappedFile file;
+    const SharedArchiveHeader* header;
+    const SharedClassRecord* classes;
+    const uint32_t* buckets;
+} SharedArchive;
+
+#include "jvm.h"
+
+uint8_t openSharedArchive(SharedArchive* archive, const char* path, uint8_t requireVerified);
+void closeSharedArchive(SharedArchive* archive);
+uint8_t openClassFromArchive(SharedArchive* archive, ClassPath* classPath, JavaClass* jc, const uint8_t* className_utf8_bytes, int32_t utf8_len);
+uint8_t dumpSharedArchive(JavaVirtualMachine* jvm, const char* path);
+
+#endif // SHAREDARCHIVE_H
+
+/// @defgroup sharedarchive Shared archive module
+///
+/// @brief Saves the classes loaded by a run, so later runs can use
+/// them without validating or verifying them again.
+///
+/// "-Xshare:dump" writes every class loaded by the program to the
+/// archive when it ends. "-Xshare:auto" and "-Xshare:on" map the
+/// archive at startup, and classes found in it are parsed straight
+/// from the mapping, skipping the constant pool checks and the
+/// verifier. When the archive is missing or invalid, or its classes
+/// weren't verified while verification is on, "-Xshare:auto" runs
+/// without it and "-Xshare:on" exits with status 1. "-Xsharedarchive:<file>"
+/// chooses the archive file, "classes.jsa" by default.
+///
+/// A class is only used from the archive if the class path still
+/// finds it in the same file, with the same modification time and
+/// size, and its bytes match the hash recorded when it was dumped.
+/// Otherwise it is loaded from its file as usual.
+///
+/// The archive holds the class file bytes rather than the parsed
+/// structures, as those are full of pointers; parsing from memory
+/// is cheap compared to the checks it saves. It is meant for the
+/// machine that dumped it, and isn't portable across byte orders.
+///
+/// @see dumpSharedArchive(), openClassFromArchive()
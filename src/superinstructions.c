@@ -0,0 +1,577 @@
+#include "superinstructions.h"
+#include "memoryinspect.h"
+#include <string.h>
+#include <inttypes.h>
+
+/// @brief Maximum number of instructions fused by a superinstruction.
+#define SUPERINSTRUCTION_MAX_LENGTH 4
+
+typedef struct SuperinstructionInfo
+{
+    const char* mnemonic;
+    uint8_t length;
+    uint8_t components[SUPERINSTRUCTION_MAX_LENGTH];
+} SuperinstructionInfo;
+
+static const SuperinstructionInfo superinstructions[] = {
+    #define SUPERINSTRUCTION_2(a, b) { #a " " #b, 2, { opcode_##a, opcode_##b } },
+    #define SUPERINSTRUCTION_3(a, b, c) { #a " " #b " " #c, 3, { opcode_##a, opcode_##b, opcode_##c } },
+    #define SUPERINSTRUCTION_4(a, b, c, d) { #a " " #b " " #c " " #d, 4, { opcode_##a, opcode_##b, opcode_##c, opcode_##d } },
+    #include "superinstructions.def"
+    #undef SUPERINSTRUCTION_2
+    #undef SUPERINSTRUCTION_3
+    #undef SUPERINSTRUCTION_4
+};
+
+// There are only 51 unassigned opcodes between breakpoint and impdep1.
+typedef char superinstruction_opcodes_must_fit[(int)opcode_superinstruction_end <= (int)opcode_impdep1 ? 1 : -1];
+
+/// @brief Tells whether an instruction can be fused with others.
+///
+/// @param uint8_t opcode - the instruction to be checked.
+/// @param uint8_t isLast - boolean telling if the instruction would be
+/// the last one of the superinstruction.
+///
+/// Instructions that transfer control (branches and returns) can only be the
+/// last instruction of a superinstruction, since the instructions after them
+/// might not be the next ones to execute. Instructions that read or change the
+/// pc in other ways, or that have variable length, are never fused.
+static uint8_t canBeFused(uint8_t opcode, uint8_t isLast)
+{
+    switch (opcode)
+    {
+        case opcode_jsr: case opcode_jsr_w: case opcode_ret:
+        case opcode_tableswitch: case opcode_lookupswitch:
+        case opcode_wide: case opcode_athrow:
+        case opcode_invokeinterface: case opcode_invokedynamic:
+            return 0;
+
+        case opcode_goto: case opcode_goto_w:
+        case opcode_ifnull: case opcode_ifnonnull:
+        case opcode_ireturn: case opcode_lreturn: case opcode_freturn:
+        case opcode_dreturn: case opcode_areturn: case opcode_return:
+            return isLast;
+
+        default:
+            break;
+    }
+
+    if (opcode >= opcode_ifeq && opcode <= opcode_if_acmpne)
+        return isLast;
+
+    return opcode <= opcode_jsr_w;
+}
+
+/// @brief Rewrites the bytecode of a method, replacing instruction
+/// sequences listed in superinstructions.def with superinstructions.
+///
+/// @param JavaVirtualMachine* jvm - the JVM the method will be run by.
+/// @param att_Code_info* code - the Code attribute of the method.
+///
+/// Only the opcode of the first instruction of each sequence is replaced,
+/// so offsets of instructions, branch targets and exception tables remain
+/// valid. When more than one superinstruction matches at the same offset,
+/// the longest one is chosen.
+///
+/// @return 1 if the bytecode could be decoded, 0 otherwise. In case of
+/// failure, the bytecode is left untouched.
+uint8_t predecodeMethod(JavaVirtualMachine* jvm, att_Code_info* code)
+{
+    uint32_t* offsets = (uint32_t*)malloc(code->code_length * sizeof(uint32_t));
+    uint32_t instructionCount = 0;
+    uint32_t pc = 0;
+    uint32_t length;
+
+    if (!offsets)
+        return 0;
+
+    // The offset of every instruction is needed before any opcode is
+    // rewritten, as superinstructions can't be decoded on their own.
+    while (pc < code->code_length)
+    {
+        length = getInstructionLength(code->code, pc, code->code_length);
+
+        if (length == 0)
+        {
+            free(offsets);
+            return 0;
+        }
+
+        offsets[instructionCount++] = pc;
+        pc += length;
+    }
+
+    uint32_t index;
+    uint8_t super, component;
+    uint8_t bestMatch, bestLength;
+    const SuperinstructionInfo* info;
+
+    for (index = 0; index < instructionCount; index++)
+    {
+        bestMatch = 0;
+        bestLength = 0;
+
+        for (super = 0; super < SUPERINSTRUCTION_COUNT; super++)
+        {
+            info = superinstructions + super;
+
+            if (info->length <= bestLength || index + info->length > instructionCount)
+                continue;
+
+            for (component = 0; component < info->length; component++)
+            {
+                if (code->code[offsets[index + component]] != info->components[component])
+                    break;
+            }
+
+            if (component == info->length)
+            {
+                bestMatch = opcode_superinstruction_base + 1 + super;
+                bestLength = info->length;
+            }
+        }
+
+        if (bestMatch)
+        {
+            code->code[offsets[index]] = bestMatch;
+            jvm->superinstructionSites++;
+        }
+    }
+
+    free(offsets);
+    return 1;
+}
+
+uint8_t isSuperinstruction(uint8_t opcode)
+{
+    return opcode > opcode_superinstruction_base && opcode < opcode_superinstruction_end;
+}
+
+/// @brief Gets the original instructions fused by a superinstruction.
+///
+/// @param uint8_t opcode - opcode of the superinstruction.
+/// @param uint8_t* outComponents - pointer to an array with at least 4
+/// elements that will receive the opcodes of the fused instructions.
+///
+/// @return The number of fused instructions, or zero if \c opcode isn't
+/// a superinstruction.
+uint8_t getSuperinstructionComponents(uint8_t opcode, uint8_t* outComponents)
+{
+    if (!isSuperinstruction(opcode))
+        return 0;
+
+    const SuperinstructionInfo* info = superinstructions + SUPERINSTRUCTION_INDEX(opcode);
+
+    memcpy(outComponents, info->components, info->length);
+    return info->length;
+}
+
+const char* getSuperinstructionMnemonic(uint8_t opcode)
+{
+    if (!isSuperinstruction(opcode))
+        return getOpcodeMnemonic(opcode);
+
+    return superinstructions[SUPERINSTRUCTION_INDEX(opcode)].mnemonic;
+}
+
+/// @brief Execution counters for each offset of a method's bytecode.
+typedef struct ExecutionCounters
+{
+    uint8_t* code;
+    uint32_t code_length;
+    uint32_t* counters;
+    struct ExecutionCounters* next;
+} ExecutionCounters;
+
+/// @brief How many times an instruction sequence was executed.
+typedef struct Ngram
+{
+    uint64_t count;
+    uint8_t length;
+    uint8_t opcodes[SUPERINSTRUCTION_MAX_LENGTH];
+} Ngram;
+
+struct NgramProfile
+{
+    /// @brief File where the profile is merged into.
+    char* path;
+
+    /// @brief Counters of all methods executed so far.
+    ExecutionCounters* methods;
+
+    /// @brief Hash table used to aggregate the n-grams.
+    Ngram* ngrams;
+    uint32_t capacity;
+    uint32_t ngramCount;
+};
+
+/// @brief Creates an empty n-gram profile, that will be merged
+/// into the file \c path when saved.
+/// @see saveNgramProfile(), freeNgramProfile()
+NgramProfile* newNgramProfile(const char* path)
+{
+    NgramProfile* profile = (NgramProfile*)malloc(sizeof(NgramProfile));
+
+    if (!profile)
+        return NULL;
+
+    profile->path = (char*)malloc(strlen(path) + 1);
+    profile->methods = NULL;
+    profile->ngrams = NULL;
+    profile->capacity = 0;
+    profile->ngramCount = 0;
+
+    if (!profile->path)
+    {
+        free(profile);
+        return NULL;
+    }
+
+    strcpy(profile->path, path);
+    return profile;
+}
+
+void freeNgramProfile(NgramProfile* profile)
+{
+    ExecutionCounters* node = profile->methods;
+    ExecutionCounters* tmp;
+
+    while (node)
+    {
+        tmp = node;
+        node = node->next;
+        free(tmp->counters);
+        free(tmp);
+    }
+
+    if (profile->ngrams)
+        free(profile->ngrams);
+
+    free(profile->path);
+    free(profile);
+}
+
+/// @brief Gets the array that counts how many times each offset of
+/// a method's bytecode was executed, creating it if needed.
+///
+/// @return Pointer to an array with \c code_length counters, or
+/// NULL if there is no memory available.
+uint32_t* getExecutionCounters(NgramProfile* profile, uint8_t* code, uint32_t code_length)
+{
+    ExecutionCounters* node;
+
+    for (node = profile->methods; node; node = node->next)
+    {
+        if (node->code == code)
+            return node->counters;
+    }
+
+    node = (ExecutionCounters*)malloc(sizeof(ExecutionCounters));
+
+    if (!node)
+        return NULL;
+
+    node->counters = (uint32_t*)malloc(code_length * sizeof(uint32_t));
+
+    if (!node->counters)
+    {
+        free(node);
+        return NULL;
+    }
+
+    memset(node->counters, 0, code_length * sizeof(uint32_t));
+
+    node->code = code;
+    node->code_length = code_length;
+    node->next = profile->methods;
+    profile->methods = node;
+
+    return node->counters;
+}
+
+static uint32_t hashNgram(const uint8_t* opcodes, uint8_t length)
+{
+    uint32_t hash = 2166136261u;
+
+    while (length-- > 0)
+        hash = (hash ^ *opcodes++) * 16777619u;
+
+    return hash;
+}
+
+static uint8_t addNgram(NgramProfile* profile, const uint8_t* opcodes, uint8_t length, uint64_t count)
+{
+    uint32_t index;
+    Ngram* ngram;
+
+    if (profile->ngramCount * 2 >= profile->capacity)
+    {
+        uint32_t oldCapacity = profile->capacity;
+        Ngram* oldNgrams = profile->ngrams;
+
+        profile->capacity = oldCapacity ? oldCapacity * 2 : 256;
+        profile->ngrams = (Ngram*)malloc(profile->capacity * sizeof(Ngram));
+        profile->ngramCount = 0;
+
+        if (!profile->ngrams)
+        {
+            profile->ngrams = oldNgrams;
+            profile->capacity = oldCapacity;
+            return 0;
+        }
+
+        memset(profile->ngrams, 0, profile->capacity * sizeof(Ngram));
+
+        for (index = 0; index < oldCapacity; index++)
+        {
+            if (oldNgrams[index].length)
+                addNgram(profile, oldNgrams[index].opcodes, oldNgrams[index].length, oldNgrams[index].count);
+        }
+
+        if (oldNgrams)
+            free(oldNgrams);
+    }
+
+    index = hashNgram(opcodes, length) & (profile->capacity - 1);
+
+    while (1)
+    {
+        ngram = profile->ngrams + index;
+
+        if (ngram->length == 0)
+        {
+            ngram->length = length;
+            memcpy(ngram->opcodes, opcodes, length);
+            ngram->count = count;
+            profile->ngramCount++;
+            return 1;
+        }
+
+        if (ngram->length == length && !memcmp(ngram->opcodes, opcodes, length))
+        {
+            ngram->count += count;
+            return 1;
+        }
+
+        index = (index + 1) & (profile->capacity - 1);
+    }
+}
+
+/// @brief Adds to the profile all sequences of instructions that could be
+/// fused, weighted by how many times their first instruction was executed.
+///
+/// Since only the last instruction of a fusable sequence can transfer control,
+/// every time the first instruction is executed, the whole sequence is too.
+static uint8_t countMethodNgrams(NgramProfile* profile, ExecutionCounters* method)
+{
+    uint32_t pc, next, count;
+    uint32_t length;
+    uint8_t opcodes[SUPERINSTRUCTION_MAX_LENGTH];
+    uint8_t ngramLength;
+
+    for (pc = 0; pc < method->code_length; pc += length)
+    {
+        length = getInstructionLength(method->code, pc, method->code_length);
+
+        if (length == 0)
+            return 0;
+
+        count = method->counters[pc];
+
+        if (count == 0)
+            continue;
+
+        next = pc;
+
+        for (ngramLength = 0; ngramLength < SUPERINSTRUCTION_MAX_LENGTH && next < method->code_length; ngramLength++)
+        {
+            opcodes[ngramLength] = method->code[next];
+
+            if (!canBeFused(opcodes[ngramLength], 1))
+                break;
+
+            if (ngramLength > 0 && !addNgram(profile, opcodes, ngramLength + 1, count))
+                return 0;
+
+            if (!canBeFused(opcodes[ngramLength], 0))
+                break;
+
+            next += getInstructionLength(method->code, next, method->code_length);
+        }
+    }
+
+    return 1;
+}
+
+static uint8_t getOpcodeByMnemonic(const char* mnemonic, size_t length, uint8_t* outOpcode)
+{
+    uint16_t opcode;
+    const char* name;
+
+    for (opcode = opcode_nop; opcode <= opcode_jsr_w; opcode++)
+    {
+        name = getOpcodeMnemonic((uint8_t)opcode);
+
+        if (strlen(name) == length && !strncmp(name, mnemonic, length))
+        {
+            *outOpcode = (uint8_t)opcode;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/// @brief Reads the n-grams of a profile file saved by a previous run,
+/// so the counts of this run can be added to them.
+static uint8_t loadNgramProfile(NgramProfile* profile)
+{
+    FILE* file = fopen(profile->path, "r");
+    char line[256];
+    char* token;
+    uint64_t count;
+    uint8_t opcodes[SUPERINSTRUCTION_MAX_LENGTH];
+    uint8_t length;
+
+    // It isn't an error if the profile doesn't exist yet
+    if (!file)
+        return 1;
+
+    while (fgets(line, sizeof(line), file))
+    {
+        if (line[0] == '#' || sscanf(line, "%" SCNu64, &count) != 1)
+            continue;
+
+        // Skip count and length columns
+        token = strchr(line, '\t');
+        token = token ? strchr(token + 1, '\t') : NULL;
+
+        for (length = 0; token && length < SUPERINSTRUCTION_MAX_LENGTH; length++)
+        {
+            token += strspn(token, " \t");
+
+            size_t tokenLength = strcspn(token, " \t\r\n");
+
+            if (tokenLength == 0 || !getOpcodeByMnemonic(token, tokenLength, opcodes + length))
+                break;
+
+            token += tokenLength;
+        }
+
+        if (length >= 2 && !addNgram(profile, opcodes, length, count))
+        {
+            fclose(file);
+            return 0;
+        }
+    }
+
+    fclose(file);
+    return 1;
+}
+
+static int compareNgramCounts(const void* a, const void* b)
+{
+    const Ngram* ngram1 = (const Ngram*)a;
+    const Ngram* ngram2 = (const Ngram*)b;
+
+    if (ngram1->count != ngram2->count)
+        return ngram1->count < ngram2->count ? 1 : -1;
+
+    return (int)ngram2->length - (int)ngram1->length;
+}
+
+/// @brief Merges the n-grams executed during this run into the profile file.
+///
+/// The file lists one n-gram per line, sorted by execution count, as
+/// "count<TAB>length<TAB>mnemonics". Counts of n-grams already in the
+/// file are added to the counts of this run, so a single profile can be
+/// built by running many programs.
+///
+/// @return 1 if the file could be written, 0 otherwise.
+uint8_t saveNgramProfile(NgramProfile* profile)
+{
+    ExecutionCounters* method;
+    uint32_t index;
+    uint8_t component;
+
+    if (!loadNgramProfile(profile))
+        return 0;
+
+    for (method = profile->methods; method; method = method->next)
+    {
+        if (!countMethodNgrams(profile, method))
+            return 0;
+    }
+
+    FILE* file = fopen(profile->path, "w");
+
+    if (!file)
+        return 0;
+
+    // Compact the hash table and sort it
+    uint32_t ngramCount = 0;
+
+    for (index = 0; index < profile->capacity; index++)
+    {
+        if (profile->ngrams[index].length)
+            profile->ngrams[ngramCount++] = profile->ngrams[index];
+    }
+
+    qsort(profile->ngrams, ngramCount, sizeof(Ngram), compareNgramCounts);
+
+    fprintf(file, "# Bytecode n-gram execution profile\n");
+    fprintf(file, "# count\tlength\tinstructions\n");
+
+    for (index = 0; index < ngramCount; index++)
+    {
+        fprintf(file, "%" PRIu64 "\t%u\t", profile->ngrams[index].count, profile->ngrams[index].length);
+
+        for (component = 0; component < profile->ngrams[index].length; component++)
+            fprintf(file, component ? " %s" : "%s", getOpcodeMnemonic(profile->ngrams[index].opcodes[component]));
+
+        fprintf(file, "\n");
+    }
+
+    // The table is no longer a valid hash table
+    free(profile->ngrams);
+    profile->ngrams = NULL;
+    profile->capacity = 0;
+    profile->ngramCount = 0;
+
+    fclose(file);
+    return 1;
+}
+
+/// @brief Prints to stderr how many dispatches superinstructions
+/// saved during the execution of a program.
+void printDispatchReport(JavaVirtualMachine* jvm, const char* programName)
+{
+    uint64_t saved = 0;
+    uint8_t index;
+
+    for (index = 0; index < SUPERINSTRUCTION_COUNT; index++)
+        saved += jvm->superinstructionCount[index] * (superinstructions[index].length - 1);
+
+    uint64_t executed = jvm->dispatchCount + saved;
+
+    fprintf(stderr, "\nDispatch report for %s\n", programName);
+    fprintf(stderr, "  superinstruction sites:  %u\n", jvm->superinstructionSites);
+    fprintf(stderr, "  instructions executed:   %" PRIu64 "\n", executed);
+    fprintf(stderr, "  dispatches:              %" PRIu64 "\n", jvm->dispatchCount);
+    fprintf(stderr, "  dispatches saved:        %" PRIu64 " (%.2f%%)\n", saved, executed ? 100.0 * saved / executed : 0.0);
+
+    if (saved == 0)
+        return;
+
+    fprintf(stderr, "\n  %-40s %12s %12s\n", "Superinstruction", "Executions", "Saved");
+
+    for (index = 0; index < SUPERINSTRUCTION_COUNT; index++)
+    {
+        if (jvm->superinstructionCount[index] == 0)
+            continue;
+
+        fprintf(stderr, "  %-40s %12" PRIu64 " %12" PRIu64 "\n", superinstructions[index].mnemonic,
+                jvm->superinstructionCount[index],
+                jvm->superinstructionCount[index] * (superinstructions[index].length - 1));
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef SUPERINSTRUCTIONS_H
+#define SUPERINSTRUCTIONS_H
+
+typedef struct NgramProfile NgramProfile;
+
+#include <stdint.h>
+#include "opcodes.h"
+
+/// @brief Opcodes of the superinstructions listed in superinstructions.def.
+///
+/// Superinstructions use the opcodes that the JVM specification leaves
+/// unassigned, starting right after \c opcode_breakpoint. They never
+/// appear in class files, only in bytecode rewritten by the predecoder.
+enum Superinstructions {
+    opcode_superinstruction_base = opcode_breakpoint,
+
+    #define SUPERINSTRUCTION_2(a, b) opcode_##a##_##b,
+    #define SUPERINSTRUCTION_3(a, b, c) opcode_##a##_##b##_##c,
+    #define SUPERINSTRUCTION_4(a, b, c, d) opcode_##a##_##b##_##c##_##d,
+    #include "superinstructions.def"
+    #undef SUPERINSTRUCTION_2
+    #undef SUPERINSTRUCTION_3
+    #undef SUPERINSTRUCTION_4
+
+    opcode_superinstruction_end
+};
+
+#define SUPERINSTRUCTION_COUNT (opcode_superinstruction_end - opcode_superinstruction_base - 1)
+#define SUPERINSTRUCTION_INDEX(opcode) ((opcode) - opcode_superinstruction_base - 1)
+
+#include "jvm.h"
+
+uint8_t predecodeMethod(JavaVirtualMachine* jvm, att_Code_info* code);
+uint8_t isSuperinstruction(uint8_t opcode);
+uint8_t getSuperinstructionComponents(uint8_t opcode, uint8_t* outComponents);
+const char* getSuperinstructionMnemonic(uint8_t opcode);
+
+NgramProfile* newNgramProfile(const char* path);
+void freeNgramProfile(NgramProfile* profile);
+uint32_t* getExecutionCounters(NgramProfile* profile, uint8_t* code, uint32_t code_length);
+uint8_t saveNgramProfile(NgramProfile* profile);
+
+void printDispatchReport(JavaVirtualMachine* jvm, const char* programName);
+
+#endif // SUPERINSTRUCTIONS_H
+
+/// @defgroup superinstructions Superinstructions module
+///
+/// @brief Fuses common instruction sequences into single dispatches.
+///
+/// Sequences like "iload_1 iload_2 iadd istore_3" or "aload_0 getfield"
+/// cost one dispatch per instruction. The predecoder replaces the first
+/// opcode of such sequences with a superinstruction the first time a
+/// method runs, and the superinstruction executes the whole sequence at once.
+/// Only that first byte is rewritten, so branches into the middle of a
+/// fused sequence still find the original instructions there.
+///
+/// The set of superinstructions is listed in superinstructions.def, which
+/// is generated from an n-gram profile of the programs we run: the JVM
+/// records it with "-Xngrams:<file>" and tools/supergen.c turns it into
+/// the list (see the "superinstructions" target in the makefile).
+///
+/// @see superinstructions.c
@@ -0,0 +1,250 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "threads.h"
+#include "memoryinspect.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <time.h>
+#include <signal.h>
+#include <sched.h>
+#endif
+
+void initMutex(Mutex* mutex)
+{
+#ifdef _WIN32
+    InitializeCriticalSection(mutex);
+#else
+    pthread_mutex_init(mutex, NULL);
+#endif
+}
+
+void lockMutex(Mutex* mutex)
+{
+#ifdef _WIN32
+    EnterCriticalSection(mutex);
+#else
+    pthread_mutex_lock(mutex);
+#endif
+}
+
+void unlockMutex(Mutex* mutex)
+{
+#ifdef _WIN32
+    LeaveCriticalSection(mutex);
+#else
+    pthread_mutex_unlock(mutex);
+#endif
+}
+
+void destroyMutex(Mutex* mutex)
+{
+#ifdef _WIN32
+    DeleteCriticalSection(mutex);
+#else
+    pthread_mutex_destroy(mutex);
+#endif
+}
+
+void initCondition(Condition* condition)
+{
+#ifdef _WIN32
+    InitializeConditionVariable(condition);
+#else
+    pthread_cond_init(condition, NULL);
+#endif
+}
+
+/// @brief Releases the mutex and waits until the condition is
+/// signaled, then locks the mutex again.
+/// @note The wait can end without a signal, so the caller must
+/// check what it is waiting for in a loop.
+void waitCondition(Condition* condition, Mutex* mutex)
+{
+#ifdef _WIN32
+    SleepConditionVariableCS(condition, mutex, INFINITE);
+#else
+    pthread_cond_wait(condition, mutex);
+#endif
+}
+
+void signalCondition(Condition* condition)
+{
+#ifdef _WIN32
+    WakeConditionVariable(condition);
+#else
+    pthread_cond_signal(condition);
+#endif
+}
+
+void broadcastCondition(Condition* condition)
+{
+#ifdef _WIN32
+    WakeAllConditionVariable(condition);
+#else
+    pthread_cond_broadcast(condition);
+#endif
+}
+
+void destroyCondition(Condition* condition)
+{
+#ifndef _WIN32
+    pthread_cond_destroy(condition);
+#endif
+}
+
+typedef struct ThreadStart
+{
+    ThreadFunction function;
+    void* argument;
+} ThreadStart;
+
+#ifdef _WIN32
+static DWORD WINAPI runThread(LPVOID parameter)
+#else
+static void* runThread(void* parameter)
+#endif
+{
+    ThreadStart start = *(ThreadStart*)parameter;
+
+    free(parameter);
+    start.function(start.argument);
+    return 0;
+}
+
+/// @brief Starts a thread, which doesn't receive signals.
+///
+/// @param Thread* thread - receives the thread, which must be
+/// joined with joinThread().
+/// @param ThreadFunction function - function run by the thread.
+/// @param void* argument - argument given to the function.
+///
+/// @return 1 if the thread was started, 0 otherwise.
+uint8_t startThread(Thread* thread, ThreadFunction function, void* argument)
+{
+    ThreadStart* start = (ThreadStart*)malloc(sizeof(ThreadStart));
+
+    if (!start)
+        return 0;
+
+    start->function = function;
+    start->argument = argument;
+
+#ifdef _WIN32
+    *thread = CreateThread(NULL, 0, runThread, start, 0, NULL);
+
+    if (*thread)
+        return 1;
+#else
+    sigset_t allSignals, previousSignals;
+    int failed;
+
+    // The thread inherits the signal mask, so signals such as the
+    // SIGPROF of the sampler are only delivered to the JVM thread
+    sigfillset(&allSignals);
+    pthread_sigmask(SIG_SETMASK, &allSignals, &previousSignals);
+    failed = pthread_create(thread, NULL, runThread, start);
+    pthread_sigmask(SIG_SETMASK, &previousSignals, NULL);
+
+    if (!failed)
+        return 1;
+#endif
+
+    free(start);
+    return 0;
+}
+
+/// @brief Waits for a thread to end and releases it.
+void joinThread(Thread thread)
+{
+#ifdef _WIN32
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+#else
+    pthread_join(thread, NULL);
+#endif
+}
+
+/// @brief Suspends the calling thread for some milliseconds, or only
+/// lets other threads run if \c milliseconds is 0.
+void sleepThread(uint32_t milliseconds)
+{
+#ifdef _WIN32
+    if (milliseconds)
+        Sleep(milliseconds);
+    else
+        SwitchToThread();
+#else
+    struct timespec duration;
+
+    if (!milliseconds)
+    {
+        sched_yield();
+        return;
+    }
+
+    duration.tv_sec = milliseconds / 1000;
+    duration.tv_nsec = (long)(milliseconds % 1000) * 1000000;
+    nanosleep(&duration, NULL);
+#endif
+}
+
+#ifdef _WIN32
+static BOOL CALLBACK runOnceCallback(PINIT_ONCE once, PVOID parameter, PVOID* context)
+{
+    ((void (*)(void))parameter)();
+    return TRUE;
+}
+#endif
+
+/// @brief Calls a function once, even if several threads get here
+/// at the same time. Those threads wait until the call returns.
+/// @param Once* once - flag initialized with ONCE_INIT.
+/// @param void (*function)(void) - the function.
+void runOnce(Once* once, void (*function)(void))
+{
+#ifdef _WIN32
+    InitOnceExecuteOnce(once, runOnceCallback, (PVOID)function, NULL);
+#else
+    pthread_once(once, function);
+#endif
+}
+
+/// @brief Gets the number of processors available to the process.
+/// @return The number of processors, at least 1.
+uint32_t getProcessorCount(void)
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? info.dwNumberOfProcessors : 1;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return count > 0 ? (uint32_t)count : 1;
+#endif
+}
+
+/// @brief Gets the time elapsed since an arbitrary point, in milliseconds.
+///
+/// Unlike clock(), which adds up the processor time of every thread,
+/// this is wall clock time, so it can measure a program that runs
+/// class loader workers.
+double getMonotonicTime(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER counter, frequency;
+
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+    return (double)counter.QuadPart * 1000.0 / (double)frequency.QuadPart;
+#else
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec * 1000.0 + (double)now.tv_nsec / 1000000.0;
+#endif
+}
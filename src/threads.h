@@ -0,0 +1,92 @@
+#ifndef THREADS_H
+#define THREADS_H
+
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <windows.h>
+
+typedef CRITICAL_SECTION Mutex;
+typedef CONDITION_VARIABLE Condition;
+typedef HANDLE Thread;
+typedef INIT_ONCE Once;
+
+#define ONCE_INIT INIT_ONCE_STATIC_INIT
+#else
+#include <pthread.h>
+
+typedef pthread_mutex_t Mutex;
+typedef pthread_cond_t Condition;
+typedef pthread_t Thread;
+typedef pthread_once_t Once;
+
+#define ONCE_INIT PTHREAD_ONCE_INIT
+#endif
+
+typedef void (*ThreadFunction)(void* argument);
+
+/// @brief Keeps the compiler from moving memory accesses across this
+/// point, so that a signal handler interrupting the thread sees them
+/// in program order.
+#if defined(_MSC_VER)
+#define SIGNAL_FENCE() _ReadWriteBarrier()
+#else
+#define SIGNAL_FENCE() __atomic_signal_fence(__ATOMIC_SEQ_CST)
+#endif
+
+/// @brief Reads a value written by another thread with storeRelease(),
+/// seeing everything that thread wrote before it.
+static inline uint32_t loadAcquire(const uint32_t* pointer)
+{
+#if defined(_MSC_VER)
+    uint32_t value = *(const volatile uint32_t*)pointer;
+    _ReadWriteBarrier();
+    return value;
+#else
+    return __atomic_load_n(pointer, __ATOMIC_ACQUIRE);
+#endif
+}
+
+/// @brief Writes a value for another thread to read with loadAcquire(),
+/// after everything this thread wrote before it.
+static inline void storeRelease(uint32_t* pointer, uint32_t value)
+{
+#if defined(_MSC_VER)
+    _ReadWriteBarrier();
+    *(volatile uint32_t*)pointer = value;
+#else
+    __atomic_store_n(pointer, value, __ATOMIC_RELEASE);
+#endif
+}
+
+void initMutex(Mutex* mutex);
+void lockMutex(Mutex* mutex);
+void unlockMutex(Mutex* mutex);
+void destroyMutex(Mutex* mutex);
+
+void initCondition(Condition* condition);
+void waitCondition(Condition* condition, Mutex* mutex);
+void signalCondition(Condition* condition);
+void broadcastCondition(Condition* condition);
+void destroyCondition(Condition* condition);
+
+uint8_t startThread(Thread* thread, ThreadFunction function, void* argument);
+void joinThread(Thread thread);
+void sleepThread(uint32_t milliseconds);
+
+void runOnce(Once* once, void (*function)(void));
+uint32_t getProcessorCount(void);
+double getMonotonicTime(void);
+
+#endif // THREADS_H
+
+/// @defgroup threads Threads module
+///
+/// @brief Mutexes, condition variables and threads, using POSIX
+/// threads or the Windows API.
+///
+/// Java threads aren't supported. Threads are only used inside the
+/// JVM, by the class loader workers, see @ref classprefetch, and by
+/// the trace writer, see @ref trace.
+///
+/// @see startThread()
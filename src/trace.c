@@ -0,0 +1,363 @@
+#include "trace.h"
+#include "memoryinspect.h"
+#include <string.h>
+#include <stdarg.h>
+
+#define TRACE_BUFFER_MASK (TRACE_BUFFER_EVENTS - 1)
+
+// Milliseconds the writer sleeps when the buffer is empty
+#define TRACE_WRITER_SLEEP 1
+
+static const char* categoryNames[] = {
+    "class", "resolve", "invoke", "alloc", "instruction"
+};
+
+/// @brief Reads a comma separated list of category names, such as
+/// "class,invoke", or "all".
+///
+/// @return The categories, from enum TraceCategory, or 0 if a name
+/// isn't known.
+uint32_t parseTraceCategories(const char* list)
+{
+    uint32_t categories = 0;
+    uint32_t index;
+    size_t length;
+
+    while (*list)
+    {
+        length = strcspn(list, ",");
+
+        if (length == 3 && !strncmp(list, "all", 3))
+        {
+            categories |= TRACE_ALL;
+        }
+        else
+        {
+            for (index = 0; index < sizeof(categoryNames) / sizeof(categoryNames[0]); index++)
+            {
+                if (strlen(categoryNames[index]) == length && !strncmp(list, categoryNames[index], length))
+                    break;
+            }
+
+            if (index == sizeof(categoryNames) / sizeof(categoryNames[0]))
+                return 0;
+
+            categories |= 1u << index;
+        }
+
+        list += length;
+
+        if (*list == ',')
+            list++;
+    }
+
+    return categories;
+}
+
+static const char* getCategoryName(uint32_t category)
+{
+    uint32_t index = 0;
+
+    while (category > 1)
+    {
+        category >>= 1;
+        index++;
+    }
+
+    return categoryNames[index];
+}
+
+/// @brief Creates a tracer, which records nothing until started.
+///
+/// @param const char* path - file the events are written to, or a
+/// null pointer to write them to stderr.
+/// @param uint32_t categories - categories recorded, from enum
+/// TraceCategory.
+///
+/// @return The tracer, to be freed with freeTracer(), or NULL if there
+/// is not enough memory or the file can't be created.
+Tracer* newTracer(const char* path, uint32_t categories)
+{
+    Tracer* tracer = (Tracer*)malloc(sizeof(Tracer));
+
+    if (!tracer)
+        return NULL;
+
+    memset(tracer, 0, sizeof(Tracer));
+    tracer->categories = categories;
+    tracer->startTime = getMonotonicTime();
+    tracer->events = (TraceEvent*)malloc(TRACE_BUFFER_EVENTS * sizeof(TraceEvent));
+    tracer->file = path ? fopen(path, "w") : stderr;
+
+    if (!tracer->events || !tracer->file)
+    {
+        if (tracer->file && tracer->file != stderr)
+            fclose(tracer->file);
+
+        free(tracer->events);
+        free(tracer);
+        return NULL;
+    }
+
+    return tracer;
+}
+
+/// @brief Writes the events added up to \c head and frees their slots.
+static void writeTraceEvents(Tracer* tracer, uint32_t head)
+{
+    TraceEvent* event;
+
+    while (tracer->tail != head)
+    {
+        event = tracer->events + (tracer->tail & TRACE_BUFFER_MASK);
+        fprintf(tracer->file, "%12.3f %-11s %s\n", event->time, getCategoryName(event->category), event->text);
+
+        // Frees the slot right away, in case the JVM thread waits
+        storeRelease(&tracer->tail, tracer->tail + 1);
+    }
+}
+
+static void runTraceWriter(void* argument)
+{
+    Tracer* tracer = (Tracer*)argument;
+    uint32_t stopping, head;
+
+    while (1)
+    {
+        // Read before head, so no event added before stopping is missed
+        stopping = loadAcquire(&tracer->stopping);
+        head = loadAcquire(&tracer->head);
+
+        if (tracer->tail != head)
+        {
+            writeTraceEvents(tracer, head);
+        }
+        else if (stopping)
+        {
+            break;
+        }
+        else
+        {
+            fflush(tracer->file);
+            sleepThread(TRACE_WRITER_SLEEP);
+        }
+    }
+
+    fflush(tracer->file);
+}
+
+/// @brief Starts the thread that writes the events.
+///
+/// If the thread can't be started, events are written by the JVM
+/// thread whenever the buffer fills up, and when the tracer stops.
+///
+/// @return 1 if the writer thread is running, 0 otherwise.
+uint8_t startTracer(Tracer* tracer)
+{
+    if (!tracer->writerRunning)
+        tracer->writerRunning = startThread(&tracer->writer, runTraceWriter, tracer);
+
+    return tracer->writerRunning;
+}
+
+/// @brief Writes the events left in the buffer and stops the writer
+/// thread. Events added afterwards are written by the JVM thread.
+void stopTracer(Tracer* tracer)
+{
+    if (tracer->writerRunning)
+    {
+        storeRelease(&tracer->stopping, 1);
+        joinThread(tracer->writer);
+        tracer->writerRunning = 0;
+    }
+
+    writeTraceEvents(tracer, tracer->head);
+
+    if (tracer->waitCount)
+    {
+        fprintf(tracer->file, "Trace buffer was full %u times\n", tracer->waitCount);
+        tracer->waitCount = 0;
+    }
+
+    fflush(tracer->file);
+}
+
+void freeTracer(Tracer* tracer)
+{
+    stopTracer(tracer);
+
+    if (tracer->file != stderr)
+        fclose(tracer->file);
+
+    free(tracer->events);
+    free(tracer);
+}
+
+/// @brief Only traces the methods matching a pattern, along with those
+/// of the other filters added.
+///
+/// @param const char* pattern - matched against "Class.method", where
+/// '*' matches any text. The string must outlive the tracer.
+///
+/// @return 0 if there are already TRACE_MAX_FILTERS filters, 1 otherwise.
+uint8_t addTraceFilter(Tracer* tracer, const char* pattern)
+{
+    if (tracer->filterCount == TRACE_MAX_FILTERS)
+        return 0;
+
+    tracer->filters[tracer->filterCount++] = pattern;
+    return 1;
+}
+
+static uint8_t matchPattern(const char* pattern, const char* text)
+{
+    while (*pattern)
+    {
+        if (*pattern == '*')
+        {
+            // Tries every length for the '*', shortest first
+            do {
+                if (matchPattern(pattern + 1, text))
+                    return 1;
+            } while (*text++);
+
+            return 0;
+        }
+
+        if (*pattern != *text)
+            return 0;
+
+        pattern++;
+        text++;
+    }
+
+    return *text == '\0';
+}
+
+static uint8_t matchTraceFilters(Tracer* tracer, JavaClass* jc, method_info* method)
+{
+    cp_info* className = jc->constantPool + jc->thisClass - 1;
+    cp_info* methodName = jc->constantPool + method->name_index - 1;
+    char name[256];
+    uint32_t index;
+
+    className = jc->constantPool + className->Class.name_index - 1;
+    snprintf(name, sizeof(name), "%.*s.%.*s", (int)className->Utf8.length, className->Utf8.bytes,
+             (int)methodName->Utf8.length, methodName->Utf8.bytes);
+
+    for (index = 0; index < tracer->filterCount; index++)
+    {
+        if (matchPattern(tracer->filters[index], name))
+            return 1;
+    }
+
+    return 0;
+}
+
+/// @brief Tells if a method matches the filters of the tracer, which
+/// is decided once per method and kept in its Code attribute.
+///
+/// @return 1 if there are no filters or the method matches one of
+/// them, 0 otherwise.
+uint8_t isMethodTraced(Tracer* tracer, JavaClass* jc, method_info* method)
+{
+    att_Code_info* code;
+
+    if (!tracer->filterCount)
+        return 1;
+
+    code = getMethodCode(jc, method);
+
+    // Native methods have no attribute to keep it in
+    if (!code)
+        return matchTraceFilters(tracer, jc, method);
+
+    if (!code->traced)
+        code->traced = matchTraceFilters(tracer, jc, method) ? 1 : 2;
+
+    return code->traced == 1;
+}
+
+/// @brief Takes the next slot of the ring buffer for an event, whose
+/// text is then written with appendTraceText().
+///
+/// If the buffer is full, waits for the writer thread to make room,
+/// so no event is lost. The event is only seen by the writer once
+/// commitTraceEvent() is called.
+///
+/// @return The event, with an empty text.
+TraceEvent* beginTraceEvent(Tracer* tracer, uint32_t category)
+{
+    TraceEvent* event;
+
+    if (tracer->head - loadAcquire(&tracer->tail) == TRACE_BUFFER_EVENTS)
+    {
+        tracer->waitCount++;
+
+        if (!tracer->writerRunning)
+            writeTraceEvents(tracer, tracer->head);
+
+        while (tracer->head - loadAcquire(&tracer->tail) == TRACE_BUFFER_EVENTS)
+            sleepThread(0);
+    }
+
+    event = tracer->events + (tracer->head & TRACE_BUFFER_MASK);
+    event->time = getMonotonicTime() - tracer->startTime;
+    event->category = category;
+    event->length = 0;
+    event->text[0] = '\0';
+    return event;
+}
+
+void appendTraceText(TraceEvent* event, const char* format, ...)
+{
+    va_list arguments;
+    int written;
+
+    if (event->length >= TRACE_TEXT_SIZE - 1)
+        return;
+
+    va_start(arguments, format);
+    written = vsnprintf(event->text + event->length, TRACE_TEXT_SIZE - event->length, format, arguments);
+    va_end(arguments);
+
+    if (written > 0)
+        event->length += (uint32_t)written;
+
+    if (event->length > TRACE_TEXT_SIZE - 1)
+        event->length = TRACE_TEXT_SIZE - 1;
+}
+
+/// @brief Appends "Class.method(descriptor)" to the text of an event.
+void appendTraceMethod(TraceEvent* event, JavaClass* jc, method_info* method)
+{
+    cp_info* className = jc->constantPool + jc->thisClass - 1;
+    cp_info* methodName = jc->constantPool + method->name_index - 1;
+    cp_info* descriptor = jc->constantPool + method->descriptor_index - 1;
+
+    className = jc->constantPool + className->Class.name_index - 1;
+    appendTraceText(event, "%.*s.%.*s%.*s", (int)className->Utf8.length, className->Utf8.bytes,
+                    (int)methodName->Utf8.length, methodName->Utf8.bytes,
+                    (int)descriptor->Utf8.length, descriptor->Utf8.bytes);
+}
+
+/// @brief Hands the event taken by beginTraceEvent() to the writer.
+void commitTraceEvent(Tracer* tracer)
+{
+    storeRelease(&tracer->head, tracer->head + 1);
+}
+
+/// @brief Records an event whose text is a single formatted string.
+void traceEvent(Tracer* tracer, uint32_t category, const char* format, ...)
+{
+    TraceEvent* event = beginTraceEvent(tracer, category);
+    va_list arguments;
+    int written;
+
+    va_start(arguments, format);
+    written = vsnprintf(event->text, TRACE_TEXT_SIZE, format, arguments);
+    va_end(arguments);
+
+    event->length = written < 0 ? 0 : written < TRACE_TEXT_SIZE ? (uint32_t)written : TRACE_TEXT_SIZE - 1;
+    commitTraceEvent(tracer);
+}
@@ -0,0 +1,117 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+typedef struct Tracer Tracer;
+
+#include <stdio.h>
+#include <stdint.h>
+#include "framestack.h"
+#include "threads.h"
+
+enum TraceCategory {
+    TRACE_CLASS = 1,
+    TRACE_RESOLVE = 2,
+    TRACE_INVOKE = 4,
+    TRACE_ALLOC = 8,
+    TRACE_INSTRUCTION = 16,
+    TRACE_ALL = 31
+};
+
+// Events held by the ring buffer, a power of two
+#define TRACE_BUFFER_EVENTS 4096
+#define TRACE_TEXT_SIZE 240
+#define TRACE_MAX_FILTERS 16
+
+/// @brief An event waiting in the ring buffer to be written.
+typedef struct TraceEvent
+{
+    // Milliseconds since the tracer was created
+    double time;
+    uint32_t category;
+
+    // Length of the text, which is cut at TRACE_TEXT_SIZE - 1 bytes
+    uint32_t length;
+    char text[TRACE_TEXT_SIZE];
+} TraceEvent;
+
+struct Tracer
+{
+    // Categories of the events recorded, from enum TraceCategory
+    uint32_t categories;
+
+    // Patterns of the methods traced, matched against "Class.method",
+    // where '*' matches any text. No filter traces every method.
+    const char* filters[TRACE_MAX_FILTERS];
+    uint32_t filterCount;
+
+    FILE* file;
+    double startTime;
+
+    // Ring buffer. The JVM thread is the only one that adds events,
+    // advancing head, and the writer thread the only one that removes
+    // them, advancing tail. Both only grow, wrapping around.
+    TraceEvent* events;
+    uint32_t head;
+    uint32_t tail;
+
+    // Times the JVM thread found the buffer full and had to wait
+    uint32_t waitCount;
+
+    Thread writer;
+    uint8_t writerRunning;
+    uint32_t stopping;
+};
+
+/// @brief Tells if events of a category are recorded, given the frames
+/// running. With method filters, events are only recorded while a
+/// traced method is on top of the frame stack.
+static inline uint8_t isTracing(Tracer* tracer, FrameStack* frames, uint32_t category)
+{
+    return tracer && (tracer->categories & category) &&
+           (!tracer->filterCount || (frames && frames->frame->traced));
+}
+
+#define TRACING(jvm, category) isTracing((jvm)->tracer, (jvm)->frames, (category))
+
+uint32_t parseTraceCategories(const char* list);
+Tracer* newTracer(const char* path, uint32_t categories);
+void freeTracer(Tracer* tracer);
+uint8_t addTraceFilter(Tracer* tracer, const char* pattern);
+uint8_t startTracer(Tracer* tracer);
+void stopTracer(Tracer* tracer);
+uint8_t isMethodTraced(Tracer* tracer, JavaClass* jc, method_info* method);
+
+TraceEvent* beginTraceEvent(Tracer* tracer, uint32_t category);
+void appendTraceText(TraceEvent* event, const char* format, ...);
+void appendTraceMethod(TraceEvent* event, JavaClass* jc, method_info* method);
+void commitTraceEvent(Tracer* tracer);
+void traceEvent(Tracer* tracer, uint32_t category, const char* format, ...);
+
+#endif // TRACE_H
+
+/// @defgroup trace Trace module
+///
+/// @brief Records what the JVM does, selected when it starts.
+///
+/// "-Xtrace:<categories>" takes a comma separated list of "class"
+/// (classes loaded and methods linked), "resolve" (method and field
+/// references), "invoke" (methods entered and left), "alloc" (objects,
+/// arrays and strings created) and "instruction" (every instruction,
+/// with the operand stack and local variables), or "all".
+/// "-Xtracemethod:<pattern>", which can be repeated, only records the
+/// events raised while a matching method runs, such as "Fibonacci.*"
+/// or "*.main". Invokes are recorded by the method entered. Events go
+/// to stderr, or to the file given by "-Xtracefile:<file>".
+///
+/// Events are formatted into a ring buffer by the JVM thread and
+/// written by a thread of their own, so the interpreter never waits
+/// for the file unless the buffer fills up. The buffer is lock-free,
+/// as each index is advanced by a single thread. Without "-Xtrace",
+/// each trace point tests a null pointer, and the interpreter only
+/// tests a local variable per instruction. Whether a method matches
+/// the filters is decided the first time it runs.
+///
+/// Events are only raised by the JVM thread: class loader workers
+/// don't trace, and their classes are traced when resolved.
+///
+/// @see TRACING(), beginTraceEvent(), startTracer()
@@ -0,0 +1,1119 @@
+#include "typemap.h"
+#include "opcodes.h"
+#include "memoryinspect.h"
+#include <string.h>
+
+typedef struct
+{
+    JavaClass* jc;
+    att_Code_info* code;
+    MethodTypes* types;
+
+    // Bytecode offset of each state.
+    uint32_t* statePc;
+
+    // Whether each state has been reached, whether it changed
+    // since its instruction was last analyzed, and whether it
+    // comes from the StackMapTable, in which case merges can't
+    // change it.
+    uint8_t* reached;
+    uint8_t* changed;
+    uint8_t* declared;
+    uint32_t pending;
+
+    // State being transformed by the current instruction, and
+    // the state received by exception handlers.
+    uint8_t* current;
+    uint16_t depth;
+    uint8_t* handlerState;
+} Analyzer;
+
+#define STATE(a, index) ((a)->types->types + (size_t)(index) * (a)->types->slotCount)
+#define STACK(a) ((a)->current + (a)->types->max_locals)
+
+static int32_t readS2(const uint8_t* code)
+{
+    return (int16_t)(code[0] << 8 | code[1]);
+}
+
+static int32_t readS4(const uint8_t* code)
+{
+    return (int32_t)((uint32_t)code[0] << 24 | (uint32_t)code[1] << 16 | (uint32_t)code[2] << 8 | (uint32_t)code[3]);
+}
+
+static uint8_t isWideType(uint8_t type)
+{
+    return type == OP_LONG || type == OP_DOUBLE;
+}
+
+/// @brief Gets the type of a value from the first character of
+/// its field descriptor.
+/// @return OP_TOP for 'V' and unknown characters.
+static uint8_t getDescriptorType(uint8_t c)
+{
+    switch (c)
+    {
+        case 'B': case 'C': case 'I': case 'S': case 'Z':
+            return OP_INTEGER;
+
+        case 'F': return OP_FLOAT;
+        case 'J': return OP_LONG;
+        case 'D': return OP_DOUBLE;
+
+        case 'L': case '[':
+            return OP_REFERENCE;
+
+        default:
+            break;
+    }
+
+    return OP_TOP;
+}
+
+static uint8_t mergeType(uint8_t type1, uint8_t type2)
+{
+    if (type1 == type2)
+        return type1;
+
+    if ((type1 == OP_NULL && type2 == OP_REFERENCE) ||
+        (type1 == OP_REFERENCE && type2 == OP_NULL))
+    {
+        return OP_REFERENCE;
+    }
+
+    return OP_TOP;
+}
+
+/// @brief Merges a state into the state of the instruction at
+/// the given offset, scheduling it to be analyzed again if it
+/// changed.
+/// @return 0 if the offset isn't the start of an instruction, if
+/// the stack depths don't match, or if the state can't be assigned
+/// to a state declared by the StackMapTable.
+static uint8_t mergeInto(Analyzer* a, int64_t pc, const uint8_t* state, uint16_t depth)
+{
+    MethodTypes* types = a->types;
+
+    if (pc < 0 || pc >= types->code_length || types->stateIndex[pc] == TYPEMAP_NO_STATE)
+        return 0;
+
+    uint32_t index = types->stateIndex[pc];
+    uint8_t* target = STATE(a, index);
+    uint16_t slot, slotCount = types->max_locals + depth;
+
+    if (!a->reached[index])
+    {
+        memcpy(target, state, slotCount);
+        memset(target + slotCount, OP_TOP, types->slotCount - slotCount);
+        types->stackDepth[index] = depth;
+        a->reached[index] = 1;
+        a->changed[index] = 1;
+        a->pending++;
+        return 1;
+    }
+
+    if (types->stackDepth[index] != depth)
+        return 0;
+
+    // Frames from the StackMapTable aren't merged: every state
+    // reaching them must be assignable to the declared types
+    if (a->declared[index])
+    {
+        for (slot = 0; slot < slotCount; slot++)
+        {
+            if (target[slot] != OP_TOP && target[slot] != state[slot] &&
+                !(target[slot] == OP_REFERENCE && state[slot] == OP_NULL))
+            {
+                return 0;
+            }
+        }
+
+        return 1;
+    }
+
+    for (slot = 0; slot < slotCount; slot++)
+    {
+        uint8_t merged = mergeType(target[slot], state[slot]);
+
+        if (merged != target[slot])
+        {
+            target[slot] = merged;
+
+            if (!a->changed[index])
+            {
+                a->changed[index] = 1;
+                a->pending++;
+            }
+        }
+    }
+
+    return 1;
+}
+
+/// @brief Merges the locals of the current state, with a reference
+/// to the exception on the stack, into the handlers covering the
+/// instruction at the given offset.
+static uint8_t mergeIntoHandlers(Analyzer* a, uint32_t pc)
+{
+    uint16_t index;
+    uint16_t max_locals = a->types->max_locals;
+
+    for (index = 0; index < a->code->exception_table_length; index++)
+    {
+        ExceptionTableEntry* entry = a->code->exception_table + index;
+
+        if (pc < entry->start_pc || pc >= entry->end_pc)
+            continue;
+
+        if (a->code->max_stack == 0)
+            return 0;
+
+        memcpy(a->handlerState, a->current, max_locals);
+        a->handlerState[max_locals] = OP_REFERENCE;
+
+        if (!mergeInto(a, entry->handler_pc, a->handlerState, 1))
+            return 0;
+    }
+
+    return 1;
+}
+
+static uint8_t push(Analyzer* a, uint8_t type)
+{
+    if (a->depth >= a->code->max_stack)
+        return 0;
+
+    STACK(a)[a->depth++] = type;
+    return 1;
+}
+
+/// @brief Pushes a value, taking two slots if it is a long or a double.
+static uint8_t pushValue(Analyzer* a, uint8_t type)
+{
+    if (!push(a, type))
+        return 0;
+
+    return isWideType(type) ? push(a, OP_TOP) : 1;
+}
+
+static uint8_t pop(Analyzer* a, uint16_t count)
+{
+    if (a->depth < count)
+        return 0;
+
+    a->depth -= count;
+    return 1;
+}
+
+/// @brief Pops the operands of an instruction and pushes its result,
+/// which can be OP_TOP for instructions without a result.
+static uint8_t popPush(Analyzer* a, uint16_t pops, uint8_t type)
+{
+    if (!pop(a, pops))
+        return 0;
+
+    return type == OP_TOP ? 1 : pushValue(a, type);
+}
+
+/// @brief Writes the type of a local variable. Writing to the second
+/// slot of a long or double value makes the first slot unusable.
+static uint8_t setLocal(Analyzer* a, uint16_t index, uint8_t type)
+{
+    uint16_t width = isWideType(type) ? 2 : 1;
+
+    if (index + width > a->types->max_locals)
+        return 0;
+
+    if (index > 0 && isWideType(a->current[index - 1]))
+        a->current[index - 1] = OP_TOP;
+
+    a->current[index] = type;
+
+    if (width == 2)
+        a->current[index + 1] = OP_TOP;
+
+    return 1;
+}
+
+static uint8_t load(Analyzer* a, uint16_t index, uint8_t type)
+{
+    if (index >= a->types->max_locals)
+        return 0;
+
+    // Keep null references as they are, references of any other
+    // type make the loaded value a reference.
+    if (type == OP_REFERENCE && a->current[index] == OP_NULL)
+        type = OP_NULL;
+
+    return pushValue(a, type);
+}
+
+static uint8_t store(Analyzer* a, uint16_t index, uint8_t type)
+{
+    uint16_t width = isWideType(type) ? 2 : 1;
+
+    if (!pop(a, width))
+        return 0;
+
+    if (type == OP_REFERENCE && STACK(a)[a->depth] == OP_NULL)
+        type = OP_NULL;
+
+    return setLocal(a, index, type);
+}
+
+/// @brief Rearranges the operand stack for the pop, dup and swap
+/// instructions. The \c pops slots at the top of the stack are
+/// removed and replaced by the slots given in \c pattern, where
+/// '0' is the deepest slot removed.
+static uint8_t shuffle(Analyzer* a, uint16_t pops, const char* pattern)
+{
+    uint8_t removed[4];
+    uint16_t index;
+
+    if (a->depth < pops)
+        return 0;
+
+    a->depth -= pops;
+
+    for (index = 0; index < pops; index++)
+        removed[index] = STACK(a)[a->depth + index];
+
+    for (; *pattern; pattern++)
+    {
+        if (!push(a, removed[*pattern - '0']))
+            return 0;
+    }
+
+    return 1;
+}
+
+/// @brief Gets the descriptor of the field or method referenced by
+/// the constant pool entry at the given index.
+static cp_info* getReferenceDescriptor(JavaClass* jc, uint16_t index)
+{
+    if (index == 0 || index >= jc->constantPoolCount)
+        return NULL;
+
+    cp_info* cpi = jc->constantPool + index - 1;
+    cpi = jc->constantPool + cpi->Methodref.name_and_type_index - 1;
+    cpi = jc->constantPool + cpi->NameAndType.descriptor_index - 1;
+
+    return cpi->Utf8.length > 0 ? cpi : NULL;
+}
+
+static uint8_t transferLoadConstant(Analyzer* a, uint16_t index, uint8_t wide)
+{
+    if (index == 0 || index >= a->jc->constantPoolCount)
+        return 0;
+
+    switch (a->jc->constantPool[index - 1].tag)
+    {
+        case CONSTANT_Integer: return !wide && push(a, OP_INTEGER);
+        case CONSTANT_Float: return !wide && push(a, OP_FLOAT);
+        case CONSTANT_String: return !wide && push(a, OP_REFERENCE);
+        case CONSTANT_Class: return !wide && push(a, OP_REFERENCE);
+        case CONSTANT_Long: return wide && pushValue(a, OP_LONG);
+        case CONSTANT_Double: return wide && pushValue(a, OP_DOUBLE);
+
+        default:
+            break;
+    }
+
+    return 0;
+}
+
+static uint8_t transferField(Analyzer* a, uint8_t opcode, uint16_t index)
+{
+    cp_info* descriptor = getReferenceDescriptor(a->jc, index);
+
+    if (!descriptor)
+        return 0;
+
+    uint8_t type = getDescriptorType(descriptor->Utf8.bytes[0]);
+    uint16_t width = isWideType(type) ? 2 : 1;
+
+    if (type == OP_TOP)
+        return 0;
+
+    switch (opcode)
+    {
+        case opcode_getstatic: return pushValue(a, type);
+        case opcode_putstatic: return pop(a, width);
+        case opcode_getfield: return popPush(a, 1, type);
+        default: return pop(a, width + 1);
+    }
+}
+
+static uint8_t transferInvoke(Analyzer* a, uint8_t opcode, uint16_t index)
+{
+    cp_info* descriptor = getReferenceDescriptor(a->jc, index);
+
+    if (!descriptor)
+        return 0;
+
+    uint8_t* returnType = memchr(descriptor->Utf8.bytes, ')', descriptor->Utf8.length);
+
+    if (!returnType || returnType + 1 >= descriptor->Utf8.bytes + descriptor->Utf8.length)
+        return 0;
+
+    uint16_t pops = getMethodDescriptorParameterCount(descriptor->Utf8.bytes, descriptor->Utf8.length);
+
+    if (opcode != opcode_invokestatic)
+        pops++;
+
+    return popPush(a, pops, getDescriptorType(returnType[1]));
+}
+
+/// @brief Transforms the current state as the instruction at the
+/// given offset does.
+/// @return 0 if the instruction can't be analyzed.
+static uint8_t transfer(Analyzer* a, uint32_t pc)
+{
+    const uint8_t* code = a->code->code;
+    uint8_t opcode = code[pc];
+
+    #define OPCODE_INTERVAL(begin, end) (opcode >= opcode_##begin && opcode <= opcode_##end)
+
+    // Instructions "<t>load_<n>" and "<t>store_<n>"
+    if (OPCODE_INTERVAL(iload_0, aload_3))
+    {
+        static const uint8_t loadTypes[] = { OP_INTEGER, OP_LONG, OP_FLOAT, OP_DOUBLE, OP_REFERENCE };
+        return load(a, (opcode - opcode_iload_0) % 4, loadTypes[(opcode - opcode_iload_0) / 4]);
+    }
+
+    if (OPCODE_INTERVAL(istore_0, astore_3))
+    {
+        static const uint8_t storeTypes[] = { OP_INTEGER, OP_LONG, OP_FLOAT, OP_DOUBLE, OP_REFERENCE };
+        return store(a, (opcode - opcode_istore_0) % 4, storeTypes[(opcode - opcode_istore_0) / 4]);
+    }
+
+    #undef OPCODE_INTERVAL
+
+    switch (opcode)
+    {
+        case opcode_nop:
+        case opcode_goto: case opcode_goto_w:
+        case opcode_return:
+            return 1;
+
+        case opcode_aconst_null:
+            return push(a, OP_NULL);
+
+        case opcode_iconst_m1: case opcode_iconst_0: case opcode_iconst_1:
+        case opcode_iconst_2: case opcode_iconst_3: case opcode_iconst_4:
+        case opcode_iconst_5: case opcode_bipush: case opcode_sipush:
+            return push(a, OP_INTEGER);
+
+        case opcode_lconst_0: case opcode_lconst_1:
+            return pushValue(a, OP_LONG);
+
+        case opcode_fconst_0: case opcode_fconst_1: case opcode_fconst_2:
+            return push(a, OP_FLOAT);
+
+        case opcode_dconst_0: case opcode_dconst_1:
+            return pushValue(a, OP_DOUBLE);
+
+        case opcode_ldc: return transferLoadConstant(a, code[pc + 1], 0);
+        case opcode_ldc_w: return transferLoadConstant(a, (uint16_t)(code[pc + 1] << 8 | code[pc + 2]), 0);
+        case opcode_ldc2_w: return transferLoadConstant(a, (uint16_t)(code[pc + 1] << 8 | code[pc + 2]), 1);
+
+        case opcode_iload: return load(a, code[pc + 1], OP_INTEGER);
+        case opcode_lload: return load(a, code[pc + 1], OP_LONG);
+        case opcode_fload: return load(a, code[pc + 1], OP_FLOAT);
+        case opcode_dload: return load(a, code[pc + 1], OP_DOUBLE);
+        case opcode_aload: return load(a, code[pc + 1], OP_REFERENCE);
+
+        case opcode_istore: return store(a, code[pc + 1], OP_INTEGER);
+        case opcode_lstore: return store(a, code[pc + 1], OP_LONG);
+        case opcode_fstore: return store(a, code[pc + 1], OP_FLOAT);
+        case opcode_dstore: return store(a, code[pc + 1], OP_DOUBLE);
+        case opcode_astore: return store(a, code[pc + 1], OP_REFERENCE);
+
+        case opcode_iaload: case opcode_baload: case opcode_caload: case opcode_saload:
+            return popPush(a, 2, OP_INTEGER);
+
+        case opcode_laload: return popPush(a, 2, OP_LONG);
+        case opcode_faload: return popPush(a, 2, OP_FLOAT);
+        case opcode_daload: return popPush(a, 2, OP_DOUBLE);
+        case opcode_aaload: return popPush(a, 2, OP_REFERENCE);
+
+        case opcode_iastore: case opcode_fastore: case opcode_aastore:
+        case opcode_bastore: case opcode_castore: case opcode_sastore:
+            return pop(a, 3);
+
+        case opcode_lastore: case opcode_dastore:
+            return pop(a, 4);
+
+        case opcode_pop: return pop(a, 1);
+        case opcode_pop2: return pop(a, 2);
+        case opcode_dup: return shuffle(a, 1, "00");
+        case opcode_dup_x1: return shuffle(a, 2, "101");
+        case opcode_dup_x2: return shuffle(a, 3, "2012");
+        case opcode_dup2: return shuffle(a, 2, "0101");
+        case opcode_dup2_x1: return shuffle(a, 3, "12012");
+        case opcode_dup2_x2: return shuffle(a, 4, "230123");
+        case opcode_swap: return shuffle(a, 2, "10");
+
+        case opcode_iadd: case opcode_isub: case opcode_imul: case opcode_idiv:
+        case opcode_irem: case opcode_ishl: case opcode_ishr: case opcode_iushr:
+        case opcode_iand: case opcode_ior: case opcode_ixor:
+        case opcode_fcmpl: case opcode_fcmpg:
+            return popPush(a, 2, OP_INTEGER);
+
+        case opcode_ladd: case opcode_lsub: case opcode_lmul: case opcode_ldiv:
+        case opcode_lrem: case opcode_land: case opcode_lor: case opcode_lxor:
+            return popPush(a, 4, OP_LONG);
+
+        case opcode_lshl: case opcode_lshr: case opcode_lushr:
+            return popPush(a, 3, OP_LONG);
+
+        case opcode_fadd: case opcode_fsub: case opcode_fmul: case opcode_fdiv:
+        case opcode_frem:
+            return popPush(a, 2, OP_FLOAT);
+
+        case opcode_dadd: case opcode_dsub: case opcode_dmul: case opcode_ddiv:
+        case opcode_drem:
+            return popPush(a, 4, OP_DOUBLE);
+
+        case opcode_ineg: case opcode_f2i: case opcode_i2b: case opcode_i2c:
+        case opcode_i2s: case opcode_arraylength: case opcode_instanceof:
+            return popPush(a, 1, OP_INTEGER);
+
+        case opcode_lneg: case opcode_d2l: return popPush(a, 2, OP_LONG);
+        case opcode_fneg: case opcode_i2f: return popPush(a, 1, OP_FLOAT);
+        case opcode_dneg: case opcode_l2d: return popPush(a, 2, OP_DOUBLE);
+
+        case opcode_iinc:
+            return setLocal(a, code[pc + 1], OP_INTEGER);
+
+        case opcode_i2l: case opcode_f2l: return popPush(a, 1, OP_LONG);
+        case opcode_i2d: case opcode_f2d: return popPush(a, 1, OP_DOUBLE);
+        case opcode_l2i: case opcode_d2i: return popPush(a, 2, OP_INTEGER);
+        case opcode_l2f: case opcode_d2f: return popPush(a, 2, OP_FLOAT);
+
+        case opcode_lcmp: case opcode_dcmpl: case opcode_dcmpg:
+            return popPush(a, 4, OP_INTEGER);
+
+        case opcode_ifeq: case opcode_ifne: case opcode_iflt: case opcode_ifge:
+        case opcode_ifgt: case opcode_ifle: case opcode_ifnull: case opcode_ifnonnull:
+        case opcode_tableswitch: case opcode_lookupswitch:
+        case opcode_ireturn: case opcode_freturn: case opcode_areturn:
+        case opcode_athrow: case opcode_monitorenter: case opcode_monitorexit:
+            return pop(a, 1);
+
+        case opcode_if_icmpeq: case opcode_if_icmpne: case opcode_if_icmplt:
+        case opcode_if_icmpge: case opcode_if_icmpgt: case opcode_if_icmple:
+        case opcode_if_acmpeq: case opcode_if_acmpne:
+        case opcode_lreturn: case opcode_dreturn:
+            return pop(a, 2);
+
+        case opcode_getstatic: case opcode_putstatic:
+        case opcode_getfield: case opcode_putfield:
+            return transferField(a, opcode, (uint16_t)(code[pc + 1] << 8 | code[pc + 2]));
+
+        case opcode_invokevirtual: case opcode_invokespecial:
+        case opcode_invokestatic: case opcode_invokeinterface:
+            return transferInvoke(a, opcode, (uint16_t)(code[pc + 1] << 8 | code[pc + 2]));
+
+        case opcode_new:
+            return push(a, OP_REFERENCE);
+
+        case opcode_newarray: case opcode_anewarray: case opcode_checkcast:
+            return popPush(a, 1, OP_REFERENCE);
+
+        case opcode_multianewarray:
+            return popPush(a, code[pc + 3], OP_REFERENCE);
+
+        case opcode_wide:
+        {
+            uint16_t index = (uint16_t)(code[pc + 2] << 8 | code[pc + 3]);
+
+            switch (code[pc + 1])
+            {
+                case opcode_iload: return load(a, index, OP_INTEGER);
+                case opcode_lload: return load(a, index, OP_LONG);
+                case opcode_fload: return load(a, index, OP_FLOAT);
+                case opcode_dload: return load(a, index, OP_DOUBLE);
+                case opcode_aload: return load(a, index, OP_REFERENCE);
+                case opcode_istore: return store(a, index, OP_INTEGER);
+                case opcode_lstore: return store(a, index, OP_LONG);
+                case opcode_fstore: return store(a, index, OP_FLOAT);
+                case opcode_dstore: return store(a, index, OP_DOUBLE);
+                case opcode_astore: return store(a, index, OP_REFERENCE);
+                case opcode_iinc: return setLocal(a, index, OP_INTEGER);
+                default: break;
+            }
+
+            return 0;
+        }
+
+        default:
+            // jsr, ret, invokedynamic and unknown instructions
+            break;
+    }
+
+    return 0;
+}
+
+/// @brief Merges the state after the instruction at the given offset
+/// into every instruction that can be executed next.
+static uint8_t mergeIntoSuccessors(Analyzer* a, uint32_t pc, uint32_t length)
+{
+    const uint8_t* code = a->code->code;
+    uint8_t opcode = code[pc];
+
+    switch (opcode)
+    {
+        case opcode_goto:
+            return mergeInto(a, (int64_t)pc + readS2(code + pc + 1), a->current, a->depth);
+
+        case opcode_goto_w:
+            return mergeInto(a, (int64_t)pc + readS4(code + pc + 1), a->current, a->depth);
+
+        case opcode_ifeq: case opcode_ifne: case opcode_iflt: case opcode_ifge:
+        case opcode_ifgt: case opcode_ifle:
+        case opcode_if_icmpeq: case opcode_if_icmpne: case opcode_if_icmplt:
+        case opcode_if_icmpge: case opcode_if_icmpgt: case opcode_if_icmple:
+        case opcode_if_acmpeq: case opcode_if_acmpne:
+        case opcode_ifnull: case opcode_ifnonnull:
+            if (!mergeInto(a, (int64_t)pc + readS2(code + pc + 1), a->current, a->depth))
+                return 0;
+            break;
+
+        case opcode_tableswitch: case opcode_lookupswitch:
+        {
+            uint32_t base = pc + 1 + (3 - pc % 4);
+            uint32_t count, index;
+
+            if (!mergeInto(a, (int64_t)pc + readS4(code + base), a->current, a->depth))
+                return 0;
+
+            if (opcode == opcode_tableswitch)
+            {
+                count = (uint32_t)(readS4(code + base + 8) - readS4(code + base + 4)) + 1;
+
+                for (index = 0; index < count; index++)
+                {
+                    if (!mergeInto(a, (int64_t)pc + readS4(code + base + 12 + 4 * index), a->current, a->depth))
+                        return 0;
+                }
+            }
+            else
+            {
+                count = (uint32_t)readS4(code + base + 4);
+
+                for (index = 0; index < count; index++)
+                {
+                    if (!mergeInto(a, (int64_t)pc + readS4(code + base + 12 + 8 * index), a->current, a->depth))
+                        return 0;
+                }
+            }
+
+            return 1;
+        }
+
+        case opcode_ireturn: case opcode_lreturn: case opcode_freturn:
+        case opcode_dreturn: case opcode_areturn: case opcode_return:
+        case opcode_athrow:
+            return 1;
+
+        default:
+            break;
+    }
+
+    // Execution can't fall off the end of the code
+    return mergeInto(a, (int64_t)pc + length, a->current, a->depth);
+}
+
+/// @brief Writes the types of the method parameters, as described
+/// by the method descriptor, to the local variables of a state.
+static uint8_t getEntryState(Analyzer* a, method_info* method, uint8_t* state)
+{
+    cp_info* descriptor = a->jc->constantPool + method->descriptor_index - 1;
+    const uint8_t* bytes = descriptor->Utf8.bytes;
+    const uint8_t* end = bytes + descriptor->Utf8.length;
+    uint16_t local = 0;
+    uint8_t type;
+
+    memset(state, OP_TOP, a->types->slotCount);
+
+    if (!(method->access_flags & ACC_STATIC))
+        state[local++] = OP_REFERENCE;
+
+    if (bytes == end || *bytes++ != '(')
+        return 0;
+
+    while (bytes < end && *bytes != ')')
+    {
+        type = getDescriptorType(*bytes);
+
+        if (type == OP_TOP)
+            return 0;
+
+        while (bytes < end && *bytes == '[')
+            bytes++;
+
+        if (bytes < end && *bytes == 'L')
+        {
+            while (bytes < end && *bytes != ';')
+                bytes++;
+        }
+
+        bytes++;
+
+        if (local + (isWideType(type) ? 2 : 1) > a->types->max_locals)
+            return 0;
+
+        state[local++] = type;
+
+        if (isWideType(type))
+            state[local++] = OP_TOP;
+    }
+
+    return 1;
+}
+
+/// @brief Writes the type of a StackMapTable entry to the given slot
+/// of a state.
+/// @return How many slots the type takes, or 0 if they don't fit.
+static uint16_t setVerificationType(uint8_t* state, uint16_t slot, uint16_t limit, VerificationTypeInfo* vti)
+{
+    static const uint8_t itemTypes[] = {
+        OP_TOP, OP_INTEGER, OP_FLOAT, OP_DOUBLE, OP_LONG,
+        OP_NULL, OP_REFERENCE, OP_REFERENCE, OP_REFERENCE
+    };
+
+    uint8_t type = itemTypes[vti->tag];
+    uint16_t width = isWideType(type) ? 2 : 1;
+
+    if (slot + width > limit)
+        return 0;
+
+    state[slot] = type;
+
+    if (width == 2)
+        state[slot + 1] = OP_TOP;
+
+    return width;
+}
+
+/// @brief Seeds the states declared by the StackMapTable attribute
+/// of the method, if it has one.
+static uint8_t seedStackMapFrames(Analyzer* a, const uint8_t* entryState)
+{
+    attribute_info* attribute = getAttributeByType(a->code->attributes, a->code->attributes_count, ATTR_StackMapTable);
+
+    if (!attribute)
+        return 1;
+
+    if (!decodeAttribute(a->jc, attribute))
+        return 0;
+
+    att_StackMapTable_info* info = (att_StackMapTable_info*)attribute->info;
+    MethodTypes* types = a->types;
+    uint16_t max_locals = types->max_locals;
+    uint8_t* state = a->current;
+    int64_t pc = -1;
+    uint16_t index, item, width;
+
+    // Slot where each local of the frame starts, as the locals of
+    // chop frames are counted in entries, not in slots
+    uint16_t* localSlots = (uint16_t*)malloc((max_locals + 1) * sizeof(uint16_t));
+    uint16_t localCount = 0, nextSlot = 0;
+
+    if (!localSlots)
+        return 0;
+
+    memcpy(state, entryState, types->slotCount);
+
+    // The implicit first frame has the method parameters as locals
+    while (nextSlot < max_locals && entryState[nextSlot] != OP_TOP)
+    {
+        localSlots[localCount++] = nextSlot;
+        nextSlot += isWideType(entryState[nextSlot]) ? 2 : 1;
+    }
+
+    for (index = 0; index < info->number_of_entries; index++)
+    {
+        StackMapFrame* frame = info->entries + index;
+        uint16_t depth = 0;
+
+        pc += frame->offset_delta + 1;
+
+        if (frame->frame_type >= 248 && frame->frame_type <= 250)
+        {
+            uint16_t chopped = 251 - frame->frame_type;
+
+            if (chopped > localCount)
+                break;
+
+            localCount -= chopped;
+            nextSlot = localSlots[localCount];
+            memset(state + nextSlot, OP_TOP, max_locals - nextSlot);
+        }
+        else if (frame->frame_type >= 252)
+        {
+            if (frame->frame_type == 255)
+            {
+                localCount = nextSlot = 0;
+                memset(state, OP_TOP, max_locals);
+            }
+
+            for (item = 0; item < frame->number_of_locals; item++)
+            {
+                width = setVerificationType(state, nextSlot, max_locals, frame->locals + item);
+
+                if (width == 0)
+                    break;
+
+                localSlots[localCount++] = nextSlot;
+                nextSlot += width;
+            }
+
+            if (item < frame->number_of_locals)
+                break;
+        }
+
+        for (item = 0; item < frame->number_of_stack_items; item++)
+        {
+            width = setVerificationType(state + max_locals, depth, a->code->max_stack, frame->stack + item);
+
+            if (width == 0)
+                break;
+
+            depth += width;
+        }
+
+        if (item < frame->number_of_stack_items)
+            break;
+
+        if (pc >= types->code_length || types->stateIndex[pc] == TYPEMAP_NO_STATE)
+            break;
+
+        uint32_t stateIndex = types->stateIndex[pc];
+
+        if (!a->reached[stateIndex])
+            a->pending++;
+
+        memcpy(STATE(a, stateIndex), state, max_locals + depth);
+        memset(STATE(a, stateIndex) + max_locals + depth, OP_TOP, types->slotCount - max_locals - depth);
+        types->stackDepth[stateIndex] = depth;
+        a->reached[stateIndex] = 1;
+        a->changed[stateIndex] = 1;
+        a->declared[stateIndex] = 1;
+    }
+
+    free(localSlots);
+    return index == info->number_of_entries;
+}
+
+/// @brief Computes the reference map of each state.
+static void buildReferenceMaps(MethodTypes* types)
+{
+    uint32_t index;
+    uint16_t slot, slotCount;
+    uint16_t mapSize = (types->slotCount + 7) / 8;
+
+    memset(types->referenceMaps, 0, (size_t)types->stateCount * mapSize);
+
+    for (index = 0; index < types->stateCount; index++)
+    {
+        uint8_t* state = types->types + (size_t)index * types->slotCount;
+        uint8_t* map = types->referenceMaps + (size_t)index * mapSize;
+
+        slotCount = types->max_locals + types->stackDepth[index];
+
+        for (slot = 0; slot < slotCount; slot++)
+        {
+            if (state[slot] == OP_REFERENCE)
+                map[slot / 8] |= 1 << (slot % 8);
+        }
+    }
+}
+
+/// @brief Computes the types of the local variables and operand stack
+/// slots at each instruction of a method.
+///
+/// @param JavaClass* jc - class of the method.
+/// @param method_info* method - the method, to get its parameters from.
+/// @param att_Code_info* code - Code attribute of the method.
+///
+/// @return The type map of the method, or NULL if it couldn't be
+/// computed.
+/// @see freeMethodTypes()
+MethodTypes* analyzeMethodTypes(JavaClass* jc, method_info* method, att_Code_info* code)
+{
+    Analyzer a;
+    MethodTypes* types;
+    uint32_t pc, length, index;
+    uint8_t success = 1;
+
+    if (code->code_length == 0)
+        return NULL;
+
+    types = (MethodTypes*)malloc(sizeof(MethodTypes));
+
+    if (!types)
+        return NULL;
+
+    types->max_locals = code->max_locals;
+    types->slotCount = code->max_locals + code->max_stack;
+    types->code_length = code->code_length;
+    types->stateIndex = (uint32_t*)malloc(code->code_length * sizeof(uint32_t));
+    types->stateCount = 0;
+    types->stackDepth = NULL;
+    types->types = NULL;
+    types->referenceMaps = NULL;
+
+    if (!types->stateIndex)
+    {
+        freeMethodTypes(types);
+        return NULL;
+    }
+
+    // Every instruction gets a state
+    for (pc = 0; pc < code->code_length; pc++)
+        types->stateIndex[pc] = TYPEMAP_NO_STATE;
+
+    for (pc = 0; pc < code->code_length; pc += length)
+    {
+        length = getInstructionLength(code->code, pc, code->code_length);
+
+        if (length == 0)
+        {
+            freeMethodTypes(types);
+            return NULL;
+        }
+
+        types->stateIndex[pc] = types->stateCount++;
+    }
+
+    // Keep the allocations non-empty for methods without slots
+    uint32_t stateBytes = types->stateCount * types->slotCount + 1;
+    uint32_t mapBytes = types->stateCount * ((types->slotCount + 7) / 8) + 1;
+
+    a.jc = jc;
+    a.code = code;
+    a.types = types;
+    a.pending = 0;
+    a.depth = 0;
+    types->stackDepth = (uint16_t*)malloc(types->stateCount * sizeof(uint16_t));
+    types->types = (uint8_t*)malloc(stateBytes);
+    types->referenceMaps = (uint8_t*)malloc(mapBytes);
+    a.statePc = (uint32_t*)malloc(types->stateCount * sizeof(uint32_t));
+    a.reached = (uint8_t*)malloc(types->stateCount);
+    a.changed = (uint8_t*)malloc(types->stateCount);
+    a.declared = (uint8_t*)malloc(types->stateCount);
+    a.current = (uint8_t*)malloc(types->slotCount + 1);
+    a.handlerState = (uint8_t*)malloc(types->slotCount + 1);
+
+    if (!types->stackDepth || !types->types || !types->referenceMaps || !a.statePc ||
+        !a.reached || !a.changed || !a.declared || !a.current || !a.handlerState)
+    {
+        success = 0;
+    }
+    else
+    {
+        memset(a.reached, 0, types->stateCount);
+        memset(a.changed, 0, types->stateCount);
+        memset(a.declared, 0, types->stateCount);
+
+        for (pc = 0; pc < code->code_length; pc++)
+        {
+            if (types->stateIndex[pc] != TYPEMAP_NO_STATE)
+                a.statePc[types->stateIndex[pc]] = pc;
+        }
+
+        success = getEntryState(&a, method, a.handlerState) &&
+                  seedStackMapFrames(&a, a.handlerState) &&
+                  mergeInto(&a, 0, a.handlerState, 0);
+    }
+
+    // Analyze changed states until none of them changes
+    while (success && a.pending > 0)
+    {
+        for (index = 0; success && index < types->stateCount; index++)
+        {
+            if (!a.changed[index])
+                continue;
+
+            a.changed[index] = 0;
+            a.pending--;
+
+            pc = a.statePc[index];
+            a.depth = types->stackDepth[index];
+            memcpy(a.current, STATE(&a, index), types->slotCount);
+
+            // Handlers can be reached with the locals from before or
+            // after the instruction, in case it stores to a local
+            success = mergeIntoHandlers(&a, pc) &&
+                      transfer(&a, pc) &&
+                      mergeIntoHandlers(&a, pc) &&
+                      mergeIntoSuccessors(&a, pc, getInstructionLength(code->code, pc, code->code_length));
+        }
+    }
+
+    if (success)
+    {
+        for (index = 0; index < types->stateCount; index++)
+        {
+            if (!a.reached[index])
+            {
+                types->stateIndex[a.statePc[index]] = TYPEMAP_NO_STATE;
+                types->stackDepth[index] = 0;
+            }
+        }
+
+        buildReferenceMaps(types);
+    }
+
+    if (a.statePc)
+        free(a.statePc);
+
+    if (a.reached)
+        free(a.reached);
+
+    if (a.changed)
+        free(a.changed);
+
+    if (a.declared)
+        free(a.declared);
+
+    if (a.current)
+        free(a.current);
+
+    if (a.handlerState)
+        free(a.handlerState);
+
+    if (!success)
+    {
+        freeMethodTypes(types);
+        types = NULL;
+    }
+
+    return types;
+}
+
+/// @brief Computes the type maps of all methods of a class.
+///
+/// This is done when the class is verified. Methods that already
+/// have a type map are skipped, and methods whose types can't be
+/// computed have none.
+///
+/// @see analyzeMethodTypes()
+void analyzeClassTypes(JavaVirtualMachine* jvm, JavaClass* jc)
+{
+    uint16_t index;
+    method_info* method;
+    att_Code_info* code;
+
+    for (index = 0; index < jc->methodCount; index++)
+    {
+        method = jc->methods + index;
+        code = getMethodCode(jc, method);
+
+        if (!code || code->types)
+            continue;
+
+        code->types = analyzeMethodTypes(jc, method, code);
+    }
+}
+
+void freeMethodTypes(MethodTypes* types)
+{
+    if (types->stateIndex)
+        free(types->stateIndex);
+
+    if (types->stackDepth)
+        free(types->stackDepth);
+
+    if (types->types)
+        free(types->types);
+
+    if (types->referenceMaps)
+        free(types->referenceMaps);
+
+    free(types);
+}
+
+void freeClassTypes(JavaClass* jc)
+{
+    uint16_t index;
+    method_info* method;
+    attribute_info* codeAttribute;
+    att_Code_info* code;
+
+    for (index = 0; index < jc->methodCount; index++)
+    {
+        method = jc->methods + index;
+        codeAttribute = getAttributeByType(method->attributes, method->attributes_count, ATTR_Code);
+
+        // Methods whose code was never decoded have no type map
+        if (!codeAttribute || !codeAttribute->info)
+            continue;
+
+        code = (att_Code_info*)codeAttribute->info;
+
+        if (code->types)
+        {
+            freeMethodTypes(code->types);
+            code->types = NULL;
+        }
+    }
+}
+
+/// @brief Gets the types of the local variables and operand stack
+/// slots before the instruction at the given offset is executed.
+///
+/// @param MethodTypes* types - type map of the method, can be NULL.
+/// @param uint32_t pc - offset of the instruction.
+/// @param [out] uint16_t* outStackDepth - how many operand stack
+/// slots are in use, if non null.
+///
+/// @return An array of OperandType with the max_locals local variables
+/// followed by the operand stack slots, or NULL if the types at that
+/// offset aren't known.
+const uint8_t* getSlotTypes(MethodTypes* types, uint32_t pc, uint16_t* outStackDepth)
+{
+    if (!types || pc >= types->code_length || types->stateIndex[pc] == TYPEMAP_NO_STATE)
+        return NULL;
+
+    uint32_t index = types->stateIndex[pc];
+
+    if (outStackDepth)
+        *outStackDepth = types->stackDepth[index];
+
+    return types->types + (size_t)index * types->slotCount;
+}
+
+/// @brief Gets which local variables and operand stack slots hold
+/// references before the instruction at the given offset is executed.
+///
+/// @return A bit map where bit (slot % 8) of byte (slot / 8) is set
+/// if the slot holds a reference, with slots numbered as in
+/// getSlotTypes(), or NULL if the types at that offset aren't known.
+/// @see getSlotTypes()
+const uint8_t* getReferenceMap(MethodTypes* types, uint32_t pc, uint16_t* outStackDepth)
+{
+    if (!types || pc >= types->code_length || types->stateIndex[pc] == TYPEMAP_NO_STATE)
+        return NULL;
+
+    uint32_t index = types->stateIndex[pc];
+
+    if (outStackDepth)
+        *outStackDepth = types->stackDepth[index];
+
+    return types->referenceMaps + (size_t)index * ((types->slotCount + 7) / 8);
+}
+
+const char* getOperandTypeName(uint8_t type)
+{
+    static const char* names[] = {
+        "top", "int", "float", "long", "double", "null", "reference", "returnAddress"
+    };
+
+    if (type < sizeof(names) / sizeof(*names))
+        return names[type];
+
+    return "unknown";
+}
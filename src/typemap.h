@@ -0,0 +1,80 @@
+#ifndef TYPEMAP_H
+#define TYPEMAP_H
+
+#include <stdint.h>
+#include "attributes.h"
+
+/// @brief Type of a local variable or operand stack slot.
+///
+/// Long and double values take two slots: the first one has
+/// the type of the value and the second one is OP_TOP.
+typedef enum OperandType {
+    OP_TOP, OP_INTEGER, OP_FLOAT, OP_LONG, OP_DOUBLE,
+    OP_NULL, OP_REFERENCE, OP_RETURNADDRESS
+} OperandType;
+
+struct MethodTypes
+{
+    // Slots of each state: max_locals local variables followed
+    // by max_stack operand stack slots.
+    uint16_t max_locals;
+    uint16_t slotCount;
+    uint32_t code_length;
+
+    // State of each bytecode instruction, indexed by its offset,
+    // or TYPEMAP_NO_STATE for offsets that aren't the start of a
+    // reachable instruction.
+    uint32_t* stateIndex;
+    uint32_t stateCount;
+
+    // Operand stack depth of each state.
+    uint16_t* stackDepth;
+
+    // OperandType of each slot, slotCount entries per state.
+    uint8_t* types;
+
+    // One bit per slot that holds a reference, (slotCount + 7) / 8
+    // bytes per state.
+    uint8_t* referenceMaps;
+};
+
+#define TYPEMAP_NO_STATE 0xFFFFFFFF
+
+#include "jvm.h"
+
+MethodTypes* analyzeMethodTypes(JavaClass* jc, method_info* method, att_Code_info* code);
+void analyzeClassTypes(JavaVirtualMachine* jvm, JavaClass* jc);
+void freeMethodTypes(MethodTypes* types);
+void freeClassTypes(JavaClass* jc);
+const uint8_t* getSlotTypes(MethodTypes* types, uint32_t pc, uint16_t* outStackDepth);
+const uint8_t* getReferenceMap(MethodTypes* types, uint32_t pc, uint16_t* outStackDepth);
+const char* getOperandTypeName(uint8_t type);
+
+#endif // TYPEMAP_H
+
+/// @defgroup typemap Type map module
+///
+/// @brief Computes the type of every local variable and operand
+/// stack slot at each instruction of a method.
+///
+/// Slots don't carry a type at runtime. Instead, when a class is
+/// verified, or else the first time a method runs, each method goes
+/// through a data flow analysis similar to the one of the type
+/// checking verifier: the state at the method entry comes from its
+/// descriptor, every instruction
+/// transforms the state it receives, and the states reaching the
+/// same instruction from different paths are merged until none of
+/// them changes. Frames of a StackMapTable attribute, when there is
+/// one, replace the merged state at their offsets, and every state
+/// reaching them must be assignable to them.
+///
+/// The result is kept for the parts of the JVM that need to know
+/// where references are, such as a garbage collector walking the
+/// frames (getReferenceMap()), or a debugger showing their values
+/// (getSlotTypes()).
+///
+/// Methods using jsr/ret, whose local variable types depend on the
+/// caller of the subroutine, or whose bytecode can't be analyzed,
+/// get no type map.
+///
+/// @see analyzeClassTypes()
@@ -1,5 +1,12 @@
 #include "utf8.h"
 
+// Class files are mostly ASCII, so byte checks are done 16 or 32
+// bytes at a time where the compiler targets SSE2 or AVX2, as with
+// "-msse2" or "-mavx2". Other targets use the scalar loops.
+#if defined(__SSE2__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
 #define SINGLE_BYTE_MASK  0x80
 #define SINGLE_BYTE_VALUE 0
 #define DOUBLE_BYTE_MASK  0xE0
@@ -278,3 +285,88 @@ uint32_t UTF8StringLength(const uint8_t* utf8_bytes, int32_t utf8_len)
 
     return length;
 }
+
+/// @brief Checks that no byte of a CONSTANT_Utf8 is zero or in the
+/// range [0xF0, 0xFF], which modified UTF-8 never uses.
+///
+/// @param const uint8_t* utf8_bytes - the bytes to check.
+/// @param int32_t utf8_len - number of bytes.
+///
+/// @return 1 if all bytes are allowed, 0 otherwise.
+uint8_t hasValidUTF8Bytes(const uint8_t* utf8_bytes, int32_t utf8_len)
+{
+    int32_t index = 0;
+
+    // Subtracting one turns 0 into 0xFF, so both cases become
+    // a single unsigned comparison against 0xEF.
+#ifdef __AVX2__
+    const __m256i one32 = _mm256_set1_epi8(1);
+    const __m256i limit32 = _mm256_set1_epi8((char)0xEF);
+
+    for (; index + 32 <= utf8_len; index += 32)
+    {
+        __m256i bytes = _mm256_sub_epi8(_mm256_loadu_si256((const __m256i*)(utf8_bytes + index)), one32);
+
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(bytes, limit32), bytes)))
+            return 0;
+    }
+#endif
+
+#ifdef __SSE2__
+    const __m128i one16 = _mm_set1_epi8(1);
+    const __m128i limit16 = _mm_set1_epi8((char)0xEF);
+
+    for (; index + 16 <= utf8_len; index += 16)
+    {
+        __m128i bytes = _mm_sub_epi8(_mm_loadu_si128((const __m128i*)(utf8_bytes + index)), one16);
+
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(bytes, limit16), bytes)))
+            return 0;
+    }
+#endif
+
+    for (; index < utf8_len; index++)
+    {
+        if ((uint8_t)(utf8_bytes[index] - 1) >= 0xEF)
+            return 0;
+    }
+
+    return 1;
+}
+
+/// @brief Counts the bytes at the start of a UTF-8 stream that are
+/// ASCII characters, each of them being a whole character.
+///
+/// @param const uint8_t* utf8_bytes - the UTF-8 stream.
+/// @param int32_t utf8_len - number of bytes.
+///
+/// @return The number of leading bytes below 0x80.
+int32_t countLeadingASCII(const uint8_t* utf8_bytes, int32_t utf8_len)
+{
+    int32_t index = 0;
+
+#ifdef __AVX2__
+    for (; index + 32 <= utf8_len; index += 32)
+    {
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_loadu_si256((const __m256i*)(utf8_bytes + index)));
+
+        if (mask)
+            return index + __builtin_ctz(mask);
+    }
+#endif
+
+#ifdef __SSE2__
+    for (; index + 16 <= utf8_len; index += 16)
+    {
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)(utf8_bytes + index)));
+
+        if (mask)
+            return index + __builtin_ctz(mask);
+    }
+#endif
+
+    while (index < utf8_len && utf8_bytes[index] < 0x80)
+        index++;
+
+    return index;
+}
@@ -9,5 +9,7 @@ char cmp_UTF8(const uint8_t* utf8A_bytes, int32_t utf8A_len, const uint8_t* utf8
 char cmp_UTF8_FilePath(const uint8_t* utf8A_bytes, int32_t utf8A_len, const uint8_t* utf8B_bytes, int32_t utf8B_len);
 uint32_t UTF8_to_Ascii(uint8_t* out_buffer, int32_t buffer_len, const uint8_t* utf8_bytes, int32_t utf8_len);
 uint32_t UTF8StringLength(const uint8_t* utf8_bytes, int32_t utf8_len);
+uint8_t hasValidUTF8Bytes(const uint8_t* utf8_bytes, int32_t utf8_len);
+int32_t countLeadingASCII(const uint8_t* utf8_bytes, int32_t utf8_len);
 
 #endif // UTF8_H
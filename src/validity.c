@@ -1,11 +1,112 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include "validity.h"
 #include "constantpool.h"
 #include "utf8.h"
 #include "readfunctions.h"
+#include "threads.h"
 #include <locale.h>
 #include <wctype.h>
 #include <ctype.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#ifndef _WIN32
+// Locale used to classify identifier characters. It is created once
+// and passed to iswalpha_l(), instead of changing the locale of the
+// whole process, which class loader workers would race on.
+static locale_t identifierLocale = (locale_t)0;
+static Once identifierLocaleOnce = ONCE_INIT;
+
+static void createIdentifierLocale(void)
+{
+    // Without it, identifiers are checked in the current locale
+    identifierLocale = newlocale(LC_CTYPE_MASK, "pt_BR.UTF-8", (locale_t)0);
+}
+#endif
+
+static int isUnicodeLetter(uint32_t utf8_char)
+{
+#ifdef _WIN32
+    return iswalpha((wint_t)utf8_char);
+#else
+    runOnce(&identifierLocaleOnce, createIdentifierLocale);
+
+    if (identifierLocale)
+        return iswalpha_l((wint_t)utf8_char, identifierLocale);
+
+    return iswalpha((wint_t)utf8_char);
+#endif
+}
+
+/// @brief Skips the ASCII letters, digits, '_', '$' and, for class
+/// names, '/' at the start of an identifier, 16 bytes at a time.
+///
+/// Digits and slashes are only skipped where isValidJavaIdentifier()
+/// would accept them, that is, not first and not after a slash.
+///
+/// @param uint8_t* firstChar - whether the next character is the first
+/// of the identifier or comes after a slash; updated to the state after
+/// the skipped bytes.
+///
+/// @return The number of bytes that can be skipped, which may be less
+/// than the valid ones, as the end is left to the scalar loop.
+static int32_t skipASCIIIdentifier(const uint8_t* utf8_bytes, int32_t utf8_len, uint8_t isClassIdentifier, uint8_t* firstChar)
+{
+    int32_t index = 0;
+
+#ifdef __SSE2__
+    uint32_t afterSlash = *firstChar;
+    uint32_t valid, digits, slashes, invalid;
+
+    for (; index + 16 <= utf8_len; index += 16)
+    {
+        __m128i bytes = _mm_loadu_si128((const __m128i*)(utf8_bytes + index));
+        __m128i lower = _mm_or_si128(bytes, _mm_set1_epi8(0x20));
+
+        // Bytes above 0x7F are negative, so they are never in range
+        __m128i letterBytes = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                                            _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+        __m128i digitBytes = _mm_and_si128(_mm_cmpgt_epi8(bytes, _mm_set1_epi8('0' - 1)),
+                                           _mm_cmplt_epi8(bytes, _mm_set1_epi8('9' + 1)));
+        __m128i symbolBytes = _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('_')),
+                                           _mm_cmpeq_epi8(bytes, _mm_set1_epi8('$')));
+
+        digits = (uint32_t)_mm_movemask_epi8(digitBytes);
+        slashes = isClassIdentifier ? (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('/'))) : 0;
+        valid = (uint32_t)_mm_movemask_epi8(_mm_or_si128(letterBytes, symbolBytes)) | digits | slashes;
+
+        // One bit per byte, set where a digit or a slash comes first
+        // or right after a slash
+        invalid = (~valid & 0xFFFF) | ((digits | slashes) & ((slashes << 1) | afterSlash));
+
+        if (invalid)
+        {
+            uint32_t skipped = (uint32_t)__builtin_ctz(invalid);
+
+            if (skipped)
+                *firstChar = (slashes >> (skipped - 1)) & 1;
+
+            return index + (int32_t)skipped;
+        }
+
+        afterSlash = slashes >> 15;
+        *firstChar = (uint8_t)afterSlash;
+    }
+#else
+    (void)utf8_bytes;
+    (void)utf8_len;
+    (void)isClassIdentifier;
+    (void)firstChar;
+#endif
+
+    return index;
+}
+
 /// @brief Checks whether the "accessFlags" parameter has a valid combination
 /// of method flags. 
 /// 
@@ -230,6 +331,11 @@ char isValidJavaIdentifier(uint8_t* utf8_bytes, int32_t utf8_len, uint8_t isClas
     if (*utf8_bytes == '[')
         return readFieldDescriptor(utf8_bytes, utf8_len, 1) == utf8_len;
 
+    int32_t skipped = skipASCIIIdentifier(utf8_bytes, utf8_len, isClassIdentifier, &firstChar);
+
+    utf8_bytes += skipped;
+    utf8_len -= skipped;
+
     while (utf8_len > 0)
     {
         used_bytes = nextUTF8Character(utf8_bytes, utf8_len, &utf8_char);
@@ -241,7 +347,7 @@ char isValidJavaIdentifier(uint8_t* utf8_bytes, int32_t utf8_len, uint8_t isClas
         }
 
         if (isalpha(utf8_char) || utf8_char == '_' || utf8_char == '$' ||
-            (isdigit(utf8_char) && !firstChar) || iswalpha(utf8_char) ||
+            (isdigit(utf8_char) && !firstChar) || isUnicodeLetter(utf8_char) ||
             (utf8_char == '/' && !firstChar && isClassIdentifier))
         {
             firstChar = utf8_char == '/';
@@ -389,7 +495,6 @@ char checkConstantPoolValidity(JavaClass* jc)
 {
     uint16_t i;
     char success = 1;
-    char* previousLocale = setlocale(LC_CTYPE, "pt_BR.UTF-8");
 
     for (i = 0; success && i < jc->constantPoolCount - 1; i++)
     {
@@ -471,7 +576,6 @@ char checkConstantPoolValidity(JavaClass* jc)
     }
 
     jc->currentValidityEntryIndex = -1;
-    setlocale(LC_CTYPE, previousLocale);
 
     return success;
 }
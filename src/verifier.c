@@ -0,0 +1,699 @@
+#include "verifier.h"
+#include "typemap.h"
+#include "opcodes.h"
+#include "memoryinspect.h"
+#include <string.h>
+#include <inttypes.h>
+
+#define VERIFY_CACHE_MAGIC "JVF2"
+
+/// @brief Types of the operands popped by each instruction, from the
+/// deepest one to the top of the stack: 'I' int, 'F' float, 'J' long,
+/// 'D' double, 'A' reference and '1' any category 1 value.
+///
+/// Loads, stores, returns and instructions using constant pool
+/// descriptors are checked separately.
+static const char* operandTypes[256] = {
+    [opcode_iaload] = "AI", [opcode_laload] = "AI", [opcode_faload] = "AI", [opcode_daload] = "AI",
+    [opcode_aaload] = "AI", [opcode_baload] = "AI", [opcode_caload] = "AI", [opcode_saload] = "AI",
+
+    [opcode_iastore] = "AII", [opcode_lastore] = "AIJ", [opcode_fastore] = "AIF", [opcode_dastore] = "AID",
+    [opcode_aastore] = "AIA", [opcode_bastore] = "AII", [opcode_castore] = "AII", [opcode_sastore] = "AII",
+
+    [opcode_pop] = "1", [opcode_dup] = "1", [opcode_dup_x1] = "11", [opcode_swap] = "11",
+
+    [opcode_iadd] = "II", [opcode_isub] = "II", [opcode_imul] = "II", [opcode_idiv] = "II",
+    [opcode_irem] = "II", [opcode_ishl] = "II", [opcode_ishr] = "II", [opcode_iushr] = "II",
+    [opcode_iand] = "II", [opcode_ior] = "II", [opcode_ixor] = "II", [opcode_ineg] = "I",
+
+    [opcode_ladd] = "JJ", [opcode_lsub] = "JJ", [opcode_lmul] = "JJ", [opcode_ldiv] = "JJ",
+    [opcode_lrem] = "JJ", [opcode_land] = "JJ", [opcode_lor] = "JJ", [opcode_lxor] = "JJ",
+    [opcode_lshl] = "JI", [opcode_lshr] = "JI", [opcode_lushr] = "JI", [opcode_lneg] = "J",
+
+    [opcode_fadd] = "FF", [opcode_fsub] = "FF", [opcode_fmul] = "FF", [opcode_fdiv] = "FF",
+    [opcode_frem] = "FF", [opcode_fneg] = "F",
+
+    [opcode_dadd] = "DD", [opcode_dsub] = "DD", [opcode_dmul] = "DD", [opcode_ddiv] = "DD",
+    [opcode_drem] = "DD", [opcode_dneg] = "D",
+
+    [opcode_i2l] = "I", [opcode_i2f] = "I", [opcode_i2d] = "I", [opcode_i2b] = "I",
+    [opcode_i2c] = "I", [opcode_i2s] = "I",
+    [opcode_l2i] = "J", [opcode_l2f] = "J", [opcode_l2d] = "J",
+    [opcode_f2i] = "F", [opcode_f2l] = "F", [opcode_f2d] = "F",
+    [opcode_d2i] = "D", [opcode_d2l] = "D", [opcode_d2f] = "D",
+
+    [opcode_lcmp] = "JJ", [opcode_fcmpl] = "FF", [opcode_fcmpg] = "FF",
+    [opcode_dcmpl] = "DD", [opcode_dcmpg] = "DD",
+
+    [opcode_ifeq] = "I", [opcode_ifne] = "I", [opcode_iflt] = "I",
+    [opcode_ifge] = "I", [opcode_ifgt] = "I", [opcode_ifle] = "I",
+    [opcode_if_icmpeq] = "II", [opcode_if_icmpne] = "II", [opcode_if_icmplt] = "II",
+    [opcode_if_icmpge] = "II", [opcode_if_icmpgt] = "II", [opcode_if_icmple] = "II",
+    [opcode_if_acmpeq] = "AA", [opcode_if_acmpne] = "AA",
+    [opcode_ifnull] = "A", [opcode_ifnonnull] = "A",
+    [opcode_tableswitch] = "I", [opcode_lookupswitch] = "I",
+
+    [opcode_newarray] = "I", [opcode_anewarray] = "I", [opcode_arraylength] = "A",
+    [opcode_athrow] = "A", [opcode_checkcast] = "A", [opcode_instanceof] = "A",
+    [opcode_monitorenter] = "A", [opcode_monitorexit] = "A"
+};
+
+/// @brief Gets the operand type character of a field descriptor.
+static char getPatternChar(uint8_t c)
+{
+    switch (c)
+    {
+        case 'B': case 'C': case 'I': case 'S': case 'Z':
+            return 'I';
+
+        case 'F': case 'J': case 'D':
+            return (char)c;
+
+        case 'L': case '[':
+            return 'A';
+
+        default:
+            break;
+    }
+
+    return 0;
+}
+
+/// @brief Checks if a slot, and the one after it for long and double
+/// values, holds a value of the type given by a pattern character.
+static uint8_t matchesType(const uint8_t* slot, char c)
+{
+    switch (c)
+    {
+        case 'I': return slot[0] == OP_INTEGER;
+        case 'F': return slot[0] == OP_FLOAT;
+        case 'J': return slot[0] == OP_LONG && slot[1] == OP_TOP;
+        case 'D': return slot[0] == OP_DOUBLE && slot[1] == OP_TOP;
+        case 'A': return slot[0] == OP_REFERENCE || slot[0] == OP_NULL;
+
+        case '1':
+            return slot[0] != OP_TOP && slot[0] != OP_LONG && slot[0] != OP_DOUBLE;
+
+        default:
+            break;
+    }
+
+    return 0;
+}
+
+/// @brief Checks the types of the operands at the top of the stack.
+/// @param const uint8_t* stack - types of the operand stack slots.
+/// @param uint16_t depth - number of slots in the stack.
+/// @param const char* pattern - operand types, as in operandTypes.
+static uint8_t matchesOperands(const uint8_t* stack, uint16_t depth, const char* pattern)
+{
+    uint16_t slots = 0;
+    const char* c;
+
+    for (c = pattern; *c; c++)
+        slots += (*c == 'J' || *c == 'D') ? 2 : 1;
+
+    if (slots > depth)
+        return 0;
+
+    stack += depth - slots;
+
+    for (c = pattern; *c; c++)
+    {
+        if (!matchesType(stack, *c))
+            return 0;
+
+        stack += (*c == 'J' || *c == 'D') ? 2 : 1;
+    }
+
+    return 1;
+}
+
+/// @brief Checks that a constant pool index points to an entry with
+/// one of the two given tags.
+static uint8_t hasTag(JavaClass* jc, uint16_t index, uint8_t tag1, uint8_t tag2)
+{
+    if (index == 0 || index >= jc->constantPoolCount)
+        return 0;
+
+    return jc->constantPool[index - 1].tag == tag1 || jc->constantPool[index - 1].tag == tag2;
+}
+
+static cp_info* getReferenceDescriptor(JavaClass* jc, uint16_t index)
+{
+    cp_info* cpi = jc->constantPool + index - 1;
+    cpi = jc->constantPool + cpi->Methodref.name_and_type_index - 1;
+    return jc->constantPool + cpi->NameAndType.descriptor_index - 1;
+}
+
+/// @brief Builds the pattern of the parameters of a method descriptor,
+/// preceded by a reference for instance methods.
+/// @return Pointer to the return type in the descriptor, or NULL if
+/// the descriptor is invalid.
+static const uint8_t* getParameterPattern(cp_info* descriptor, uint8_t hasObjectRef, char* pattern, uint16_t size)
+{
+    const uint8_t* bytes = descriptor->Utf8.bytes;
+    const uint8_t* end = bytes + descriptor->Utf8.length;
+    uint16_t length = 0;
+
+    if (hasObjectRef)
+        pattern[length++] = 'A';
+
+    if (bytes == end || *bytes++ != '(')
+        return NULL;
+
+    while (bytes < end && *bytes != ')')
+    {
+        if (length + 1 >= size || !getPatternChar(*bytes))
+            return NULL;
+
+        pattern[length++] = getPatternChar(*bytes);
+
+        while (bytes < end && *bytes == '[')
+            bytes++;
+
+        if (bytes < end && *bytes == 'L')
+        {
+            while (bytes < end && *bytes != ';')
+                bytes++;
+        }
+
+        bytes++;
+    }
+
+    pattern[length] = '\0';
+    return bytes + 1 < end ? bytes + 1 : NULL;
+}
+
+static uint8_t isLoadValid(const uint8_t* locals, uint16_t index, char c)
+{
+    return matchesType(locals + index, c);
+}
+
+/// @brief Checks an instruction against the types of the locals
+/// and operands before it.
+/// @return NULL if the instruction is valid, or the reason why
+/// it isn't.
+static const char* verifyInstruction(JavaClass* jc, method_info* method, att_Code_info* code,
+                                     uint32_t pc, const uint8_t* locals, const uint8_t* stack, uint16_t depth)
+{
+    static const char loadStoreTypes[] = { 'I', 'J', 'F', 'D', 'A' };
+
+    const uint8_t* bytecode = code->code;
+    uint8_t opcode = bytecode[pc];
+    uint16_t index = (uint16_t)(bytecode[pc + 1] << 8 | bytecode[pc + 2]);
+    char pattern[258];
+    cp_info* descriptor;
+
+    if (operandTypes[opcode] && !matchesOperands(stack, depth, operandTypes[opcode]))
+        return "operand types don't match the instruction";
+
+    #define OPCODE_INTERVAL(begin, end) (opcode >= opcode_##begin && opcode <= opcode_##end)
+
+    if (OPCODE_INTERVAL(iload, aload))
+    {
+        if (!isLoadValid(locals, bytecode[pc + 1], loadStoreTypes[opcode - opcode_iload]))
+            return "local variable type doesn't match the load";
+
+        return NULL;
+    }
+
+    if (OPCODE_INTERVAL(iload_0, aload_3))
+    {
+        if (!isLoadValid(locals, (opcode - opcode_iload_0) % 4, loadStoreTypes[(opcode - opcode_iload_0) / 4]))
+            return "local variable type doesn't match the load";
+
+        return NULL;
+    }
+
+    if (OPCODE_INTERVAL(istore, astore) || OPCODE_INTERVAL(istore_0, astore_3))
+    {
+        pattern[0] = opcode <= opcode_astore ? loadStoreTypes[opcode - opcode_istore]
+                                             : loadStoreTypes[(opcode - opcode_istore_0) / 4];
+        pattern[1] = '\0';
+
+        if (!matchesOperands(stack, depth, pattern))
+            return "operand type doesn't match the store";
+
+        return NULL;
+    }
+
+    if (OPCODE_INTERVAL(ireturn, return))
+    {
+        descriptor = jc->constantPool + method->descriptor_index - 1;
+        const uint8_t* returnType = memchr(descriptor->Utf8.bytes, ')', descriptor->Utf8.length);
+
+        if (!returnType || returnType + 1 >= descriptor->Utf8.bytes + descriptor->Utf8.length)
+            return "invalid method descriptor";
+
+        if (opcode == opcode_return)
+            return returnType[1] == 'V' ? NULL : "return in a method that returns a value";
+
+        pattern[0] = getPatternChar(returnType[1]);
+        pattern[1] = '\0';
+
+        if (pattern[0] != loadStoreTypes[opcode - opcode_ireturn] || !matchesOperands(stack, depth, pattern))
+            return "returned value doesn't match the method descriptor";
+
+        return NULL;
+    }
+
+    #undef OPCODE_INTERVAL
+
+    switch (opcode)
+    {
+        case opcode_iinc:
+            if (!isLoadValid(locals, bytecode[pc + 1], 'I'))
+                return "iinc on a local variable that isn't an int";
+            break;
+
+        case opcode_ldc:
+            if (!hasTag(jc, bytecode[pc + 1], CONSTANT_Integer, CONSTANT_Float) &&
+                !hasTag(jc, bytecode[pc + 1], CONSTANT_String, CONSTANT_Class))
+            {
+                return "ldc of an invalid constant";
+            }
+            break;
+
+        case opcode_ldc_w:
+            if (!hasTag(jc, index, CONSTANT_Integer, CONSTANT_Float) &&
+                !hasTag(jc, index, CONSTANT_String, CONSTANT_Class))
+            {
+                return "ldc_w of an invalid constant";
+            }
+            break;
+
+        case opcode_ldc2_w:
+            if (!hasTag(jc, index, CONSTANT_Long, CONSTANT_Double))
+                return "ldc2_w of an invalid constant";
+            break;
+
+        case opcode_getstatic: case opcode_putstatic:
+        case opcode_getfield: case opcode_putfield:
+        {
+            if (!hasTag(jc, index, CONSTANT_Fieldref, CONSTANT_Fieldref))
+                return "field instruction doesn't reference a field";
+
+            descriptor = getReferenceDescriptor(jc, index);
+            pattern[0] = opcode == opcode_putfield || opcode == opcode_getfield ? 'A' : '\0';
+            pattern[1] = opcode == opcode_putfield ? getPatternChar(descriptor->Utf8.bytes[0]) : '\0';
+            pattern[2] = '\0';
+
+            if (opcode == opcode_putstatic)
+                pattern[0] = getPatternChar(descriptor->Utf8.bytes[0]);
+
+            if (!matchesOperands(stack, depth, pattern))
+                return "operand types don't match the field";
+
+            break;
+        }
+
+        case opcode_invokevirtual: case opcode_invokespecial:
+        case opcode_invokestatic: case opcode_invokeinterface:
+        {
+            uint8_t tag = opcode == opcode_invokeinterface ? CONSTANT_InterfaceMethodref : CONSTANT_Methodref;
+
+            // Since version 52, invokestatic and invokespecial can
+            // also call interface methods
+            if (!hasTag(jc, index, tag, jc->majorVersion >= 52 && opcode != opcode_invokevirtual ? CONSTANT_InterfaceMethodref : tag))
+                return "invoke instruction doesn't reference a method";
+
+            if (opcode == opcode_invokeinterface && (bytecode[pc + 3] == 0 || bytecode[pc + 4] != 0))
+                return "invalid invokeinterface count";
+
+            descriptor = getReferenceDescriptor(jc, index);
+
+            if (!getParameterPattern(descriptor, opcode != opcode_invokestatic, pattern, sizeof(pattern)))
+                return "invalid method descriptor";
+
+            if (!matchesOperands(stack, depth, pattern))
+                return "arguments don't match the method descriptor";
+
+            break;
+        }
+
+        case opcode_new: case opcode_anewarray:
+        case opcode_checkcast: case opcode_instanceof:
+            if (!hasTag(jc, index, CONSTANT_Class, CONSTANT_Class))
+                return "instruction doesn't reference a class";
+            break;
+
+        case opcode_newarray:
+            if (bytecode[pc + 1] < T_BOOLEAN || bytecode[pc + 1] > T_LONG)
+                return "invalid newarray type";
+            break;
+
+        case opcode_multianewarray:
+        {
+            uint8_t dimensions = bytecode[pc + 3];
+
+            if (!hasTag(jc, index, CONSTANT_Class, CONSTANT_Class) || dimensions == 0)
+                return "invalid multianewarray";
+
+            memset(pattern, 'I', dimensions);
+            pattern[dimensions] = '\0';
+
+            if (!matchesOperands(stack, depth, pattern))
+                return "array dimensions must be ints";
+
+            break;
+        }
+
+        case opcode_wide:
+        {
+            uint8_t wideOpcode = bytecode[pc + 1];
+            uint16_t local = (uint16_t)(bytecode[pc + 2] << 8 | bytecode[pc + 3]);
+
+            if (wideOpcode >= opcode_iload && wideOpcode <= opcode_aload &&
+                !isLoadValid(locals, local, loadStoreTypes[wideOpcode - opcode_iload]))
+            {
+                return "local variable type doesn't match the load";
+            }
+
+            if (wideOpcode >= opcode_istore && wideOpcode <= opcode_astore)
+            {
+                pattern[0] = loadStoreTypes[wideOpcode - opcode_istore];
+                pattern[1] = '\0';
+
+                if (!matchesOperands(stack, depth, pattern))
+                    return "operand type doesn't match the store";
+            }
+
+            if (wideOpcode == opcode_iinc && !isLoadValid(locals, local, 'I'))
+                return "iinc on a local variable that isn't an int";
+
+            break;
+        }
+
+        default:
+            break;
+    }
+
+    return NULL;
+}
+
+/// @brief Checks if the code of a method uses instructions that the
+/// type inference doesn't handle, but which are valid in its class.
+static uint8_t usesUnanalyzedInstructions(JavaClass* jc, att_Code_info* code)
+{
+    uint32_t pc, length;
+    uint8_t opcode;
+
+    for (pc = 0; pc < code->code_length; pc += length)
+    {
+        length = getInstructionLength(code->code, pc, code->code_length);
+
+        if (length == 0)
+            return 0;
+
+        opcode = code->code[pc];
+
+        if (opcode == opcode_wide)
+            opcode = code->code[pc + 1];
+
+        // Subroutines are forbidden from version 51 on
+        if ((opcode == opcode_jsr || opcode == opcode_jsr_w || opcode == opcode_ret) && jc->majorVersion < 51)
+            return 1;
+
+        if (opcode == opcode_invokedynamic)
+            return 1;
+    }
+
+    return 0;
+}
+
+/// @brief Verifies the code of a method, using its type map.
+///
+/// @param JavaClass* jc - class of the method.
+/// @param method_info* method - the method to be verified.
+/// @param att_Code_info* code - Code attribute of the method, whose
+/// type map has already been computed.
+/// @param [out] uint32_t* outPc - offset of the instruction that
+/// failed verification.
+/// @param [out] const char** outReason - why verification failed.
+///
+/// @return 1 if the method is valid, 0 otherwise.
+uint8_t verifyMethod(JavaClass* jc, method_info* method, att_Code_info* code, uint32_t* outPc, const char** outReason)
+{
+    MethodTypes* types = code->types;
+    const uint8_t* state;
+    const char* reason = NULL;
+    uint32_t pc, length;
+    uint16_t depth, index;
+
+    *outPc = 0;
+
+    if (!types)
+    {
+        *outReason = "inconsistent stack or local variable types";
+        return 0;
+    }
+
+    for (index = 0; index < code->exception_table_length; index++)
+    {
+        ExceptionTableEntry* entry = code->exception_table + index;
+
+        if (entry->start_pc >= entry->end_pc || entry->end_pc > code->code_length ||
+            (entry->catch_type && !hasTag(jc, entry->catch_type, CONSTANT_Class, CONSTANT_Class)))
+        {
+            *outPc = entry->handler_pc;
+            *outReason = "invalid exception table entry";
+            return 0;
+        }
+    }
+
+    for (pc = 0; pc < code->code_length && !reason; pc += length)
+    {
+        length = getInstructionLength(code->code, pc, code->code_length);
+        state = getSlotTypes(types, pc, &depth);
+
+        // Unreachable instructions are never executed
+        if (state)
+            reason = verifyInstruction(jc, method, code, pc, state, state + types->max_locals, depth);
+
+        for (index = 0; !reason && index < code->exception_table_length; index++)
+        {
+            ExceptionTableEntry* entry = code->exception_table + index;
+
+            if (entry->start_pc > pc && entry->start_pc < pc + length)
+                reason = "exception range doesn't start at an instruction";
+            else if (entry->end_pc > pc && entry->end_pc < pc + length)
+                reason = "exception range doesn't end at an instruction";
+        }
+
+        if (reason)
+            *outPc = pc;
+    }
+
+    *outReason = reason;
+    return reason == NULL;
+}
+
+/// @brief Computes a FNV-1a hash of the whole class file, from
+/// its mapping in memory.
+uint64_t hashClassFile(JavaClass* jc)
+{
+    uint64_t hash = 0xCBF29CE484222325ull;
+    uint32_t index;
+
+    for (index = 0; index < jc->file.size; index++)
+    {
+        hash ^= jc->file.data[index];
+        hash *= 0x100000001B3ull;
+    }
+
+    return hash;
+}
+
+static void getCacheFilePath(JavaVirtualMachine* jvm, uint64_t hash, char* path, size_t size)
+{
+    snprintf(path, size, "%s/%016" PRIx64 ".verify", jvm->verifyCachePath, hash);
+}
+
+/// @brief Checks that a cache file holds a copy of the class file.
+///
+/// The hash only names the file: as colliding class files are easy to
+/// build, the result of another class must not be trusted.
+static uint8_t matchesClassFile(FILE* file, JavaClass* jc)
+{
+    uint8_t buffer[4096];
+    uint32_t size, offset, length;
+
+    if (fread(&size, sizeof(size), 1, file) != 1 || size != jc->file.size)
+        return 0;
+
+    for (offset = 0; offset < size; offset += length)
+    {
+        length = size - offset < sizeof(buffer) ? size - offset : (uint32_t)sizeof(buffer);
+
+        if (fread(buffer, 1, length, file) != length || memcmp(buffer, jc->file.data + offset, length))
+            return 0;
+    }
+
+    return 1;
+}
+
+/// @brief Reads the verification result of a class from the cache.
+/// @return 1 if the class was found in the cache, in which case the
+/// methods that passed verification are flagged, 0 otherwise.
+static uint8_t loadCachedResult(JavaVirtualMachine* jvm, JavaClass* jc, uint64_t hash)
+{
+    char path[512];
+    char magic[4];
+    uint16_t methodCount, index;
+    att_Code_info* code;
+    uint8_t* verified;
+    uint8_t success;
+
+    getCacheFilePath(jvm, hash, path, sizeof(path));
+
+    FILE* file = fopen(path, "rb");
+
+    if (!file)
+        return 0;
+
+    verified = (uint8_t*)malloc(jc->methodCount + 1);
+
+    // The file must end right after the flags, each 0 or 1
+    success = verified &&
+              fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+              !memcmp(magic, VERIFY_CACHE_MAGIC, sizeof(magic)) &&
+              matchesClassFile(file, jc) &&
+              fread(&methodCount, sizeof(methodCount), 1, file) == 1 &&
+              methodCount == jc->methodCount &&
+              fread(verified, 1, methodCount, file) == methodCount &&
+              fgetc(file) == EOF;
+
+    for (index = 0; success && index < jc->methodCount; index++)
+        success = verified[index] <= 1;
+
+    for (index = 0; success && index < jc->methodCount; index++)
+    {
+        code = getMethodCode(jc, jc->methods + index);
+
+        if (code)
+            code->verified = verified[index];
+    }
+
+    if (verified)
+        free(verified);
+
+    fclose(file);
+    return success;
+}
+
+static void saveCachedResult(JavaVirtualMachine* jvm, JavaClass* jc, uint64_t hash)
+{
+    char path[512];
+    uint16_t index;
+    uint8_t verified;
+    attribute_info* codeAttribute;
+
+    getCacheFilePath(jvm, hash, path, sizeof(path));
+
+    FILE* file = fopen(path, "wb");
+
+    if (!file)
+        return;
+
+    fwrite(VERIFY_CACHE_MAGIC, 1, 4, file);
+    fwrite(&jc->file.size, sizeof(jc->file.size), 1, file);
+    fwrite(jc->file.data, 1, jc->file.size, file);
+    fwrite(&jc->methodCount, sizeof(jc->methodCount), 1, file);
+
+    for (index = 0; index < jc->methodCount; index++)
+    {
+        codeAttribute = getAttributeByType(jc->methods[index].attributes, jc->methods[index].attributes_count, ATTR_Code);
+        verified = codeAttribute && codeAttribute->info && ((att_Code_info*)codeAttribute->info)->verified;
+        fwrite(&verified, 1, 1, file);
+    }
+
+    fclose(file);
+}
+
+static void printVerifyError(JavaClass* jc, method_info* method, uint32_t pc, const char* reason)
+{
+    cp_info* className = jc->constantPool + jc->thisClass - 1;
+    cp_info* methodName = jc->constantPool + method->name_index - 1;
+    cp_info* descriptor = jc->constantPool + method->descriptor_index - 1;
+
+    className = jc->constantPool + className->Class.name_index - 1;
+
+    printf("VerifyError: class %.*s, method %.*s%.*s, offset %u: %s\n",
+           className->Utf8.length, className->Utf8.bytes,
+           methodName->Utf8.length, methodName->Utf8.bytes,
+           descriptor->Utf8.length, descriptor->Utf8.bytes, pc, reason);
+}
+
+/// @brief Verifies all methods of a class.
+///
+/// This is done once, when the class is linked. The type maps are
+/// computed first, unless the result was cached. It has no effect if
+/// verification is disabled in the JVM. Otherwise, a class that fails verification sets the
+/// JVM status to JVM_STATUS_VERIFICATION_FAILED.
+///
+/// @param JavaVirtualMachine* jvm - the JVM loading the class.
+/// @param JavaClass* jc - the class to be verified.
+///
+/// @return 0 if the class failed verification, 1 otherwise.
+/// @see analyzeClassTypes(), verifyMethod()
+uint8_t verifyClass(JavaVirtualMachine* jvm, JavaClass* jc)
+{
+    // Classes of a shared archive were verified when it was dumped,
+    // and their methods are already flagged
+    if (!jvm->verifyClasses || jc->trusted)
+        return 1;
+
+    uint64_t hash = jvm->verifyCachePath ? hashClassFile(jc) : 0;
+    uint16_t index;
+    method_info* method;
+    attribute_info* codeAttribute;
+    att_Code_info* code;
+    const char* reason;
+    uint32_t pc;
+
+    if (jvm->verifyCachePath && loadCachedResult(jvm, jc, hash))
+    {
+        jvm->verifiedClassCount++;
+        jvm->cachedVerificationCount++;
+        return 1;
+    }
+
+    analyzeClassTypes(jvm, jc);
+
+    for (index = 0; index < jc->methodCount; index++)
+    {
+        method = jc->methods + index;
+        codeAttribute = getAttributeByType(method->attributes, method->attributes_count, ATTR_Code);
+
+        if (!codeAttribute)
+            continue;
+
+        if (!decodeAttribute(jc, codeAttribute))
+        {
+            printVerifyError(jc, method, 0, decodeJavaClassStatus(jc->status));
+            jvm->status = JVM_STATUS_VERIFICATION_FAILED;
+            return 0;
+        }
+
+        code = (att_Code_info*)codeAttribute->info;
+
+        if (!code->types && usesUnanalyzedInstructions(jc, code))
+            continue;
+
+        if (!verifyMethod(jc, method, code, &pc, &reason))
+        {
+            printVerifyError(jc, method, pc, reason);
+            jvm->status = JVM_STATUS_VERIFICATION_FAILED;
+            return 0;
+        }
+
+        code->verified = 1;
+    }
+
+    if (jvm->verifyCachePath)
+        saveCachedResult(jvm, jc, hash);
+
+    jvm->verifiedClassCount++;
+    return 1;
+}
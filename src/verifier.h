@@ -0,0 +1,49 @@
+#ifndef VERIFIER_H
+#define VERIFIER_H
+
+#include <stdint.h>
+#include "jvm.h"
+
+uint8_t verifyMethod(JavaClass* jc, method_info* method, att_Code_info* code, uint32_t* outPc, const char** outReason);
+uint8_t verifyClass(JavaVirtualMachine* jvm, JavaClass* jc);
+uint64_t hashClassFile(JavaClass* jc);
+
+#endif // VERIFIER_H
+
+/// @defgroup verifier Verifier module
+///
+/// @brief Checks that the bytecode of a class is type safe before
+/// it is executed.
+///
+/// The types of every local variable and operand stack slot are
+/// inferred when the class is linked (see @ref typemap). Classes
+/// older than version 50 only have that inference. From version 50
+/// on, the frames of the StackMapTable attribute are also checked
+/// against every state reaching them.
+///
+/// The verifier then checks each reachable instruction against the
+/// state before it: operand and local variable types, constant pool
+/// tags, field and method descriptors and the method return type.
+/// Branch targets, stack overflows and underflows and falling off
+/// the end of the code are already rejected by the inference.
+///
+/// Classes failing verification aren't loaded. Methods that passed
+/// are flagged in their Code attribute, and the interpreter skips
+/// the stack bound checks of its fast paths when running them.
+/// Methods using jsr/ret, allowed before version 51, or
+/// invokedynamic, which the type inference doesn't handle, are
+/// accepted without being verified.
+///
+/// With "-Xverifycache:<dir>", the result is saved in a file named
+/// after a hash of the class file, so later runs skip verification
+/// of classes that didn't change. The file holds a copy of the class
+/// file, and a result is only used for a class with the same bytes.
+/// The directory must be as trusted as the class path, as a result
+/// written in it disables the checks of the interpreter.
+/// "-Xstartupreport" prints how many classes were verified and how
+/// many results came from the cache. The fixtures of "test files/"
+/// named verify_*, checked by "make test_verifier", show the errors
+/// reported for invalid code and a cached result being reused.
+/// "-Xverify:none" disables it.
+///
+/// @see verifyClass()
@@ -0,0 +1,14 @@
+/*
+ * Compile with: javac verify_cache.java -target 1.5 -source 1.5
+ * Run twice with -Xverifycache:<dir> -Xstartupreport: the first run
+ * verifies the classes and saves the results in <dir>, the second one
+ * reads them from there instead of verifying the classes again.
+ */
+public class verify_cache{
+	public static void main(String args[]){
+		int sum = 0;
+		for (int i = 1; i <= 10; i++)
+			sum += i;
+		System.out.println(sum);
+	}
+}
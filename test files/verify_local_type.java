@@ -0,0 +1,13 @@
+/*
+ * Compile with: javac verify_local_type.java -target 1.5 -source 1.5
+ * Then patch the fload_2 of main into an iload_2, which loads the float
+ * local f as an int. The verifier must reject the class with a
+ * VerifyError.
+ */
+public class verify_local_type{
+	public static void main(String args[]){
+		int i = 7;
+		float f = 1.5f;
+		System.out.println(f);
+	}
+}
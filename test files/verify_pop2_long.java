@@ -0,0 +1,13 @@
+/*
+ * Compile with: javac verify_pop2_long.java -target 1.5 -source 1.5
+ * Then patch the i2l of main into a pop2, which pops the int b and half
+ * of the long a under it. The verifier must reject the class with a
+ * VerifyError.
+ */
+public class verify_pop2_long{
+	public static void main(String args[]){
+		long a = 5;
+		int b = 3;
+		System.out.println(a + b);
+	}
+}
@@ -0,0 +1,13 @@
+/*
+ * Compile with: javac verify_stack_overflow.java -target 1.5 -source 1.5
+ * Then patch the max_stack of main from 3 to 2, so that pushing a and b
+ * over System.out overflows the operand stack. The verifier must reject
+ * the class with a VerifyError.
+ */
+public class verify_stack_overflow{
+	public static void main(String args[]){
+		int a = 2;
+		int b = 3;
+		System.out.println(a + b);
+	}
+}
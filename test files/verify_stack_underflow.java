@@ -0,0 +1,13 @@
+/*
+ * Compile with: javac verify_stack_underflow.java -target 1.5 -source 1.5
+ * Then patch the iload_1 at offset 2 of main into a nop, so that imul
+ * pops two ints from a stack holding one. The verifier must reject the
+ * class with a VerifyError.
+ */
+public class verify_stack_underflow{
+	public static void main(String args[]){
+		int a = 2;
+		int b = a * 3;
+		System.out.println(b);
+	}
+}
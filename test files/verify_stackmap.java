@@ -0,0 +1,15 @@
+/*
+ * Compile with: javac verify_stackmap.java -target 1.6 -source 1.6
+ * Version 50 classes have a StackMapTable. Patch the frame of the loop,
+ * an append_frame of two ints, to declare sum as a float. The state
+ * reaching the loop doesn't match it, and the verifier must reject the
+ * class with a VerifyError.
+ */
+public class verify_stackmap{
+	public static void main(String args[]){
+		int sum = 0;
+		for (int i = 0; i < 10; i++)
+			sum += i;
+		System.out.println(sum);
+	}
+}
@@ -0,0 +1,13 @@
+/*
+ * Compile with: javac verify_wide_local.java -target 1.5 -source 1.5
+ * The increment doesn't fit a byte, so javac emits a wide iinc. Patch
+ * its local index from 1 to 300, past the max_locals of 2. The verifier
+ * must reject the class with a VerifyError.
+ */
+public class verify_wide_local{
+	public static void main(String args[]){
+		int i = 7;
+		i += 1000;
+		System.out.println(i);
+	}
+}
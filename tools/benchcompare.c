@@ -0,0 +1,181 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+// Compares the results of two runs of "make bench", written with
+// "-Xbench:<file>".
+//
+// Usage: benchcompare <before> <after> [threshold]
+//
+// Prints the operations per second of each benchmark in both files and
+// how much they changed. A change is significant when the 95% confidence
+// intervals of the two runs don't overlap. The exit status is 1 when a
+// benchmark got slower by a significant change of more than <threshold>
+// percent (default: 5), so scripts can fail a build on regressions.
+// When a file has several results for a benchmark, the last one counts.
+
+#define MAX_BENCHMARKS 256
+#define MAX_NAME_LENGTH 64
+
+typedef struct
+{
+    char name[MAX_NAME_LENGTH];
+    double opsPerSecond;
+    double low, high;
+} Result;
+
+typedef struct
+{
+    uint32_t count;
+    Result results[MAX_BENCHMARKS];
+} ResultFile;
+
+/// @brief Finds the value of a key in a JSON line.
+/// @return A pointer to the value, or NULL if the key isn't there.
+static const char* findValue(const char* line, const char* key)
+{
+    char pattern[MAX_NAME_LENGTH + 4];
+    const char* value;
+
+    snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+    value = strstr(line, pattern);
+
+    return value ? value + strlen(pattern) : NULL;
+}
+
+static Result* findResult(ResultFile* file, const char* name)
+{
+    uint32_t index;
+
+    for (index = 0; index < file->count; index++)
+    {
+        if (!strcmp(file->results[index].name, name))
+            return file->results + index;
+    }
+
+    return NULL;
+}
+
+static uint8_t parseLine(const char* line, Result* result)
+{
+    const char* value = findValue(line, "benchmark");
+    uint32_t length = 0;
+
+    if (!value || *value++ != '"')
+        return 0;
+
+    while (value[length] && value[length] != '"' && length < MAX_NAME_LENGTH - 1)
+    {
+        result->name[length] = value[length];
+        length++;
+    }
+
+    result->name[length] = '\0';
+
+    value = findValue(line, "ops_per_s");
+
+    if (!value)
+        return 0;
+
+    result->opsPerSecond = strtod(value, NULL);
+
+    value = findValue(line, "ops_per_s_ci95");
+
+    if (!value || sscanf(value, "[%lf,%lf]", &result->low, &result->high) != 2)
+        result->low = result->high = result->opsPerSecond;
+
+    return 1;
+}
+
+static uint8_t readResults(const char* path, ResultFile* file)
+{
+    FILE* stream = fopen(path, "r");
+    char line[16384];
+    Result result;
+    Result* existing;
+
+    file->count = 0;
+
+    if (!stream)
+        return 0;
+
+    while (fgets(line, sizeof(line), stream))
+    {
+        if (!parseLine(line, &result))
+            continue;
+
+        existing = findResult(file, result.name);
+
+        if (existing)
+            *existing = result;
+        else if (file->count < MAX_BENCHMARKS)
+            file->results[file->count++] = result;
+    }
+
+    fclose(stream);
+    return 1;
+}
+
+int main(int argc, char* args[])
+{
+    static ResultFile before, after;
+    double threshold = argc > 3 ? atof(args[3]) : 5.0;
+    double change;
+    uint32_t index, regressions = 0;
+    uint8_t significant;
+    Result* previous;
+    Result* current;
+
+    if (argc < 3)
+    {
+        printf("Usage: %s <before> <after> [threshold]\n", args[0]);
+        return 2;
+    }
+
+    if (!readResults(args[1], &before))
+    {
+        printf("Couldn't read benchmark results '%s'\n", args[1]);
+        return 2;
+    }
+
+    if (!readResults(args[2], &after))
+    {
+        printf("Couldn't read benchmark results '%s'\n", args[2]);
+        return 2;
+    }
+
+    printf("%-24s %16s %16s %9s\n", "benchmark", "before (ops/s)", "after (ops/s)", "change");
+
+    for (index = 0; index < after.count; index++)
+    {
+        current = after.results + index;
+        previous = findResult(&before, current->name);
+
+        if (!previous)
+        {
+            printf("%-24s %16s %16.0f %9s\n", current->name, "-", current->opsPerSecond, "new");
+            continue;
+        }
+
+        change = previous->opsPerSecond > 0 ? (current->opsPerSecond - previous->opsPerSecond) * 100 / previous->opsPerSecond : 0;
+        significant = current->high < previous->low || current->low > previous->high;
+
+        printf("%-24s %16.0f %16.0f %+8.1f%%%s\n", current->name, previous->opsPerSecond, current->opsPerSecond, change,
+               significant ? (change < -threshold ? " regression" : " significant") : "");
+
+        if (significant && change < -threshold)
+            regressions++;
+    }
+
+    for (index = 0; index < before.count; index++)
+    {
+        if (!findResult(&after, before.results[index].name))
+            printf("%-24s %16.0f %16s %9s\n", before.results[index].name, before.results[index].opsPerSecond, "-", "gone");
+    }
+
+    if (regressions)
+        printf("%u benchmark(s) got slower by more than %.1f%%\n", regressions, threshold);
+
+    return regressions ? 1 : 0;
+}
@@ -0,0 +1,644 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+
+// Reads a heap dump written by the JVM with "-Xheapdump:<file>" and
+// prints the memory kept alive by each type and by the largest objects.
+//
+// Usage: heapanalyze <dump> [rows]
+//
+// An object's retained size is its own size plus the size of every
+// object that is only reachable through it, which is the memory that
+// would be freed if it became garbage. It is computed from the
+// dominator tree of the object graph, rooted at the static fields and
+// frame slots. Unless "-Xgc" collects them, the JVM keeps objects
+// unreachable from the roots, which are reported apart, as garbage.
+
+#define HEAP_DUMP_NULL 0xFFFFFFFFu
+#define HEAP_TYPE_CLASS 0
+#define HEAP_TYPE_OBJECT_ARRAY 2
+
+// Dominator of nodes not reached from the roots
+#define UNDEFINED 0xFFFFFFFFu
+
+typedef struct
+{
+    uint8_t kind;
+    char* name;
+
+    // Whether each slot of the instances holds a reference
+    uint16_t slotCount;
+    uint8_t* isReference;
+
+    uint32_t count;
+    uint64_t bytes;
+    uint64_t retained;
+
+    // Objects of this type on the current dominator tree path
+    uint32_t activeCount;
+} Type;
+
+/// @brief The object graph. Node 0 is a root pointing to every root
+/// object, and node i + 1 is object i of the dump.
+typedef struct
+{
+    uint32_t typeCount;
+    Type* types;
+
+    uint32_t nodeCount;
+    uint32_t* nodeTypes;
+    uint32_t* sizes;
+
+    // Edges of node i are edges[edgeStart[i]] to edges[edgeStart[i + 1] - 1]
+    uint32_t* edgeStart;
+    uint32_t* edges;
+    uint32_t edgeCount;
+    uint32_t edgeCapacity;
+} Graph;
+
+static uint8_t readU8(FILE* file, uint8_t* value)
+{
+    int byte = fgetc(file);
+
+    *value = (uint8_t)byte;
+    return byte != EOF;
+}
+
+static uint8_t readU16(FILE* file, uint16_t* value)
+{
+    uint8_t low, high;
+
+    if (!readU8(file, &low) || !readU8(file, &high))
+        return 0;
+
+    *value = (uint16_t)(low | (high << 8));
+    return 1;
+}
+
+static uint8_t readU32(FILE* file, uint32_t* value)
+{
+    uint16_t low, high;
+
+    if (!readU16(file, &low) || !readU16(file, &high))
+        return 0;
+
+    *value = (uint32_t)low | ((uint32_t)high << 16);
+    return 1;
+}
+
+/// @brief Reads a u16 length and that many bytes, as a C string.
+static char* readName(FILE* file)
+{
+    uint16_t length;
+    char* name;
+
+    if (!readU16(file, &length) || !(name = (char*)malloc(length + 1u)))
+        return NULL;
+
+    if (fread(name, 1, length, file) != length)
+    {
+        free(name);
+        return NULL;
+    }
+
+    name[length] = '\0';
+    return name;
+}
+
+static uint8_t addEdge(Graph* graph, uint32_t to)
+{
+    if (graph->edgeCount == graph->edgeCapacity)
+    {
+        uint32_t capacity = graph->edgeCapacity ? graph->edgeCapacity * 2 : 1024;
+        uint32_t* edges = (uint32_t*)malloc(capacity * sizeof(uint32_t));
+
+        if (!edges)
+            return 0;
+
+        if (graph->edges)
+        {
+            memcpy(edges, graph->edges, graph->edgeCount * sizeof(uint32_t));
+            free(graph->edges);
+        }
+
+        graph->edges = edges;
+        graph->edgeCapacity = capacity;
+    }
+
+    graph->edges[graph->edgeCount++] = to;
+    return 1;
+}
+
+static uint8_t readType(FILE* file, Type* type)
+{
+    uint16_t fieldCount, index, slot;
+    uint8_t isReference;
+    char* name;
+
+    memset(type, 0, sizeof(Type));
+
+    if (!readU8(file, &type->kind) || !(type->name = readName(file)))
+        return 0;
+
+    if (type->kind != HEAP_TYPE_CLASS)
+        return 1;
+
+    if (!readU16(file, &type->slotCount) || !readU16(file, &fieldCount))
+        return 0;
+
+    type->isReference = (uint8_t*)malloc(type->slotCount + 1u);
+
+    if (!type->isReference)
+        return 0;
+
+    memset(type->isReference, 0, type->slotCount + 1u);
+
+    for (index = 0; index < fieldCount; index++)
+    {
+        if (!readU16(file, &slot) || !readU8(file, &isReference))
+            return 0;
+
+        // Field names and descriptors aren't needed for sizes
+        if (!(name = readName(file)))
+            return 0;
+
+        free(name);
+
+        if (!(name = readName(file)))
+            return 0;
+
+        free(name);
+
+        if (slot < type->slotCount)
+            type->isReference[slot] = isReference;
+    }
+
+    return 1;
+}
+
+/// @brief Reads a dump into a graph.
+/// @return 1 on success, 0 if the file is invalid or memory runs out.
+static uint8_t readDump(const char* path, Graph* graph)
+{
+    char magic[8];
+    uint32_t version, objectCount, rootCount, index, length, value, item;
+    uint8_t rootKind;
+    uint8_t success = 0;
+    FILE* file = fopen(path, "rb");
+
+    memset(graph, 0, sizeof(Graph));
+
+    if (!file)
+        return 0;
+
+    if (fread(magic, 1, sizeof(magic), file) != sizeof(magic) || memcmp(magic, "JVMHEAP", 8) ||
+        !readU32(file, &version) || version != 1 || !readU32(file, &graph->typeCount) ||
+        !readU32(file, &objectCount) || !readU32(file, &rootCount))
+    {
+        goto done;
+    }
+
+    graph->types = (Type*)malloc((graph->typeCount + 1) * sizeof(Type));
+    graph->nodeCount = objectCount + 1;
+    graph->nodeTypes = (uint32_t*)malloc(graph->nodeCount * sizeof(uint32_t));
+    graph->sizes = (uint32_t*)malloc(graph->nodeCount * sizeof(uint32_t));
+    graph->edgeStart = (uint32_t*)malloc((graph->nodeCount + 1) * sizeof(uint32_t));
+
+    if (!graph->types || !graph->nodeTypes || !graph->sizes || !graph->edgeStart)
+        goto done;
+
+    for (index = 0; index < graph->typeCount; index++)
+    {
+        if (!readType(file, graph->types + index))
+        {
+            graph->typeCount = index + 1;
+            goto done;
+        }
+    }
+
+    // The root node is filled in last, as its edges are the roots
+    graph->sizes[0] = 0;
+    graph->nodeTypes[0] = UNDEFINED;
+
+    for (index = 1; index < graph->nodeCount; index++)
+    {
+        Type* type;
+
+        graph->edgeStart[index] = graph->edgeCount;
+
+        if (!readU32(file, graph->nodeTypes + index) || graph->nodeTypes[index] >= graph->typeCount ||
+            !readU32(file, graph->sizes + index) || !readU32(file, &length))
+        {
+            goto done;
+        }
+
+        type = graph->types + graph->nodeTypes[index];
+        type->count++;
+        type->bytes += graph->sizes[index];
+
+        // Primitive arrays and strings are written without their data
+        if (type->kind != HEAP_TYPE_CLASS && type->kind != HEAP_TYPE_OBJECT_ARRAY)
+            continue;
+
+        for (item = 0; item < length; item++)
+        {
+            if (!readU32(file, &value))
+                goto done;
+
+            if ((type->kind != HEAP_TYPE_CLASS || (item < type->slotCount && type->isReference[item])) &&
+                value != HEAP_DUMP_NULL && value < objectCount && !addEdge(graph, value + 1))
+            {
+                goto done;
+            }
+        }
+    }
+
+    graph->edgeStart[graph->nodeCount] = graph->edgeCount;
+
+    // Roots are kept apart, then moved to the front as node 0's edges
+    {
+        uint32_t objectEdges = graph->edgeCount;
+        uint32_t* rotated;
+
+        for (index = 0; index < rootCount; index++)
+        {
+            if (!readU8(file, &rootKind) || !readU32(file, &value))
+                goto done;
+
+            if (value < objectCount && !addEdge(graph, value + 1))
+                goto done;
+        }
+
+        rotated = (uint32_t*)malloc((graph->edgeCount + 1) * sizeof(uint32_t));
+
+        if (!rotated)
+            goto done;
+
+        memcpy(rotated, graph->edges + objectEdges, (graph->edgeCount - objectEdges) * sizeof(uint32_t));
+        memcpy(rotated + graph->edgeCount - objectEdges, graph->edges, objectEdges * sizeof(uint32_t));
+        free(graph->edges);
+        graph->edges = rotated;
+
+        for (index = 1; index <= graph->nodeCount; index++)
+            graph->edgeStart[index] += graph->edgeCount - objectEdges;
+
+        graph->edgeStart[0] = 0;
+    }
+
+    success = 1;
+
+done:
+    fclose(file);
+    return success;
+}
+
+static void freeGraph(Graph* graph)
+{
+    uint32_t index;
+
+    for (index = 0; graph->types && index < graph->typeCount; index++)
+    {
+        free(graph->types[index].name);
+        free(graph->types[index].isReference);
+    }
+
+    free(graph->types);
+    free(graph->nodeTypes);
+    free(graph->sizes);
+    free(graph->edgeStart);
+    free(graph->edges);
+}
+
+/// @brief Numbers the nodes reachable from node 0 in postorder.
+/// @return The number of nodes reached, listed in \c outOrder.
+static uint32_t orderNodes(Graph* graph, uint32_t* outOrder, uint32_t* outNumbers)
+{
+    uint32_t* stack = (uint32_t*)malloc(graph->nodeCount * sizeof(uint32_t));
+    uint32_t* nextEdge = (uint32_t*)malloc(graph->nodeCount * sizeof(uint32_t));
+    uint32_t top = 0, count = 0, node, child;
+
+    if (!stack || !nextEdge)
+    {
+        free(stack);
+        free(nextEdge);
+        return 0;
+    }
+
+    for (node = 0; node < graph->nodeCount; node++)
+        outNumbers[node] = UNDEFINED;
+
+    // Nodes on the stack are marked with a number past the last one
+    stack[top++] = 0;
+    nextEdge[0] = graph->edgeStart[0];
+    outNumbers[0] = graph->nodeCount;
+
+    while (top)
+    {
+        node = stack[top - 1];
+
+        if (nextEdge[node] < graph->edgeStart[node + 1])
+        {
+            child = graph->edges[nextEdge[node]++];
+
+            if (outNumbers[child] == UNDEFINED)
+            {
+                outNumbers[child] = graph->nodeCount;
+                nextEdge[child] = graph->edgeStart[child];
+                stack[top++] = child;
+            }
+        }
+        else
+        {
+            outNumbers[node] = count;
+            outOrder[count++] = node;
+            top--;
+        }
+    }
+
+    free(stack);
+    free(nextEdge);
+    return count;
+}
+
+static uint32_t intersect(const uint32_t* dominators, const uint32_t* numbers, uint32_t node1, uint32_t node2)
+{
+    while (node1 != node2)
+    {
+        while (numbers[node1] < numbers[node2])
+            node1 = dominators[node1];
+
+        while (numbers[node2] < numbers[node1])
+            node2 = dominators[node2];
+    }
+
+    return node1;
+}
+
+/// @brief Finds the immediate dominator of each node, with the
+/// iterative algorithm of Cooper, Harvey and Kennedy.
+/// @return 1 on success, 0 if there is not enough memory.
+static uint8_t findDominators(Graph* graph, const uint32_t* order, const uint32_t* numbers, uint32_t reached,
+                              uint32_t* outDominators)
+{
+    uint32_t* predecessorStart = (uint32_t*)malloc((graph->nodeCount + 1) * sizeof(uint32_t));
+    uint32_t* predecessors = (uint32_t*)malloc((graph->edgeCount + 1) * sizeof(uint32_t));
+    uint32_t* fill = (uint32_t*)malloc((graph->nodeCount + 1) * sizeof(uint32_t));
+    uint32_t node, edge, index, dominator, predecessor;
+    uint8_t changed = 1;
+
+    if (!predecessorStart || !predecessors || !fill)
+    {
+        free(predecessorStart);
+        free(predecessors);
+        free(fill);
+        return 0;
+    }
+
+    memset(predecessorStart, 0, (graph->nodeCount + 1) * sizeof(uint32_t));
+
+    for (edge = 0; edge < graph->edgeCount; edge++)
+        predecessorStart[graph->edges[edge] + 1]++;
+
+    for (node = 0; node < graph->nodeCount; node++)
+        predecessorStart[node + 1] += predecessorStart[node];
+
+    memcpy(fill, predecessorStart, (graph->nodeCount + 1) * sizeof(uint32_t));
+
+    for (node = 0; node < graph->nodeCount; node++)
+    {
+        for (edge = graph->edgeStart[node]; edge < graph->edgeStart[node + 1]; edge++)
+            predecessors[fill[graph->edges[edge]]++] = node;
+    }
+
+    for (node = 0; node < graph->nodeCount; node++)
+        outDominators[node] = UNDEFINED;
+
+    outDominators[0] = 0;
+
+    while (changed)
+    {
+        changed = 0;
+
+        // Reverse postorder, skipping node 0, which is last
+        for (index = reached - 1; index-- > 0;)
+        {
+            node = order[index];
+            dominator = UNDEFINED;
+
+            for (edge = predecessorStart[node]; edge < predecessorStart[node + 1]; edge++)
+            {
+                predecessor = predecessors[edge];
+
+                if (outDominators[predecessor] == UNDEFINED)
+                    continue;
+
+                dominator = dominator == UNDEFINED ? predecessor : intersect(outDominators, numbers, predecessor, dominator);
+            }
+
+            if (outDominators[node] != dominator)
+            {
+                outDominators[node] = dominator;
+                changed = 1;
+            }
+        }
+    }
+
+    free(predecessorStart);
+    free(predecessors);
+    free(fill);
+    return 1;
+}
+
+/// @brief Adds the retained size of each type: the size of the objects
+/// dominated by at least one object of the type, each counted once.
+static void sumTypeRetained(Graph* graph, const uint32_t* dominators, const uint64_t* retained)
+{
+    uint32_t* childStart = (uint32_t*)malloc((graph->nodeCount + 1) * sizeof(uint32_t));
+    uint32_t* children = (uint32_t*)malloc(graph->nodeCount * sizeof(uint32_t));
+    uint32_t* fill = (uint32_t*)malloc((graph->nodeCount + 1) * sizeof(uint32_t));
+    uint32_t* stack = (uint32_t*)malloc(graph->nodeCount * sizeof(uint32_t));
+    uint32_t* nextChild = (uint32_t*)malloc(graph->nodeCount * sizeof(uint32_t));
+    uint32_t node, top = 0;
+    Type* type;
+
+    if (childStart && children && fill && stack && nextChild)
+    {
+        memset(childStart, 0, (graph->nodeCount + 1) * sizeof(uint32_t));
+
+        for (node = 1; node < graph->nodeCount; node++)
+        {
+            if (dominators[node] != UNDEFINED)
+                childStart[dominators[node] + 1]++;
+        }
+
+        for (node = 0; node < graph->nodeCount; node++)
+            childStart[node + 1] += childStart[node];
+
+        memcpy(fill, childStart, (graph->nodeCount + 1) * sizeof(uint32_t));
+
+        for (node = 1; node < graph->nodeCount; node++)
+        {
+            if (dominators[node] != UNDEFINED)
+                children[fill[dominators[node]]++] = node;
+        }
+
+        // Walks the dominator tree, charging an object's retained size
+        // to its type unless an object of the same type dominates it.
+        stack[top++] = 0;
+        nextChild[0] = childStart[0];
+
+        while (top)
+        {
+            node = stack[top - 1];
+
+            if (nextChild[node] < childStart[node + 1])
+            {
+                uint32_t child = children[nextChild[node]++];
+
+                type = graph->types + graph->nodeTypes[child];
+
+                if (!type->activeCount)
+                    type->retained += retained[child];
+
+                type->activeCount++;
+                nextChild[child] = childStart[child];
+                stack[top++] = child;
+            }
+            else
+            {
+                if (node)
+                    graph->types[graph->nodeTypes[node]].activeCount--;
+
+                top--;
+            }
+        }
+    }
+
+    free(childStart);
+    free(children);
+    free(fill);
+    free(stack);
+    free(nextChild);
+}
+
+static const uint64_t* sortedRetained;
+
+static int compareRetained(const void* a, const void* b)
+{
+    uint64_t retained1 = sortedRetained[*(const uint32_t*)a];
+    uint64_t retained2 = sortedRetained[*(const uint32_t*)b];
+
+    return retained1 < retained2 ? 1 : (retained1 > retained2 ? -1 : 0);
+}
+
+static int compareTypeRetained(const void* a, const void* b)
+{
+    const Type* type1 = (const Type*)a;
+    const Type* type2 = (const Type*)b;
+
+    if (type1->retained != type2->retained)
+        return type1->retained < type2->retained ? 1 : -1;
+
+    return type1->bytes < type2->bytes ? 1 : (type1->bytes > type2->bytes ? -1 : 0);
+}
+
+int main(int argc, char* args[])
+{
+    Graph graph;
+    uint32_t rows = argc > 2 ? (uint32_t)atoi(args[2]) : 20;
+    uint32_t *order, *numbers, *dominators, *largest;
+    uint64_t* retained;
+    uint64_t totalBytes = 0, garbageBytes = 0;
+    uint32_t reached, index, node, garbageCount = 0;
+
+    if (argc < 2)
+    {
+        printf("Usage: %s <dump> [rows]\n", args[0]);
+        return 1;
+    }
+
+    if (!readDump(args[1], &graph))
+    {
+        printf("Couldn't read heap dump '%s'\n", args[1]);
+        freeGraph(&graph);
+        return 1;
+    }
+
+    order = (uint32_t*)malloc(graph.nodeCount * sizeof(uint32_t));
+    numbers = (uint32_t*)malloc(graph.nodeCount * sizeof(uint32_t));
+    dominators = (uint32_t*)malloc(graph.nodeCount * sizeof(uint32_t));
+    largest = (uint32_t*)malloc(graph.nodeCount * sizeof(uint32_t));
+    retained = (uint64_t*)malloc(graph.nodeCount * sizeof(uint64_t));
+
+    if (!order || !numbers || !dominators || !largest || !retained ||
+        !(reached = orderNodes(&graph, order, numbers)) ||
+        !findDominators(&graph, order, numbers, reached, dominators))
+    {
+        printf("Not enough memory\n");
+        return 1;
+    }
+
+    // Postorder visits every node after the nodes it dominates
+    for (node = 0; node < graph.nodeCount; node++)
+        retained[node] = graph.sizes[node];
+
+    for (index = 0; index + 1 < reached; index++)
+    {
+        node = order[index];
+        retained[dominators[node]] += retained[node];
+    }
+
+    for (node = 1; node < graph.nodeCount; node++)
+    {
+        totalBytes += graph.sizes[node];
+
+        if (dominators[node] == UNDEFINED)
+        {
+            garbageCount++;
+            garbageBytes += graph.sizes[node];
+        }
+    }
+
+    printf("Objects: %u, %" PRIu64 " bytes\n", graph.nodeCount - 1, totalBytes);
+    printf("Reachable from %u roots: %u, %" PRIu64 " bytes\n",
+           graph.edgeStart[1] - graph.edgeStart[0], reached - 1, retained[0]);
+    printf("Garbage: %u, %" PRIu64 " bytes\n", garbageCount, garbageBytes);
+
+    sumTypeRetained(&graph, dominators, retained);
+
+    // Objects sorted first, as sorting the types renumbers them
+    for (index = 0; index + 1 < reached; index++)
+        largest[index] = order[index];
+
+    sortedRetained = retained;
+    qsort(largest, reached - 1, sizeof(uint32_t), compareRetained);
+
+    printf("\n  %-6s %-40s %14s %14s\n", "Object", "Type", "Shallow", "Retained");
+
+    for (index = 0; index + 1 < reached && index < rows; index++)
+    {
+        node = largest[index];
+        printf("  %-6u %-40s %14u %14" PRIu64 "\n", node - 1, graph.types[graph.nodeTypes[node]].name,
+               graph.sizes[node], retained[node]);
+    }
+
+    qsort(graph.types, graph.typeCount, sizeof(Type), compareTypeRetained);
+
+    printf("\n  %-40s %10s %14s %14s\n", "Type", "Instances", "Shallow", "Retained");
+
+    for (index = 0; index < graph.typeCount && index < rows; index++)
+    {
+        printf("  %-40s %10u %14" PRIu64 " %14" PRIu64 "\n", graph.types[index].name, graph.types[index].count,
+               graph.types[index].bytes, graph.types[index].retained);
+    }
+
+    free(order);
+    free(numbers);
+    free(dominators);
+    free(largest);
+    free(retained);
+    freeGraph(&graph);
+    return 0;
+}
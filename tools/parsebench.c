@@ -0,0 +1,266 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "../src/javaclass.h"
+
+// Measures the throughput of the class file parser, in MB/s.
+//
+// Usage: parsebench [-n iterations] [-g fields] [file.class | @listfile]...
+//
+// A "@listfile" argument contains one class file path per line, which
+// allows large corpora, for example "find / -name '*.class' > list".
+// "-g" adds a class generated in memory, with the given number of
+// fields (up to 16382) of long class types, whose constant pool is
+// mostly class names and descriptors, to measure the UTF-8 and
+// identifier checks. Every file is parsed once to warm the page cache,
+// then the whole corpus is parsed the given number of times (10 by
+// default).
+
+#define MAX_PATH_LENGTH 1024
+
+typedef struct
+{
+    char** paths;
+    uint32_t count;
+    uint32_t capacity;
+
+    // Class generated with "-g", or NULL
+    uint8_t* generated;
+    uint32_t generatedSize;
+} Corpus;
+
+static void addPath(Corpus* corpus, const char* path)
+{
+    if (corpus->count == corpus->capacity)
+    {
+        uint32_t capacity = corpus->capacity ? corpus->capacity * 2 : 256;
+        char** paths = (char**)malloc(sizeof(char*) * capacity);
+
+        if (!paths)
+            return;
+
+        if (corpus->paths)
+        {
+            memcpy(paths, corpus->paths, sizeof(char*) * corpus->count);
+            free(corpus->paths);
+        }
+
+        corpus->paths = paths;
+        corpus->capacity = capacity;
+    }
+
+    size_t length = strlen(path);
+    char* copy = (char*)malloc(length + 1);
+
+    if (copy)
+    {
+        memcpy(copy, path, length + 1);
+        corpus->paths[corpus->count++] = copy;
+    }
+}
+
+static void addListFile(Corpus* corpus, const char* listPath)
+{
+    char line[MAX_PATH_LENGTH];
+    FILE* list = fopen(listPath, "r");
+
+    if (!list)
+    {
+        printf("Couldn't open list file '%s'\n", listPath);
+        return;
+    }
+
+    while (fgets(line, sizeof(line), list))
+    {
+        line[strcspn(line, "\r\n")] = '\0';
+
+        if (line[0])
+            addPath(corpus, line);
+    }
+
+    fclose(list);
+}
+
+static uint8_t* putU2(uint8_t* out, uint16_t value)
+{
+    out[0] = (uint8_t)(value >> 8);
+    out[1] = (uint8_t)value;
+    return out + 2;
+}
+
+static uint8_t* putUtf8(uint8_t* out, const char* text)
+{
+    size_t length = strlen(text);
+
+    *out++ = 1; // CONSTANT_Utf8
+    out = putU2(out, (uint16_t)length);
+    memcpy(out, text, length);
+    return out + length;
+}
+
+static uint8_t* putClass(uint8_t* out, uint16_t nameIndex)
+{
+    *out++ = 7; // CONSTANT_Class
+    return putU2(out, nameIndex);
+}
+
+/// @brief Generates a class named "Generated" with private fields
+/// whose types are distinct classes with long names.
+///
+/// Each field adds four constants: the name of its class, the class,
+/// the field name and the field descriptor.
+static void generateClass(Corpus* corpus, uint32_t fieldCount)
+{
+    char text[128];
+    uint32_t index;
+    uint16_t base;
+
+    if (fieldCount > 16382)
+        fieldCount = 16382;
+
+    uint8_t* data = (uint8_t*)malloc(64 + fieldCount * 240);
+    uint8_t* out = data;
+
+    if (!data)
+        return;
+
+    out = putU2(putU2(out, 0xCAFE), 0xBABE);
+    out = putU2(putU2(out, 0), 50);
+    out = putU2(out, (uint16_t)(5 + fieldCount * 4));
+
+    out = putUtf8(out, "Generated");
+    out = putClass(out, 1);
+    out = putUtf8(out, "java/lang/Object");
+    out = putClass(out, 3);
+
+    for (index = 0; index < fieldCount; index++)
+    {
+        base = (uint16_t)(5 + index * 4);
+        sprintf(text, "generated/package%04u/AVeryLongGeneratedClassName%06u", index % 100, index);
+        out = putUtf8(out, text);
+        out = putClass(out, base);
+        sprintf(text, "generatedFieldWithALongName%06u", index);
+        out = putUtf8(out, text);
+        sprintf(text, "Lgenerated/package%04u/AVeryLongGeneratedClassName%06u;", index % 100, index);
+        out = putUtf8(out, text);
+    }
+
+    out = putU2(out, 0x21);    // ACC_PUBLIC | ACC_SUPER
+    out = putU2(out, 2);       // this_class
+    out = putU2(out, 4);       // super_class
+    out = putU2(out, 0);       // interfaces_count
+    out = putU2(out, (uint16_t)fieldCount);
+
+    for (index = 0; index < fieldCount; index++)
+    {
+        base = (uint16_t)(5 + index * 4);
+        out = putU2(out, 0x02); // ACC_PRIVATE
+        out = putU2(out, base + 2);
+        out = putU2(out, base + 3);
+        out = putU2(out, 0);
+    }
+
+    out = putU2(out, 0);       // methods_count
+    out = putU2(out, 0);       // attributes_count
+
+    corpus->generated = data;
+    corpus->generatedSize = (uint32_t)(out - data);
+}
+
+/// @brief Parses every file of the corpus once.
+/// @param [out] uint64_t* outBytes - total size of the files parsed.
+/// @return Number of files that failed to parse.
+static uint32_t parseCorpus(Corpus* corpus, uint64_t* outBytes)
+{
+    JavaClass jc;
+    uint32_t index;
+    uint32_t failures = 0;
+
+    *outBytes = 0;
+
+    for (index = 0; index < corpus->count; index++)
+    {
+        openClassFile(&jc, corpus->paths[index]);
+
+        if (jc.status == CLASS_STATUS_OK)
+            *outBytes += jc.file.size;
+        else
+            failures++;
+
+        closeClassFile(&jc);
+    }
+
+    if (corpus->generated)
+    {
+        openClassData(&jc, "Generated", corpus->generated, corpus->generatedSize, CLASS_FILE_BORROWED, 0);
+
+        if (jc.status == CLASS_STATUS_OK)
+            *outBytes += jc.file.size;
+        else
+            failures++;
+
+        closeClassFile(&jc);
+    }
+
+    return failures;
+}
+
+int main(int argc, char* argv[])
+{
+    Corpus corpus = {NULL, 0, 0, NULL, 0};
+    uint32_t iterations = 10;
+    uint32_t iteration, failures;
+    uint64_t bytes, totalBytes = 0;
+    int argIndex;
+
+    for (argIndex = 1; argIndex < argc; argIndex++)
+    {
+        if (!strcmp(argv[argIndex], "-n") && argIndex + 1 < argc)
+            iterations = (uint32_t)strtoul(argv[++argIndex], NULL, 10);
+        else if (!strcmp(argv[argIndex], "-g") && argIndex + 1 < argc)
+            generateClass(&corpus, (uint32_t)strtoul(argv[++argIndex], NULL, 10));
+        else if (argv[argIndex][0] == '@')
+            addListFile(&corpus, argv[argIndex] + 1);
+        else
+            addPath(&corpus, argv[argIndex]);
+    }
+
+    if ((corpus.count == 0 && !corpus.generated) || iterations == 0)
+    {
+        printf("Usage: parsebench [-n iterations] [-g fields] [file.class | @listfile]...\n");
+        return 1;
+    }
+
+    failures = parseCorpus(&corpus, &bytes);
+
+    clock_t start = clock();
+
+    for (iteration = 0; iteration < iterations; iteration++)
+    {
+        parseCorpus(&corpus, &bytes);
+        totalBytes += bytes;
+    }
+
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    printf("Files: %u (%u failed to parse)\n", corpus.count + (corpus.generated != NULL), failures);
+    printf("Bytes per iteration: %llu\n", (unsigned long long)bytes);
+    printf("Iterations: %u\n", iterations);
+    printf("Time: %.3f s\n", seconds);
+
+    if (seconds > 0)
+        printf("Throughput: %.2f MB/s\n", totalBytes / seconds / (1024.0 * 1024.0));
+
+    for (argIndex = 0; (uint32_t)argIndex < corpus.count; argIndex++)
+        free(corpus.paths[argIndex]);
+
+    if (corpus.paths)
+        free(corpus.paths);
+
+    if (corpus.generated)
+        free(corpus.generated);
+
+    return 0;
+}
@@ -0,0 +1,339 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <ctype.h>
+#include "../src/perfdata.h"
+#include "../src/threads.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// Reads the counters a JVM publishes with "-Xperfdata".
+//
+// Usage: perfstat <file|pid>                 prints the counters
+//        perfstat <file|pid> <ms> [count]    prints them and their rates every <ms> milliseconds
+//        perfstat -d <before> <after>        prints how much each counter changed
+//
+// A pid stands for the default file of that JVM, "/tmp/jvmperf_<pid>".
+// Copies of a counters file, made with "cp" while the JVM runs or of a
+// file named with "-Xperfdata:<file>" after it exits, are snapshots
+// that "-d" compares. Counters are matched by name, so snapshots of
+// JVMs publishing different counters can be compared too.
+
+#define MAX_COUNTERS 256
+
+typedef struct
+{
+    uint32_t pid;
+    uint32_t state;
+    uint64_t startTime;
+    uint32_t count;
+    char names[MAX_COUNTERS][PERF_DATA_NAME_LENGTH];
+    uint64_t values[MAX_COUNTERS];
+} Snapshot;
+
+/// @brief A counters file, mapped for reading except on Windows.
+typedef struct
+{
+    const char* path;
+    const uint8_t* data;
+    uint32_t size;
+} CounterFile;
+
+static const char* const stateNames[] = { "starting", "running", "exited" };
+
+static uint8_t openCounterFile(CounterFile* file, const char* path)
+{
+#ifdef _WIN32
+    // Windows keeps the file coherent with the mapping of the JVM, so
+    // reading it again sees the counters as they change
+    FILE* stream = fopen(path, "rb");
+    long size;
+
+    file->path = path;
+    file->data = NULL;
+
+    if (!stream)
+        return 0;
+
+    fseek(stream, 0, SEEK_END);
+    size = ftell(stream);
+
+    if (size <= 0)
+    {
+        fclose(stream);
+        return 0;
+    }
+
+    file->size = (uint32_t)size;
+    fclose(stream);
+    return 1;
+#else
+    struct stat status;
+    void* data;
+    int descriptor = open(path, O_RDONLY);
+
+    if (descriptor < 0)
+        return 0;
+
+    if (fstat(descriptor, &status) || status.st_size < (off_t)offsetof(PerfData, entries))
+    {
+        close(descriptor);
+        return 0;
+    }
+
+    data = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_SHARED, descriptor, 0);
+    close(descriptor);
+
+    if (data == MAP_FAILED)
+        return 0;
+
+    file->path = path;
+    file->data = (const uint8_t*)data;
+    file->size = (uint32_t)status.st_size;
+    return 1;
+#endif
+}
+
+static void closeCounterFile(CounterFile* file)
+{
+#ifndef _WIN32
+    munmap((void*)file->data, file->size);
+#endif
+}
+
+/// @brief Copies the counters of a file. On Windows the file is read
+/// again each time, elsewhere the mapping shows the current values.
+static uint8_t takeSnapshot(CounterFile* file, Snapshot* snapshot)
+{
+    const uint8_t* data = file->data;
+    const PerfData* header;
+    uint32_t index;
+
+#ifdef _WIN32
+    static uint8_t* buffer;
+    FILE* stream = fopen(file->path, "rb");
+
+    if (!buffer)
+        buffer = (uint8_t*)malloc(file->size);
+
+    if (!stream || !buffer || fread(buffer, 1, file->size, stream) != file->size)
+    {
+        if (stream)
+            fclose(stream);
+
+        return 0;
+    }
+
+    fclose(stream);
+    data = buffer;
+#endif
+
+    header = (const PerfData*)data;
+
+    if (memcmp(header->magic, PERF_DATA_MAGIC, sizeof(PERF_DATA_MAGIC)) || header->version != PERF_DATA_VERSION)
+        return 0;
+
+    snapshot->state = loadAcquire(&header->state);
+
+    if (snapshot->state == PERF_DATA_STARTING || header->entrySize < sizeof(PerfDataEntry) ||
+        header->entryCount > MAX_COUNTERS ||
+        (uint64_t)header->headerSize + (uint64_t)header->entryCount * header->entrySize > file->size)
+    {
+        return 0;
+    }
+
+    snapshot->pid = header->pid;
+    snapshot->startTime = header->startTime;
+    snapshot->count = header->entryCount;
+
+    for (index = 0; index < snapshot->count; index++)
+    {
+        const PerfDataEntry* entry = (const PerfDataEntry*)(data + header->headerSize + index * header->entrySize);
+
+        memcpy(snapshot->names[index], entry->name, PERF_DATA_NAME_LENGTH);
+        snapshot->names[index][PERF_DATA_NAME_LENGTH - 1] = '\0';
+        snapshot->values[index] = readPerfCounter(&entry->value);
+    }
+
+    return 1;
+}
+
+static uint8_t readSnapshot(const char* path, Snapshot* snapshot)
+{
+    CounterFile file;
+    uint8_t success;
+
+    if (!openCounterFile(&file, path))
+        return 0;
+
+    success = takeSnapshot(&file, snapshot);
+    closeCounterFile(&file);
+    return success;
+}
+
+static const char* getStateName(uint32_t state)
+{
+    return state <= PERF_DATA_EXITED ? stateNames[state] : "unknown";
+}
+
+static void printSnapshot(const Snapshot* snapshot)
+{
+    uint32_t index;
+
+    printf("JVM %u, %s\n", snapshot->pid, getStateName(snapshot->state));
+
+    for (index = 0; index < snapshot->count; index++)
+        printf("  %-28s %20" PRIu64 "\n", snapshot->names[index], snapshot->values[index]);
+}
+
+static void printDifference(const Snapshot* before, const Snapshot* after, double seconds)
+{
+    uint32_t index, other;
+
+    if (seconds > 0)
+        printf("  %-28s %20s %20s %16s\n", "Counter", "Value", "Change", "Per second");
+    else
+        printf("  %-28s %20s %20s %20s\n", "Counter", "Before", "After", "Change");
+
+    for (index = 0; index < after->count; index++)
+    {
+        uint64_t previous = 0;
+        uint8_t found = 0;
+        int64_t change;
+
+        for (other = 0; other < before->count && !found; other++)
+        {
+            if (!strcmp(before->names[other], after->names[index]))
+            {
+                previous = before->values[other];
+                found = 1;
+            }
+        }
+
+        change = (int64_t)(after->values[index] - previous);
+
+        if (seconds > 0)
+        {
+            printf("  %-28s %20" PRIu64 " %+20" PRId64 " %16.0f\n", after->names[index], after->values[index], change,
+                   change / seconds);
+        }
+        else if (found)
+        {
+            printf("  %-28s %20" PRIu64 " %20" PRIu64 " %+20" PRId64 "\n", after->names[index], previous,
+                   after->values[index], change);
+        }
+        else
+        {
+            printf("  %-28s %20s %20" PRIu64 "\n", after->names[index], "-", after->values[index]);
+        }
+    }
+}
+
+static const char* getCounterPath(const char* argument, char* buffer, size_t size)
+{
+    const char* character;
+
+    for (character = argument; isdigit((unsigned char)*character); character++);
+
+    if (*character || character == argument)
+        return argument;
+
+#ifdef _WIN32
+    snprintf(buffer, size, "%s\\jvmperf_%s", getenv("TEMP") ? getenv("TEMP") : ".", argument);
+#else
+    snprintf(buffer, size, "/tmp/jvmperf_%s", argument);
+#endif
+    return buffer;
+}
+
+static int watchCounters(const char* path, uint32_t milliseconds, uint32_t count)
+{
+    static Snapshot snapshots[2];
+    CounterFile file;
+    double previousTime, time;
+    uint32_t sample;
+
+    if (!openCounterFile(&file, path) || !takeSnapshot(&file, snapshots))
+    {
+        printf("Couldn't read counters from '%s'\n", path);
+        return 1;
+    }
+
+    printSnapshot(snapshots);
+    previousTime = getMonotonicTime();
+
+    for (sample = 1; !count || sample <= count; sample++)
+    {
+        Snapshot* before = snapshots + (sample + 1) % 2;
+        Snapshot* after = snapshots + sample % 2;
+
+        sleepThread(milliseconds);
+
+        if (!takeSnapshot(&file, after))
+            break;
+
+        // Milliseconds
+        time = getMonotonicTime();
+        printf("\n%.3f s, %s\n", (time - previousTime) / 1000, getStateName(after->state));
+        printDifference(before, after, (time - previousTime) / 1000);
+        previousTime = time;
+
+        if (after->state == PERF_DATA_EXITED)
+            break;
+    }
+
+    closeCounterFile(&file);
+    return 0;
+}
+
+int main(int argc, char* args[])
+{
+    static Snapshot before, after;
+    char buffer[300];
+
+    if (argc < 2)
+    {
+        printf("Usage: %s <file|pid> [<ms> [count]]\n", args[0]);
+        printf("       %s -d <before> <after>\n", args[0]);
+        return 1;
+    }
+
+    if (!strcmp(args[1], "-d"))
+    {
+        if (argc < 4 || !readSnapshot(args[2], &before) || !readSnapshot(args[3], &after))
+        {
+            printf("Couldn't read counters from '%s' and '%s'\n", argc > 2 ? args[2] : "", argc > 3 ? args[3] : "");
+            return 1;
+        }
+
+        printf("JVM %u, %s -> JVM %u, %s\n", before.pid, getStateName(before.state), after.pid,
+               getStateName(after.state));
+        printDifference(&before, &after, 0);
+        return 0;
+    }
+
+    if (argc > 2)
+        return watchCounters(getCounterPath(args[1], buffer, sizeof(buffer)), (uint32_t)atoi(args[2]),
+                             argc > 3 ? (uint32_t)atoi(args[3]) : 0);
+
+    if (!readSnapshot(getCounterPath(args[1], buffer, sizeof(buffer)), &before))
+    {
+        printf("Couldn't read counters from '%s'\n", args[1]);
+        return 1;
+    }
+
+    printSnapshot(&before);
+    return 0;
+}
@@ -0,0 +1,176 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+
+// Generates src/superinstructions.def from an n-gram profile recorded
+// by the JVM with "-Xngrams:<file>".
+//
+// Usage: supergen <profile> <output .def file> [maximum count]
+
+// Opcodes left unassigned between breakpoint and impdep1
+#define MAX_SUPERINSTRUCTIONS 51
+#define DEFAULT_SUPERINSTRUCTIONS 48
+#define MAX_NGRAM_LENGTH 4
+
+typedef struct
+{
+    uint64_t count;
+
+    // Dispatches that would be saved by fusing this n-gram
+    uint64_t score;
+
+    uint8_t length;
+    char mnemonics[MAX_NGRAM_LENGTH][16];
+} Candidate;
+
+static int compareScores(const void* a, const void* b)
+{
+    const Candidate* candidate1 = (const Candidate*)a;
+    const Candidate* candidate2 = (const Candidate*)b;
+
+    if (candidate1->score != candidate2->score)
+        return candidate1->score < candidate2->score ? 1 : -1;
+
+    return (int)candidate2->length - (int)candidate1->length;
+}
+
+/// @brief Reads one "count<TAB>length<TAB>mnemonics" line of the profile.
+/// @return 1 if the line contains an n-gram, 0 otherwise.
+static uint8_t parseCandidate(char* line, Candidate* candidate)
+{
+    unsigned int length;
+    char* token;
+
+    if (line[0] == '#' || sscanf(line, "%" SCNu64 "\t%u", &candidate->count, &length) != 2)
+        return 0;
+
+    if (length < 2 || length > MAX_NGRAM_LENGTH)
+        return 0;
+
+    // Skip count and length columns
+    token = strchr(line, '\t');
+    token = token ? strchr(token + 1, '\t') : NULL;
+
+    for (candidate->length = 0; token && candidate->length < length; candidate->length++)
+    {
+        token += strspn(token, " \t");
+
+        size_t tokenLength = strcspn(token, " \t\r\n");
+
+        if (tokenLength == 0 || tokenLength >= sizeof(candidate->mnemonics[0]))
+            return 0;
+
+        memcpy(candidate->mnemonics[candidate->length], token, tokenLength);
+        candidate->mnemonics[candidate->length][tokenLength] = '\0';
+        token += tokenLength;
+    }
+
+    if (candidate->length != length)
+        return 0;
+
+    candidate->score = candidate->count * (length - 1);
+    return 1;
+}
+
+int main(int argc, char* args[])
+{
+    if (argc < 3)
+    {
+        printf("Usage: supergen <profile> <output .def file> [maximum count]\n");
+        return 1;
+    }
+
+    uint32_t maximum = DEFAULT_SUPERINSTRUCTIONS;
+
+    if (argc > 3)
+    {
+        maximum = (uint32_t)atoi(args[3]);
+
+        if (maximum == 0 || maximum > MAX_SUPERINSTRUCTIONS)
+            maximum = MAX_SUPERINSTRUCTIONS;
+    }
+
+    FILE* file = fopen(args[1], "r");
+
+    if (!file)
+    {
+        printf("Couldn't open profile '%s'\n", args[1]);
+        return 1;
+    }
+
+    Candidate* candidates = NULL;
+    uint32_t candidateCount = 0;
+    uint32_t capacity = 0;
+    char line[256];
+
+    while (fgets(line, sizeof(line), file))
+    {
+        if (candidateCount == capacity)
+        {
+            capacity = capacity ? capacity * 2 : 256;
+            Candidate* resized = (Candidate*)realloc(candidates, capacity * sizeof(Candidate));
+
+            if (!resized)
+            {
+                printf("Out of memory\n");
+                free(candidates);
+                fclose(file);
+                return 1;
+            }
+
+            candidates = resized;
+        }
+
+        if (parseCandidate(line, candidates + candidateCount))
+            candidateCount++;
+    }
+
+    fclose(file);
+
+    // The JVM can't be built with an empty list
+    if (candidateCount == 0)
+    {
+        printf("Profile '%s' has no n-grams\n", args[1]);
+        free(candidates);
+        return 1;
+    }
+
+    qsort(candidates, candidateCount, sizeof(Candidate), compareScores);
+
+    file = fopen(args[2], "w");
+
+    if (!file)
+    {
+        printf("Couldn't write to '%s'\n", args[2]);
+        free(candidates);
+        return 1;
+    }
+
+    fprintf(file, "// Superinstructions fused by the predecoder, one per line, most\n");
+    fprintf(file, "// valuable first. Generated by tools/supergen.c from an n-gram profile\n");
+    fprintf(file, "// (see the \"superinstructions\" target in the makefile).\n");
+
+    uint32_t index;
+    uint8_t component;
+
+    if (candidateCount < maximum)
+        maximum = candidateCount;
+
+    for (index = 0; index < maximum; index++)
+    {
+        fprintf(file, "SUPERINSTRUCTION_%u(", candidates[index].length);
+
+        for (component = 0; component < candidates[index].length; component++)
+            fprintf(file, component ? ", %s" : "%s", candidates[index].mnemonics[component]);
+
+        fprintf(file, ")\n");
+    }
+
+    fclose(file);
+    free(candidates);
+
+    printf("%u superinstructions written to '%s'\n", maximum, args[2]);
+    return 0;
+}